@@ -26,7 +26,8 @@
 ##
 ## OVERVIEW:            Project File.
 ##
-## HISTORY:             2019-10-05/GGB - Changed compiler to use C++17.
+## HISTORY:             2026-10-19/GGB - Changed compiler to use C++20 (coroutines).
+##                      2019-10-05/GGB - Changed compiler to use C++17.
 ##											2015-05-17/GGB - Development of classes for WSd.
 ##
 ##**********************************************************************************************************************************
@@ -38,7 +39,12 @@ CONFIG   += console qt thread static link_prl
 QT       += core network sql
 QT       -= gui
 
-QMAKE_CXXFLAGS += -std=c++17 -static -static-libgcc
+QMAKE_CXXFLAGS += -std=c++20 -static -static-libgcc
+
+# The derived quantity kernels are vectorised with omp simd. (No OpenMP runtime is used.) Floating point exceptions are not used,
+# which allows the selects in the kernels to be vectorised.
+
+QMAKE_CXXFLAGS += -fopenmp-simd -fno-trapping-math
 
 DEFINES += BOOST_THREAD_USE_LIB
 DEFINES += QT_CORE_LIB
@@ -63,14 +69,73 @@ INCLUDEPATH +=  \
 
 SOURCES += \
     source/WSD.cpp \
+    source/alertRules.cpp \
+    source/apiServer.cpp \
+    source/archiveRecord.cpp \
+    source/compression.cpp \
+    source/configuration.cpp \
+    source/consoleConfiguration.cpp \
+    source/derived.cpp \
+    source/executor.cpp \
+    source/exporter.cpp \
+    source/ingest.cpp \
+    source/lease.cpp \
+    source/logger.cpp \
+    source/qualityControl.cpp \
+    source/recentWindow.cpp \
+    source/receptionLog.cpp \
+    source/replicationJournal.cpp \
+    source/replicator.cpp \
+    source/rollups.cpp \
     source/service.cpp \
+    source/sqlArchive.cpp \
     source/statemachine.cpp \
+    source/stationHealth.cpp \
+    source/stationSnapshot.cpp \
+    source/systemd.cpp \
     source/tcp.cpp \
+    source/timeSeriesStore.cpp \
+    source/tracer.cpp \
+    source/transaction.cpp \
+    source/weatherDatabase.cpp \
+    source/wireCapture.cpp \
+    source/wireReplay.cpp \
+    source/wlkImport.cpp \
 
 HEADERS += \
+    include/alertRules.h \
+    include/apiServer.h \
+    include/archiveRecord.h \
+    include/compression.h \
+    include/configuration.h \
+    include/consoleConfiguration.h \
+    include/derived.h \
+    include/executor.h \
+    include/exporter.h \
+    include/ingest.h \
+    include/lease.h \
+    include/logger.h \
+    include/qualityControl.h \
+    include/recentWindow.h \
+    include/receptionLog.h \
+    include/replicationJournal.h \
+    include/replicator.h \
+    include/rollups.h \
     include/service.h \
+    include/sqlArchive.h \
     include/statemachine.h \
+    include/stationHealth.h \
+    include/stationSnapshot.h \
+    include/systemd.h \
+    include/task.h \
     include/tcp.h \
+    include/timeSeriesStore.h \
+    include/tracer.h \
+    include/transaction.h \
+    include/weatherDatabase.h \
+    include/wireCapture.h \
+    include/wireReplay.h \
+    include/wlkImport.h \
 
 win32:CONFIG(release, debug|release) {
   LIBS += -L../../Library/Library/win32/release/ -lGCL
@@ -0,0 +1,161 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								alertRules
+// SUBSYSTEM:						Alerts
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Alert rules. Threshold rules with a hold time and hysteresis, checked against every record as it is
+//                      ingested and against the LOOP packet read after each download. Events are passed to the subscribers
+//                      (read API) and to the command of the rule.
+//
+// HISTORY:             2026-10-19/GGB - LOOP packets checked. Alerts removed by a reload cleared.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef ALERTRULES_H
+#define ALERTRULES_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+
+namespace WSd
+{
+  /// @brief An alert that has been raised or cleared.
+
+  struct SAlertEvent
+  {
+    std::uint32_t siteID;
+    std::uint32_t instrumentID;
+    QString name;
+    bool raised;                            // true if raised, false if cleared.
+    std::int64_t timeStamp;                 // Time of the record that raised or cleared the alert.
+    EColumn column;
+    double value;                           // SI units.
+  };
+
+  /// @brief The alert rules of a station. The rules are compiled once into a threshold in console units, so that checking a
+  ///        record is a comparison per rule. Events are passed to the subscribers and the command of the rule when the record
+  ///        is ingested, before it is written to storage. The current conditions (LOOP packet) are also checked after each
+  ///        download, so an event follows the condition by up to a poll interval. An archive record covers its archive
+  ///        period, which counts towards the hold time; a LOOP packet is a sample at an instant.
+  /// @note  Rule syntax: <column> <op> <value> [for <duration>] [clear <value>]
+  ///        The column is a column name of the read API, op is one of > >= < <=, and the values are in SI units. The alert is
+  ///        raised when the condition has held for the duration (s, m or h suffix. Default 0) and is cleared when the value
+  ///        no longer meets the condition against the clear value. (Default: the raise value.)
+
+  class CAlertRules
+  {
+  public:
+    typedef std::function<void(SAlertEvent const &)> TSubscriber;
+
+  private:
+    enum EComparison
+    {
+      CMP_GREATER,
+      CMP_GREATER_EQUAL,
+      CMP_LESS,
+      CMP_LESS_EQUAL,
+    };
+
+    struct SRule
+    {
+      QString name;
+      QString command;
+      EColumn column = COL_OUTSIDE_TEMPERATURE;
+      EComparison comparison = CMP_GREATER;
+      double raiseLevel = 0;                // Console units.
+      double clearLevel = 0;                // Console units.
+      std::int64_t holdTime = 0;            // Seconds.
+      bool active = false;
+      std::int64_t pendingSince = INT64_MIN;
+      double lastValue = std::numeric_limits<double>::quiet_NaN();  // Last value checked. (SI units)
+
+      bool sameCondition(SRule const &other) const
+      {
+        return (column == other.column) && (comparison == other.comparison) && (raiseLevel == other.raiseLevel) &&
+               (clearLevel == other.clearLevel) && (holdTime == other.holdTime);
+      }
+    };
+
+    static std::map<int, TSubscriber> subscribers;
+    static int nextSubscriber;
+
+    std::uint32_t siteID;
+    std::uint32_t instrumentID;
+    std::int64_t maximumAge;                // Events from older records are not published.
+    std::vector<SRule> rules;
+    std::int64_t lastTimeStamp = INT64_MIN;
+
+    static bool compile(configuration::SAlertRuleConfiguration const &, SRule &, std::string &);
+    static bool meets(EComparison comparison, double value, double level)
+    {
+      switch (comparison)
+      {
+        case CMP_GREATER:
+          return (value > level);
+        case CMP_GREATER_EQUAL:
+          return (value >= level);
+        case CMP_LESS:
+          return (value < level);
+        default:
+          return (value <= level);
+      };
+    }
+    void publish(SRule const &, std::int64_t, double);
+
+    CAlertRules(CAlertRules const &) = delete;
+    CAlertRules &operator=(CAlertRules const &) = delete;
+
+  protected:
+  public:
+    CAlertRules(std::uint32_t, std::uint32_t, std::int64_t);
+
+    void setRules(std::vector<configuration::SAlertRuleConfiguration> const &);
+    void setMaximumAge(std::int64_t age) { maximumAge = age; }
+    void evaluate(SArchiveRecord const &, std::int64_t);
+    bool empty() const { return rules.empty(); }
+
+    static bool validate(configuration::SAlertRuleConfiguration const &, std::string &);
+    static int subscribe(TSubscriber);
+    static void unsubscribe(int);
+  };
+
+} // namespace WSd
+
+#endif // ALERTRULES_H
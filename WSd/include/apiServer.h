@@ -0,0 +1,169 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								ApiServer
+// SUBSYSTEM:						Read API
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            HTTP/JSON read API. Serves the stations being acquired, the latest record of a station, ranges of records
+//                      (JSON or a compact binary format) and the hourly and daily rollups. Recent data is served from the in memory
+//                      window, older data from the local store and data that is not held locally from the weather database. Range
+//                      responses are streamed one slice at a time through a pre-sized buffer.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef APISERVER_H
+#define APISERVER_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+  // WSd header files
+
+#include "include/alertRules.h"
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+#include "include/receptionLog.h"
+
+namespace WSd
+{
+  /// @brief A connection to the read API. One request is served per connection. Range responses are generated one slice at a
+  ///        time as the socket drains, so that the memory used does not depend on the size of the range. Alert subscriptions
+  ///        remain open until the client disconnects.
+
+  class CApiConnection : public QObject
+  {
+    Q_OBJECT
+
+  private:
+    enum EFormat
+    {
+      FMT_JSON,
+      FMT_BINARY,
+    };
+
+    static int const MAX_REQUEST_SIZE = 8192;
+    static int const BUFFER_SIZE = 64 * 1024;
+    static qint64 const HIGH_WATER = 256 * 1024;        // Stop generating when this much is waiting to be sent.
+    static qint64 const LOW_WATER = 64 * 1024;          // Resume generating when the socket has drained to this.
+    static std::size_t const SLICE_RECORDS = 1440;      // Maximum records read from a source at a time.
+    static std::int64_t const SLICE_SECONDS = 1440 * 60;  // Store slice. Archive periods are at least a minute.
+    static std::size_t const DATABASE_RECORDS = 16384;  // Maximum records read from the database at a time.
+    static std::size_t const REPLICATION_RECORDS = 4096;  // Maximum journal entries in a replication response.
+
+    QTcpSocket *socket;
+    configuration::PConfiguration configuration;
+    QByteArray request;
+    QByteArray buffer;
+    bool requestComplete = false;
+
+      // Range streaming state.
+
+    bool streaming = false;
+    bool responseStarted = false;                       // Part of the range response has been written to the socket.
+    std::uint32_t siteID = 0;
+    std::uint32_t instrumentID = 0;
+    std::int64_t nextTime = 0;
+    std::int64_t endTime = 0;
+    std::vector<EColumn> columns;
+    EFormat format = FMT_JSON;
+    bool firstRecord = true;
+    bool databaseReading = false;                       // A database read is running on the executor.
+    bool databaseLoaded = false;                        // The records of the last database read are being sent.
+    std::vector<SArchiveRecord> databaseRecords;
+    std::size_t databasePosition = 0;
+    std::int64_t databaseEnd = 0;                       // The database read holds all the records up to this time.
+
+      // Alert subscription.
+
+    int alertSubscription = -1;
+
+    void handleRequest(QByteArray const &, QByteArray const &);
+    void sendResponse(int, char const *, QByteArray const &);
+    void sendError(int, QString const &);
+    void sendStations();
+    void sendLatest();
+    void readLatest();
+    void latestRead(bool, bool, SArchiveRecord const &);
+    void sendRecord(SArchiveRecord const &);
+    void sendRollups(QString const &);
+    void sendReception(QString const &);
+    void receptionRead(bool, std::vector<SReceptionSample> &&, std::vector<SRadioPacket> &&, bool);
+    void sendMetrics();
+    void sendReplication(QString const &);
+    void startRange(QString const &);
+    bool streamSlice();
+    void readDatabase(std::int64_t, std::int64_t);
+    void databaseRead(bool, std::vector<SArchiveRecord> &&);
+    void startAlerts();
+    void sendAlert(SAlertEvent const &);
+    void appendRecord(SArchiveRecord const &);
+
+    static bool parseStation(QString const &, std::uint32_t &, std::uint32_t &);
+    static void appendTime(QByteArray &, std::int64_t);
+    static void appendNumber(QByteArray &, double);
+
+  protected:
+  public:
+    CApiConnection(QTcpSocket *, configuration::PConfiguration);
+    virtual ~CApiConnection();
+
+  private slots:
+    void readRequest();
+    void continueStreaming(qint64);
+  };
+
+  /// @brief HTTP server for the read API. Serves recent and historical data of the stations being acquired.
+
+  class CApiServer : public QObject
+  {
+    Q_OBJECT
+
+  private:
+    QTcpServer server;
+    configuration::PConfiguration configuration;
+
+  protected:
+  public:
+    CApiServer(configuration::PConfiguration, QObject * = nullptr);
+
+    bool listen();
+
+  private slots:
+    void acceptConnection();
+  };
+
+} // namespace WSd
+
+#endif // APISERVER_H
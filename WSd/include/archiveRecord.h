@@ -0,0 +1,147 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								ArchiveRecord
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Decoded archive record. The Rev B archive record (52 bytes) sent by the console in the DMPAFT pages is
+//                      decoded into integer columns in console units, with the dash values (no sensor) replaced by NO_VALUE.
+//                      The current conditions of a LOOP packet are decoded into the same columns, so that they can be checked
+//                      against the alert rules.
+//
+// HISTORY:             2026-10-19/GGB - LOOP packets decoded.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef ARCHIVERECORD_H
+#define ARCHIVERECORD_H
+
+  // Standard C++ library header files
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace WSd
+{
+  /// @brief The columns of an archive record. The values are held in the units used by the console so that they are stored
+  ///        without loss. The order of the columns must not be changed, as it is the column number in the local store.
+  ///        The columns from COL_FIRST_DERIVED are computed from the raw columns when the records are ingested.
+
+  enum EColumn : std::uint8_t
+  {
+    COL_OUTSIDE_TEMPERATURE,          ///< 0.1 °F
+    COL_HIGH_OUTSIDE_TEMPERATURE,     ///< 0.1 °F
+    COL_LOW_OUTSIDE_TEMPERATURE,      ///< 0.1 °F
+    COL_RAINFALL,                     ///< Rain collector clicks.
+    COL_HIGH_RAIN_RATE,               ///< Clicks/hour.
+    COL_BAROMETER,                    ///< 0.001 inHg
+    COL_SOLAR_RADIATION,              ///< W/m²
+    COL_WIND_SAMPLES,                 ///< Number of wind samples in the archive period.
+    COL_INSIDE_TEMPERATURE,           ///< 0.1 °F
+    COL_INSIDE_HUMIDITY,              ///< %
+    COL_OUTSIDE_HUMIDITY,             ///< %
+    COL_AVERAGE_WIND_SPEED,           ///< mph
+    COL_HIGH_WIND_SPEED,              ///< mph
+    COL_HIGH_WIND_DIRECTION,          ///< 0 - 15 (N, NNE, ...)
+    COL_PREVAILING_WIND_DIRECTION,    ///< 0 - 15 (N, NNE, ...)
+    COL_UV_INDEX,                     ///< 0.1 index
+    COL_ET,                           ///< 0.001 in
+    COL_HIGH_SOLAR_RADIATION,         ///< W/m²
+    COL_HIGH_UV_INDEX,                ///< 0.1 index
+    COL_DEW_POINT,                    ///< 0.1 °F (derived)
+    COL_HEAT_INDEX,                   ///< 0.1 °F (derived)
+    COL_WIND_CHILL,                   ///< 0.1 °F (derived)
+    COL_THSW_INDEX,                   ///< 0.1 °F (derived)
+    COL_ABSOLUTE_HUMIDITY,            ///< 0.01 g/m³ (derived)
+    COL_STATION_PRESSURE,             ///< 0.001 inHg (derived)
+    COL_COUNT,
+    COL_FIRST_DERIVED = COL_DEW_POINT,
+  };
+
+  /// @brief The quality code of a raw column, set by the quality control stage when the record is ingested.
+
+  enum EQuality : std::uint8_t
+  {
+    QC_GOOD,                          ///< Passed all the checks. (Or not checked.)
+    QC_RANGE,                         ///< Outside the valid range of the sensor.
+    QC_RATE,                          ///< Changed faster than the maximum rate of change.
+    QC_SPIKE,                         ///< Too far from the median of the recent values.
+    QC_FLATLINE,                      ///< Unchanged for longer than the sensor can be expected to be unchanged.
+  };
+
+  static_assert(COL_FIRST_DERIVED * 3 <= 64, "Quality codes of the raw columns must fit in 64 bits.");
+
+  std::size_t const ARCHIVE_RECORD_SIZE = 52;         ///< Size of a Rev B archive record.
+  std::size_t const LOOP_PACKET_SIZE = 99;            ///< Size of a LOOP packet. (Including the CRC.)
+  std::int32_t const NO_VALUE = std::numeric_limits<std::int32_t>::min();
+  double const RAIN_CLICK_DEFAULT = 0.2;               ///< mm. (0.2 mm rain collector, as assumed by the weather database.)
+
+  typedef std::array<std::uint8_t, ARCHIVE_RECORD_SIZE> TRawRecord;
+
+  /// @brief A decoded archive record.
+  /// @note  The time stamp is the console time (local time of the station) expressed as seconds since 1970-01-01 00:00, without
+  ///        any time zone conversion.
+
+  struct SArchiveRecord
+  {
+    std::int64_t timeStamp = 0;
+    std::array<std::int32_t, COL_COUNT> values;
+    std::uint64_t qualityCodes = 0;                     ///< 3 bits per raw column.
+
+    SArchiveRecord() { values.fill(NO_VALUE); }
+
+    bool decode(std::uint8_t const *);
+    bool decodeLoop(std::uint8_t const *, std::int64_t);
+
+    bool hasValue(EColumn column) const { return (values[column] != NO_VALUE); }
+    bool isGood(EColumn column) const { return hasValue(column) && (quality(column) == QC_GOOD); }
+    EQuality quality(EColumn column) const
+    {
+      return (column < COL_FIRST_DERIVED) ? static_cast<EQuality>((qualityCodes >> (3 * column)) & 0x07) : QC_GOOD;
+    }
+    void setQuality(EColumn column, EQuality code)
+    {
+      if (column < COL_FIRST_DERIVED)
+      {
+        qualityCodes = (qualityCodes & ~(std::uint64_t(0x07) << (3 * column))) | (std::uint64_t(code) << (3 * column));
+      };
+    }
+    double value(EColumn, double rainClick = RAIN_CLICK_DEFAULT) const;
+
+    static std::int64_t makeTimeStamp(int year, int month, int day, int hour, int minute);
+    static void splitTimeStamp(std::int64_t, int &year, int &month, int &day, int &hour, int &minute);
+    static bool parseTimeStamp(std::string const &, std::int64_t &);
+  };
+
+  char const *columnName(EColumn);
+  char const *qualityName(EQuality);
+  bool setDashValue(std::uint8_t *, EColumn);
+  double engineeringValue(EColumn, double, double rainClick = RAIN_CLICK_DEFAULT);
+
+} // namespace WSd
+
+#endif // ARCHIVERECORD_H
@@ -0,0 +1,101 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Compression
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Bit stream compression of the columns of the local store. Integers are delta (or delta of delta) encoded
+//                      with a variable length prefix, as described for the Gorilla time series database (Pelkonen et al, 2015).
+//
+// HISTORY:             2026-10-19/GGB - Unused XOR encoder removed.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+  // Standard C++ library header files
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace WSd
+{
+  /// @brief Writes a stream of bits (most significant bit first).
+
+  class CBitWriter
+  {
+  private:
+    std::vector<std::uint8_t> &buffer;
+    int freeBits = 0;                       // Unused bits in the last byte.
+
+  public:
+    CBitWriter(std::vector<std::uint8_t> &b) : buffer(b) {}
+
+    void write(std::uint64_t, int);
+    void writeBit(bool bit) { write(bit ? 1 : 0, 1); }
+  };
+
+  /// @brief Reads a stream of bits written by CBitWriter. Reading past the end of the stream returns zero bits.
+
+  class CBitReader
+  {
+  private:
+    std::uint8_t const *data;
+    std::size_t size;
+    std::size_t position = 0;               // Bit position.
+
+  public:
+    CBitReader(std::uint8_t const *d, std::size_t s) : data(d), size(s) {}
+
+    std::uint64_t read(int);
+    bool readBit() { return (read(1) != 0); }
+    bool overrun() const { return (position > size * 8); }
+  };
+
+  /// @brief Delta encoding of integers. Values that are the same as the previous value cost one bit, small changes a few bits.
+  ///        (The timestamp encoding of Gorilla, applied to either the delta or the delta of the delta.)
+
+  class CDeltaEncoder
+  {
+  private:
+    std::int64_t previous = 0;
+    std::int64_t previousDelta = 0;
+    bool first = true;
+    bool deltaOfDelta;
+
+  public:
+    CDeltaEncoder(bool dod = false) : deltaOfDelta(dod) {}
+
+    void encode(CBitWriter &, std::int64_t);
+    std::int64_t decode(CBitReader &);
+
+    static void writeSigned(CBitWriter &, std::int64_t);
+    static std::int64_t readSigned(CBitReader &);
+  };
+
+} // namespace WSd
+
+#endif // COMPRESSION_H
@@ -0,0 +1,173 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Configuration
+// SUBSYSTEM:						Configuration
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd::configuration
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Immutable, strongly typed configuration snapshot. The snapshot is built once from the settings file with the
+//                      command line overriding any values given in the file, validated, and installed atomically. Subsystems hold
+//                      a shared pointer to the snapshot they were configured with and compare it against a new snapshot when the
+//                      configuration is reloaded (SIGHUP or service command) so that only the parts that have changed are
+//                      rebuilt. QSettings is only accessed when a snapshot is loaded or saved.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef CONFIGURATION_H
+#define CONFIGURATION_H
+
+  // Standard C++ library header files
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <boost/program_options.hpp>
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+
+namespace WSd
+{
+  namespace configuration
+  {
+    /// @brief Weather station (console) connection settings.
+
+    struct SStationConfiguration
+    {
+      std::uint32_t siteID = 53;
+      std::uint32_t instrumentID = 1;
+      QString ipAddress = "192.168.8.129";
+      std::uint16_t port = 22222;
+
+      bool operator==(SStationConfiguration const &rhs) const
+      {
+        return (siteID == rhs.siteID) && (instrumentID == rhs.instrumentID) && (ipAddress == rhs.ipAddress) && (port == rhs.port);
+      }
+      bool operator!=(SStationConfiguration const &rhs) const { return !(*this == rhs); }
+    };
+
+    /// @brief Weather database connection settings.
+
+    struct SDatabaseConfiguration
+    {
+      QString driver = "MYSQL";
+      QString hostAddress = "localhost";
+      std::uint16_t port = 3306;
+      QString databaseName = "WEATHER";
+      QString userName = "WEATHER";
+      QString password = "WEATHER";
+
+      bool operator==(SDatabaseConfiguration const &) const;
+      bool operator!=(SDatabaseConfiguration const &rhs) const { return !(*this == rhs); }
+    };
+
+    /// @brief Quality control thresholds of a raw column. The values are in SI units. (As returned by SArchiveRecord::value())
+
+    struct SQualityLimits
+    {
+      double minimum = -1e9;
+      double maximum = 1e9;
+      double maximumRate = 0;                       ///< Maximum change per minute. 0 to disable.
+      double spikeFactor = 0;                       ///< Maximum deviation from the median, in MADs. 0 to disable.
+      double spikeFloor = 0;                        ///< Deviations smaller than this are never spikes.
+      std::uint32_t flatlineMinutes = 0;            ///< Maximum time a value may be unchanged. 0 to disable.
+
+      bool operator==(SQualityLimits const &) const = default;
+    };
+
+    /// @brief Quality control settings of the station.
+
+    struct SQualityConfiguration
+    {
+      bool enabled = true;
+      bool reject = false;                          ///< Write flagged values to the database as dash values.
+      std::array<SQualityLimits, COL_FIRST_DERIVED> limits = defaultQualityLimits();
+
+      bool operator==(SQualityConfiguration const &) const = default;
+      bool operator!=(SQualityConfiguration const &rhs) const { return !(*this == rhs); }
+
+      static std::array<SQualityLimits, COL_FIRST_DERIVED> defaultQualityLimits();
+    };
+
+    /// @brief An alert rule. (See CAlertRules for the syntax of the rule.)
+
+    struct SAlertRuleConfiguration
+    {
+      QString name;
+      QString rule;                                 ///< eg "highWindSpeed > 11 for 10m clear 8"
+      QString command;                              ///< Command run when the alert is raised or cleared. Empty for none.
+
+      bool operator==(SAlertRuleConfiguration const &rhs) const
+      {
+        return (name == rhs.name) && (rule == rhs.rule) && (command == rhs.command);
+      }
+      bool operator!=(SAlertRuleConfiguration const &rhs) const { return !(*this == rhs); }
+    };
+
+    /// @brief The complete configuration of the daemon. Once installed a snapshot is never modified.
+
+    struct SConfiguration
+    {
+      SStationConfiguration station;
+      SDatabaseConfiguration database;
+      std::uint32_t pollInterval = 5;               ///< Poll interval in minutes.
+      std::uint32_t startupSpread = 0;              ///< Seconds the first polls of the stations are spread over. 0 for none.
+      std::uint32_t receptionInterval = 0;          ///< Minutes between samples of the console diagnostics. 0 for none.
+      std::uint32_t radioMonitor = 0;               ///< Seconds the radio packets are captured for with each sample. 0 for none.
+      std::uint32_t leaseTime = 0;                  ///< Seconds the lease of the station is held for. 0 if not shared.
+      double elevation = 0;                         ///< Elevation of the station (m). Used for the station pressure.
+      SQualityConfiguration quality;
+      std::vector<SAlertRuleConfiguration> alertRules;
+      std::uint32_t retentionMonths = 0;            ///< Months kept in the weather database, 0 to keep all.
+      bool retentionArchive = true;                 ///< Expired months are moved to archive tables rather than dropped.
+      QString traceFile = "WSd-trace.json";         ///< File the trace spans are exported to.
+      QString captureFile;                          ///< File the console traffic is captured to. Empty to disable capture.
+      QString storeDirectory = "WSd-store";         ///< Directory of the local time series store. Empty to disable the store.
+      QString apiAddress = "127.0.0.1";             ///< Address the read API listens on.
+      std::uint16_t apiPort = 8088;                 ///< Port of the read API. 0 to disable the API.
+      QString upstreamAddress;                      ///< Daemon the station is replicated from. Empty to poll the console.
+      std::uint16_t upstreamPort = 8088;            ///< Read API port of the upstream daemon.
+    };
+
+    typedef std::shared_ptr<SConfiguration const> PConfiguration;
+
+    void addCommandLineOptions(boost::program_options::options_description &);
+    void setCommandLine(boost::program_options::variables_map const &);
+
+    PConfiguration load(std::string &);
+    bool save(SConfiguration const &);
+    PConfiguration current();
+    void install(PConfiguration);
+
+  } // namespace configuration
+} // namespace WSd
+
+#endif // CONFIGURATION_H
@@ -0,0 +1,103 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								consoleConfiguration
+// SUBSYSTEM:						Console transactions
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt, WCL
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Cache of the configuration and calibration area of the console EEPROM. The area is read from the console
+//                      with EEBRD and kept in a local file, so that the setup of the console is known without a round trip on each
+//                      poll.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef CONSOLECONFIGURATION_H
+#define CONSOLECONFIGURATION_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+
+namespace WSd
+{
+  /// @brief The configuration and calibration area of the console EEPROM. (Setup, station list, calibration and alarms.) The
+  ///        image is read with EEBRD and cached in a file together with the identity of the console it was read from. A cached
+  ///        image is used until it is replaced by an image read from the console.
+
+  class CConsoleConfiguration
+  {
+  public:
+    static std::uint16_t const EEPROM_ADDRESS = 0x0000;
+    static std::uint16_t const EEPROM_SIZE = 0x00B2;
+
+  private:
+    QString fileName;
+    QString identity;
+    QByteArray image;                               // EEPROM_SIZE bytes and the CRC. Empty if the setup is not known.
+    double rainRemainder = 0;                       // Part of a database click of rainfall carried to the next record.
+
+    std::uint8_t byte(std::size_t offset) const { return static_cast<std::uint8_t>(image[static_cast<qsizetype>(offset)]); }
+    std::int16_t int16(std::size_t) const;
+
+    CConsoleConfiguration(CConsoleConfiguration const &) = delete;
+    CConsoleConfiguration &operator=(CConsoleConfiguration const &) = delete;
+
+  protected:
+  public:
+    CConsoleConfiguration() = default;
+
+    void setCache(QString const &, QString const &);
+    bool update(QByteArray const &);
+
+    bool valid() const { return !image.isEmpty(); }
+
+    std::uint8_t archivePeriod() const;
+    double rainClick() const;
+    std::uint8_t unitBits() const;
+    double latitude() const;
+    double longitude() const;
+    std::int16_t elevation() const;
+    std::uint8_t usedTransmitters() const;
+    std::uint8_t transmitterType(int) const;
+    std::int8_t insideTemperatureCalibration() const;
+    std::int8_t outsideTemperatureCalibration() const;
+    std::int8_t insideHumidityCalibration() const;
+    std::int8_t outsideHumidityCalibration() const;
+    std::int16_t windDirectionCalibration() const;
+
+    void normaliseRecord(TRawRecord &);
+  };
+
+} // namespace WSd
+
+#endif // CONSOLECONFIGURATION_H
@@ -0,0 +1,84 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Derived
+// SUBSYSTEM:						Ingest
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Derived meteorological quantities (dew point, heat index, wind chill, THSW index, absolute humidity and
+//                      station pressure) computed for batches of decoded records when they are ingested. The kernels work on one
+//                      array per quantity and are branch free so that they are vectorised; a scalar reference implementation using
+//                      the standard library is used to check them and as the benchmark baseline.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef DERIVED_H
+#define DERIVED_H
+
+  // Standard C++ library header files
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+
+namespace WSd
+{
+  namespace derived
+  {
+    /// @brief The inputs and outputs of the derived quantity kernels, held as one array per quantity so that the kernels work
+    ///        on contiguous values. Missing inputs are replaced by neutral values; the caller tracks which outputs are valid.
+
+    struct SBatch
+    {
+      std::vector<float> temperature;         ///< °C
+      std::vector<float> humidity;            ///< %
+      std::vector<float> windSpeed;           ///< m/s
+      std::vector<float> solarRadiation;      ///< W/m²
+      std::vector<float> barometer;           ///< hPa (reduced to sea level by the console)
+
+      std::vector<float> dewPoint;            ///< °C
+      std::vector<float> heatIndex;           ///< °C
+      std::vector<float> windChill;           ///< °C
+      std::vector<float> thswIndex;           ///< °C
+      std::vector<float> absoluteHumidity;    ///< g/m³
+      std::vector<float> stationPressure;     ///< hPa
+
+      void resize(std::size_t);
+      std::size_t size() const { return temperature.size(); }
+    };
+
+    void computeScalar(SBatch &, float);
+    void computeVector(SBatch &, float);
+
+    void compute(std::vector<SArchiveRecord> &, double);
+    void benchmark(std::ostream &, std::size_t, double);
+
+  } // namespace derived
+} // namespace WSd
+
+#endif // DERIVED_H
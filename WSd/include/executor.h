@@ -0,0 +1,117 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								executor
+// SUBSYSTEM:						Executor
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Work stealing executor. One worker thread per core, each with its own queue of tasks. A worker runs the
+//                      newest task of its own queue and, when its queue is empty, steals the oldest task of another worker, so that
+//                      CPU heavy work is spread over all the cores.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+  // Standard C++ library header files
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace WSd
+{
+  /// @brief Work stealing thread pool. Tasks submitted by a worker are queued on the worker's own queue, other tasks are spread
+  ///        over the queues. A thread that waits for tasks (parallelFor) runs queued tasks while it waits, so tasks may submit
+  ///        and wait for further tasks without deadlocking the pool.
+
+  class CExecutor
+  {
+  public:
+    typedef std::function<void()> TTask;
+
+  private:
+    struct SQueue
+    {
+      std::mutex mutex;
+      std::deque<TTask> tasks;
+    };
+
+    std::vector<std::unique_ptr<SQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queuedTasks = 0;
+    std::atomic<std::size_t> nextQueue = 0;
+    std::mutex sleepMutex;
+    std::condition_variable wakeup;
+    bool stopping = false;                            // Protected by sleepMutex.
+
+    bool takeTask(std::size_t, TTask &);
+    void workerFunction(std::size_t);
+
+    CExecutor(CExecutor const &) = delete;
+    CExecutor &operator=(CExecutor const &) = delete;
+
+  protected:
+  public:
+    CExecutor(unsigned int = 0);
+    ~CExecutor();
+
+    static CExecutor &global();
+
+    std::size_t size() const { return workers.size(); }
+
+    void submit(TTask);
+    bool runPending();
+    void parallelFor(std::size_t, std::function<void(std::size_t)> const &);
+
+    /// @brief      Runs a function on the pool.
+    /// @param[in]  function: The function to run.
+    /// @returns    The future result of the function.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    template<typename F>
+    std::future<std::invoke_result_t<F>> async(F function)
+    {
+      auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(function));
+      std::future<std::invoke_result_t<F>> result = task->get_future();
+
+      submit([task]() { (*task)(); });
+
+      return result;
+    }
+  };
+
+} // namespace WSd
+
+#endif // EXECUTOR_H
@@ -0,0 +1,81 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								exporter
+// SUBSYSTEM:						Export
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Bulk export of the history of a station to CSV or columnar files. The records are read in chunks from the
+//                      local store and the weather database, and the chunks are encoded in parallel and written in order.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+
+namespace WSd
+{
+  namespace exporter
+  {
+    enum EFormat
+    {
+      FMT_CSV,
+      FMT_COLUMNAR,
+    };
+
+    /// @brief The parameters of an export.
+
+    struct SExport
+    {
+      QString fileName;
+      EFormat format = FMT_CSV;
+      std::int64_t from = 0;
+      std::int64_t to = INT64_MAX;
+      std::vector<EColumn> columns;                     // All columns if empty.
+    };
+
+    bool parseFormat(std::string const &, EFormat &);
+    bool parseColumns(std::string const &, std::vector<EColumn> &);
+    bool exportRange(SExport const &, configuration::SConfiguration const &, std::ostream &);
+
+  } // namespace exporter
+} // namespace WSd
+
+#endif // EXPORTER_H
@@ -0,0 +1,211 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Ingest
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Ingest pipeline of a station. The archive records downloaded from the console are decoded, written to the
+//                      weather database, appended to the local store and the replication journal and added to the rollups.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef INGEST_H
+#define INGEST_H
+
+  // Standard C++ library header files
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+  // WSd header files
+
+#include "include/alertRules.h"
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+#include "include/qualityControl.h"
+#include "include/recentWindow.h"
+#include "include/replicationJournal.h"
+#include "include/rollups.h"
+#include "include/task.h"
+#include "include/timeSeriesStore.h"
+#include "include/transaction.h"
+
+namespace WSd
+{
+  /// @brief The ingest pipeline of a station. All archive records pass through here on their way to storage.
+
+  class CIngest
+  {
+  public:
+    typedef std::pair<std::uint32_t, std::uint32_t> TStationKey;          // Site ID, instrument ID.
+
+    static std::size_t const WINDOW_RECORDS = 7 * 24 * 60;                // One week of one minute records.
+    static std::size_t const DECODE_CHUNK = 256;                          // Records decoded per executor task.
+
+  private:
+    static std::map<TStationKey, CIngest *> registry;
+
+    std::uint32_t siteID;
+    std::uint32_t instrumentID;
+    double elevation;
+    std::unique_ptr<CTimeSeriesStore> store;
+    std::unique_ptr<CRollups> rollups;
+    std::unique_ptr<CReplicationJournal> journal;
+    CRecentWindow window;
+    CQualityControl qualityControl;
+    bool qualityEnabled;
+    bool qualityReject;
+    CAlertRules alertRules;
+    CAsyncResult<bool> opening;                                           // Opening of the local store on the executor.
+    std::int64_t latestTimeStamp = INT64_MIN;                             // Latest record written to the database.
+    std::uint16_t latestDate = 0;                                         // Date and time of that record. (Console format)
+    std::uint16_t latestTime = 0;
+    bool latestBlocked = false;                                           // A record of the download was not stored.
+    bool batchStored = true;                                              // All the records of the last batch were stored.
+    std::function<std::chrono::steady_clock::time_point()> writeDeadline; // Time after which records are not written.
+    std::int64_t archivePeriod = 0;                                       // Archive period of the console. (s, 0 if not known)
+
+    CIngest(CIngest const &) = delete;
+    CIngest &operator=(CIngest const &) = delete;
+
+    void openStore(QString const &);
+    void waitOpen();
+    bool isOpen();
+
+  protected:
+  public:
+    CIngest(std::uint32_t, std::uint32_t, configuration::SConfiguration const &);
+    ~CIngest();
+
+    CTask<std::size_t> ingest(std::vector<TRawRecord> const &);
+    void startDownload();
+    void endDownload();
+    bool latestStored(std::uint16_t &, std::uint16_t &);
+    void setQualityConfiguration(configuration::SQualityConfiguration const &);
+    void setAlertRules(configuration::SConfiguration const &);
+    void checkAlerts(SArchiveRecord const &);
+
+    static CIngest *find(std::uint32_t, std::uint32_t);
+    static std::vector<TStationKey> stations();
+
+    /// @brief      Returns the date and time of the latest record written to the database by this pipeline. Records that follow
+    ///             a record that was not stored (since startDownload()) are not taken into account.
+    /// @param[out] date: The date of the record. (Console format)
+    /// @param[out] time: The time of the record. (HHMM)
+    /// @returns    false if no record has been written.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool latestInserted(std::uint16_t &date, std::uint16_t &time) const
+    {
+      date = latestDate;
+      time = latestTime;
+      return (latestTimeStamp != INT64_MIN);
+    }
+
+    /// @brief      Determines if all the records of the last batch were stored in the database.
+    /// @returns    false if an insert or the commit failed.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool lastBatchStored() const { return batchStored; }
+
+    /// @brief      Sets the archive period of the console. Each record covers the archive period before its time stamp.
+    /// @param[in]  period: The archive period. (s, 0 if not known)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void setArchivePeriod(std::int64_t period) { archivePeriod = period; }
+
+    /// @brief      Determines if the station has alert rules. (The current conditions are only read if it has.)
+    /// @returns    true if there are alert rules.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool hasAlertRules() const { return !alertRules.empty(); }
+
+    /// @brief      Sets the deadline for writing records. (eg the time the lease of the station is given up.) A batch is not
+    ///             written once the deadline has passed. The deadline is read on the event loop before each batch.
+    /// @param[in]  deadline: Returns the deadline. (Empty if there is none.)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void setWriteDeadline(std::function<std::chrono::steady_clock::time_point()> deadline) { writeDeadline = std::move(deadline); }
+
+    /// @brief      Determines if records can be written. (The write deadline has not passed.)
+    /// @returns    true if records can be written.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool writable() const { return !writeDeadline || (std::chrono::steady_clock::now() < writeDeadline()); }
+
+    /// @brief      Waits for the local store to be opened without blocking the event loop. (co_await ingest.opened())
+    /// @returns    The awaitable.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Resumed by the executor when the store has been opened.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CAsyncResult<bool> opened() const { return opening; }
+
+    std::uint32_t site() const { return siteID; }
+    std::uint32_t instrument() const { return instrumentID; }
+
+    /// @brief      Returns the local store of the station.
+    /// @returns    The store. nullptr if the local store is disabled.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CTimeSeriesStore *localStore() const { return store.get(); }
+
+    /// @brief      Returns the rollups of the station.
+    /// @returns    The rollups. nullptr if the local store is disabled.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CRollups *localRollups() const { return rollups.get(); }
+
+    /// @brief      Returns the replication journal of the station.
+    /// @returns    The journal. nullptr if the local store is disabled.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CReplicationJournal *replicationJournal() const { return journal.get(); }
+
+    /// @brief      Returns the window of the most recent records of the station.
+    /// @returns    The window.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CRecentWindow const &recentWindow() const { return window; }
+  };
+
+} // namespace WSd
+
+#endif // INGEST_H
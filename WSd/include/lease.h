@@ -0,0 +1,96 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								lease
+// SUBSYSTEM:						Lease
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Lease that lets two daemons acquire the same station as an active/standby pair. The lease is a row of the
+//                      weather database (TBL_LEASE) with the name of the daemon holding it and the time it expires by the clock of
+//                      the database server. The active daemon renews the lease at a third of its duration; the standby tries to
+//                      take it at the same rate, and gets it once it has expired or been released. The lease is read and written on
+//                      the database thread, so an unreachable database does not block the event loop.
+//
+// HISTORY:             2026-10-19/GGB - Lease renewed and released on the database thread.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef LEASE_H
+#define LEASE_H
+
+  // Standard C++ library header files
+
+#include <chrono>
+#include <cstdint>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/configuration.h"
+#include "include/task.h"
+#include "include/transaction.h"
+
+namespace WSd
+{
+  /// @brief The lease of a station. Only the daemon holding the lease polls the console. The lease is given up locally a little
+  ///        before it expires in the database, so that a daemon that cannot renew its lease (eg the database is not reachable)
+  ///        has stopped polling before the other daemon can take over.
+
+  class CLease
+  {
+  private:
+    static int const SAFETY_MARGIN = 2;               // Time the lease is given up before it expires in the database. (s)
+
+    std::uint32_t siteID;
+    std::uint32_t instrumentID;
+    configuration::SDatabaseConfiguration database;
+    std::uint32_t duration;                           // s
+    QString name;                                     // Name of this daemon. (host:pid)
+    QString currentHolder;                            // Holder of the lease at the last renewal. Empty if nobody holds it.
+    bool tableCreated = false;                        // Only used on the database thread.
+    bool active = false;
+    std::chrono::steady_clock::time_point expiry;     // Time the lease is given up locally.
+
+    CLease(CLease const &) = delete;
+    CLease &operator=(CLease const &) = delete;
+
+  protected:
+  public:
+    CLease(std::uint32_t, std::uint32_t, configuration::SConfiguration const &);
+    ~CLease();
+
+    CTask<bool> renew();
+    CAsyncResult<bool> release();
+
+    bool held() const;
+    std::chrono::steady_clock::time_point heldUntil() const;
+    QString const &holder() const { return currentHolder; }
+    QString const &instance() const { return name; }
+  };
+
+} // namespace WSd
+
+#endif // LEASE_H
@@ -0,0 +1,195 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Logger
+// SUBSYSTEM:						Asynchronous logging
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd::logging
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Asynchronous logging frontend for the acquisition (hot) path.
+//                      The LOGxxx macros test the severity before any argument is evaluated. Enabled messages are recorded as a
+//                      format string and a small array of typed arguments into a preallocated, lock-free ring. A background thread
+//                      drains the ring, formats the messages and writes them to the log file in batches. If the ring is full the
+//                      message is dropped and counted rather than blocking the caller.
+//                      Format strings use "{}" as the placeholder for the next argument. The format string must have static
+//                      storage duration (normally a string literal).
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+  // Standard C++ library header files
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#define LOGMESSAGE(SEVERITY, ...) \
+  do { if (WSd::logging::enabled(SEVERITY)) { WSd::logging::logMessage(SEVERITY, __VA_ARGS__); } } while (false)
+
+#define LOGCRITICAL(...) LOGMESSAGE(WSd::logging::critical, __VA_ARGS__)
+#define LOGERROR(...) LOGMESSAGE(WSd::logging::error, __VA_ARGS__)
+#define LOGWARNING(...) LOGMESSAGE(WSd::logging::warning, __VA_ARGS__)
+#define LOGNOTICE(...) LOGMESSAGE(WSd::logging::notice, __VA_ARGS__)
+#define LOGINFO(...) LOGMESSAGE(WSd::logging::info, __VA_ARGS__)
+#define LOGDEBUG(...) LOGMESSAGE(WSd::logging::debug, __VA_ARGS__)
+#define LOGTRACE(...) LOGMESSAGE(WSd::logging::trace, __VA_ARGS__)
+
+namespace WSd
+{
+  namespace logging
+  {
+    enum ESeverity : std::uint8_t
+    {
+      critical = 0,
+      error,
+      warning,
+      notice,
+      info,
+      debug,
+      trace,
+    };
+
+    std::size_t const MAX_ARGUMENTS = 6;
+    std::size_t const MAX_STRING_LENGTH = 31;       ///< Longer string arguments are truncated.
+
+    /// @brief A captured argument. Strings are copied into the record so that no allocation is needed.
+
+    struct SArgument
+    {
+      enum EType : std::uint8_t { SIGNED, UNSIGNED, REAL, STRING } type;
+      union
+      {
+        std::int64_t s;
+        std::uint64_t u;
+        double d;
+        char string[MAX_STRING_LENGTH + 1];
+      };
+    };
+
+    /// @brief A message waiting to be formatted.
+
+    struct SLogRecord
+    {
+      std::size_t position;                         ///< Ring position claimed by the producer.
+      std::chrono::system_clock::time_point timeStamp;
+      char const *format;
+      ESeverity severity;
+      std::uint8_t argumentCount;
+      SArgument arguments[MAX_ARGUMENTS];
+    };
+
+    extern std::atomic<std::uint8_t> severityMask;
+
+    /// @brief      Determines if a severity level is enabled. This is the only test performed for a filtered message.
+    /// @param[in]  severity: The severity to test.
+    /// @returns    true if messages of this severity are recorded.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    inline bool enabled(ESeverity severity)
+    {
+      return (severityMask.load(std::memory_order_relaxed) & (1 << severity)) != 0;
+    }
+
+    void setSeverity(bool, bool, bool, bool, bool, bool, bool);
+    bool start(std::string const &);
+    void stop();
+    std::uint64_t droppedMessages();
+
+    SLogRecord *acquireRecord();
+    void publishRecord(SLogRecord *);
+
+    inline void captureArgument(SArgument &argument, char const *value)
+    {
+      argument.type = SArgument::STRING;
+      std::strncpy(argument.string, value ? value : "(null)", MAX_STRING_LENGTH);
+      argument.string[MAX_STRING_LENGTH] = 0;
+    }
+
+    inline void captureArgument(SArgument &argument, std::string const &value)
+    {
+      captureArgument(argument, value.c_str());
+    }
+
+    template<typename T>
+    inline void captureArgument(SArgument &argument, T value)
+    {
+      static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Unsupported log argument type.");
+
+      if constexpr (std::is_floating_point<T>::value)
+      {
+        argument.type = SArgument::REAL;
+        argument.d = static_cast<double>(value);
+      }
+      else if constexpr (std::is_enum<T>::value)
+      {
+        argument.type = SArgument::SIGNED;
+        argument.s = static_cast<std::int64_t>(value);
+      }
+      else if constexpr (std::is_signed<T>::value)
+      {
+        argument.type = SArgument::SIGNED;
+        argument.s = static_cast<std::int64_t>(value);
+      }
+      else
+      {
+        argument.type = SArgument::UNSIGNED;
+        argument.u = static_cast<std::uint64_t>(value);
+      };
+    }
+
+    /// @brief      Records a message. Use the LOGxxx macros rather than calling this directly so that the severity is tested first.
+    /// @param[in]  severity: The message severity.
+    /// @param[in]  format: The format string. Must have static storage duration.
+    /// @param[in]  args: The arguments. (Maximum MAX_ARGUMENTS)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    template<typename... Args>
+    void logMessage(ESeverity severity, char const *format, Args const &... args)
+    {
+      static_assert(sizeof...(Args) <= MAX_ARGUMENTS, "Too many log arguments.");
+
+      SLogRecord *record = acquireRecord();
+
+      if (record)
+      {
+        record->timeStamp = std::chrono::system_clock::now();
+        record->format = format;
+        record->severity = severity;
+        record->argumentCount = 0;
+        (captureArgument(record->arguments[record->argumentCount++], args), ...);
+        publishRecord(record);
+      };
+    }
+
+  } // namespace logging
+} // namespace WSd
+
+#endif // LOGGER_H
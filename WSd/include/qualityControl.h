@@ -0,0 +1,97 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								qualityControl
+// SUBSYSTEM:						Quality Control
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Streaming quality control of the archive records. Range, rate of change, spike (median/MAD) and flatline
+//                      checks of each raw column, with O(1) work per sample.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef QUALITYCONTROL_H
+#define QUALITYCONTROL_H
+
+  // Standard C++ library header files
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+
+namespace WSd
+{
+  /// @brief Streaming quality control of the archive records of a station. Each raw column of a record is checked against the
+  ///        recent values of the column and given a quality code. (Range, rate of change, spike and flatline checks.)
+  /// @note  The spike check uses the median and MAD of a fixed size window, so the work per record is constant.
+
+  class CQualityControl
+  {
+  public:
+    static std::size_t const WINDOW_SAMPLES = 15;           // Samples in the median window.
+    static std::size_t const MINIMUM_SAMPLES = 5;           // Samples required before the spike check is made.
+    static std::int64_t const MAXIMUM_GAP = 3600;           // History older than this (s) is not used.
+
+  private:
+    struct SColumnState
+    {
+      std::array<double, WINDOW_SAMPLES> samples;           // In arrival order. (Ring buffer)
+      std::array<double, WINDOW_SAMPLES> sorted;            // The same samples in ascending order.
+      std::size_t count = 0;
+      std::size_t next = 0;                                 // Next slot of the ring buffer.
+      double lastValue = 0;                                 // Last good value.
+      std::int64_t lastTime = INT64_MIN;                    // Time of the last good value.
+      double flatValue = 0;
+      std::int64_t flatSince = INT64_MIN;                   // Time the value last changed.
+      std::int64_t sampleTime = INT64_MIN;                  // Time of the last sample added to the window.
+
+      void add(double, std::int64_t);
+      void expire(std::int64_t);
+      double median() const;
+      double mad(double) const;
+    };
+
+    configuration::SQualityConfiguration configuration;
+    std::array<SColumnState, COL_FIRST_DERIVED> state;
+    std::int64_t lastTimeStamp = INT64_MIN;
+
+    void update(EColumn, double, std::int64_t, bool);
+
+  protected:
+  public:
+    CQualityControl(configuration::SQualityConfiguration const &);
+
+    void setConfiguration(configuration::SQualityConfiguration const &);
+    void prime(SArchiveRecord const &);
+    std::size_t check(SArchiveRecord &);
+  };
+
+} // namespace WSd
+
+#endif // QUALITYCONTROL_H
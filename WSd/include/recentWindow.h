@@ -0,0 +1,80 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								RecentWindow
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            In memory window of the most recent archive records of a station. Queries for recent data (the last hour of
+//                      wind) are answered from the window without touching the local store or the database.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef RECENTWINDOW_H
+#define RECENTWINDOW_H
+
+  // Standard C++ library header files
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/timeSeriesStore.h"
+
+namespace WSd
+{
+  /// @brief The most recent archive records of a station, held in memory in time order. The buffer is allocated once when the
+  ///        window is created.
+  /// @note  The window is complete from its first record. (Every record from the first record to the latest record is held.)
+
+  class CRecentWindow
+  {
+  private:
+    std::vector<SArchiveRecord> buffer;
+    std::size_t head = 0;                   // Index of the oldest record.
+    std::size_t count = 0;
+
+    std::size_t physical(std::size_t index) const { return (head + index) % buffer.size(); }
+    std::size_t lowerBound(std::int64_t) const;
+
+  protected:
+  public:
+    CRecentWindow(std::size_t);
+
+    void insert(SArchiveRecord const &);
+    bool scan(std::int64_t, std::int64_t, CTimeSeriesStore::TScanFunction const &) const;
+
+    bool empty() const { return (count == 0); }
+    std::size_t size() const { return count; }
+    SArchiveRecord const &at(std::size_t index) const { return buffer[physical(index)]; }
+    SArchiveRecord const &latest() const { return at(count - 1); }
+    std::int64_t firstTime() const { return empty() ? INT64_MAX : at(0).timeStamp; }
+  };
+
+} // namespace WSd
+
+#endif // RECENTWINDOW_H
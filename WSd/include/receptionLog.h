@@ -0,0 +1,171 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								receptionLog
+// SUBSYSTEM:						Reception Diagnostics
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Radio reception diagnostics of a station. The console diagnostics (RXCHECK: packets received and missed,
+//                      resynchronisations, longest run of packets received and CRC errors) are sampled at a low rate and the raw
+//                      packets received from the transmitters (STRMON) may be captured. Both are kept as a compact time series per
+//                      station and are served as metrics by the read API.
+//
+// HISTORY:             2026-10-19/GGB - Sparse time index added. Time ranges read without parsing the whole file.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef RECEPTIONLOG_H
+#define RECEPTIONLOG_H
+
+  // Standard C++ library header files
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace WSd
+{
+  /// @brief A sample of the console diagnostics. The counters are kept by the console since midnight (or since they were last
+  ///        cleared), so they fall back to zero once a day.
+
+  struct SReceptionSample
+  {
+    std::int64_t timeStamp = 0;         ///< Time of the sample. (ms since 1970)
+    std::uint32_t packets = 0;          ///< Packets received.
+    std::uint32_t missed = 0;           ///< Packets missed.
+    std::uint32_t resyncs = 0;          ///< Resynchronisations with the transmitter.
+    std::uint32_t maxInARow = 0;        ///< Longest run of packets received without an error.
+    std::uint32_t crcErrors = 0;        ///< Packets received with a CRC error.
+  };
+
+  /// @brief A raw packet received from a transmitter. (STRMON)
+
+  struct SRadioPacket
+  {
+    std::int64_t timeStamp = 0;         ///< Time the packet was received. (ms since 1970)
+    std::array<std::uint8_t, 8> data;
+  };
+
+  /// @brief Time series of the reception diagnostics of a station. The file starts with the magic "WSDR" and a version byte, and
+  ///        is followed by the records. A record is the type (1 byte) and the time since the previous record (ms, LEB128 varint),
+  ///        followed by the five counters (varints) of a sample or the eight bytes of a packet. The time of the first record is
+  ///        the time since 1970. A sample takes about 12 bytes, a packet 11 bytes.
+  ///        A sparse time index (the offset and preceding time of a record every INDEX_BYTES) is kept in memory, so a time range
+  ///        is read from the part of the file that holds it.
+
+  class CReceptionLog
+  {
+  public:
+    typedef std::pair<std::uint32_t, std::uint32_t> TStationKey;          // Site ID, instrument ID.
+
+    static qint64 const INDEX_BYTES = 64 * 1024;                          // Bytes of records between entries of the index.
+
+    /// @brief The part of the file that holds a time range. Taken from the time index by range(), and read by read(), which
+    ///        may run on any thread.
+
+    struct SRange
+    {
+      QString fileName;
+      qint64 begin = 0;                 ///< Offset of the first record to read.
+      qint64 end = 0;                   ///< Offset following the last record to read.
+      std::int64_t time = 0;            ///< Time of the record preceding begin. (ms since 1970, 0 at the start of the file)
+    };
+
+    enum ERecord : std::uint8_t
+    {
+      RR_SAMPLE,                      ///< A sample of the console diagnostics.
+      RR_PACKET,                      ///< A raw packet.
+    };
+
+  private:
+    struct SIndexEntry
+    {
+      qint64 offset;                    // Offset of a record.
+      std::int64_t time;                // Time of the preceding record. (ms since 1970)
+    };
+
+    static std::map<TStationKey, CReceptionLog *> registry;
+
+    std::uint32_t siteID;
+    std::uint32_t instrumentID;
+    QFile file;
+    std::int64_t previousTime = 0;                  // Time of the last record in the file.
+    qint64 fileSize = 0;                            // Size of the file up to the end of the last record.
+    std::vector<SIndexEntry> timeIndex;             // Sparse time index. (In file order.)
+    bool sampled = false;                           // A sample has been added. (latest is valid)
+    SReceptionSample latest;
+
+      // Totals since the daemon started, accumulated from the changes of the counters between samples.
+
+    std::uint64_t totalPackets = 0;
+    std::uint64_t totalMissed = 0;
+    std::uint64_t totalResyncs = 0;
+    std::uint64_t totalCRCErrors = 0;
+    std::uint64_t totalCaptured = 0;
+
+    void appendRecord(QByteArray &, ERecord, std::int64_t);
+    bool write(QByteArray const &, std::int64_t);
+
+    static void appendVarint(QByteArray &, std::uint64_t);
+    static bool readVarint(QByteArray const &, qsizetype &, std::uint64_t &);
+    static qsizetype parse(QByteArray const &, qsizetype, std::int64_t &, std::vector<SReceptionSample> &,
+                           std::vector<SRadioPacket> &, std::vector<SIndexEntry> *);
+    static std::uint64_t increase(std::uint32_t, std::uint32_t);
+
+    CReceptionLog(CReceptionLog const &) = delete;
+    CReceptionLog &operator=(CReceptionLog const &) = delete;
+
+  protected:
+  public:
+    CReceptionLog(std::uint32_t, std::uint32_t, QString const &);
+    ~CReceptionLog();
+
+    bool open();
+
+    void add(SReceptionSample const &);
+    void add(std::vector<SRadioPacket> const &);
+
+    bool hasSample() const { return sampled; }
+    SReceptionSample const &latestSample() const { return latest; }
+
+    SRange range(std::int64_t, std::int64_t) const;
+    static bool read(SRange const &, std::int64_t, std::int64_t, std::vector<SReceptionSample> &, std::vector<SRadioPacket> &);
+
+    static bool parseRXCHECK(QByteArray const &, SReceptionSample &);
+    static int parseSTRMON(QByteArray const &, std::uint8_t &);
+
+    static CReceptionLog *find(std::uint32_t, std::uint32_t);
+    static void metrics(QByteArray &);
+  };
+
+} // namespace WSd
+
+#endif // RECEPTIONLOG_H
@@ -0,0 +1,92 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								replicationJournal
+// SUBSYSTEM:						Replication
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Replication journal of a station. Each record that is new to the local store is appended to the journal in
+//                      the order it was ingested and is numbered by its log sequence number (LSN), starting from 1. The journal
+//                      holds the raw archive records, so a downstream daemon applies them through its own ingest pipeline. Entries
+//                      are fixed size, so the entries following a sequence number are read without an index. Entries are synced to
+//                      disk before they are numbered, so an entry that has been served survives a crash.
+//
+// HISTORY:             2026-10-19/GGB - Entries synced to disk before they are served.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef REPLICATIONJOURNAL_H
+#define REPLICATIONJOURNAL_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QFile>
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+
+namespace WSd
+{
+  /// @brief Append only journal of the raw archive records ingested for a station. The epoch identifies the numbering of the
+  ///        journal: a journal that is created again (eg it was lost or not valid) has a new epoch, and a downstream daemon that
+  ///        has applied sequence numbers of another epoch starts again from the first entry.
+
+  class CReplicationJournal
+  {
+  public:
+    static qint64 const HEADER_SIZE = 16;                                 // Magic, version, reserved and the epoch.
+    static qint64 const ENTRY_SIZE = ARCHIVE_RECORD_SIZE + 2;             // Raw record and its CRC.
+
+  private:
+    QFile file;
+    std::int64_t journalEpoch = 0;                                        // Time the journal was created. (ms since 1970)
+    std::uint64_t entryCount = 0;                                         // Sequence number of the last entry.
+
+    bool create();
+    bool writeHeader();
+
+    CReplicationJournal(CReplicationJournal const &) = delete;
+    CReplicationJournal &operator=(CReplicationJournal const &) = delete;
+
+  protected:
+  public:
+    CReplicationJournal(QString const &);
+
+    bool open();
+    bool append(std::vector<TRawRecord> const &);
+    bool read(std::uint64_t, std::size_t, std::vector<TRawRecord> &);
+
+    std::int64_t epoch() const { return journalEpoch; }
+    std::uint64_t lastSequence() const { return entryCount; }
+  };
+
+} // namespace WSd
+
+#endif // REPLICATIONJOURNAL_H
@@ -0,0 +1,100 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								replicator
+// SUBSYSTEM:						Replication
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Replication of a station from an upstream daemon. The entries of the replication journal of the upstream
+//                      daemon are requested in batches through its read API, from the last sequence number applied, and each batch
+//                      is applied through the ingest pipeline of the station. The epoch of the journal and the last sequence number
+//                      applied are saved after each batch, so replication resumes where it stopped when the daemon is restarted.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef REPLICATOR_H
+#define REPLICATOR_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QString>
+#include <QTcpSocket>
+
+  // WSd header files
+
+#include "include/ingest.h"
+#include "include/task.h"
+
+namespace WSd
+{
+  /// @brief Replicates a station from the replication journal of an upstream daemon. A batch that is applied again (eg the
+  ///        daemon stopped before the position was saved) is harmless, as records already in the database and the local store
+  ///        are not written again.
+
+  class CReplicator
+  {
+  public:
+    static std::size_t const BATCH_RECORDS = 1440;    // Journal entries requested at a time.
+
+  private:
+    static int const CONNECT_TIMEOUT = 5000;          // ms
+    static int const RESPONSE_TIMEOUT = 30000;        // ms
+    static qsizetype const MAX_HEADER_SIZE = 8192;
+    static qsizetype const RESPONSE_HEADER_SIZE = 33; // Magic, version, epoch, last sequence, first sequence and count.
+
+    std::uint32_t siteID;
+    std::uint32_t instrumentID;
+    QString hostAddress;
+    std::uint16_t port;
+    QString positionFile;
+    QTcpSocket socket;
+    std::int64_t epoch = 0;                           // Epoch of the upstream journal the sequence number belongs to.
+    std::uint64_t appliedSequence = 0;                // Last sequence number applied.
+    bool cancelled = false;                           // Replication has been cancelled. The upstream daemon is not connected again.
+
+    void loadPosition();
+    bool savePosition() const;
+    CTask<QByteArray> request(std::uint64_t);
+
+    CReplicator(CReplicator const &) = delete;
+    CReplicator &operator=(CReplicator const &) = delete;
+
+  protected:
+  public:
+    CReplicator(std::uint32_t, std::uint32_t, QString const &, std::uint16_t, QString const &);
+
+    CTask<bool> pull(CIngest &);
+    void cancel();
+
+    std::uint64_t sequence() const { return appliedSequence; }
+  };
+
+} // namespace WSd
+
+#endif // REPLICATOR_H
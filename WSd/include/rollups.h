@@ -0,0 +1,141 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Rollups
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Hourly and daily rollups (minimum, maximum, sum and count, so the mean) of temperature, humidity, pressure,
+//                      wind speed and rainfall. The rollups are updated as each new record is ingested. Because the aggregates are
+//                      commutative a late or backfilled record is simply added to its bucket. Aggregate queries read O(buckets)
+//                      instead of O(records).
+//                      The rollups are held in memory and the changed buckets are appended to a rollup file in the station
+//                      directory of the local store.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef ROLLUPS_H
+#define ROLLUPS_H
+
+  // Standard C++ library header files
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+
+namespace WSd
+{
+  class CTimeSeriesStore;
+
+  enum ERollupMeasure : std::uint8_t
+  {
+    RM_TEMPERATURE,                   ///< Outside temperature. (Minimum from the low, maximum from the high temperature.)
+    RM_HUMIDITY,                      ///< Outside humidity.
+    RM_BAROMETER,
+    RM_WIND_SPEED,                    ///< Average wind speed. (Maximum from the high wind speed.)
+    RM_RAINFALL,
+    RM_COUNT,
+  };
+
+  enum ERollupPeriod : std::uint8_t
+  {
+    RP_HOUR,
+    RP_DAY,
+    RP_COUNT,
+  };
+
+  /// @brief Aggregate of a measure over a bucket. The values are in console units. All the operations are commutative, so the
+  ///        order in which records are added (late or backfilled records) does not change the aggregate.
+
+  struct SAggregate
+  {
+    std::int32_t minimum = std::numeric_limits<std::int32_t>::max();
+    std::int32_t maximum = std::numeric_limits<std::int32_t>::min();
+    std::int64_t sum = 0;
+    std::uint32_t count = 0;
+
+    void add(std::int32_t, std::int32_t, std::int32_t);
+    void merge(SAggregate const &);
+    double mean() const { return (count == 0) ? 0 : static_cast<double>(sum) / count; }
+  };
+
+  typedef std::array<SAggregate, RM_COUNT> TAggregates;
+
+  /// @brief A rollup bucket returned by a query.
+
+  struct SRollup
+  {
+    std::int64_t start;               ///< Start of the bucket. (Time stamp)
+    TAggregates measures;
+  };
+
+  /// @brief Hourly and daily rollups of the archive records of a station, maintained as the records are ingested.
+
+  class CRollups
+  {
+  private:
+    QString fileName;
+    std::array<std::map<std::int64_t, TAggregates>, RP_COUNT> buckets;
+    std::set<std::pair<ERollupPeriod, std::int64_t>> dirty;
+    std::uint64_t logEntries = 0;
+
+    bool load();
+    bool compact();
+    bool writeEntries(QString const &, std::vector<std::pair<ERollupPeriod, std::int64_t>> const &, bool);
+
+    CRollups(CRollups const &) = delete;
+    CRollups &operator=(CRollups const &) = delete;
+
+  protected:
+  public:
+    CRollups(QString const &);
+    ~CRollups();
+
+    bool open(CTimeSeriesStore const *);
+    void add(SArchiveRecord const &);
+    bool flush();
+
+    std::vector<SRollup> query(ERollupPeriod, std::int64_t, std::int64_t) const;
+
+    static std::int64_t bucketStart(ERollupPeriod, std::int64_t);
+    static EColumn measureColumn(ERollupMeasure);
+    static char const *measureName(ERollupMeasure);
+    static char const *periodName(ERollupPeriod);
+  };
+
+} // namespace WSd
+
+#endif // ROLLUPS_H
@@ -40,33 +40,62 @@
 
   // Miscellaneous library header files
 
+#include <QLocalServer>
+#include <QSocketNotifier>
+#include <QTimer>
 #include "qtservice.h"
 
   // WSd header files
 
+#include "include/apiServer.h"
 #include "include/statemachine.h"
 
 namespace WSd
 {
   namespace service
   {
+    int const COMMAND_RELOAD = 128;         ///< Service command to reload the configuration.
+    int const COMMAND_TRACE_START = 129;    ///< Service command to start recording trace spans.
+    int const COMMAND_TRACE_STOP = 130;     ///< Service command to stop recording trace spans and export them.
+
     class CWSService : public QObject, public QtService<QCoreApplication>
     {
       Q_OBJECT
 
     private:
       std::unique_ptr<CStateMachine> stateMachine;
-      std::uint32_t siteID;
-      std::uint32_t instrumentID;
+      std::unique_ptr<CApiServer> apiServer;
+      QSocketNotifier *signalNotifier = nullptr;
+      QTimer *watchdogTimer = nullptr;
+      QLocalServer *controlServer = nullptr;
+      bool stopped = false;
+
+      static int signalFD[2];
+      static void signalHandler(int);
+
+      void installSignalHandlers();
+      void startApiServer(configuration::PConfiguration);
+      void startControlServer();
+      bool controlCommand(QByteArray const &);
+      void terminate();
 
     protected:
       void start();
       void stop();
       void pause() {}
       void resume();
+      void processCommand(int);
 
     public:
-      CWSService(int argc, char **argv, std::uint32_t siteID, std::uint32_t instrumentID);
+      CWSService(int argc, char **argv);
+
+    public slots:
+      void handleSignal();
+      void acceptControlConnection();
+      void resetWatchdog();
+      void reloadConfiguration();
+      void startTracing();
+      void stopTracing();
     };
 
   } // namespace service
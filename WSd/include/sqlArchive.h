@@ -0,0 +1,76 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								SQLArchive
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Direct SQL access to the archive table (TBL_ARCHIVE) of the weather database through named connections that
+//                      are independent of the WCL connection. Used for the queries that WCL does not provide. Also holds the
+//                      leases (TBL_LEASE) that decide which of a pair of daemons polls a station.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef SQLARCHIVE_H
+#define SQLARCHIVE_H
+
+  // Standard C++ library header files
+
+#include <cstddef>
+#include <cstdint>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/configuration.h"
+#include "include/timeSeriesStore.h"
+
+namespace WSd
+{
+  namespace sql
+  {
+    bool openConnection(QString const &, configuration::SDatabaseConfiguration const &);
+    void closeConnection(QString const &);
+
+    bool readRecords(QString const &, std::uint32_t, std::uint32_t, std::int64_t, std::int64_t, std::size_t,
+                     CTimeSeriesStore::TScanFunction const &);
+    bool lastRecord(QString const &, std::uint32_t, std::uint32_t, SArchiveRecord &, bool &);
+    bool insertRecord(QString const &, std::uint32_t, std::uint32_t, SArchiveRecord const &, bool &);
+    bool containsRecord(QString const &, std::uint32_t, std::uint32_t, std::int64_t, bool &);
+
+    bool partitionArchive(QString const &, std::int32_t);
+    bool maintainPartitions(QString const &, std::int32_t, std::uint32_t, bool);
+    bool expireRecords(QString const &, std::int32_t, std::uint32_t, bool);
+
+    bool createLeaseTable(QString const &);
+    bool acquireLease(QString const &, std::uint32_t, std::uint32_t, QString const &, std::uint32_t, QString &, std::int64_t &);
+    bool releaseLease(QString const &, std::uint32_t, std::uint32_t, QString const &);
+
+  } // namespace sql
+} // namespace WSd
+
+#endif // SQLARCHIVE_H
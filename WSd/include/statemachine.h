@@ -35,7 +35,10 @@
 
   // Standard C++ library  header files
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <optional>
 
   // Miscellaneousl library header files
 
@@ -43,6 +46,13 @@
 
   // WSd header files
 
+#include "include/configuration.h"
+#include "include/ingest.h"
+#include "include/lease.h"
+#include "include/receptionLog.h"
+#include "include/replicator.h"
+#include "include/stationHealth.h"
+#include "include/task.h"
 #include "tcp.h"
 
 namespace WSd
@@ -64,17 +74,49 @@ namespace WSd
     uint32_t lastJDReceived = 0;
     uint32_t lastSecReceived = 0;
     QTimer *pollTimer;
+    configuration::PConfiguration configuration;
+    CStationHealth health;
+    std::unique_ptr<CIngest> ingest;
+    std::unique_ptr<CReceptionLog> reception;             // nullptr if the console diagnostics are not sampled.
+    std::unique_ptr<CReplicator> replicator;              // nullptr if the console is polled.
+    std::chrono::steady_clock::time_point nextReception;  // Time the console diagnostics are next sampled.
+    std::unique_ptr<CLease> lease;                        // nullptr if the station is not shared with a standby daemon.
+    QTimer *leaseTimer = nullptr;
+    bool leaseHeld = false;                               // The lease was held at the last renewal.
+    bool leaseRenewing = false;
+    std::optional<CTask<bool>> leaseTask;                 // The renewal of the lease in progress, or the last one.
+    bool pollInProgress = false;
+    bool standingBy = false;                              // The task in progress is a standby refresh.
+    std::optional<CTask<bool>> pollTask;                  // The poll (or standby refresh) in progress, or the last one.
+    bool stopped = false;
+    bool timeUpdated = false;
+    bool databaseConnected = false;                       // The database is connected by the first poll.
+    bool firstReadReported = false;
+    bool highWaterCheck = false;                          // The restored high-water mark is checked by the first poll.
+    int maintenanceDay = -1;                              // Day of the year the database was last maintained.
+    configuration::PConfiguration pendingConfiguration;   // Configuration received while a poll was in progress.
+
+    CTask<bool> poll();
+    void openLease(configuration::SConfiguration const &);
+    CTask<bool> refreshLease();
+    std::chrono::steady_clock::time_point writeDeadline() const;
+    CTask<bool> refreshStandby();
+    void restoreSnapshot();
+    void saveSnapshot();
 
   protected:
   public:
-    CStateMachine(QObject *, std::uint32_t site, std::uint32_t instrument);
+    CStateMachine(QObject *, std::uint32_t site, std::uint32_t instrument, configuration::PConfiguration);
     virtual ~CStateMachine();
 
+    void reconfigure(configuration::PConfiguration);
+
     void start();
     void stop();
 
   public slots:
     void pollModeTimer();
+    void renewLease();
   };
 
 
@@ -0,0 +1,111 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								StationHealth
+// SUBSYSTEM:						StateMachine
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Per station health (circuit breaker).
+//                      healthy   - The console is responding. Every poll is attempted.
+//                      degraded  - The last poll(s) failed. Polls are still attempted but with a single wakeup attempt.
+//                      open      - Too many consecutive failures. No polls are attempted until the backoff period expires.
+//                      halfOpen  - The backoff has expired. A single probe poll is allowed. Success closes the circuit, failure
+//                                  re-opens it with double the backoff.
+//                      The backoff grows exponentially up to a maximum, with jitter so that many dead consoles are not probed in
+//                      step.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef STATIONHEALTH_H
+#define STATIONHEALTH_H
+
+  // Standard C++ library header files
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+namespace WSd
+{
+  enum EStationHealth : std::uint8_t
+  {
+    SH_HEALTHY,
+    SH_DEGRADED,
+    SH_OPEN,
+    SH_HALFOPEN,
+  };
+
+  class CStationHealth
+  {
+  public:
+    typedef std::chrono::steady_clock::time_point time_point;
+    typedef std::chrono::steady_clock::duration duration;
+
+  private:
+    EStationHealth state = SH_HEALTHY;
+    std::uint32_t consecutiveFailures = 0;
+    std::uint32_t openCount = 0;                      // Number of times the circuit has opened without a success.
+    time_point nextAttempt;
+    std::mt19937 randomGenerator;
+
+    std::uint32_t failureThreshold;
+    duration initialBackoff;
+    duration maximumBackoff;
+
+    duration backoff();
+
+  protected:
+  public:
+    CStationHealth(std::uint32_t threshold = 3,
+                   duration initial = std::chrono::minutes(1),
+                   duration maximum = std::chrono::hours(1));
+
+    bool allowAttempt(time_point);
+    void recordSuccess();
+    void recordFailure(time_point);
+    void restore(EStationHealth, std::uint32_t, std::uint32_t, time_point);
+
+    /// @brief      Returns the current state of the station.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    EStationHealth health() const { return state; }
+
+    /// @brief      Determines if the next attempt should be a minimal probe (single wakeup, short timeouts).
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool probeOnly() const { return (state != SH_HEALTHY); }
+
+    std::uint32_t failures() const { return consecutiveFailures; }
+    std::uint32_t openings() const { return openCount; }
+    time_point nextAttemptTime() const { return nextAttempt; }
+    duration backoffLimit() const { return maximumBackoff; }
+
+    static char const *healthText(EStationHealth);
+  };
+
+} // namespace WSd
+
+#endif // STATIONHEALTH_H
@@ -0,0 +1,76 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								stationSnapshot
+// SUBSYSTEM:						Station Snapshot
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Snapshot of the runtime state of a station: the high-water mark of the database, the circuit breaker,
+//                      whether the console configuration has been checked and the daily tasks done. The snapshot is written after
+//                      each poll and when the daemon stops, and loaded when it starts, so a restarted daemon resumes polling where
+//                      it left off.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef STATIONSNAPSHOT_H
+#define STATIONSNAPSHOT_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/stationHealth.h"
+
+namespace WSd
+{
+  /// @brief The runtime state of a station that is kept over a restart. The snapshot is only loaded for the same station,
+  ///        console and database (the identity) that it was saved for.
+
+  struct SStationSnapshot
+  {
+    std::int64_t savedTime = 0;                     ///< Time the snapshot was saved. (UNIX time, s)
+    bool highWaterValid = false;                    ///< The high-water mark is known.
+    std::uint16_t highWaterDate = 0;                ///< Date of the last record in the database. (Console format)
+    std::uint16_t highWaterTime = 0;                ///< Time of the last record in the database. (HHMM)
+    EStationHealth health = SH_HEALTHY;
+    std::uint32_t failures = 0;                     ///< Consecutive failed polls.
+    std::uint32_t openCount = 0;                    ///< Times the circuit has opened without a success.
+    std::int64_t nextAttempt = 0;                   ///< Time the open circuit allows the next attempt. (UNIX time, ms)
+    bool consoleValidated = false;                  ///< The console configuration has been checked against the console.
+    std::int32_t maintenanceDay = -1;               ///< Day of the year the database was last maintained.
+    bool timeUpdated = false;                       ///< The console time has been set today.
+
+    bool load(QString const &, QString const &);
+    bool save(QString const &, QString const &) const;
+  };
+
+} // namespace WSd
+
+#endif // STATIONSNAPSHOT_H
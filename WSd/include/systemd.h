@@ -0,0 +1,64 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								systemd
+// SUBSYSTEM:						Systemd
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Integration with systemd. Readiness, status and watchdog notifications are sent as datagrams to the notify
+//                      socket ($NOTIFY_SOCKET) and the listening sockets passed by socket activation ($LISTEN_FDS) are taken by
+//                      name. The protocol is implemented directly, libsystemd is not required. Without systemd all the functions do
+//                      nothing.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef SYSTEMD_H
+#define SYSTEMD_H
+
+  // Standard C++ library header files
+
+#include <chrono>
+#include <string>
+
+namespace WSd
+{
+  namespace systemd
+  {
+    void initialise();
+    bool supervised();
+
+    bool notify(std::string const &);
+    void ready(std::string const &);
+    void status(std::string const &);
+    void reloading();
+    void stopping();
+    void watchdog();
+    std::chrono::milliseconds watchdogInterval();
+
+    int listenSocket(std::string const &);
+
+  } // namespace systemd
+} // namespace WSd
+
+#endif // SYSTEMD_H
@@ -0,0 +1,174 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Task
+// SUBSYSTEM:						Console transactions
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            C++20 coroutine task. A task does not run until it is either awaited by another task (co_await), or
+//                      started with start(). A started task owns its own frame and destroys it when it completes, after calling
+//                      the completion function. A task that is awaited resumes the awaiting task when it completes.
+//                      Tasks are resumed from the event loop (by the awaitables in transaction.h), so no thread is blocked while a
+//                      task is waiting.
+//
+// HISTORY:             2026-10-19/GGB - Tasks started without being detached.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef TASK_H
+#define TASK_H
+
+  // Standard C++ library header files
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <utility>
+
+namespace WSd
+{
+  template<typename T>
+  class CTask
+  {
+  public:
+    struct promise_type;
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+    struct SFinalAwaiter
+    {
+      bool await_ready() noexcept { return false; }
+
+      std::coroutine_handle<> await_suspend(handle_type handle) noexcept
+      {
+        promise_type &promise = handle.promise();
+
+        if (promise.continuation)
+        {
+          return promise.continuation;
+        }
+        else
+        {
+          if (promise.completion)
+          {
+            promise.completion(std::move(promise.value), promise.exception);
+          };
+          if (promise.detached)
+          {
+            handle.destroy();
+          };
+          return std::noop_coroutine();
+        };
+      }
+
+      void await_resume() noexcept {}
+    };
+
+    struct promise_type
+    {
+      T value{};
+      std::exception_ptr exception;
+      std::coroutine_handle<> continuation;
+      std::function<void(T, std::exception_ptr)> completion;
+      bool detached = false;
+
+      CTask get_return_object() { return CTask(handle_type::from_promise(*this)); }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      SFinalAwaiter final_suspend() noexcept { return {}; }
+      void return_value(T v) { value = std::move(v); }
+      void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+  private:
+    handle_type coroutine;
+
+    explicit CTask(handle_type h) : coroutine(h) {}
+    CTask(CTask const &) = delete;
+    CTask &operator=(CTask const &) = delete;
+
+  public:
+    CTask(CTask &&other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+    ~CTask()
+    {
+      if (coroutine)
+      {
+        coroutine.destroy();
+      };
+    }
+
+      // Awaitable interface. The awaiting coroutine is resumed when this task completes (symmetric transfer).
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+      coroutine.promise().continuation = awaiting;
+      return coroutine;
+    }
+
+    T await_resume()
+    {
+      if (coroutine.promise().exception)
+      {
+        std::rethrow_exception(coroutine.promise().exception);
+      };
+      return std::move(coroutine.promise().value);
+    }
+
+    /// @brief      Determines if the task has completed. (Or has been started detached.)
+    /// @returns    true if the task has completed.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool done() const noexcept { return !coroutine || coroutine.done(); }
+
+    /// @brief      Starts the task without awaiting it and without giving up the task frame. The frame is destroyed with the task,
+    ///             so the owner can check that the task has completed (done()) before it releases what the task is using. The
+    ///             task must not be destroyed from the completion.
+    /// @param[in]  completion: Called with the result (or exception) when the task completes. May be empty.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void launch(std::function<void(T, std::exception_ptr)> completion = {})
+    {
+      coroutine.promise().completion = std::move(completion);
+      coroutine.resume();
+    }
+
+    /// @brief      Starts the task without awaiting it. The task frame is destroyed when the task completes.
+    /// @param[in]  completion: Called with the result (or exception) when the task completes. May be empty.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void start(std::function<void(T, std::exception_ptr)> completion = {})
+    {
+      handle_type handle = std::exchange(coroutine, nullptr);
+
+      handle.promise().completion = std::move(completion);
+      handle.promise().detached = true;
+      handle.resume();
+    }
+  };
+
+} // namespace WSd
+
+#endif // TASK_H
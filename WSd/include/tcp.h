@@ -42,6 +42,15 @@
 
 #include <QtNetwork>
 
+  // WSd header files
+
+#include "include/configuration.h"
+#include "include/consoleConfiguration.h"
+#include "include/ingest.h"
+#include "include/receptionLog.h"
+#include "include/task.h"
+#include "include/wireCapture.h"
+
 namespace WSd
 {
   class CTCPSocket : public QTcpSocket
@@ -49,19 +58,70 @@ namespace WSd
     Q_OBJECT
 
   private:
+    static int const WAKEUP_ATTEMPTS = 3;
+    static int const CONNECT_TIMEOUT = 1000;          // ms
+    static int const PROBE_CONNECT_TIMEOUT = 500;     // ms
+    static int const WAKEUP_TIMEOUT = 1200;           // ms
+    static int const RESPONSE_TIMEOUT = 5000;         // ms
+    static int const PAGE_RETRIES = 2;                // Number of times a page with a bad CRC is requested again.
+    static qint64 const DMPAFT_HEADER_SIZE = 7;       // ACK, pages, first record, CRC.
+    static qint64 const DUMP_PAGE_SIZE = 267;         // Sequence, 5 records, unused, CRC.
+    static qsizetype const MAX_LINE_SIZE = 80;        // Longest line of a text response. (RXCHECK, STRMON)
+    static constexpr std::uint32_t MAX_RADIO_MONITOR = 60;    // Longest capture of the radio packets. (s)
+    static constexpr char NAK = 0x21;
+    static constexpr char ESC = 0x1B;
+
     std::uint32_t siteID;
     std::uint32_t instrumentID;
     QString ipAddress;
-    qint16 port;
+    std::uint16_t port;
+    int wakeupAttempts = WAKEUP_ATTEMPTS;
+    int connectTimeout = CONNECT_TIMEOUT;
+    std::unique_ptr<CWireCapture> capture;          // nullptr when the traffic is not captured.
+    CConsoleConfiguration console;
+    bool consoleValidated = false;                  // The cached console configuration has been checked since connecting.
+    bool highWaterValid = false;                    // The high-water mark is known.
+    std::uint16_t highWaterDate = 0;                // Date of the last record in the database. (Console format, 0 for none.)
+    std::uint16_t highWaterTime = 0;                // Time of the last record in the database. (HHMM)
+    bool storeChecked = false;                      // The download has been started from the local store once.
+    std::uint32_t radioMonitorTime = 0;             // Time the radio packets are captured for after RXCHECK. (s, 0 for none)
+    bool cancelled = false;                         // The transactions have been cancelled. The console is not connected again.
+
+    CTask<bool> connectAndWake(QByteArray const &);
+    CTask<bool> sendCommand(QByteArray, QByteArray);
+    CTask<bool> readConsoleConfiguration();
+    CTask<QByteArray> readLine(int);
+    CTask<bool> readReception(CReceptionLog &);
+    CTask<std::size_t> monitorRadio(CReceptionLog &);
+    CTask<bool> readLoop(CIngest &);
+    QByteArray received(QByteArray);
 
   protected:
+    virtual qint64 writeData(char const *, qint64) override;
 
   public:
-    CTCPSocket(QObject *parent, std::uint32_t  sid, std::uint32_t iid);
+    CTCPSocket(QObject *parent, std::uint32_t  sid, std::uint32_t iid, configuration::SStationConfiguration const &);
+    ~CTCPSocket();
+
+    void reconfigure(configuration::SStationConfiguration const &);
+    void setProbeMode(bool);
+    void setCapture(QString const &);
+    void setConsoleCache(QString const &);
+    void setRadioMonitor(std::uint32_t);
+    void cancel();
+
+    CConsoleConfiguration const &consoleConfiguration() const { return console; }
+    bool consoleConfigurationValidated() const { return consoleValidated; }
+    void assumeConsoleValidated() { consoleValidated = console.valid(); }
+
+    CTask<bool> loadHighWater();
+    bool highWater(std::uint16_t &, std::uint16_t &) const;
+    void setHighWater(std::uint16_t, std::uint16_t);
+    void invalidateHighWater() { highWaterValid = false; }
 
-    bool readArchive();
-    bool setTime();
-    bool setInterval(std::uint8_t);
+    CTask<bool> readArchive(CIngest &, CReceptionLog * = nullptr);
+    CTask<bool> setTime();
+    CTask<bool> setInterval(std::uint8_t);
   };
 
 }   // namespace WSd
@@ -0,0 +1,135 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								TimeSeriesStore
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Embedded, append only, columnar time series store for the archive records of a station. The store is kept in
+//                      a directory per station with one chunk file per month (time partition). Each chunk file holds a sequence of
+//                      blocks of up to 1024 records. Within a block each column is compressed separately (delta of delta for the
+//                      time stamps, delta for the values) and the block header holds the time range of the block. The block headers
+//                      form a sparse time index, so a range scan only decodes the blocks that overlap the range, directly from the
+//                      memory mapped chunk files.
+//                      The last block is kept open in memory and saved to a file of its own each time the store is flushed. It is
+//                      appended to its chunk file when it is full, so the chunk files are only appended to.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+
+namespace WSd
+{
+  /// @brief Append only, compressed, columnar store of the archive records of one station.
+
+  class CTimeSeriesStore
+  {
+  public:
+    typedef std::function<bool(SArchiveRecord const &)> TScanFunction;
+
+    static std::size_t const BLOCK_RECORDS = 1024;
+
+  private:
+    struct SBlockIndex
+    {
+      std::int64_t minimumTime;
+      std::int64_t maximumTime;
+      std::int64_t offset;                  // Offset of the block header in the chunk file.
+      std::uint32_t length;                 // Length of the block, including the header.
+      std::uint16_t recordCount;
+    };
+
+    struct SChunk
+    {
+      QString fileName;
+      std::int64_t validSize = 0;           // Size of the file up to the end of the last valid block.
+      std::vector<SBlockIndex> blocks;      // Sparse time index. (One entry per block.)
+    };
+
+    QString directory;
+    std::map<std::int32_t, SChunk> chunks;  // Keyed by partition. (year * 12 + month - 1)
+    std::int64_t firstTimeStamp = INT64_MAX;
+    std::int64_t lastTimeStamp = INT64_MIN;
+    std::uint64_t totalRecords = 0;
+
+      // The open (unsealed) block. It is written to the open block file each time the store is flushed, and appended to its
+      // chunk file (sealed) when it is full or records of another partition are appended. Chunk files are only appended to.
+
+    std::int32_t openPartition = -1;
+    std::vector<SArchiveRecord> openRecords;
+    bool openDirty = false;
+
+    static std::int32_t partition(std::int64_t);
+    QString chunkFileName(std::int32_t) const;
+    bool indexChunk(std::int32_t, SChunk &);
+    QString openBlockFileName() const;
+    void loadOpenBlock();
+    bool saveOpenBlock();
+    bool sealOpenBlock();
+
+    static void encodeBlock(std::vector<SArchiveRecord> const &, std::vector<std::uint8_t> &);
+    static bool decodeBlock(std::uint8_t const *, std::size_t, std::vector<SArchiveRecord> &);
+
+    CTimeSeriesStore(CTimeSeriesStore const &) = delete;
+    CTimeSeriesStore &operator=(CTimeSeriesStore const &) = delete;
+
+  protected:
+  public:
+    CTimeSeriesStore(QString const &);
+    ~CTimeSeriesStore();
+
+    bool open();
+    bool append(SArchiveRecord const &);
+    bool flush();
+
+    std::set<std::int64_t> storedTimes(std::int64_t, std::int64_t) const;
+    bool scan(std::int64_t, std::int64_t, TScanFunction const &) const;
+    std::vector<SArchiveRecord> read(std::int64_t, std::int64_t) const;
+
+    std::int64_t firstTime() const { return firstTimeStamp; }
+    std::int64_t lastTime() const { return lastTimeStamp; }
+    std::uint64_t recordCount() const { return totalRecords; }
+    std::uint64_t storageSize() const;
+  };
+
+} // namespace WSd
+
+#endif // TIMESERIESSTORE_H
@@ -0,0 +1,111 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Tracer
+// SUBSYSTEM:						Span tracing
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd::tracing
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Low overhead span tracer. A span is opened with TRACESPAN("name") and closed when the enclosing scope is
+//                      left. When tracing is disabled a span costs a single relaxed load. When enabled the span is written, with
+//                      nanosecond monotonic timestamps, into a ring buffer owned by the calling thread, so no locks are taken.
+//                      The rings can be exported at any time in the Chrome trace event format (chrome://tracing, Perfetto).
+//                      Span names must have static storage duration (normally a string literal).
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef TRACER_H
+#define TRACER_H
+
+  // Standard C++ library header files
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#define TRACESPAN_CONCAT2(A, B) A ## B
+#define TRACESPAN_CONCAT(A, B) TRACESPAN_CONCAT2(A, B)
+#define TRACESPAN(...) WSd::tracing::CSpan TRACESPAN_CONCAT(traceSpan_, __LINE__)(__VA_ARGS__)
+
+namespace WSd
+{
+  namespace tracing
+  {
+    std::int64_t const NO_ARGUMENT = INT64_MIN;
+
+    extern std::atomic<bool> tracingEnabled;
+
+    /// @brief      Determines if tracing is enabled.
+    /// @returns    true if spans are being recorded.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    inline bool enabled()
+    {
+      return tracingEnabled.load(std::memory_order_relaxed);
+    }
+
+    /// @brief      Returns the monotonic clock in nanoseconds.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    inline std::uint64_t now()
+    {
+      return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void enable();
+    void disable();
+    void clear();
+    bool exportChromeTrace(std::string const &);
+    void recordSpan(char const *, std::uint64_t, std::uint64_t, std::int64_t);
+
+    /// @brief Scoped span. The span is only recorded if tracing was enabled when it was opened.
+
+    class CSpan
+    {
+    private:
+      char const *name;
+      std::int64_t argument;
+      std::uint64_t startTime;
+
+      CSpan(CSpan const &) = delete;
+      CSpan &operator=(CSpan const &) = delete;
+
+    public:
+      explicit CSpan(char const *n, std::int64_t a = NO_ARGUMENT) : name(n), argument(a), startTime(enabled() ? now() : 0) {}
+      ~CSpan()
+      {
+        if (startTime != 0)
+        {
+          recordSpan(name, startTime, now() - startTime, argument);
+        };
+      }
+    };
+
+  } // namespace tracing
+} // namespace WSd
+
+#endif // TRACER_H
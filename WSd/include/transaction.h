@@ -0,0 +1,260 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Transaction
+// SUBSYSTEM:						Console transactions
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Awaitables for writing console transactions as coroutines over an asynchronous socket. Each awaitable
+//                      suspends the coroutine until the socket signals the condition or the timeout expires. The coroutine is
+//                      always resumed from the event loop, never from within the signal that completed the wait.
+//                      CAsyncResult is awaited in the same way for work running on another thread. (eg the database thread) The
+//                      worker posts the resumption of the coroutine to the event loop when it completes.
+//                      Example:
+//                        if (co_await CConnectAwaiter(socket, host, port, 1000))
+//                        {
+//                          socket.write("TEST\n");
+//                          QByteArray response = co_await CReadAwaiter(socket, 6, 1000);
+//                        };
+//
+// HISTORY:             2026-10-19/GGB - CFutureAwaiter replaced by CAsyncResult, resumed by the worker.
+//                      2026-10-19/GGB - CFutureAwaiter added.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef TRANSACTION_H
+#define TRANSACTION_H
+
+  // Standard C++ library header files
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+  // Miscellaneous library header files
+
+#include <QAbstractSocket>
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QTimer>
+
+namespace WSd
+{
+  /// @brief Base class for the awaitables. Holds the timeout timer and resumes the coroutine from the event loop.
+
+  class CSocketAwaiter
+  {
+  private:
+    std::coroutine_handle<> awaiting;
+    bool finished = false;
+
+    CSocketAwaiter(CSocketAwaiter const &) = delete;
+    CSocketAwaiter &operator=(CSocketAwaiter const &) = delete;
+
+  protected:
+    QAbstractSocket &socket;
+    QTimer timer;
+    bool timedOut = false;
+
+    CSocketAwaiter(QAbstractSocket &, int);
+
+    void suspend(std::coroutine_handle<>);
+    void finish();
+
+  public:
+    bool await_ready() const noexcept { return false; }
+  };
+
+  /// @brief Connects the socket to a host. Any existing connection is aborted first, and the connection is aborted if it times out.
+  ///        Returns true if the connection succeeded.
+
+  class CConnectAwaiter : public CSocketAwaiter
+  {
+  private:
+    QString hostAddress;
+    std::uint16_t port;
+    bool connected = false;
+
+  public:
+    CConnectAwaiter(QAbstractSocket &, QString const &, std::uint16_t, int);
+
+    void await_suspend(std::coroutine_handle<>);
+    bool await_resume() const noexcept { return connected; }
+  };
+
+  /// @brief Reads exactly the specified number of bytes. On timeout or disconnection the bytes that have been received are
+  ///        returned, so the caller must check the size of the returned data.
+
+  class CReadAwaiter : public CSocketAwaiter
+  {
+  private:
+    qint64 size;
+
+  public:
+    CReadAwaiter(QAbstractSocket &, qint64, int);
+
+    bool await_ready() const { return (socket.bytesAvailable() >= size); }
+    void await_suspend(std::coroutine_handle<>);
+    QByteArray await_resume() { return socket.read(size); }
+  };
+
+  /// @brief Result of work running on another thread. (eg the database thread) The worker sets the result when the work is done
+  ///        and, if a coroutine is waiting for it, posts the resumption of the coroutine to the event loop, so nothing is polled.
+  ///        The result may be set before or after it is awaited. It is awaited by one coroutine at a time. Copies share the
+  ///        result. Awaiting returns the result. (Rethrows the exception of the work.)
+
+  template<typename T>
+  class CAsyncResult
+  {
+  private:
+    struct SState
+    {
+      std::mutex mutex;
+      std::condition_variable completed;
+      bool ready = false;
+      T value{};
+      std::exception_ptr exception;
+      std::coroutine_handle<> awaiting;
+    };
+
+    std::shared_ptr<SState> state;
+
+    /// @brief      Returns the result once it is ready.
+    /// @returns    The result.
+    /// @throws     The exception of the work.
+    /// @version    2026-10-19/GGB - Function created.
+
+    T result() const
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+
+      if (state->exception)
+      {
+        std::rethrow_exception(state->exception);
+      };
+
+      return state->value;
+    }
+
+  public:
+    CAsyncResult() : state(std::make_shared<SState>()) {}
+
+    /// @brief      Sets the result. Called by the worker. A coroutine waiting for the result is resumed from the event loop.
+    /// @param[in]  value: The result of the work.
+    /// @param[in]  exception: The exception thrown by the work. (nullptr if none)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void set(T value, std::exception_ptr exception = nullptr)
+    {
+      std::coroutine_handle<> handle;
+
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        state->value = std::move(value);
+        state->exception = exception;
+        state->ready = true;
+        handle = std::exchange(state->awaiting, nullptr);
+      }
+
+      state->completed.notify_all();
+
+      if (handle)
+      {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [handle]() { handle.resume(); }, Qt::QueuedConnection);
+      };
+    }
+
+    /// @brief      Runs the work and sets the result from its return value, or its exception. Called by the worker.
+    /// @param[in]  function: The work.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    template<typename F>
+    void run(F &function)
+    {
+      try
+      {
+        set(function());
+      }
+      catch (...)
+      {
+        set(T(), std::current_exception());
+      };
+    }
+
+    /// @brief      Determines if the result has been set, without waiting.
+    /// @returns    true if the result is ready.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool ready() const
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+
+      return state->ready;
+    }
+
+    /// @brief      Waits for the result, blocking the calling thread. Not used by the event loop while the work may be running.
+    /// @returns    The result.
+    /// @throws     The exception of the work.
+    /// @version    2026-10-19/GGB - Function created.
+
+    T wait() const
+    {
+      {
+        std::unique_lock<std::mutex> lock(state->mutex);
+
+        state->completed.wait(lock, [this]() { return state->ready; });
+      }
+
+      return result();
+    }
+
+    bool await_ready() const { return ready(); }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+
+      if (state->ready)
+      {
+        return false;                                         // Completed while suspending. Not suspended.
+      };
+
+      state->awaiting = handle;
+      return true;
+    }
+
+    T await_resume() const { return result(); }
+  };
+
+} // namespace WSd
+
+#endif // TRANSACTION_H
@@ -0,0 +1,76 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								weatherDatabase
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt, WCL
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Access to the weather database by the acquisition. MySQL databases are accessed through WCL. SQLite
+//                      databases, which WCL does not support, are accessed directly through a single long lived connection with
+//                      prepared statements and batched transactions. The database is only accessed from the database thread.
+//
+// HISTORY:             2026-10-19/GGB - Database accessed from the database thread.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef WEATHERDATABASE_H
+#define WEATHERDATABASE_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <functional>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+#include "include/transaction.h"
+
+namespace WSd
+{
+  namespace weatherDatabase
+  {
+    void connect(configuration::SDatabaseConfiguration const &);
+    void disconnect();
+
+    bool open();
+    void close();
+    CAsyncResult<bool> openAsync(configuration::SDatabaseConfiguration const &, bool);
+
+    CAsyncResult<bool> executeAsync(std::function<bool()>);
+
+    bool lastWeatherRecord(std::uint32_t, std::uint32_t, std::uint16_t &, std::uint16_t &);
+
+    void beginBatch();
+    bool endBatch();
+    bool insertRecord(std::uint32_t, std::uint32_t, TRawRecord const &, bool &);
+
+    bool partition(configuration::SConfiguration const &);
+    bool maintain(configuration::SConfiguration const &);
+    CAsyncResult<bool> maintainAsync(configuration::PConfiguration);
+
+  } // namespace weatherDatabase
+} // namespace WSd
+
+#endif // WEATHERDATABASE_H
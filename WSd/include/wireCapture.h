@@ -0,0 +1,103 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								wireCapture
+// SUBSYSTEM:						Transport
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Capture of the raw bytes exchanged with the console. Each record is stamped with the monotonic time since
+//                      the previous record, so that a session can be replayed with its original timing.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef WIRECAPTURE_H
+#define WIRECAPTURE_H
+
+  // Standard C++ library header files
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace WSd
+{
+  /// @brief Writes the bytes exchanged with the console to a capture file. The file starts with the magic "WSDW" and a version
+  ///        byte, and is followed by the records. A record is the type (1 byte), the time since the previous record (us) and the
+  ///        length of the data as LEB128 varints, and the data. Captures are appended to an existing file.
+
+  class CWireCapture
+  {
+  public:
+    enum ERecord : std::uint8_t
+    {
+      WR_CONNECT,                     ///< Connected to the console. The data is the transaction. ("readArchive", "setTime" ...)
+      WR_SENT,                        ///< Bytes written to the console.
+      WR_RECEIVED,                    ///< Bytes read from the console.
+      WR_DISCONNECT,                  ///< The connection was closed.
+    };
+
+    struct SRecord
+    {
+      ERecord type;
+      std::uint64_t delay;            ///< Time since the previous record. (us)
+      QByteArray data;
+    };
+
+  private:
+    static qsizetype const FLUSH_SIZE = 65536;
+
+    QFile file;
+    QByteArray buffer;
+    std::chrono::steady_clock::time_point previousTime;
+    bool firstRecord = true;
+
+    static void appendVarint(QByteArray &, std::uint64_t);
+    static bool readVarint(QByteArray const &, qsizetype &, std::uint64_t &);
+
+    CWireCapture(CWireCapture const &) = delete;
+    CWireCapture &operator=(CWireCapture const &) = delete;
+
+  protected:
+  public:
+    CWireCapture(QString const &);
+    ~CWireCapture();
+
+    bool open();
+    bool flush();
+    QString fileName() const { return file.fileName(); }
+
+    void record(ERecord, char const *, qint64);
+
+    static bool read(QString const &, std::vector<SRecord> &);
+  };
+
+} // namespace WSd
+
+#endif // WIRECAPTURE_H
@@ -0,0 +1,101 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								wireReplay
+// SUBSYSTEM:						Transport
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Deterministic replay of captured console sessions. A loopback server plays the console side of a capture
+//                      file to a CTCPSocket, either with the original timing or as fast as possible, and the latency and throughput
+//                      of the transactions are reported.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef WIREREPLAY_H
+#define WIREREPLAY_H
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+  // WSd header files
+
+#include "include/configuration.h"
+#include "include/wireCapture.h"
+
+namespace WSd
+{
+  /// @brief Plays the console side of captured sessions. Each connection accepted plays the next session of the capture. The bytes
+  ///        that were sent to the console are awaited (and compared), the bytes that were received from the console are sent.
+
+  class CReplayServer : public QTcpServer
+  {
+  private:
+    std::vector<CWireCapture::SRecord> const &records;
+    bool realTime;
+    std::size_t position = 0;                 // The next record to play.
+    QTcpSocket *connection = nullptr;
+    QByteArray pending;                       // Bytes received from the client that have not been matched.
+    QTimer delayTimer;
+    bool delayed = false;                     // The delay before the next record has elapsed.
+    std::uint64_t bytesSent = 0;
+    std::uint64_t mismatches = 0;
+    std::uint64_t sessionsAborted = 0;
+
+    void acceptConnection();
+    void closeConnection();
+    void skipSession();
+    void play();
+
+    CReplayServer(CReplayServer const &) = delete;
+    CReplayServer &operator=(CReplayServer const &) = delete;
+
+  protected:
+  public:
+    CReplayServer(std::vector<CWireCapture::SRecord> const &, bool);
+    ~CReplayServer();
+
+    std::uint64_t sent() const { return bytesSent; }
+    std::uint64_t mismatched() const { return mismatches; }
+    std::uint64_t aborted() const { return sessionsAborted; }
+  };
+
+  namespace wire
+  {
+    bool replay(QString const &, bool, configuration::SConfiguration const &, std::ostream &);
+
+  } // namespace wire
+} // namespace WSd
+
+#endif // WIREREPLAY_H
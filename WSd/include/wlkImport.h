@@ -0,0 +1,60 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								wlkImport
+// SUBSYSTEM:						Import
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Importer for the monthly archive files (.wlk) of the WeatherLink PC software. The files are memory mapped
+//                      and their days decoded in parallel into Rev B archive records, which are passed through the ingest pipeline.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#ifndef WLKIMPORT_H
+#define WLKIMPORT_H
+
+  // Standard C++ library header files
+
+#include <ostream>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QString>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/configuration.h"
+
+namespace WSd
+{
+  namespace wlk
+  {
+    bool import(std::vector<QString> const &, configuration::SConfiguration const &, std::ostream &);
+
+  } // namespace wlk
+} // namespace WSd
+
+#endif // WLKIMPORT_H
@@ -37,6 +37,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
   // Qt Library header files
 
@@ -57,46 +58,55 @@
 
   // WSd header files
 
-#include "include/settings.h"
+#include "include/configuration.h"
+#include "include/derived.h"
+#include "include/exporter.h"
+#include "include/logger.h"
 #include "include/service.h"
+#include "include/systemd.h"
+#include "include/tracer.h"
+#include "include/weatherDatabase.h"
+#include "include/wireReplay.h"
+#include "include/wlkImport.h"
 
 /// @brief Main function for the service.
 /// @param[in] argc: The number of command line arguments
 /// @param[in] argv: The command line arguments
 /// @returns
+/// @version 2026-10-19/GGB - Archive table partitioned with --partition.
+/// @version 2026-10-19/GGB - Runs in the foreground when started by systemd.
+/// @version 2026-10-19/GGB - Captured console sessions replayed with --replay.
+/// @version 2026-10-19/GGB - Station history exported with --export.
+/// @version 2026-10-19/GGB - WeatherLink .wlk files imported with --import.
+/// @version 2026-10-19/GGB - Derived quantity benchmark run with --benchmark.
+/// @version 2026-10-19/GGB - Span tracing enabled with --tracespans.
+/// @version 2026-10-19/GGB - Asynchronous logger started.
+/// @version 2026-10-19/GGB - Configuration parsed once into a typed snapshot. Settings only written with --writesettings.
 /// @version 2015-05-17/GGB - Function created.
 
 int main(int argc, char *argv[])
 {
   int returnValue = -1;
-
-  std::string ipaddr;
-  int port;
-  int pollInterval;
-  std::string dbDriver;
-  std::string dbIP;
-  int dbPort;
-  std::string dbName;
-  std::string dbUser;
-  std::string dbPassword;
-  unsigned long instrumentID;
-  unsigned long siteID;
+  std::string errorMessage;
 
   boost::program_options::options_description cmdLine("Allowed Options");
   cmdLine.add_options()
       ("help,h", "produce help message")
-      ("ipaddr", boost::program_options::value<std::string>(&ipaddr), "IP address of Weather Station")
-      ("port", boost::program_options::value<int>(&port)->default_value(22222), "port to use with the Weather Station <22222>")
-      ("pollinterval", boost::program_options::value<int>(&pollInterval)->default_value(5), "interval to poll the Weather Station <5>")
-      ("dbdriver", boost::program_options::value<std::string>(&dbDriver)->default_value("MYSQL"), "database type <MYSQL>")
-      ("dbip", boost::program_options::value<std::string>(&dbIP)->default_value("localhost"), "database host address <localhost>")
-      ("dbport", boost::program_options::value<int>(&dbPort)->default_value(3306), "database port <3306>")
-      ("dbname", boost::program_options::value<std::string>(&dbName)->default_value("WEATHER"), "database name <WEATHER>")
-      ("dbuser", boost::program_options::value<std::string>(&dbUser)->default_value("WEATHER"), "database username <WEATHER>")
-      ("dbpassword", boost::program_options::value<std::string>(&dbPassword)->default_value("WEATHER"), "database password <WEATHER>")
-      ("siteid", boost::program_options::value<unsigned long>(&siteID)->default_value(53), "site ID value")
-      ("instrumentid", boost::program_options::value<unsigned long>(&instrumentID)->default_value(1), "instrument ID value")
+      ;
+  WSd::configuration::addCommandLineOptions(cmdLine);
+  cmdLine.add_options()
       ("writesettings", "write the settings to conf file then exit.")
+      ("benchmark", "time the derived quantity kernels then exit.")
+      ("import", boost::program_options::value<std::vector<std::string>>()->multitoken(),
+       "import WeatherLink .wlk files (or directories of them) then exit.")
+      ("export", boost::program_options::value<std::string>(), "export the history of the station to a file then exit.")
+      ("from", boost::program_options::value<std::string>(), "start of the export. (YYYY-MM-DD[THH:MM])")
+      ("to", boost::program_options::value<std::string>(), "end of the export. (YYYY-MM-DD[THH:MM])")
+      ("format", boost::program_options::value<std::string>()->default_value("csv"), "format of the export. (csv|columnar)")
+      ("columns", boost::program_options::value<std::string>(), "comma separated columns to export. (Default all)")
+      ("partition", "partition the archive table by month (MySQL) then exit. (Run with the daemon stopped.)")
+      ("replay", boost::program_options::value<std::string>(), "replay the console sessions of a capture file then exit.")
+      ("replayfast", "replay as fast as possible rather than with the original timing.")
       ("install,i", "Install the service.")
       ("uninstall,u", "Uninstall the service.")
       ("exec,e", "Execute as standalone application.")
@@ -106,6 +116,7 @@ int main(int argc, char *argv[])
       ("version,v", "Display version and status information.")
       ("debug", "Display debug information.")
       ("trace", "Capture Trace Information.")
+      ("tracespans", "Record trace spans from startup. (Exported when the daemon stops.)")
       ;
 
   boost::program_options::variables_map vm;
@@ -119,32 +130,125 @@ int main(int argc, char *argv[])
     return 0;
   };
 
-  QSettings settings(WCL::settings::FILENAME, QSettings::IniFormat);
+    // Parse and validate the configuration once. The snapshot is shared read-only with all the subsystems.
 
-  settings.setValue(WCL::settings::WS_IPADDRESS, QVariant(QString::fromStdString(ipaddr)));
-  settings.setValue(WCL::settings::WS_PORT, QVariant(port));
-  settings.setValue(WCL::settings::WS_POLLINTERVAL, QVariant(pollInterval));
+  WSd::configuration::setCommandLine(vm);
+  WSd::configuration::PConfiguration configuration = WSd::configuration::load(errorMessage);
 
-  boost::to_upper(dbDriver);
-  settings.setValue(WCL::settings::WEATHER_DATABASE, QVariant(QString::fromStdString(dbDriver)));
+  if (!configuration)
+  {
+    std::cerr << "Invalid configuration: " << errorMessage << std::endl;
+    GCL::logger::defaultLogger().shutDown();
+    return -1;
+  };
 
-  if (dbDriver == "MYSQL")
+  if (vm.count("writesettings"))
   {
-    settings.setValue(WCL::settings::WEATHER_MYSQL_DRIVERNAME, QVariant(QCL::QDRV_MYSQL));
-    settings.setValue(WCL::settings::WEATHER_MYSQL_HOSTADDRESS, QVariant(QString::fromStdString(dbIP)));
-    settings.setValue(WCL::settings::WEATHER_MYSQL_PORT, QVariant(dbPort));
-    settings.setValue(WCL::settings::WEATHER_MYSQL_DATABASENAME, QVariant(QString::fromStdString(dbName)));
-    settings.setValue(WCL::settings::WEATHER_MYSQL_USERNAME, QVariant(QString::fromStdString(dbUser)));
-    settings.setValue(WCL::settings::WEATHER_MYSQL_PASSWORD, QVariant(QString::fromStdString(dbPassword)));
+    if (WSd::configuration::save(*configuration))
+    {
+      std::cout << "Settings written. Exiting" << std::endl;
+      returnValue = 0;
+    }
+    else
+    {
+      std::cerr << "Unable to write settings. Exiting" << std::endl;
+    };
+    GCL::logger::defaultLogger().shutDown();
+    return returnValue;
   };
 
-  if (vm.count("writeSettings"))
+  if (vm.count("benchmark"))
   {
-    std::cout << "Setting written exiting" << std::endl;
+    WSd::derived::benchmark(std::cout, 1 << 20, configuration->elevation);
     GCL::logger::defaultLogger().shutDown();
     return 0;
   };
 
+  if (vm.count("import"))
+  {
+    QCoreApplication application(argc, argv);       // Required by the database drivers.
+    std::vector<QString> paths;
+
+    for (std::string const &path : vm["import"].as<std::vector<std::string>>())
+    {
+      paths.push_back(QString::fromStdString(path));
+    };
+
+    WSd::configuration::install(configuration);
+    WSd::logging::setSeverity(true, true, true, true, false, false, false);
+    WSd::logging::start("WSd-import.log");
+
+    returnValue = WSd::wlk::import(paths, *configuration, std::cout) ? 0 : -1;
+
+    WSd::logging::stop();
+    GCL::logger::defaultLogger().shutDown();
+    return returnValue;
+  };
+
+  if (vm.count("export"))
+  {
+    QCoreApplication application(argc, argv);       // Required by the database drivers.
+    WSd::exporter::SExport parameters;
+
+    parameters.fileName = QString::fromStdString(vm["export"].as<std::string>());
+
+    if ( (vm.count("from") && !WSd::SArchiveRecord::parseTimeStamp(vm["from"].as<std::string>(), parameters.from)) ||
+         (vm.count("to") && !WSd::SArchiveRecord::parseTimeStamp(vm["to"].as<std::string>(), parameters.to)) ||
+         !WSd::exporter::parseFormat(vm["format"].as<std::string>(), parameters.format) ||
+         (vm.count("columns") && !WSd::exporter::parseColumns(vm["columns"].as<std::string>(), parameters.columns)) )
+    {
+      std::cerr << "Invalid export parameters." << std::endl;
+      GCL::logger::defaultLogger().shutDown();
+      return -1;
+    };
+
+    WSd::configuration::install(configuration);
+    WSd::logging::setSeverity(true, true, true, true, false, false, false);
+    WSd::logging::start("WSd-export.log");
+
+    returnValue = WSd::exporter::exportRange(parameters, *configuration, std::cout) ? 0 : -1;
+
+    WSd::logging::stop();
+    GCL::logger::defaultLogger().shutDown();
+    return returnValue;
+  };
+
+  if (vm.count("partition"))
+  {
+    QCoreApplication application(argc, argv);       // Required by the database drivers.
+
+    WSd::configuration::install(configuration);
+    WSd::logging::setSeverity(true, true, true, true, false, false, false);
+    WSd::logging::start("WSd-partition.log");
+
+    WSd::weatherDatabase::connect(configuration->database);
+    returnValue = WSd::weatherDatabase::partition(*configuration) ? 0 : -1;
+    WSd::weatherDatabase::disconnect();
+    std::cout << (returnValue == 0 ? "Archive table partitioned." : "Unable to partition the archive table.") << std::endl;
+
+    WSd::logging::stop();
+    GCL::logger::defaultLogger().shutDown();
+    return returnValue;
+  };
+
+  if (vm.count("replay"))
+  {
+    QCoreApplication application(argc, argv);       // Required by the sockets and the database drivers.
+
+    WSd::configuration::install(configuration);
+    WSd::logging::setSeverity(true, true, true, true, false, false, false);
+    WSd::logging::start("WSd-replay.log");
+
+    returnValue = WSd::wire::replay(QString::fromStdString(vm["replay"].as<std::string>()), !vm.count("replayfast"),
+                                    *configuration, std::cout) ? 0 : -1;
+
+    WSd::logging::stop();
+    GCL::logger::defaultLogger().shutDown();
+    return returnValue;
+  };
+
+  WSd::configuration::install(configuration);
+
       // Create the logger.
 
   GCL::logger::PLoggerSink fileLogger(new GCL::logger::CFileSink("", "WSd", ".log"));
@@ -164,21 +268,62 @@ int main(int argc, char *argv[])
 
   std::dynamic_pointer_cast<GCL::logger::CFileSink>(fileLogger)->openLogFile();
 
+    // The acquisition path logs through the asynchronous logger. Formatting and writing is done on its own thread.
+
+  if (vm.count("debug") && (vm.count("trace")))
+  {
+    WSd::logging::setSeverity(true, true, true, true, true, true, true);
+  }
+  else if (vm.count("debug"))
+  {
+    WSd::logging::setSeverity(true, true, true, true, true, true, false);
+  }
+  else
+  {
+    WSd::logging::setSeverity(true, true, true, true, false, false, false);
+  };
+
+  if (!WSd::logging::start("WSd-acquisition.log"))
+  {
+    std::clog << "Unable to open acquisition log file." << std::endl;
+  };
+
+  if (vm.count("tracespans"))
+  {
+    WSd::tracing::enable();
+  };
+
   GCL::logger::defaultLogger().addSink(fileLogger);
   GCL::logger::defaultLogger().logMessage(GCL::logger::debug, "File Logger Created.");
 
+    // When started by systemd the daemon runs in the foreground (Type=notify) rather than forking through the service controller.
+    // The service controller only looks at the first argument.
+
+  std::vector<char *> serviceArguments(argv, argv + argc);
+  static char execArgument[] = "-e";
+
+  WSd::systemd::initialise();
+
+  if (WSd::systemd::supervised() && !vm.count("install") && !vm.count("uninstall") && !vm.count("exec") &&
+      !vm.count("terminate") && !vm.count("pause") && !vm.count("resume") && !vm.count("version"))
+  {
+    serviceArguments.insert(serviceArguments.begin() + 1, execArgument);
+  };
+  serviceArguments.push_back(nullptr);
+
   try
   {
     GCL::logger::defaultLogger().logMessage(GCL::logger::notice, "Application starting.");
 
-    DEBUGMESSAGE("Creating Service");
-    WSd::service::CWSService service(argc, argv, siteID, instrumentID);
+    LOGDEBUG("Creating Service");
+    WSd::service::CWSService service(static_cast<int>(serviceArguments.size() - 1), serviceArguments.data());
 
-    DEBUGMESSAGE("Executing Service");
+    LOGDEBUG("Executing Service");
     returnValue = service.exec();
 
     GCL::logger::defaultLogger().logMessage(GCL::logger::notice, "Application Terminated. Return Value: " + std::to_string(returnValue));
 
+    WSd::logging::stop();
     GCL::logger::defaultLogger().shutDown();
     return returnValue;
 
@@ -207,6 +352,7 @@ int main(int argc, char *argv[])
     std::clog << "Application Terminated: Return Value: " << returnValue << std::endl;
   };
 
+  WSd::logging::stop();
   GCL::logger::defaultLogger().shutDown();
   return returnValue;
 }
@@ -0,0 +1,417 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								alertRules
+// SUBSYSTEM:						Alerts
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Alert rules. Threshold rules with a hold time and hysteresis, checked against every record as it is
+//                      ingested and against the LOOP packet read after each download. Events are passed to the subscribers
+//                      (read API) and to the command of the rule.
+//
+// HISTORY:             2026-10-19/GGB - LOOP packets checked. Alerts removed by a reload cleared.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/alertRules.h"
+
+  // Miscellaneous library header files
+
+#include <QDateTime>
+#include <QProcess>
+#include <QStringList>
+
+  // WSd header files
+
+#include "include/logger.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+  std::map<int, CAlertRules::TSubscriber> CAlertRules::subscribers;
+  int CAlertRules::nextSubscriber = 0;
+
+  /// @brief      Returns the current time as a station time stamp. (Local time, as used by the console.)
+  /// @returns    The current time.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::int64_t stationTime()
+  {
+    QDateTime now = QDateTime::currentDateTime();
+
+    return SArchiveRecord::makeTimeStamp(now.date().year(), now.date().month(), now.date().day(), now.time().hour(),
+                                         now.time().minute());
+  }
+
+  /// @brief      Constructor.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @param[in]  age: Maximum age (s) of a record that events are published for. (Records downloaded after an outage change
+  ///             the state of the alerts without publishing stale events.)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CAlertRules::CAlertRules(std::uint32_t sid, std::uint32_t iid, std::int64_t age)
+    : siteID(sid), instrumentID(iid), maximumAge(age)
+  {
+  }
+
+  /// @brief      Compiles a rule.
+  /// @param[in]  configuration: The rule.
+  /// @param[out] rule: The compiled rule.
+  /// @param[out] errorMessage: Description of the error if the rule is not valid.
+  /// @returns    true if the rule is valid.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CAlertRules::compile(configuration::SAlertRuleConfiguration const &configuration, SRule &rule, std::string &errorMessage)
+  {
+    QStringList tokens = configuration.rule.split(' ', Qt::SkipEmptyParts);
+    double raiseValue, clearValue;
+    bool ok;
+    std::size_t column;
+
+    rule = SRule();
+    rule.name = configuration.name;
+    rule.command = configuration.command;
+
+    if (configuration.name.isEmpty())
+    {
+      errorMessage = "Alert rule has no name.";
+      return false;
+    };
+
+    if ( (tokens.size() != 3) && (tokens.size() != 5) && (tokens.size() != 7) )
+    {
+      errorMessage = "Alert rule " + configuration.name.toStdString() + ": expected <column> <op> <value> [for <duration>] " +
+                     "[clear <value>].";
+      return false;
+    };
+
+    for (column = 0; column < COL_COUNT; column++)
+    {
+      if (tokens[0] == columnName(static_cast<EColumn>(column)))
+      {
+        break;
+      };
+    };
+    if (column == COL_COUNT)
+    {
+      errorMessage = "Alert rule " + configuration.name.toStdString() + ": unknown column " + tokens[0].toStdString() + ".";
+      return false;
+    };
+    rule.column = static_cast<EColumn>(column);
+
+    if (tokens[1] == ">")
+    {
+      rule.comparison = CMP_GREATER;
+    }
+    else if (tokens[1] == ">=")
+    {
+      rule.comparison = CMP_GREATER_EQUAL;
+    }
+    else if (tokens[1] == "<")
+    {
+      rule.comparison = CMP_LESS;
+    }
+    else if (tokens[1] == "<=")
+    {
+      rule.comparison = CMP_LESS_EQUAL;
+    }
+    else
+    {
+      errorMessage = "Alert rule " + configuration.name.toStdString() + ": unknown comparison " + tokens[1].toStdString() + ".";
+      return false;
+    };
+
+    raiseValue = tokens[2].toDouble(&ok);
+    if (!ok)
+    {
+      errorMessage = "Alert rule " + configuration.name.toStdString() + ": value not valid.";
+      return false;
+    };
+    clearValue = raiseValue;
+
+    for (int index = 3; index < tokens.size(); index += 2)
+    {
+      QString argument = tokens[index + 1];
+
+      if (tokens[index] == "for")
+      {
+        std::int64_t scale = 1;
+
+        if (argument.endsWith('h'))
+        {
+          scale = 3600;
+          argument.chop(1);
+        }
+        else if (argument.endsWith('m'))
+        {
+          scale = 60;
+          argument.chop(1);
+        }
+        else if (argument.endsWith('s'))
+        {
+          argument.chop(1);
+        };
+
+        rule.holdTime = argument.toLongLong(&ok) * scale;
+        if (!ok || (rule.holdTime < 0))
+        {
+          errorMessage = "Alert rule " + configuration.name.toStdString() + ": duration not valid.";
+          return false;
+        };
+      }
+      else if (tokens[index] == "clear")
+      {
+        clearValue = argument.toDouble(&ok);
+        if (!ok)
+        {
+          errorMessage = "Alert rule " + configuration.name.toStdString() + ": clear value not valid.";
+          return false;
+        };
+      }
+      else
+      {
+        errorMessage = "Alert rule " + configuration.name.toStdString() + ": unexpected " + tokens[index].toStdString() + ".";
+        return false;
+      };
+    };
+
+    if ( ((rule.comparison == CMP_GREATER || rule.comparison == CMP_GREATER_EQUAL) && (clearValue > raiseValue)) ||
+         ((rule.comparison == CMP_LESS || rule.comparison == CMP_LESS_EQUAL) && (clearValue < raiseValue)) )
+    {
+      errorMessage = "Alert rule " + configuration.name.toStdString() + ": clear value is on the wrong side of the value.";
+      return false;
+    };
+
+      // Convert the levels to console units. (All the conversions are linear with a positive scale.)
+
+    double offset = engineeringValue(rule.column, 0);
+    double scale = engineeringValue(rule.column, 1) - offset;
+
+    rule.raiseLevel = (raiseValue - offset) / scale;
+    rule.clearLevel = (clearValue - offset) / scale;
+
+    return true;
+  }
+
+  /// @brief      Checks that a rule is valid.
+  /// @param[in]  configuration: The rule.
+  /// @param[out] errorMessage: Description of the error if the rule is not valid.
+  /// @returns    true if the rule is valid.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CAlertRules::validate(configuration::SAlertRuleConfiguration const &configuration, std::string &errorMessage)
+  {
+    SRule rule;
+
+    return compile(configuration, rule, errorMessage);
+  }
+
+  /// @brief      Replaces the rules. A rule that is unchanged (same name and condition) keeps the state of its alert. An alert
+  ///             that is raised and whose rule is removed or changed is cleared, and the clear is published.
+  /// @param[in]  configurations: The new rules. Rules that are not valid are logged and ignored.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - State of unchanged rules kept. Alerts of removed or changed rules cleared and published.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CAlertRules::setRules(std::vector<configuration::SAlertRuleConfiguration> const &configurations)
+  {
+    std::string errorMessage;
+    std::vector<SRule> previousRules = std::move(rules);
+
+    rules.clear();
+    rules.reserve(configurations.size());
+
+    for (configuration::SAlertRuleConfiguration const &configuration : configurations)
+    {
+      SRule rule;
+
+      if (compile(configuration, rule, errorMessage))
+      {
+        for (SRule &previousRule : previousRules)
+        {
+          if ( (previousRule.name == rule.name) && previousRule.sameCondition(rule) )
+          {
+            rule.active = previousRule.active;
+            rule.pendingSince = previousRule.pendingSince;
+            rule.lastValue = previousRule.lastValue;
+            previousRule.active = false;          // Carried over. Not cleared below.
+            break;
+          };
+        };
+
+        rules.push_back(rule);
+      }
+      else
+      {
+        LOGERROR("{}", errorMessage);
+      };
+    };
+
+    for (SRule &previousRule : previousRules)
+    {
+      if (previousRule.active)
+      {
+        previousRule.active = false;
+        publish(previousRule, stationTime(), previousRule.lastValue);
+      };
+    };
+  }
+
+  /// @brief      Checks a record against the rules and publishes the alerts that are raised or cleared. Values that are missing
+  ///             or flagged by the quality control are skipped; they do not change the state of an alert or restart its hold
+  ///             time. Records that are not newer than the last record checked are ignored.
+  /// @param[in]  record: The decoded record, or the current conditions of a LOOP packet.
+  /// @param[in]  period: The time covered by the record, ending at its time stamp. (s. The archive period, 0 for a LOOP
+  ///             packet or if the archive period is not known.)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Period of the record counted in the hold time. Missing and flagged values skipped.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CAlertRules::evaluate(SArchiveRecord const &record, std::int64_t period)
+  {
+    if (record.timeStamp <= lastTimeStamp)
+    {
+      return;
+    };
+    lastTimeStamp = record.timeStamp;
+
+    for (SRule &rule : rules)
+    {
+      if (!record.isGood(rule.column))
+      {
+        continue;
+      };
+
+      rule.lastValue = record.value(rule.column);
+
+      if (!rule.active)
+      {
+        if (meets(rule.comparison, record.values[rule.column], rule.raiseLevel))
+        {
+            // The condition has held since the start of the period covered by the first record that met it.
+
+          if (rule.pendingSince == INT64_MIN)
+          {
+            rule.pendingSince = record.timeStamp - period;
+          };
+          if (record.timeStamp - rule.pendingSince >= rule.holdTime)
+          {
+            rule.active = true;
+            publish(rule, record.timeStamp, rule.lastValue);
+          };
+        }
+        else
+        {
+          rule.pendingSince = INT64_MIN;
+        };
+      }
+      else if (!meets(rule.comparison, record.values[rule.column], rule.clearLevel))
+      {
+        rule.active = false;
+        rule.pendingSince = INT64_MIN;
+        publish(rule, record.timeStamp, rule.lastValue);
+      };
+    };
+  }
+
+  /// @brief      Publishes a change of the state of an alert to the subscribers and runs the command of the rule. The command
+  ///             is run with the arguments: name, raised|cleared, value and time stamp.
+  /// @param[in]  rule: The rule that changed state.
+  /// @param[in]  timeStamp: The time of the record that changed the state. (The current time for a rule that was removed.)
+  /// @param[in]  value: The value that changed the state. (SI units. The last value checked for a rule that was removed.)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Time stamp and value passed, so that the alerts of removed rules can be cleared.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CAlertRules::publish(SRule const &rule, std::int64_t timeStamp, double value)
+  {
+    SAlertEvent event { siteID, instrumentID, rule.name, rule.active, timeStamp, rule.column, value };
+
+    if (timeStamp < stationTime() - maximumAge)
+    {
+      LOGDEBUG("Alert {} {} by an old record. Not published.", rule.name.toStdString(), rule.active ? "raised" : "cleared");
+      return;
+    };
+
+    TRACESPAN("publishAlert");
+
+    LOGINFO("Alert {} {}: {} = {}.", rule.name.toStdString(), rule.active ? "raised" : "cleared", columnName(rule.column),
+            event.value);
+
+      // A subscriber may unsubscribe itself from the callback.
+
+    for (auto iterator = subscribers.begin(); iterator != subscribers.end(); )
+    {
+      auto current = iterator++;
+
+      current->second(event);
+    };
+
+    QStringList arguments = QProcess::splitCommand(rule.command);
+
+    if (!arguments.isEmpty())
+    {
+      QString program = arguments.takeFirst();
+
+      arguments << rule.name << (rule.active ? "raised" : "cleared") << QString::number(event.value)
+                << QString::number(timeStamp);
+
+      if (!QProcess::startDetached(program, arguments))
+      {
+        LOGERROR("Unable to run the command of alert {}: {}", rule.name.toStdString(), program.toStdString());
+      };
+    };
+  }
+
+  /// @brief      Adds a subscriber. The subscriber is called for each alert that is raised or cleared, on the thread that
+  ///             ingests the records.
+  /// @param[in]  subscriber: The function to call.
+  /// @returns    The ID of the subscription.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  int CAlertRules::subscribe(TSubscriber subscriber)
+  {
+    int id = nextSubscriber++;
+
+    subscribers[id] = std::move(subscriber);
+
+    return id;
+  }
+
+  /// @brief      Removes a subscriber.
+  /// @param[in]  id: The ID of the subscription.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CAlertRules::unsubscribe(int id)
+  {
+    subscribers.erase(id);
+  }
+
+} // namespace WSd
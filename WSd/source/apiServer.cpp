@@ -0,0 +1,1305 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								ApiServer
+// SUBSYSTEM:						Read API
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            HTTP/JSON read API. Serves the stations being acquired, the latest record of a station, ranges of records
+//                      (JSON or a compact binary format), the hourly and daily rollups and the replication journal. Recent data is
+//                      served from the in memory window, older data from the local store and data that is not held locally from the
+//                      weather database. Range responses are streamed one slice at a time through a pre-sized buffer.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/apiServer.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+  // Miscellaneous library header files
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QPointer>
+#include <QStringList>
+#include <QUrl>
+#include <QUrlQuery>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+  // WSd header files
+
+#include "include/executor.h"
+#include "include/ingest.h"
+#include "include/logger.h"
+#include "include/receptionLog.h"
+#include "include/rollups.h"
+#include "include/sqlArchive.h"
+#include "include/systemd.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+  static char const *const CONTENT_JSON = "application/json";
+  static char const *const CONTENT_BINARY = "application/octet-stream";
+  static char const *const CONTENT_EVENTS = "text/event-stream";
+  static char const *const CONTENT_METRICS = "text/plain; version=0.0.4";
+  static char const BINARY_MAGIC[4] = { 'W', 'S', 'D', 'B' };
+  static std::uint8_t const BINARY_VERSION = 1;
+  static char const REPLICATION_MAGIC[4] = { 'W', 'S', 'D', 'L' };
+  static std::uint8_t const REPLICATION_VERSION = 1;
+  static char const *const DATABASE_FAILED = "Weather database could not be read.";
+
+  static std::atomic<std::uint32_t> databaseReads = 0;           // Numbers the connections of the database reads.
+
+  /// @brief      Returns the reason phrase of a HTTP status code.
+  /// @param[in]  status: The status code.
+  /// @returns    The reason phrase.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static char const *reasonPhrase(int status)
+  {
+    switch (status)
+    {
+      case 200:
+        return "OK";
+      case 400:
+        return "Bad Request";
+      case 404:
+        return "Not Found";
+      case 405:
+        return "Method Not Allowed";
+      case 431:
+        return "Request Header Fields Too Large";
+      case 503:
+        return "Service Unavailable";
+      default:
+        return "Internal Server Error";
+    };
+  }
+
+  /// @brief      Appends a little endian integer to a buffer.
+  /// @param[in]  buffer: The buffer to append to.
+  /// @param[in]  value: The value.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  template<typename T>
+  static void appendLittleEndian(QByteArray &buffer, T value)
+  {
+    char bytes[sizeof(T)];
+
+    for (std::size_t index = 0; index < sizeof(T); index++)
+    {
+      bytes[index] = static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * index)) & 0xFF);
+    };
+
+    buffer.append(bytes, sizeof(T));
+  }
+
+  //*******************************************************************************************************************************
+  //
+  // CApiConnection
+  //
+  //*******************************************************************************************************************************
+
+  /// @brief      Constructor. The connection owns the socket and deletes itself when the socket is disconnected.
+  /// @param[in]  s: The socket of the connection.
+  /// @param[in]  c: The configuration snapshot. (Used for the database fallback.)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CApiConnection::CApiConnection(QTcpSocket *s, configuration::PConfiguration c) : QObject(nullptr), socket(s), configuration(c)
+  {
+    socket->setParent(this);
+    buffer.reserve(BUFFER_SIZE);
+
+    connect(socket, SIGNAL(readyRead()), this, SLOT(readRequest()));
+    connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(continueStreaming(qint64)));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(deleteLater()));
+  }
+
+  /// @brief      Destructor. Ends the alert subscription.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Database reads use connections of their own.
+  /// @version    2026-10-19/GGB - Alert subscription ended.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CApiConnection::~CApiConnection()
+  {
+    if (alertSubscription >= 0)
+    {
+      CAlertRules::unsubscribe(alertSubscription);
+    };
+  }
+
+  /// @brief      Slot called when request data is available. The request is handled once the header is complete.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::readRequest()
+  {
+    if (requestComplete)
+    {
+      socket->readAll();              // Only one request is served. Anything else is discarded.
+      return;
+    };
+
+    request.append(socket->readAll());
+
+    int end = request.indexOf("\r\n\r\n");
+
+    if (end < 0)
+    {
+      if (request.size() > MAX_REQUEST_SIZE)
+      {
+        requestComplete = true;
+        sendError(431, "Request header too large.");
+      };
+      return;
+    };
+
+    QByteArray requestLine = request.left(request.indexOf("\r\n"));
+    QList<QByteArray> parts = requestLine.split(' ');
+
+    requestComplete = true;
+    request.clear();
+
+    if (parts.size() != 3)
+    {
+      sendError(400, "Malformed request line.");
+    }
+    else
+    {
+      handleRequest(parts[0], parts[1]);
+    };
+  }
+
+  /// @brief      Dispatches a request to its handler.
+  /// @param[in]  method: The request method.
+  /// @param[in]  target: The request target. (Path and query.)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Replication journal added.
+  /// @version    2026-10-19/GGB - Reception diagnostics and metrics added.
+  /// @version    2026-10-19/GGB - Alerts added.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::handleRequest(QByteArray const &method, QByteArray const &target)
+  {
+    TRACESPAN("apiRequest");
+
+    LOGDEBUG("API request: {} {}", method.toStdString(), target.toStdString());
+
+    if (method != "GET")
+    {
+      sendError(405, "Only GET is supported.");
+      return;
+    };
+
+    QUrl url(QString::fromLatin1(target));
+    QStringList path = url.path().split('/', Qt::SkipEmptyParts);
+    QUrlQuery query(url);
+
+    if ( (path.size() == 1) && (path[0] == "stations") )
+    {
+      sendStations();
+    }
+    else if ( (path.size() == 1) && (path[0] == "alerts") )
+    {
+      startAlerts();
+    }
+    else if ( (path.size() == 1) && (path[0] == "metrics") )
+    {
+      sendMetrics();
+    }
+    else if ( (path.size() == 3) && (path[0] == "stations") && parseStation(path[1], siteID, instrumentID) )
+    {
+      if (path[2] == "latest")
+      {
+        sendLatest();
+      }
+      else if (path[2] == "range")
+      {
+        startRange(query.query());
+      }
+      else if (path[2] == "rollups")
+      {
+        sendRollups(query.query());
+      }
+      else if (path[2] == "reception")
+      {
+        sendReception(query.query());
+      }
+      else if (path[2] == "replication")
+      {
+        sendReplication(query.query());
+      }
+      else
+      {
+        sendError(404, "Unknown resource.");
+      };
+    }
+    else
+    {
+      sendError(404, "Unknown resource.");
+    };
+  }
+
+  /// @brief      Sends a complete response and closes the connection.
+  /// @param[in]  status: The HTTP status code.
+  /// @param[in]  contentType: The content type of the body.
+  /// @param[in]  body: The body.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendResponse(int status, char const *contentType, QByteArray const &body)
+  {
+    QByteArray header;
+
+    header.reserve(160);
+    header.append("HTTP/1.1 ").append(QByteArray::number(status)).append(' ').append(reasonPhrase(status)).append("\r\n");
+    header.append("Content-Type: ").append(contentType).append("\r\n");
+    header.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n");
+    header.append("Connection: close\r\n\r\n");
+
+    socket->write(header);
+    socket->write(body);
+    socket->disconnectFromHost();
+  }
+
+  /// @brief      Sends an error response.
+  /// @param[in]  status: The HTTP status code.
+  /// @param[in]  message: Description of the error.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendError(int status, QString const &message)
+  {
+    QByteArray text = message.toUtf8();
+
+    text.replace('\\', "\\\\").replace('"', "\\\"");
+
+    QByteArray body = "{\"error\":\"" + text + "\"}";
+
+    sendResponse(status, CONTENT_JSON, body);
+  }
+
+  /// @brief      Sends the list of stations being acquired.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendStations()
+  {
+    QByteArray body = "{\"stations\":[";
+    bool first = true;
+
+    for (CIngest::TStationKey const &key : CIngest::stations())
+    {
+      CIngest const *station = CIngest::find(key.first, key.second);
+      CRecentWindow const &window = station->recentWindow();
+
+      if (!first)
+      {
+        body.append(',');
+      };
+      first = false;
+
+      body.append("{\"id\":\"").append(QByteArray::number(key.first)).append('-').append(QByteArray::number(key.second));
+      body.append("\",\"site\":").append(QByteArray::number(key.first));
+      body.append(",\"instrument\":").append(QByteArray::number(key.second));
+      body.append(",\"latest\":");
+      if (window.empty())
+      {
+        body.append("null");
+      }
+      else
+      {
+        body.append('"');
+        appendTime(body, window.latest().timeStamp);
+        body.append('"');
+      };
+      body.append(",\"localStore\":").append(station->localStore() ? "true" : "false");
+      body.append('}');
+    };
+
+    body.append("]}");
+
+    sendResponse(200, CONTENT_JSON, body);
+  }
+
+  /// @brief      Sends the latest record of a station. The record is taken from the recent window, the local store or the
+  ///             database, in that order. The database is read on the executor.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Database read on the executor.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendLatest()
+  {
+    CIngest const *station = CIngest::find(siteID, instrumentID);
+
+    if (station && !station->recentWindow().empty())
+    {
+      sendRecord(station->recentWindow().latest());
+    }
+    else if (station && station->localStore() && (station->localStore()->recordCount() != 0))
+    {
+      CTimeSeriesStore const *store = station->localStore();
+      SArchiveRecord record;
+      bool found = false;
+
+      store->scan(store->lastTime(), store->lastTime(), [&](SArchiveRecord const &r)
+      {
+        record = r;
+        found = true;
+        return false;
+      });
+
+      latestRead(true, found, record);
+    }
+    else
+    {
+      readLatest();
+    };
+  }
+
+  /// @brief      Reads the latest record of the station from the database on the executor. As for readDatabase(), the read
+  ///             uses its own connection and the result is passed back to the connection on the event loop.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::readLatest()
+  {
+    QPointer<CApiConnection> connection(this);
+    configuration::SDatabaseConfiguration database = configuration->database;
+    QString connectionName = QString("WSd-API-read-%1").arg(++databaseReads);
+    std::uint32_t site = siteID;
+    std::uint32_t instrument = instrumentID;
+
+    CExecutor::global().submit([connection, database, connectionName, site, instrument]()
+    {
+      TRACESPAN("apiLatestRead");
+
+      SArchiveRecord record;
+      bool found = false;
+      bool succeeded = false;
+
+      try
+      {
+        succeeded = sql::openConnection(connectionName, database) &&
+                    sql::lastRecord(connectionName, site, instrument, record, found);
+      }
+      catch (std::exception const &e)
+      {
+        LOGERROR("API database read failed: {}", e.what());
+        succeeded = false;
+      };
+      sql::closeConnection(connectionName);
+
+      QMetaObject::invokeMethod(QCoreApplication::instance(), [connection, succeeded, found, record]()
+      {
+        if (connection)
+        {
+          connection->latestRead(succeeded, found, record);
+        };
+      }, Qt::QueuedConnection);
+    });
+  }
+
+  /// @brief      Called when the latest record has been read. Sends the record, or an error if there is none.
+  /// @param[in]  succeeded: false if the source could not be read.
+  /// @param[in]  found: true if the station has a record.
+  /// @param[in]  record: The record.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::latestRead(bool succeeded, bool found, SArchiveRecord const &record)
+  {
+    if (!succeeded)
+    {
+      sendError(503, DATABASE_FAILED);
+    }
+    else if (!found)
+    {
+      sendError(404, "No records for the station.");
+    }
+    else
+    {
+      sendRecord(record);
+    };
+  }
+
+  /// @brief      Sends a single record with all the columns.
+  /// @param[in]  record: The record.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendRecord(SArchiveRecord const &record)
+  {
+    for (std::size_t column = 0; column < COL_COUNT; column++)
+    {
+      columns.push_back(static_cast<EColumn>(column));
+    };
+
+    appendRecord(record);
+
+    sendResponse(200, CONTENT_JSON, buffer);
+  }
+
+  /// @brief      Sends the rollups of a station. Query: period=hourly|daily, from, to.
+  /// @param[in]  queryString: The query of the request.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendRollups(QString const &queryString)
+  {
+    QUrlQuery query(queryString);
+    CIngest const *station = CIngest::find(siteID, instrumentID);
+    ERollupPeriod period = RP_HOUR;
+    std::int64_t from = INT64_MIN;
+    std::int64_t to = INT64_MAX;
+
+    if (query.queryItemValue("period") == "daily")
+    {
+      period = RP_DAY;
+    }
+    else if (query.hasQueryItem("period") && (query.queryItemValue("period") != "hourly"))
+    {
+      sendError(400, "period must be hourly or daily.");
+      return;
+    };
+
+    if ( (query.hasQueryItem("from") && !SArchiveRecord::parseTimeStamp(query.queryItemValue("from").toStdString(), from)) ||
+         (query.hasQueryItem("to") && !SArchiveRecord::parseTimeStamp(query.queryItemValue("to").toStdString(), to)) )
+    {
+      sendError(400, "Invalid time.");
+      return;
+    };
+
+    if (!station || !station->localRollups())
+    {
+      sendError(404, "Rollups are not available for the station.");
+      return;
+    };
+
+    std::vector<SRollup> rollups = station->localRollups()->query(period, from, to);
+
+    buffer.append("{\"period\":\"").append(CRollups::periodName(period)).append("\",\"buckets\":[");
+
+    for (std::size_t index = 0; index < rollups.size(); index++)
+    {
+      SRollup const &rollup = rollups[index];
+
+      buffer.append((index == 0) ? "{\"start\":\"" : ",{\"start\":\"");
+      appendTime(buffer, rollup.start);
+      buffer.append('"');
+
+      for (std::size_t measure = 0; measure < RM_COUNT; measure++)
+      {
+        SAggregate const &aggregate = rollup.measures[measure];
+        EColumn column = CRollups::measureColumn(static_cast<ERollupMeasure>(measure));
+
+        buffer.append(",\"").append(CRollups::measureName(static_cast<ERollupMeasure>(measure))).append("\":");
+        if (aggregate.count == 0)
+        {
+          buffer.append("null");
+        }
+        else
+        {
+          buffer.append("{\"min\":");
+          appendNumber(buffer, engineeringValue(column, aggregate.minimum));
+          buffer.append(",\"max\":");
+          appendNumber(buffer, engineeringValue(column, aggregate.maximum));
+          if (measure == RM_RAINFALL)
+          {
+            buffer.append(",\"sum\":");
+            appendNumber(buffer, engineeringValue(column, static_cast<double>(aggregate.sum)));
+          }
+          else
+          {
+            buffer.append(",\"mean\":");
+            appendNumber(buffer, engineeringValue(column, aggregate.mean()));
+          };
+          buffer.append(",\"count\":").append(QByteArray::number(aggregate.count)).append('}');
+        };
+      };
+      buffer.append('}');
+    };
+
+    buffer.append("]}");
+
+    sendResponse(200, CONTENT_JSON, buffer);
+  }
+
+  /// @brief      Sends the reception diagnostics of a station. Query: from, to (seconds since 1970, UTC), packets=true to include
+  ///             the raw packets. Times in the response are ms since 1970. The part of the reception file that holds the range
+  ///             is read on the executor, and the response is sent by receptionRead().
+  /// @param[in]  queryString: The query of the request.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Only the part of the file that holds the range is read, on the executor.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendReception(QString const &queryString)
+  {
+    QUrlQuery query(queryString);
+    CReceptionLog const *reception = CReceptionLog::find(siteID, instrumentID);
+    std::int64_t from = INT64_MIN / 1000;
+    std::int64_t to = INT64_MAX / 1000;
+
+    if ( (query.hasQueryItem("from") && !SArchiveRecord::parseTimeStamp(query.queryItemValue("from").toStdString(), from)) ||
+         (query.hasQueryItem("to") && !SArchiveRecord::parseTimeStamp(query.queryItemValue("to").toStdString(), to)) )
+    {
+      sendError(400, "Invalid time.");
+      return;
+    };
+
+    if (!reception)
+    {
+      sendError(404, "Reception diagnostics are not available for the station.");
+      return;
+    };
+
+    QPointer<CApiConnection> connection(this);
+    CReceptionLog::SRange range = reception->range(from * 1000, to * 1000 + 999);
+    bool includePackets = (query.queryItemValue("packets") == "true");
+
+    CExecutor::global().submit([connection, range, from, to, includePackets]()
+    {
+      TRACESPAN("apiReceptionRead");
+
+      std::vector<SReceptionSample> samples;
+      std::vector<SRadioPacket> packets;
+      bool found;
+
+      try
+      {
+        found = CReceptionLog::read(range, from * 1000, to * 1000 + 999, samples, packets);
+      }
+      catch (std::exception const &e)
+      {
+        LOGERROR("API reception read failed: {}", e.what());
+        found = false;
+      };
+
+      QMetaObject::invokeMethod(QCoreApplication::instance(),
+                                [connection, found, samples = std::move(samples), packets = std::move(packets),
+                                 includePackets]() mutable
+      {
+        if (connection)
+        {
+          connection->receptionRead(found, std::move(samples), std::move(packets), includePackets);
+        };
+      }, Qt::QueuedConnection);
+    });
+  }
+
+  /// @brief      Called on the event loop when the reception diagnostics have been read. Sends the response.
+  /// @param[in]  found: The reception file was read.
+  /// @param[in]  samples: The samples in the range.
+  /// @param[in]  packets: The packets in the range.
+  /// @param[in]  includePackets: The packets are included in the response.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created. (From sendReception())
+
+  void CApiConnection::receptionRead(bool found, std::vector<SReceptionSample> &&samples, std::vector<SRadioPacket> &&packets,
+                                     bool includePackets)
+  {
+    if (!found)
+    {
+      sendError(404, "Reception diagnostics are not available for the station.");
+      return;
+    };
+
+    buffer.append("{\"samples\":[");
+    for (std::size_t index = 0; index < samples.size(); index++)
+    {
+      SReceptionSample const &sample = samples[index];
+
+      buffer.append((index == 0) ? "{\"time\":" : ",{\"time\":").append(QByteArray::number(sample.timeStamp));
+      buffer.append(",\"packets\":").append(QByteArray::number(sample.packets));
+      buffer.append(",\"missed\":").append(QByteArray::number(sample.missed));
+      buffer.append(",\"resyncs\":").append(QByteArray::number(sample.resyncs));
+      buffer.append(",\"maxInARow\":").append(QByteArray::number(sample.maxInARow));
+      buffer.append(",\"crcErrors\":").append(QByteArray::number(sample.crcErrors)).append('}');
+    };
+    buffer.append(']');
+
+    if (includePackets)
+    {
+      buffer.append(",\"packets\":[");
+      for (std::size_t index = 0; index < packets.size(); index++)
+      {
+        buffer.append((index == 0) ? "{\"time\":" : ",{\"time\":").append(QByteArray::number(packets[index].timeStamp));
+        buffer.append(",\"data\":\"");
+        buffer.append(QByteArray(reinterpret_cast<char const *>(packets[index].data.data()),
+                                 static_cast<qsizetype>(packets[index].data.size())).toHex());
+        buffer.append("\"}");
+      };
+      buffer.append(']');
+    };
+
+    buffer.append('}');
+
+    sendResponse(200, CONTENT_JSON, buffer);
+  }
+
+  /// @brief      Sends the metrics of the daemon in the Prometheus text format.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendMetrics()
+  {
+    CReceptionLog::metrics(buffer);
+
+    sendResponse(200, CONTENT_METRICS, buffer);
+  }
+
+  /// @brief      Sends the entries of the replication journal of a station that follow a sequence number. Query: after (the last
+  ///             sequence number applied, 0 for none), limit. The response is binary: magic "WSDL", version, the epoch of the
+  ///             journal (int64), the last sequence number in the journal (uint64), the sequence number of the first entry
+  ///             (uint64) and the number of entries (uint32), all little endian, followed by the raw archive records.
+  /// @param[in]  queryString: The query of the request.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendReplication(QString const &queryString)
+  {
+    QUrlQuery query(queryString);
+    CIngest const *station = CIngest::find(siteID, instrumentID);
+    CReplicationJournal *journal = station ? station->replicationJournal() : nullptr;
+    std::vector<TRawRecord> records;
+    std::uint64_t after = 0;
+    std::size_t limit = REPLICATION_RECORDS;
+    bool valid = true;
+
+    if (query.hasQueryItem("after"))
+    {
+      after = query.queryItemValue("after").toULongLong(&valid);
+    };
+    if (valid && query.hasQueryItem("limit"))
+    {
+      limit = std::min<std::size_t>(query.queryItemValue("limit").toUInt(&valid), REPLICATION_RECORDS);
+    };
+    if (!valid)
+    {
+      sendError(400, "after and limit must be numbers.");
+      return;
+    };
+
+    if (!journal)
+    {
+      sendError(404, "Replication journal is not available for the station.");
+      return;
+    };
+
+    if (!journal->read(after, limit, records))
+    {
+      sendError(500, "Replication journal could not be read.");
+      return;
+    };
+
+    buffer.append(REPLICATION_MAGIC, sizeof(REPLICATION_MAGIC));
+    buffer.append(static_cast<char>(REPLICATION_VERSION));
+    appendLittleEndian<std::int64_t>(buffer, journal->epoch());
+    appendLittleEndian<std::uint64_t>(buffer, journal->lastSequence());
+    appendLittleEndian<std::uint64_t>(buffer, after + 1);
+    appendLittleEndian<std::uint32_t>(buffer, static_cast<std::uint32_t>(records.size()));
+
+    for (TRawRecord const &record : records)
+    {
+      buffer.append(reinterpret_cast<char const *>(record.data()), static_cast<qsizetype>(record.size()));
+    };
+
+    sendResponse(200, CONTENT_BINARY, buffer);
+  }
+
+  /// @brief      Starts a range response. Query: from, to, columns (comma separated names), format=json|binary. The header is
+  ///             sent immediately and the records are streamed as the socket drains.
+  /// @param[in]  queryString: The query of the request.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::startRange(QString const &queryString)
+  {
+    QUrlQuery query(queryString);
+
+    if (!query.hasQueryItem("from") || !SArchiveRecord::parseTimeStamp(query.queryItemValue("from").toStdString(), nextTime))
+    {
+      sendError(400, "from is required.");
+      return;
+    };
+
+    endTime = INT64_MAX;
+    if (query.hasQueryItem("to") && !SArchiveRecord::parseTimeStamp(query.queryItemValue("to").toStdString(), endTime))
+    {
+      sendError(400, "Invalid time.");
+      return;
+    };
+    nextTime = std::max<std::int64_t>(nextTime, 0);
+
+    if (query.queryItemValue("format") == "binary")
+    {
+      format = FMT_BINARY;
+    }
+    else if (query.hasQueryItem("format") && (query.queryItemValue("format") != "json"))
+    {
+      sendError(400, "format must be json or binary.");
+      return;
+    };
+
+    if (query.hasQueryItem("columns"))
+    {
+      for (QString const &name : query.queryItemValue("columns").split(',', Qt::SkipEmptyParts))
+      {
+        std::size_t column = 0;
+
+        while ( (column < COL_COUNT) && (name != columnName(static_cast<EColumn>(column))) )
+        {
+          column++;
+        };
+
+        if (column == COL_COUNT)
+        {
+          sendError(400, "Unknown column " + name + ".");
+          return;
+        };
+        columns.push_back(static_cast<EColumn>(column));
+      };
+    }
+    else
+    {
+      for (std::size_t column = 0; column < COL_COUNT; column++)
+      {
+        columns.push_back(static_cast<EColumn>(column));
+      };
+    };
+
+      // The length of the body is not known, so the body is delimited by closing the connection.
+
+    buffer.append("HTTP/1.1 200 OK\r\nContent-Type: ").append((format == FMT_JSON) ? CONTENT_JSON : CONTENT_BINARY);
+    buffer.append("\r\nConnection: close\r\n\r\n");
+
+    if (format == FMT_JSON)
+    {
+      buffer.append("{\"site\":").append(QByteArray::number(siteID));
+      buffer.append(",\"instrument\":").append(QByteArray::number(instrumentID)).append(",\"records\":[");
+    }
+    else
+    {
+      buffer.append(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+      buffer.append(static_cast<char>(BINARY_VERSION));
+      buffer.append(static_cast<char>(columns.size()));
+      for (EColumn column : columns)
+      {
+        buffer.append(static_cast<char>(column));
+      };
+    };
+
+    streaming = true;
+    continueStreaming(0);
+  }
+
+  /// @brief      Slot called when data has been written to the socket. Generates slices of the range response until the socket
+  ///             has enough data waiting, the range is complete or a database read is running. Nothing is written while the
+  ///             first database read is running, so that a failed read can still be answered with an error status.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Response held back until the first database read has completed.
+  /// @version    2026-10-19/GGB - Stops while a database read is running.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::continueStreaming(qint64)
+  {
+    if (!streaming || databaseReading || (socket->bytesToWrite() > LOW_WATER))
+    {
+      return;
+    };
+
+    bool more = true;
+
+    while (more && !databaseReading && (socket->bytesToWrite() < HIGH_WATER))
+    {
+      more = streamSlice();
+
+      if (responseStarted || !databaseReading)
+      {
+        socket->write(buffer);
+        buffer.resize(0);                 // Keeps the capacity.
+        responseStarted = true;
+      };
+    };
+
+    if (!more)
+    {
+      streaming = false;
+      socket->disconnectFromHost();
+    };
+  }
+
+  /// @brief      Starts an alert subscription. The response is a server-sent event stream with an "alert" event for each alert
+  ///             that is raised or cleared at any station.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::startAlerts()
+  {
+    QByteArray header;
+
+    header.append("HTTP/1.1 200 OK\r\n");
+    header.append("Content-Type: ").append(CONTENT_EVENTS).append("\r\n");
+    header.append("Cache-Control: no-cache\r\n");
+    header.append("Connection: keep-alive\r\n\r\n");
+
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    socket->write(header);
+
+    alertSubscription = CAlertRules::subscribe([this](SAlertEvent const &event) { sendAlert(event); });
+  }
+
+  /// @brief      Sends an alert event to the subscriber. A subscriber that is not reading its events is disconnected.
+  /// @param[in]  event: The alert event.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::sendAlert(SAlertEvent const &event)
+  {
+    if (socket->bytesToWrite() > HIGH_WATER)
+    {
+      LOGWARNING("Alert subscriber not reading. Disconnecting.");
+      CAlertRules::unsubscribe(alertSubscription);
+      alertSubscription = -1;
+      socket->abort();
+      return;
+    };
+
+    QByteArray name = event.name.toUtf8();
+
+    name.replace('\\', "\\\\").replace('"', "\\\"");
+
+    buffer.resize(0);
+    buffer.append("event: alert\ndata: {\"station\":\"").append(QByteArray::number(event.siteID)).append('-')
+          .append(QByteArray::number(event.instrumentID)).append("\",\"name\":\"").append(name)
+          .append("\",\"state\":\"").append(event.raised ? "raised" : "cleared").append("\",\"time\":\"");
+    appendTime(buffer, event.timeStamp);
+    buffer.append("\",\"column\":\"").append(columnName(event.column)).append("\",\"value\":");
+    appendNumber(buffer, event.value);
+    buffer.append("}\n\n");
+
+    socket->write(buffer);
+    socket->flush();
+    buffer.resize(0);
+  }
+
+  /// @brief      Generates the next slice of the range response into the buffer. Records held in the recent window are served
+  ///             from the window, records held in the local store from the store and older records from the database. A slice
+  ///             ends at the first change of source or after SLICE_RECORDS records.
+  ///             The window is in time order, so window slices continue after the last record sent. The store is in storage
+  ///             order and backfilled records may be out of order, so store slices are time windows of SLICE_SECONDS that are
+  ///             sorted before they are sent. Database records are read on the executor; the slice that starts a read generates
+  ///             nothing and streaming resumes when the read has completed.
+  /// @returns    true if there are more slices.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Store slices sorted. Database read on the executor.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CApiConnection::streamSlice()
+  {
+    TRACESPAN("apiSlice");
+
+    CIngest const *station = CIngest::find(siteID, instrumentID);
+    std::int64_t windowFirst = station ? station->recentWindow().firstTime() : INT64_MAX;
+    std::int64_t storeFirst = (station && station->localStore()) ? station->localStore()->firstTime() : INT64_MAX;
+    std::int64_t sliceEnd = endTime;
+    std::int64_t lastTime = 0;
+    std::size_t recordCount = 0;
+
+    if (nextTime >= windowFirst)
+    {
+      station->recentWindow().scan(nextTime, sliceEnd, [&](SArchiveRecord const &record)
+      {
+        appendRecord(record);
+        lastTime = record.timeStamp;
+        return (++recordCount < SLICE_RECORDS);
+      });
+    }
+    else if (nextTime >= storeFirst)
+    {
+      CTimeSeriesStore const *store = station->localStore();
+
+      sliceEnd = std::min({endTime, windowFirst - 1, store->lastTime(), nextTime + SLICE_SECONDS - 1});
+      for (SArchiveRecord const &record : store->read(nextTime, sliceEnd))
+      {
+        appendRecord(record);
+      };
+      if (sliceEnd == store->lastTime())
+      {
+        sliceEnd = std::min(endTime, windowFirst - 1);        // Nothing follows the end of the store.
+      };
+    }
+    else if (!databaseLoaded)
+    {
+      readDatabase(nextTime, std::min(endTime, std::min(windowFirst, storeFirst) - 1));
+      return true;
+    }
+    else
+    {
+      while ( (databasePosition < databaseRecords.size()) && (recordCount < SLICE_RECORDS) )
+      {
+        appendRecord(databaseRecords[databasePosition++]);
+        recordCount++;
+      };
+
+      if (databasePosition < databaseRecords.size())
+      {
+        return true;
+      };
+
+      sliceEnd = databaseEnd;
+      databaseLoaded = false;
+      databaseRecords.clear();
+      databasePosition = 0;
+      recordCount = 0;
+    };
+
+    if (recordCount == SLICE_RECORDS)
+    {
+      nextTime = lastTime + 1;
+      return true;
+    }
+    else if (sliceEnd < endTime)
+    {
+      nextTime = sliceEnd + 1;
+      return true;
+    }
+    else
+    {
+      if (format == FMT_JSON)
+      {
+        buffer.append("]}");
+      };
+      return false;
+    };
+  }
+
+  /// @brief      Reads the records in a time range from the database on the executor. The read uses its own connection, opened
+  ///             and closed by the worker, and the records are passed back to the connection on the event loop. If the connection
+  ///             has been closed in the meantime the records are discarded.
+  /// @param[in]  from: The start of the range (inclusive).
+  /// @param[in]  to: The end of the range (inclusive).
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Failed reads reported.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::readDatabase(std::int64_t from, std::int64_t to)
+  {
+    QPointer<CApiConnection> connection(this);
+    configuration::SDatabaseConfiguration database = configuration->database;
+    QString connectionName = QString("WSd-API-read-%1").arg(++databaseReads);
+    std::uint32_t site = siteID;
+    std::uint32_t instrument = instrumentID;
+
+    databaseReading = true;
+    databaseEnd = to;
+
+    CExecutor::global().submit([connection, database, connectionName, site, instrument, from, to]()
+    {
+      TRACESPAN("apiDatabaseRead");
+
+      std::vector<SArchiveRecord> records;
+      bool succeeded = false;
+
+      try
+      {
+        if (sql::openConnection(connectionName, database))
+        {
+          succeeded = sql::readRecords(connectionName, site, instrument, from, to, DATABASE_RECORDS,
+                                       [&records](SArchiveRecord const &record)
+          {
+            records.push_back(record);
+            return (records.size() < DATABASE_RECORDS);
+          });
+        };
+      }
+      catch (std::exception const &e)
+      {
+        LOGERROR("API database read failed: {}", e.what());
+        succeeded = false;
+      };
+      sql::closeConnection(connectionName);
+
+      if (!succeeded)
+      {
+        records.clear();
+      };
+
+      QMetaObject::invokeMethod(QCoreApplication::instance(), [connection, succeeded, records = std::move(records)]() mutable
+      {
+        if (connection)
+        {
+          connection->databaseRead(succeeded, std::move(records));
+        };
+      }, Qt::QueuedConnection);
+    });
+  }
+
+  /// @brief      Called on the event loop when a database read has completed. Resumes streaming. If the read failed and nothing
+  ///             has been sent the response is an error. Otherwise the response is ended early: a JSON response ends with an
+  ///             "error" member after the records, a binary response (which has no trailer) is aborted so that the client sees
+  ///             a reset connection instead of the end of the body.
+  /// @param[in]  succeeded: false if the database could not be read.
+  /// @param[in]  records: The records read, in time order.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Failed reads reported.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::databaseRead(bool succeeded, std::vector<SArchiveRecord> &&records)
+  {
+    databaseReading = false;
+
+    if (!succeeded)
+    {
+      streaming = false;
+
+      if (!responseStarted)
+      {
+        buffer.resize(0);
+        sendError(503, DATABASE_FAILED);
+      }
+      else if (format == FMT_JSON)
+      {
+        buffer.append("],\"error\":\"").append(DATABASE_FAILED).append("\"}");
+        socket->write(buffer);
+        buffer.resize(0);
+        socket->disconnectFromHost();
+      }
+      else
+      {
+        socket->abort();
+      };
+      return;
+    };
+
+    if (records.size() == DATABASE_RECORDS)
+    {
+      databaseEnd = records.back().timeStamp;                 // Keyset pagination: the next read starts after the last record.
+    };
+
+    databaseRecords = std::move(records);
+    databasePosition = 0;
+    databaseLoaded = true;
+
+    continueStreaming(0);
+  }
+
+  /// @brief      Appends a record to the buffer in the format of the response. JSON values are in SI units with null for
+  ///             missing values, and the values flagged by the quality control are listed in a "quality" object. Binary values
+  ///             are in console units with NO_VALUE for missing values.
+  /// @param[in]  record: The record.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Quality codes added to the JSON format.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::appendRecord(SArchiveRecord const &record)
+  {
+    if (format == FMT_BINARY)
+    {
+      appendLittleEndian(buffer, record.timeStamp);
+      for (EColumn column : columns)
+      {
+        appendLittleEndian(buffer, record.values[column]);
+      };
+    }
+    else
+    {
+      buffer.append(firstRecord ? "{\"time\":\"" : ",{\"time\":\"");
+      firstRecord = false;
+      appendTime(buffer, record.timeStamp);
+      buffer.append('"');
+
+      for (EColumn column : columns)
+      {
+        buffer.append(",\"").append(columnName(column)).append("\":");
+        appendNumber(buffer, record.value(column));
+      };
+
+      if (record.qualityCodes != 0)
+      {
+        bool first = true;
+
+        for (EColumn column : columns)
+        {
+          if (record.quality(column) != QC_GOOD)
+          {
+            buffer.append(first ? ",\"quality\":{\"" : ",\"").append(columnName(column)).append("\":\"")
+                  .append(qualityName(record.quality(column))).append('"');
+            first = false;
+          };
+        };
+        if (!first)
+        {
+          buffer.append('}');
+        };
+      };
+      buffer.append('}');
+    };
+  }
+
+  /// @brief      Parses a station identifier of the form {siteID}-{instrumentID}.
+  /// @param[in]  text: The identifier.
+  /// @param[out] site: The site ID.
+  /// @param[out] instrument: The instrument ID.
+  /// @returns    true if the identifier is valid.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CApiConnection::parseStation(QString const &text, std::uint32_t &site, std::uint32_t &instrument)
+  {
+    QStringList parts = text.split('-');
+    bool siteOK = false;
+    bool instrumentOK = false;
+
+    if (parts.size() == 2)
+    {
+      site = parts[0].toUInt(&siteOK);
+      instrument = parts[1].toUInt(&instrumentOK);
+    };
+
+    return (siteOK && instrumentOK);
+  }
+
+  /// @brief      Appends a time stamp as YYYY-MM-DDTHH:MM.
+  /// @param[in]  buffer: The buffer to append to.
+  /// @param[in]  timeStamp: The time stamp.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::appendTime(QByteArray &buffer, std::int64_t timeStamp)
+  {
+    int year, month, day, hour, minute;
+    char text[24];
+
+    SArchiveRecord::splitTimeStamp(timeStamp, year, month, day, hour, minute);
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d", year, month, day, hour, minute);
+
+    buffer.append(text);
+  }
+
+  /// @brief      Appends a number to the buffer. NaN is appended as null.
+  /// @param[in]  buffer: The buffer to append to.
+  /// @param[in]  value: The value.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiConnection::appendNumber(QByteArray &buffer, double value)
+  {
+    if (std::isnan(value))
+    {
+      buffer.append("null");
+    }
+    else
+    {
+      char text[32];
+      std::to_chars_result result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+
+      buffer.append(text, static_cast<int>(result.ptr - text));
+    };
+  }
+
+  //*******************************************************************************************************************************
+  //
+  // CApiServer
+  //
+  //*******************************************************************************************************************************
+
+  /// @brief      Constructor.
+  /// @param[in]  c: The configuration snapshot.
+  /// @param[in]  parent: The parent object.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CApiServer::CApiServer(configuration::PConfiguration c, QObject *parent) : QObject(parent), server(this), configuration(c)
+  {
+    connect(&server, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+  }
+
+  /// @brief      Starts listening on the socket passed by systemd (socket activation) or, if there is none, on the configured
+  ///             address and port.
+  /// @returns    true if the server is listening.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Socket passed by systemd used.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CApiServer::listen()
+  {
+    int descriptor = systemd::listenSocket("api");
+
+    if (descriptor >= 0)
+    {
+      if (server.setSocketDescriptor(descriptor))
+      {
+        LOGINFO("Read API listening on the socket passed by systemd.");
+        return true;
+      }
+      else
+      {
+        LOGERROR("Read API unable to use the socket passed by systemd: {}", server.errorString().toStdString());
+#ifdef Q_OS_UNIX
+        ::close(descriptor);
+#endif
+        return false;
+      };
+    }
+    else if (server.listen(QHostAddress(configuration->apiAddress), configuration->apiPort))
+    {
+      LOGINFO("Read API listening on {}:{}.", configuration->apiAddress.toStdString(), configuration->apiPort);
+      return true;
+    }
+    else
+    {
+      LOGERROR("Read API unable to listen on {}:{}: {}", configuration->apiAddress.toStdString(), configuration->apiPort,
+               server.errorString().toStdString());
+      return false;
+    };
+  }
+
+  /// @brief      Slot called when there are connections waiting. A connection object is created for each connection.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CApiServer::acceptConnection()
+  {
+    while (server.hasPendingConnections())
+    {
+      new CApiConnection(server.nextPendingConnection(), configuration);
+    };
+  }
+
+} // namespace WSd
@@ -0,0 +1,436 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								ArchiveRecord
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Decoded archive record. The Rev B archive record (52 bytes) sent by the console in the DMPAFT pages is
+//                      decoded into integer columns in console units, with the dash values (no sensor) replaced by NO_VALUE.
+//                      The current conditions of a LOOP packet are decoded into the same columns, so that they can be checked
+//                      against the alert rules.
+//
+// HISTORY:             2026-10-19/GGB - LOOP packets decoded.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/archiveRecord.h"
+
+  // Standard C++ library header files
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace WSd
+{
+  /// @brief Description of a column in the Rev B archive record.
+
+  struct SColumnLayout
+  {
+    char const *name;
+    std::uint8_t offset;
+    std::uint8_t size;                  // 1 or 2 bytes. (0 for the derived columns.)
+    bool isSigned;
+    std::int32_t dashValue;             // Value sent when there is no sensor. NO_VALUE if the column has no dash value.
+  };
+
+  static SColumnLayout const columnLayout[COL_COUNT] =
+  {
+    { "outsideTemperature",         4,  2, true,  32767 },
+    { "highOutsideTemperature",     6,  2, true,  -32768 },
+    { "lowOutsideTemperature",      8,  2, true,  32767 },
+    { "rainfall",                   10, 2, false, NO_VALUE },
+    { "highRainRate",               12, 2, false, NO_VALUE },
+    { "barometer",                  14, 2, false, 0 },
+    { "solarRadiation",             16, 2, false, 32767 },
+    { "windSamples",                18, 2, false, NO_VALUE },
+    { "insideTemperature",          20, 2, true,  32767 },
+    { "insideHumidity",             22, 1, false, 255 },
+    { "outsideHumidity",            23, 1, false, 255 },
+    { "averageWindSpeed",           24, 1, false, 255 },
+    { "highWindSpeed",              25, 1, false, NO_VALUE },
+    { "highWindDirection",          26, 1, false, 255 },
+    { "prevailingWindDirection",    27, 1, false, 255 },
+    { "uvIndex",                    28, 1, false, 255 },
+    { "et",                         29, 1, false, NO_VALUE },
+    { "highSolarRadiation",         30, 2, false, NO_VALUE },
+    { "highUVIndex",                32, 1, false, NO_VALUE },
+    { "dewPoint",                   0,  0, false, NO_VALUE },
+    { "heatIndex",                  0,  0, false, NO_VALUE },
+    { "windChill",                  0,  0, false, NO_VALUE },
+    { "thswIndex",                  0,  0, false, NO_VALUE },
+    { "absoluteHumidity",           0,  0, false, NO_VALUE },
+    { "stationPressure",            0,  0, false, NO_VALUE },
+  };
+
+    // The columns of a LOOP packet. The packet holds the current conditions, so the high and low columns take the current
+    // value and the average wind speed is the 10 minute average. Columns with a size of 0 are not in the packet.
+
+  static SColumnLayout const loopLayout[COL_FIRST_DERIVED] =
+  {
+    { "outsideTemperature",         12, 2, true,  32767 },
+    { "highOutsideTemperature",     12, 2, true,  32767 },
+    { "lowOutsideTemperature",      12, 2, true,  32767 },
+    { "rainfall",                   0,  0, false, NO_VALUE },
+    { "highRainRate",               41, 2, false, NO_VALUE },
+    { "barometer",                  7,  2, false, 0 },
+    { "solarRadiation",             44, 2, false, 32767 },
+    { "windSamples",                0,  0, false, NO_VALUE },
+    { "insideTemperature",          9,  2, true,  32767 },
+    { "insideHumidity",             11, 1, false, 255 },
+    { "outsideHumidity",            33, 1, false, 255 },
+    { "averageWindSpeed",           15, 1, false, 255 },
+    { "highWindSpeed",              14, 1, false, 255 },
+    { "highWindDirection",          0,  0, false, NO_VALUE },
+    { "prevailingWindDirection",    0,  0, false, NO_VALUE },
+    { "uvIndex",                    43, 1, false, 255 },
+    { "et",                         0,  0, false, NO_VALUE },
+    { "highSolarRadiation",         44, 2, false, 32767 },
+    { "highUVIndex",                43, 1, false, 255 },
+  };
+
+  /// @brief      Decodes the value of a column.
+  /// @param[in]  raw: The record or packet.
+  /// @param[in]  layout: The layout of the column.
+  /// @returns    The value. NO_VALUE if the dash value was sent.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created. (Moved from SArchiveRecord::decode())
+
+  static std::int32_t decodeValue(std::uint8_t const *raw, SColumnLayout const &layout)
+  {
+    std::int32_t value;
+
+    if (layout.size == 1)
+    {
+      value = raw[layout.offset];
+    }
+    else if (layout.isSigned)
+    {
+      value = static_cast<std::int16_t>(raw[layout.offset] | (raw[layout.offset + 1] << 8));
+    }
+    else
+    {
+      value = static_cast<std::uint16_t>(raw[layout.offset] | (raw[layout.offset + 1] << 8));
+    };
+
+    return (value == layout.dashValue) ? NO_VALUE : value;
+  }
+
+  /// @brief      Returns the name of a column. (Used in the API and the export files.)
+  /// @param[in]  column: The column.
+  /// @returns    The name of the column.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  char const *columnName(EColumn column)
+  {
+    return (column < COL_COUNT) ? columnLayout[column].name : "unknown";
+  }
+
+  /// @brief      Returns the name of a quality code.
+  /// @param[in]  code: The quality code.
+  /// @returns    The name.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  char const *qualityName(EQuality code)
+  {
+    static char const *const names[] = { "good", "range", "rate", "spike", "flatline" };
+
+    return (code <= QC_FLATLINE) ? names[code] : "unknown";
+  }
+
+  /// @brief      Replaces the value of a column of a raw archive record with the dash value (no sensor) of the column.
+  /// @param[in]  raw: The 52 byte archive record.
+  /// @param[in]  column: The column.
+  /// @returns    false if the column has no dash value. (The record is not changed.)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool setDashValue(std::uint8_t *raw, EColumn column)
+  {
+    if ( (column >= COL_FIRST_DERIVED) || (columnLayout[column].dashValue == NO_VALUE) )
+    {
+      return false;
+    };
+
+    SColumnLayout const &layout = columnLayout[column];
+    std::uint16_t value = static_cast<std::uint16_t>(layout.dashValue);
+
+    raw[layout.offset] = static_cast<std::uint8_t>(value & 0xFF);
+    if (layout.size == 2)
+    {
+      raw[layout.offset + 1] = static_cast<std::uint8_t>(value >> 8);
+    };
+
+    return true;
+  }
+
+  /// @brief      Decodes a Rev B archive record. The derived columns are set to NO_VALUE.
+  /// @param[in]  raw: The 52 byte archive record.
+  /// @returns    false if the record is empty (unused archive slot).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Derived columns cleared.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool SArchiveRecord::decode(std::uint8_t const *raw)
+  {
+    std::uint16_t date = static_cast<std::uint16_t>(raw[0] | (raw[1] << 8));
+    std::uint16_t time = static_cast<std::uint16_t>(raw[2] | (raw[3] << 8));
+
+    if ( (date == 0) || (date == 0xFFFF) )
+    {
+      return false;
+    };
+
+    timeStamp = makeTimeStamp((date >> 9) + 2000, (date >> 5) & 0x0F, date & 0x1F, time / 100, time % 100);
+
+    for (std::size_t column = 0; column < COL_FIRST_DERIVED; column++)
+    {
+      values[column] = decodeValue(raw, columnLayout[column]);
+    };
+
+    for (std::size_t column = COL_FIRST_DERIVED; column < COL_COUNT; column++)
+    {
+      values[column] = NO_VALUE;
+    };
+    qualityCodes = 0;
+
+    return true;
+  }
+
+  /// @brief      Decodes the current conditions of a LOOP packet. The columns that are not in the packet and the derived columns
+  ///             are set to NO_VALUE. The CRC is checked by the caller.
+  /// @param[in]  raw: The 99 byte LOOP packet.
+  /// @param[in]  time: The time the packet was received. (Console time, s)
+  /// @returns    false if the packet is not a LOOP packet. (eg a LOOP2 packet)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool SArchiveRecord::decodeLoop(std::uint8_t const *raw, std::int64_t time)
+  {
+    if ( (raw[0] != 'L') || (raw[1] != 'O') || (raw[2] != 'O') || (raw[4] != 0) )
+    {
+      return false;
+    };
+
+    timeStamp = time;
+
+    for (std::size_t column = 0; column < COL_FIRST_DERIVED; column++)
+    {
+      values[column] = (loopLayout[column].size == 0) ? NO_VALUE : decodeValue(raw, loopLayout[column]);
+    };
+
+    for (std::size_t column = COL_FIRST_DERIVED; column < COL_COUNT; column++)
+    {
+      values[column] = NO_VALUE;
+    };
+    qualityCodes = 0;
+
+    return true;
+  }
+
+  /// @brief      Converts a value in console units to SI units. (°C, mm, mm/h, hPa, W/m², %, m/s, degrees, index.)
+  /// @param[in]  column: The column the value is from.
+  /// @param[in]  raw: The value in console units. (May be fractional, eg a mean.)
+  /// @param[in]  rainClick: The size of a rain collector click (mm).
+  /// @returns    The value in SI units.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double engineeringValue(EColumn column, double raw, double rainClick)
+  {
+    switch (column)
+    {
+      case COL_OUTSIDE_TEMPERATURE:
+      case COL_HIGH_OUTSIDE_TEMPERATURE:
+      case COL_LOW_OUTSIDE_TEMPERATURE:
+      case COL_INSIDE_TEMPERATURE:
+      case COL_DEW_POINT:
+      case COL_HEAT_INDEX:
+      case COL_WIND_CHILL:
+      case COL_THSW_INDEX:
+        return (raw / 10.0 - 32.0) * 5.0 / 9.0;
+      case COL_RAINFALL:
+      case COL_HIGH_RAIN_RATE:
+        return raw * rainClick;
+      case COL_BAROMETER:
+      case COL_STATION_PRESSURE:
+        return raw * 0.0338638866667;                               // 0.001 inHg -> hPa
+      case COL_AVERAGE_WIND_SPEED:
+      case COL_HIGH_WIND_SPEED:
+        return raw * 0.44704;                                       // mph -> m/s
+      case COL_HIGH_WIND_DIRECTION:
+      case COL_PREVAILING_WIND_DIRECTION:
+        return raw * 22.5;
+      case COL_UV_INDEX:
+      case COL_HIGH_UV_INDEX:
+        return raw / 10.0;
+      case COL_ET:
+        return raw * 0.0254;                                        // 0.001 in -> mm
+      case COL_ABSOLUTE_HUMIDITY:
+        return raw / 100.0;
+      default:
+        return raw;
+    };
+  }
+
+  /// @brief      Returns the value of a column in SI units.
+  /// @param[in]  column: The column.
+  /// @param[in]  rainClick: The size of a rain collector click (mm).
+  /// @returns    The value. NaN if there is no value.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double SArchiveRecord::value(EColumn column, double rainClick) const
+  {
+    if (values[column] == NO_VALUE)
+    {
+      return std::nan("");
+    }
+    else
+    {
+      return engineeringValue(column, values[column], rainClick);
+    };
+  }
+
+  /// @brief      Converts a (console) date and time to a time stamp.
+  /// @param[in]  year: The year (eg 2026).
+  /// @param[in]  month: The month (1 - 12).
+  /// @param[in]  day: The day of the month.
+  /// @param[in]  hour: The hour.
+  /// @param[in]  minute: The minute.
+  /// @returns    Seconds since 1970-01-01 00:00.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int64_t SArchiveRecord::makeTimeStamp(int year, int month, int day, int hour, int minute)
+  {
+      // Days from the civil date. (H. Hinnant)
+
+    year -= (month <= 2) ? 1 : 0;
+
+    std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    std::int64_t yearOfEra = year - era * 400;
+    std::int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    std::int64_t days = era * 146097 + dayOfEra - 719468;
+
+    return days * 86400 + hour * 3600 + minute * 60;
+  }
+
+  /// @brief      Converts a time stamp to the date and time.
+  /// @param[in]  timeStamp: Seconds since 1970-01-01 00:00.
+  /// @param[out] year: The year.
+  /// @param[out] month: The month (1 - 12).
+  /// @param[out] day: The day of the month.
+  /// @param[out] hour: The hour.
+  /// @param[out] minute: The minute.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void SArchiveRecord::splitTimeStamp(std::int64_t timeStamp, int &year, int &month, int &day, int &hour, int &minute)
+  {
+    std::int64_t days = timeStamp / 86400;
+    std::int64_t seconds = timeStamp % 86400;
+
+    if (seconds < 0)
+    {
+      seconds += 86400;
+      days--;
+    };
+
+      // Civil date from days. (H. Hinnant)
+
+    days += 719468;
+
+    std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    std::int64_t dayOfEra = days - era * 146097;
+    std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    std::int64_t mp = (5 * dayOfYear + 2) / 153;
+
+    day = static_cast<int>(dayOfYear - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = static_cast<int>(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+    hour = static_cast<int>(seconds / 3600);
+    minute = static_cast<int>((seconds % 3600) / 60);
+  }
+
+  /// @brief      Parses a time. Times are given as a time stamp (seconds) or as YYYY-MM-DD[THH:MM], in station time.
+  /// @param[in]  text: The time.
+  /// @param[out] timeStamp: The time stamp.
+  /// @returns    true if the time is valid.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Moved from the API server so that it is shared with the exporter.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool SArchiveRecord::parseTimeStamp(std::string const &text, std::int64_t &timeStamp)
+  {
+    std::int64_t seconds;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), seconds);
+
+    if ( !text.empty() && (result.ec == std::errc()) && (result.ptr == text.data() + text.size()) )
+    {
+      timeStamp = seconds;
+      return true;
+    };
+
+    int year, month, day, hour = 0, minute = 0;
+    int length = 0;
+
+    if ( (std::sscanf(text.c_str(), "%4d-%2d-%2d%n", &year, &month, &day, &length) != 3) || (length != 10) )
+    {
+      return false;
+    };
+
+    if (text.size() > 10)
+    {
+      if ( ((text[10] != 'T') && (text[10] != ' ')) ||
+           (std::sscanf(text.c_str() + 11, "%2d:%2d%n", &hour, &minute, &length) != 2) || (length != 5) ||
+           (text.size() != 16) )
+      {
+        return false;
+      };
+    };
+
+      // Reject dates that do not exist (eg 2026-02-30) by converting back.
+
+    std::int64_t value = makeTimeStamp(year, month, day, hour, minute);
+    int checkYear, checkMonth, checkDay, checkHour, checkMinute;
+
+    splitTimeStamp(value, checkYear, checkMonth, checkDay, checkHour, checkMinute);
+
+    if ( (month < 1) || (month > 12) || (hour > 23) || (minute > 59) || (hour < 0) || (minute < 0) ||
+         (checkYear != year) || (checkMonth != month) || (checkDay != day) )
+    {
+      return false;
+    };
+
+    timeStamp = value;
+
+    return true;
+  }
+
+} // namespace WSd
@@ -0,0 +1,251 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Compression
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Bit stream compression of the columns of the local store. Integers are delta (or delta of delta) encoded
+//                      with a variable length prefix, as described for the Gorilla time series database (Pelkonen et al, 2015).
+//
+// HISTORY:             2026-10-19/GGB - Deltas wrap instead of overflowing. Unused XOR encoder removed.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/compression.h"
+
+namespace WSd
+{
+  /// @brief      Subtraction and addition modulo 2^64. Deltas between values at the extremes of the range overflow int64, the
+  ///             encoder and decoder wrap the same way so the values still round trip.
+  /// @param[in]  lhs: The first operand.
+  /// @param[in]  rhs: The second operand.
+  /// @returns    The result (modulo 2^64).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::int64_t wrappingSubtract(std::int64_t lhs, std::int64_t rhs)
+  {
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(lhs) - static_cast<std::uint64_t>(rhs));
+  }
+
+  static std::int64_t wrappingAdd(std::int64_t lhs, std::int64_t rhs)
+  {
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(lhs) + static_cast<std::uint64_t>(rhs));
+  }
+
+  /// @brief      Appends bits to the stream.
+  /// @param[in]  value: The value to write. Only the low order bits are written.
+  /// @param[in]  bits: The number of bits to write (0 - 64).
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CBitWriter::write(std::uint64_t value, int bits)
+  {
+    while (bits > 0)
+    {
+      if (freeBits == 0)
+      {
+        buffer.push_back(0);
+        freeBits = 8;
+      };
+
+      int count = (bits < freeBits) ? bits : freeBits;
+      std::uint8_t chunk = static_cast<std::uint8_t>((value >> (bits - count)) & ((1U << count) - 1));
+
+      buffer.back() |= static_cast<std::uint8_t>(chunk << (freeBits - count));
+      freeBits -= count;
+      bits -= count;
+    };
+  }
+
+  /// @brief      Reads bits from the stream.
+  /// @param[in]  bits: The number of bits to read (0 - 64).
+  /// @returns    The bits read.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint64_t CBitReader::read(int bits)
+  {
+    std::uint64_t value = 0;
+
+    while (bits > 0)
+    {
+      std::size_t byte = position / 8;
+      int available = 8 - static_cast<int>(position % 8);
+      int count = (bits < available) ? bits : available;
+      std::uint8_t current = (byte < size) ? data[byte] : 0;
+
+      value = (value << count) | ((current >> (available - count)) & ((1U << count) - 1));
+      position += count;
+      bits -= count;
+    };
+
+    return value;
+  }
+
+  /// @brief      Writes a signed value with a variable length prefix.
+  ///             '0' - zero, '10' - 7 bits, '110' - 9 bits, '1110' - 12 bits, '11110' - 32 bits, '11111' - 64 bits.
+  /// @param[in]  writer: The bit stream.
+  /// @param[in]  value: The value to write.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CDeltaEncoder::writeSigned(CBitWriter &writer, std::int64_t value)
+  {
+    if (value == 0)
+    {
+      writer.write(0x00, 1);
+    }
+    else if ( (value >= -63) && (value <= 64) )
+    {
+      writer.write(0x02, 2);
+      writer.write(static_cast<std::uint64_t>(value), 7);
+    }
+    else if ( (value >= -255) && (value <= 256) )
+    {
+      writer.write(0x06, 3);
+      writer.write(static_cast<std::uint64_t>(value), 9);
+    }
+    else if ( (value >= -2047) && (value <= 2048) )
+    {
+      writer.write(0x0E, 4);
+      writer.write(static_cast<std::uint64_t>(value), 12);
+    }
+    else if ( (value >= INT32_MIN) && (value <= INT32_MAX) )
+    {
+      writer.write(0x1E, 5);
+      writer.write(static_cast<std::uint64_t>(value), 32);
+    }
+    else
+    {
+      writer.write(0x1F, 5);
+      writer.write(static_cast<std::uint64_t>(value), 64);
+    };
+  }
+
+  /// @brief      Reads a value written by writeSigned().
+  /// @param[in]  reader: The bit stream.
+  /// @returns    The value.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int64_t CDeltaEncoder::readSigned(CBitReader &reader)
+  {
+    static int const widths[] = { 7, 9, 12, 32, 64 };
+    int bucket = 0;
+
+    if (!reader.readBit())
+    {
+      return 0;
+    };
+
+    while ( (bucket < 4) && reader.readBit() )
+    {
+      bucket++;
+    };
+
+    int width = widths[bucket];
+    std::uint64_t bits = reader.read(width);
+
+      // Sign extend. (Values of 64, 256 and 2048 were written in 7, 9 and 12 bits and read back as negative numbers, so the
+      // boundary values are handled explicitly.)
+
+    if (width == 64)
+    {
+      return static_cast<std::int64_t>(bits);
+    }
+    else
+    {
+      std::uint64_t signBit = std::uint64_t(1) << (width - 1);
+      std::int64_t value = static_cast<std::int64_t>((bits ^ signBit) - signBit);
+
+      if ( (width < 32) && (value == -static_cast<std::int64_t>(signBit)) )
+      {
+        value = static_cast<std::int64_t>(signBit);
+      };
+
+      return value;
+    };
+  }
+
+  /// @brief      Encodes a value.
+  /// @param[in]  writer: The bit stream.
+  /// @param[in]  value: The value to encode.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Deltas wrap instead of overflowing.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CDeltaEncoder::encode(CBitWriter &writer, std::int64_t value)
+  {
+    if (first)
+    {
+      writer.write(static_cast<std::uint64_t>(value), 64);
+      first = false;
+    }
+    else
+    {
+      std::int64_t delta = wrappingSubtract(value, previous);
+
+      if (deltaOfDelta)
+      {
+        writeSigned(writer, wrappingSubtract(delta, previousDelta));
+        previousDelta = delta;
+      }
+      else
+      {
+        writeSigned(writer, delta);
+      };
+    };
+
+    previous = value;
+  }
+
+  /// @brief      Decodes a value.
+  /// @param[in]  reader: The bit stream.
+  /// @returns    The value.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Deltas wrap instead of overflowing.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int64_t CDeltaEncoder::decode(CBitReader &reader)
+  {
+    if (first)
+    {
+      previous = static_cast<std::int64_t>(reader.read(64));
+      first = false;
+    }
+    else if (deltaOfDelta)
+    {
+      previousDelta = wrappingAdd(previousDelta, readSigned(reader));
+      previous = wrappingAdd(previous, previousDelta);
+    }
+    else
+    {
+      previous = wrappingAdd(previous, readSigned(reader));
+    };
+
+    return previous;
+  }
+
+} // namespace WSd
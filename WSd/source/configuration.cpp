@@ -0,0 +1,570 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Configuration
+// SUBSYSTEM:						Configuration
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd::configuration
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Immutable, strongly typed configuration snapshot.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/configuration.h"
+
+  // Standard C++ library header files
+
+#include <atomic>
+
+  // Miscellaneous library header files
+
+#include <GCL>
+#include <QCL>
+#include <WCL>
+
+  // WSd header files
+
+#include "include/alertRules.h"
+#include "include/settings.h"
+
+namespace WSd
+{
+  namespace configuration
+  {
+    static QString const SETTINGS_SITEID("WSd/SiteID");
+    static QString const SETTINGS_INSTRUMENTID("WSd/InstrumentID");
+    static QString const SETTINGS_TRACEFILE("WSd/TraceFile");
+    static QString const SETTINGS_CAPTUREFILE("WSd/CaptureFile");
+    static QString const SETTINGS_STOREDIRECTORY("WSd/StoreDirectory");
+    static QString const SETTINGS_APIADDRESS("WSd/ApiAddress");
+    static QString const SETTINGS_APIPORT("WSd/ApiPort");
+    static QString const SETTINGS_UPSTREAM_ADDRESS("WSd/Replication/Address");
+    static QString const SETTINGS_UPSTREAM_PORT("WSd/Replication/Port");
+    static QString const SETTINGS_ELEVATION("WSd/Elevation");
+    static QString const SETTINGS_QC_ENABLED("WSd/QC/Enabled");
+    static QString const SETTINGS_QC_REJECT("WSd/QC/Reject");
+    static QString const SETTINGS_ALERTS("WSd/Alerts");
+    static QString const SETTINGS_RETENTION_MONTHS("WSd/Retention/Months");
+    static QString const SETTINGS_RETENTION_ARCHIVE("WSd/Retention/Archive");
+    static QString const SETTINGS_STARTUPSPREAD("WSd/StartupSpread");
+    static QString const SETTINGS_RECEPTION_INTERVAL("WSd/Reception/Interval");
+    static QString const SETTINGS_RECEPTION_MONITOR("WSd/Reception/RadioMonitor");
+    static QString const SETTINGS_LEASE_TIME("WSd/Lease/Time");
+
+    static PConfiguration currentConfiguration;
+    static boost::program_options::variables_map commandLine;
+
+    /// @brief      Equality operator for the database settings.
+    /// @param[in]  rhs: The settings to compare against.
+    /// @returns    true if the settings refer to the same database with the same credentials.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool SDatabaseConfiguration::operator==(SDatabaseConfiguration const &rhs) const
+    {
+      return ( (driver == rhs.driver) &&
+               (hostAddress == rhs.hostAddress) &&
+               (port == rhs.port) &&
+               (databaseName == rhs.databaseName) &&
+               (userName == rhs.userName) &&
+               (password == rhs.password) );
+    }
+
+    /// @brief      Returns the default quality control thresholds. (Limits of the Davis sensors, and changes that are not
+    ///             physically plausible within one archive interval.)
+    /// @returns    The thresholds of each raw column.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    std::array<SQualityLimits, COL_FIRST_DERIVED> SQualityConfiguration::defaultQualityLimits()
+    {
+      std::array<SQualityLimits, COL_FIRST_DERIVED> limits;
+
+        //                                            minimum  maximum  rate/min  spike  floor  flatline (min)
+
+      limits[COL_OUTSIDE_TEMPERATURE] =             { -40,     65,      1.0,      6,     2.0,   360 };
+      limits[COL_HIGH_OUTSIDE_TEMPERATURE] =        { -40,     65,      1.0,      6,     2.0,   0 };
+      limits[COL_LOW_OUTSIDE_TEMPERATURE] =         { -40,     65,      1.0,      6,     2.0,   0 };
+      limits[COL_RAINFALL] =                        { 0,       100,     0,        0,     0,     0 };
+      limits[COL_HIGH_RAIN_RATE] =                  { 0,       2500,    0,        0,     0,     0 };
+      limits[COL_BAROMETER] =                       { 880,     1080,    0.5,      6,     1.0,   720 };
+      limits[COL_SOLAR_RADIATION] =                 { 0,       1800,    0,        0,     0,     0 };
+      limits[COL_INSIDE_TEMPERATURE] =              { 0,       60,      1.0,      6,     2.0,   0 };
+      limits[COL_INSIDE_HUMIDITY] =                 { 1,       100,     5.0,      6,     8.0,   0 };
+      limits[COL_OUTSIDE_HUMIDITY] =                { 1,       100,     5.0,      6,     8.0,   1440 };
+      limits[COL_AVERAGE_WIND_SPEED] =              { 0,       60,      0,        8,     10.0,  720 };
+      limits[COL_HIGH_WIND_SPEED] =                 { 0,       90,      0,        0,     0,     0 };
+      limits[COL_HIGH_WIND_DIRECTION] =             { 0,       360,     0,        0,     0,     0 };
+      limits[COL_PREVAILING_WIND_DIRECTION] =       { 0,       360,     0,        0,     0,     1440 };
+      limits[COL_UV_INDEX] =                        { 0,       16,      0,        0,     0,     0 };
+      limits[COL_ET] =                              { 0,       25,      0,        0,     0,     0 };
+      limits[COL_HIGH_SOLAR_RADIATION] =            { 0,       1800,    0,        0,     0,     0 };
+      limits[COL_HIGH_UV_INDEX] =                   { 0,       16,      0,        0,     0,     0 };
+
+      return limits;
+    }
+
+    /// @brief      Returns the settings key of a quality control threshold.
+    /// @param[in]  column: The column.
+    /// @param[in]  name: The name of the threshold.
+    /// @returns    The key. (WSd/QC/<column>/<name>)
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static QString qualityKey(std::size_t column, char const *name)
+    {
+      return QString("WSd/QC/%1/%2").arg(columnName(static_cast<EColumn>(column))).arg(name);
+    }
+
+    /// @brief      Adds the configuration options to the command line description. No default values are given to the options so
+    ///             that only values that are given explicitly override the settings file.
+    /// @param[in]  options: The options description to add to.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void addCommandLineOptions(boost::program_options::options_description &options)
+    {
+      options.add_options()
+          ("ipaddr", boost::program_options::value<std::string>(), "IP address of Weather Station")
+          ("port", boost::program_options::value<unsigned int>(), "port to use with the Weather Station <22222>")
+          ("pollinterval", boost::program_options::value<unsigned int>(), "interval to poll the Weather Station <5>")
+          ("startupspread", boost::program_options::value<unsigned int>(), "seconds the first polls are spread over <0>")
+          ("rxinterval", boost::program_options::value<unsigned int>(), "minutes between console diagnostics, 0 to disable <0>")
+          ("strmon", boost::program_options::value<unsigned int>(), "seconds radio packets are captured per diagnostic <0>")
+          ("lease", boost::program_options::value<unsigned int>(), "seconds the lease of a shared station is held for <0>")
+          ("elevation", boost::program_options::value<double>(), "elevation of the Weather Station (m) <0>")
+          ("dbdriver", boost::program_options::value<std::string>(), "database type <MYSQL|SQLITE>")
+          ("dbip", boost::program_options::value<std::string>(), "database host address <localhost>")
+          ("dbport", boost::program_options::value<unsigned int>(), "database port <3306>")
+          ("dbname", boost::program_options::value<std::string>(), "database name <WEATHER>")
+          ("dbuser", boost::program_options::value<std::string>(), "database username <WEATHER>")
+          ("dbpassword", boost::program_options::value<std::string>(), "database password <WEATHER>")
+          ("siteid", boost::program_options::value<unsigned long>(), "site ID value <53>")
+          ("instrumentid", boost::program_options::value<unsigned long>(), "instrument ID value <1>")
+          ("tracefile", boost::program_options::value<std::string>(), "file to export trace spans to <WSd-trace.json>")
+          ("capture", boost::program_options::value<std::string>(), "file to capture the console traffic to, empty to disable <>")
+          ("storedir", boost::program_options::value<std::string>(), "directory of the local store, empty to disable <WSd-store>")
+          ("apiaddr", boost::program_options::value<std::string>(), "address the read API listens on <127.0.0.1>")
+          ("apiport", boost::program_options::value<unsigned int>(), "port of the read API, 0 to disable <8088>")
+          ("upstream", boost::program_options::value<std::string>(), "address of the daemon to replicate the station from <>")
+          ("upstreamport", boost::program_options::value<unsigned int>(), "read API port of the upstream daemon <8088>")
+          ("retention", boost::program_options::value<unsigned int>(), "months kept in the weather database, 0 to keep all <0>")
+          ;
+    }
+
+    /// @brief      Stores the parsed command line. The command line values are re-applied over the settings file each time a
+    ///             snapshot is loaded so that a reload does not lose them.
+    /// @param[in]  vm: The parsed command line.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void setCommandLine(boost::program_options::variables_map const &vm)
+    {
+      commandLine = vm;
+    }
+
+    /// @brief      Loads a new configuration snapshot. Defaults are overridden by the settings file, which is overridden by the
+    ///             command line. The snapshot is validated before it is returned.
+    /// @param[out] errorMessage: Description of the validation failures.
+    /// @returns    The new snapshot. The snapshot is not installed. nullptr if the configuration is not valid.
+    /// @note       The settings file is re-read from disk so that edits made since the last load are picked up.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Upstream daemon added.
+    /// @version    2026-10-19/GGB - Lease of shared stations added.
+    /// @version    2026-10-19/GGB - Sampling of the console diagnostics added.
+    /// @version    2026-10-19/GGB - Startup spread added.
+    /// @version    2026-10-19/GGB - Capture file of the console traffic added.
+    /// @version    2026-10-19/GGB - Retention of the weather database added.
+    /// @version    2026-10-19/GGB - SQLite databases accepted.
+    /// @version    2026-10-19/GGB - Alert rules loaded and validated.
+    /// @version    2026-10-19/GGB - Command line values applied. Snapshot validated.
+    /// @version    2026-10-19/GGB - Function created.
+
+    PConfiguration load(std::string &errorMessage)
+    {
+      std::shared_ptr<SConfiguration> configuration = std::make_shared<SConfiguration>();
+      QSettings &settings = WCL::settings::settings;
+
+      errorMessage.clear();
+
+        // Settings file.
+
+      settings.sync();
+
+      configuration->station.siteID = settings.value(SETTINGS_SITEID, configuration->station.siteID).toUInt();
+      configuration->station.instrumentID = settings.value(SETTINGS_INSTRUMENTID, configuration->station.instrumentID).toUInt();
+      configuration->station.ipAddress = settings.value(WCL::settings::WS_IPADDRESS, configuration->station.ipAddress).toString();
+      configuration->station.port = static_cast<std::uint16_t>(settings.value(WCL::settings::WS_PORT,
+                                                                              configuration->station.port).toUInt());
+      configuration->pollInterval = settings.value(WCL::settings::WS_POLLINTERVAL, configuration->pollInterval).toUInt();
+      configuration->startupSpread = settings.value(SETTINGS_STARTUPSPREAD, configuration->startupSpread).toUInt();
+      configuration->receptionInterval = settings.value(SETTINGS_RECEPTION_INTERVAL, configuration->receptionInterval).toUInt();
+      configuration->radioMonitor = settings.value(SETTINGS_RECEPTION_MONITOR, configuration->radioMonitor).toUInt();
+      configuration->leaseTime = settings.value(SETTINGS_LEASE_TIME, configuration->leaseTime).toUInt();
+      configuration->elevation = settings.value(SETTINGS_ELEVATION, configuration->elevation).toDouble();
+      configuration->quality.enabled = settings.value(SETTINGS_QC_ENABLED, configuration->quality.enabled).toBool();
+      configuration->quality.reject = settings.value(SETTINGS_QC_REJECT, configuration->quality.reject).toBool();
+
+      for (std::size_t column = 0; column < COL_FIRST_DERIVED; column++)
+      {
+        SQualityLimits &limits = configuration->quality.limits[column];
+
+        limits.minimum = settings.value(qualityKey(column, "Minimum"), limits.minimum).toDouble();
+        limits.maximum = settings.value(qualityKey(column, "Maximum"), limits.maximum).toDouble();
+        limits.maximumRate = settings.value(qualityKey(column, "Rate"), limits.maximumRate).toDouble();
+        limits.spikeFactor = settings.value(qualityKey(column, "SpikeFactor"), limits.spikeFactor).toDouble();
+        limits.spikeFloor = settings.value(qualityKey(column, "SpikeFloor"), limits.spikeFloor).toDouble();
+        limits.flatlineMinutes = settings.value(qualityKey(column, "FlatlineMinutes"), limits.flatlineMinutes).toUInt();
+      };
+
+      int alertCount = settings.beginReadArray(SETTINGS_ALERTS);
+
+      for (int index = 0; index < alertCount; index++)
+      {
+        SAlertRuleConfiguration &rule = configuration->alertRules.emplace_back();
+
+        settings.setArrayIndex(index);
+        rule.name = settings.value("Name").toString();
+        rule.rule = settings.value("Rule").toString();
+        rule.command = settings.value("Command").toString();
+      };
+      settings.endArray();
+
+      configuration->retentionMonths = settings.value(SETTINGS_RETENTION_MONTHS, configuration->retentionMonths).toUInt();
+      configuration->retentionArchive = settings.value(SETTINGS_RETENTION_ARCHIVE, configuration->retentionArchive).toBool();
+      configuration->traceFile = settings.value(SETTINGS_TRACEFILE, configuration->traceFile).toString();
+      configuration->captureFile = settings.value(SETTINGS_CAPTUREFILE, configuration->captureFile).toString();
+      configuration->storeDirectory = settings.value(SETTINGS_STOREDIRECTORY, configuration->storeDirectory).toString();
+      configuration->apiAddress = settings.value(SETTINGS_APIADDRESS, configuration->apiAddress).toString();
+      configuration->apiPort = static_cast<std::uint16_t>(settings.value(SETTINGS_APIPORT, configuration->apiPort).toUInt());
+      configuration->upstreamAddress = settings.value(SETTINGS_UPSTREAM_ADDRESS, configuration->upstreamAddress).toString();
+      configuration->upstreamPort = static_cast<std::uint16_t>(settings.value(SETTINGS_UPSTREAM_PORT,
+                                                                              configuration->upstreamPort).toUInt());
+
+      configuration->database.driver = settings.value(WCL::settings::WEATHER_DATABASE, configuration->database.driver).toString();
+      configuration->database.hostAddress = settings.value(WCL::settings::WEATHER_MYSQL_HOSTADDRESS,
+                                                           configuration->database.hostAddress).toString();
+      configuration->database.port = static_cast<std::uint16_t>(settings.value(WCL::settings::WEATHER_MYSQL_PORT,
+                                                                               configuration->database.port).toUInt());
+      configuration->database.databaseName = settings.value(WCL::settings::WEATHER_MYSQL_DATABASENAME,
+                                                            configuration->database.databaseName).toString();
+      configuration->database.userName = settings.value(WCL::settings::WEATHER_MYSQL_USERNAME,
+                                                        configuration->database.userName).toString();
+      configuration->database.password = settings.value(WCL::settings::WEATHER_MYSQL_PASSWORD,
+                                                        configuration->database.password).toString();
+
+        // Command line.
+
+      if (commandLine.count("siteid"))
+      {
+        configuration->station.siteID = static_cast<std::uint32_t>(commandLine["siteid"].as<unsigned long>());
+      };
+      if (commandLine.count("instrumentid"))
+      {
+        configuration->station.instrumentID = static_cast<std::uint32_t>(commandLine["instrumentid"].as<unsigned long>());
+      };
+      if (commandLine.count("ipaddr"))
+      {
+        configuration->station.ipAddress = QString::fromStdString(commandLine["ipaddr"].as<std::string>());
+      };
+      if (commandLine.count("port"))
+      {
+        configuration->station.port = static_cast<std::uint16_t>(commandLine["port"].as<unsigned int>());
+      };
+      if (commandLine.count("pollinterval"))
+      {
+        configuration->pollInterval = commandLine["pollinterval"].as<unsigned int>();
+      };
+      if (commandLine.count("startupspread"))
+      {
+        configuration->startupSpread = commandLine["startupspread"].as<unsigned int>();
+      };
+      if (commandLine.count("rxinterval"))
+      {
+        configuration->receptionInterval = commandLine["rxinterval"].as<unsigned int>();
+      };
+      if (commandLine.count("strmon"))
+      {
+        configuration->radioMonitor = commandLine["strmon"].as<unsigned int>();
+      };
+      if (commandLine.count("lease"))
+      {
+        configuration->leaseTime = commandLine["lease"].as<unsigned int>();
+      };
+      if (commandLine.count("elevation"))
+      {
+        configuration->elevation = commandLine["elevation"].as<double>();
+      };
+      if (commandLine.count("tracefile"))
+      {
+        configuration->traceFile = QString::fromStdString(commandLine["tracefile"].as<std::string>());
+      };
+      if (commandLine.count("capture"))
+      {
+        configuration->captureFile = QString::fromStdString(commandLine["capture"].as<std::string>());
+      };
+      if (commandLine.count("storedir"))
+      {
+        configuration->storeDirectory = QString::fromStdString(commandLine["storedir"].as<std::string>());
+      };
+      if (commandLine.count("apiaddr"))
+      {
+        configuration->apiAddress = QString::fromStdString(commandLine["apiaddr"].as<std::string>());
+      };
+      if (commandLine.count("apiport"))
+      {
+        configuration->apiPort = static_cast<std::uint16_t>(commandLine["apiport"].as<unsigned int>());
+      };
+      if (commandLine.count("upstream"))
+      {
+        configuration->upstreamAddress = QString::fromStdString(commandLine["upstream"].as<std::string>());
+      };
+      if (commandLine.count("upstreamport"))
+      {
+        configuration->upstreamPort = static_cast<std::uint16_t>(commandLine["upstreamport"].as<unsigned int>());
+      };
+      if (commandLine.count("retention"))
+      {
+        configuration->retentionMonths = commandLine["retention"].as<unsigned int>();
+      };
+      if (commandLine.count("dbdriver"))
+      {
+        configuration->database.driver = QString::fromStdString(commandLine["dbdriver"].as<std::string>());
+      };
+      if (commandLine.count("dbip"))
+      {
+        configuration->database.hostAddress = QString::fromStdString(commandLine["dbip"].as<std::string>());
+      };
+      if (commandLine.count("dbport"))
+      {
+        configuration->database.port = static_cast<std::uint16_t>(commandLine["dbport"].as<unsigned int>());
+      };
+      if (commandLine.count("dbname"))
+      {
+        configuration->database.databaseName = QString::fromStdString(commandLine["dbname"].as<std::string>());
+      };
+      if (commandLine.count("dbuser"))
+      {
+        configuration->database.userName = QString::fromStdString(commandLine["dbuser"].as<std::string>());
+      };
+      if (commandLine.count("dbpassword"))
+      {
+        configuration->database.password = QString::fromStdString(commandLine["dbpassword"].as<std::string>());
+      };
+
+        // Validation.
+
+      configuration->database.driver = configuration->database.driver.toUpper();
+
+      if (configuration->station.ipAddress.isEmpty())
+      {
+        errorMessage += "Weather station IP address not specified. ";
+      };
+      if (configuration->station.port == 0)
+      {
+        errorMessage += "Weather station port not valid. ";
+      };
+      if ( (configuration->pollInterval == 0) || (configuration->pollInterval > 24 * 60) )
+      {
+        errorMessage += "Poll interval must be between 1 and 1440 minutes. ";
+      };
+      if (configuration->startupSpread > configuration->pollInterval * 60)
+      {
+        errorMessage += "Startup spread must not be longer than the poll interval. ";
+      };
+      if (configuration->receptionInterval > 24 * 60)
+      {
+        errorMessage += "Console diagnostics interval must not be longer than 1440 minutes. ";
+      };
+      if (configuration->radioMonitor > 60)
+      {
+        errorMessage += "Radio packets can be captured for at most 60 seconds. ";
+      };
+      if ( (configuration->radioMonitor != 0) && (configuration->receptionInterval == 0) )
+      {
+        errorMessage += "Radio packets are only captured when the console diagnostics are sampled. ";
+      };
+      if ( (configuration->leaseTime != 0) && ((configuration->leaseTime < 10) || (configuration->leaseTime > 600)) )
+      {
+        errorMessage += "Lease time must be between 10 and 600 seconds. ";
+      };
+      if ( (configuration->elevation < -500) || (configuration->elevation > 9000) )
+      {
+        errorMessage += "Elevation must be between -500 and 9000 m. ";
+      };
+      for (std::size_t column = 0; column < COL_FIRST_DERIVED; column++)
+      {
+        SQualityLimits const &limits = configuration->quality.limits[column];
+
+        if ( (limits.minimum > limits.maximum) || (limits.maximumRate < 0) || (limits.spikeFactor < 0) || (limits.spikeFloor < 0) )
+        {
+          errorMessage += std::string("Quality control thresholds of ") + columnName(static_cast<EColumn>(column)) + " not valid. ";
+        };
+      };
+      for (SAlertRuleConfiguration const &rule : configuration->alertRules)
+      {
+        std::string ruleError;
+
+        if (!CAlertRules::validate(rule, ruleError))
+        {
+          errorMessage += ruleError + " ";
+        };
+      };
+      if ( (configuration->database.driver != "MYSQL") && (configuration->database.driver != "SQLITE") )
+      {
+        errorMessage += "Database driver " + configuration->database.driver.toStdString() + " not supported. ";
+      };
+      if ( (configuration->database.driver == "MYSQL") && (configuration->database.port == 0) )
+      {
+        errorMessage += "Database port not valid. ";
+      };
+      if ( (configuration->database.driver == "SQLITE") && configuration->database.databaseName.isEmpty() )
+      {
+        errorMessage += "SQLite database file not specified. ";
+      };
+      if ( (configuration->apiPort != 0) && configuration->apiAddress.isEmpty() )
+      {
+        errorMessage += "Read API address not specified. ";
+      };
+      if ( !configuration->upstreamAddress.isEmpty() && (configuration->upstreamPort == 0) )
+      {
+        errorMessage += "Upstream daemon port not valid. ";
+      };
+
+      if (errorMessage.empty())
+      {
+        return configuration;
+      }
+      else
+      {
+        return nullptr;
+      };
+    }
+
+    /// @brief      Writes a configuration to the settings file.
+    /// @param[in]  configuration: The configuration to write.
+    /// @returns    true if the settings file was written.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Upstream daemon saved.
+    /// @version    2026-10-19/GGB - Lease of shared stations saved.
+    /// @version    2026-10-19/GGB - Sampling of the console diagnostics saved.
+    /// @version    2026-10-19/GGB - Startup spread saved.
+    /// @version    2026-10-19/GGB - Capture file of the console traffic saved.
+    /// @version    2026-10-19/GGB - Retention of the weather database saved.
+    /// @version    2026-10-19/GGB - File name of SQLite databases saved.
+    /// @version    2026-10-19/GGB - Alert rules saved.
+    /// @version    2026-10-19/GGB - Function created. (Replaces the writing of the settings in main(...))
+
+    bool save(SConfiguration const &configuration)
+    {
+      QSettings &settings = WCL::settings::settings;
+
+      settings.setValue(SETTINGS_SITEID, QVariant(configuration.station.siteID));
+      settings.setValue(SETTINGS_INSTRUMENTID, QVariant(configuration.station.instrumentID));
+      settings.setValue(WCL::settings::WS_IPADDRESS, QVariant(configuration.station.ipAddress));
+      settings.setValue(WCL::settings::WS_PORT, QVariant(configuration.station.port));
+      settings.setValue(WCL::settings::WS_POLLINTERVAL, QVariant(configuration.pollInterval));
+      settings.setValue(SETTINGS_STARTUPSPREAD, QVariant(configuration.startupSpread));
+      settings.setValue(SETTINGS_RECEPTION_INTERVAL, QVariant(configuration.receptionInterval));
+      settings.setValue(SETTINGS_RECEPTION_MONITOR, QVariant(configuration.radioMonitor));
+      settings.setValue(SETTINGS_LEASE_TIME, QVariant(configuration.leaseTime));
+      settings.setValue(SETTINGS_ELEVATION, QVariant(configuration.elevation));
+      settings.setValue(SETTINGS_QC_ENABLED, QVariant(configuration.quality.enabled));
+      settings.setValue(SETTINGS_QC_REJECT, QVariant(configuration.quality.reject));
+
+      for (std::size_t column = 0; column < COL_FIRST_DERIVED; column++)
+      {
+        SQualityLimits const &limits = configuration.quality.limits[column];
+
+        settings.setValue(qualityKey(column, "Minimum"), QVariant(limits.minimum));
+        settings.setValue(qualityKey(column, "Maximum"), QVariant(limits.maximum));
+        settings.setValue(qualityKey(column, "Rate"), QVariant(limits.maximumRate));
+        settings.setValue(qualityKey(column, "SpikeFactor"), QVariant(limits.spikeFactor));
+        settings.setValue(qualityKey(column, "SpikeFloor"), QVariant(limits.spikeFloor));
+        settings.setValue(qualityKey(column, "FlatlineMinutes"), QVariant(limits.flatlineMinutes));
+      };
+
+      settings.beginWriteArray(SETTINGS_ALERTS, static_cast<int>(configuration.alertRules.size()));
+      for (std::size_t index = 0; index < configuration.alertRules.size(); index++)
+      {
+        settings.setArrayIndex(static_cast<int>(index));
+        settings.setValue("Name", QVariant(configuration.alertRules[index].name));
+        settings.setValue("Rule", QVariant(configuration.alertRules[index].rule));
+        settings.setValue("Command", QVariant(configuration.alertRules[index].command));
+      };
+      settings.endArray();
+      settings.setValue(SETTINGS_RETENTION_MONTHS, QVariant(configuration.retentionMonths));
+      settings.setValue(SETTINGS_RETENTION_ARCHIVE, QVariant(configuration.retentionArchive));
+      settings.setValue(SETTINGS_TRACEFILE, QVariant(configuration.traceFile));
+      settings.setValue(SETTINGS_CAPTUREFILE, QVariant(configuration.captureFile));
+      settings.setValue(SETTINGS_STOREDIRECTORY, QVariant(configuration.storeDirectory));
+      settings.setValue(SETTINGS_APIADDRESS, QVariant(configuration.apiAddress));
+      settings.setValue(SETTINGS_APIPORT, QVariant(configuration.apiPort));
+      settings.setValue(SETTINGS_UPSTREAM_ADDRESS, QVariant(configuration.upstreamAddress));
+      settings.setValue(SETTINGS_UPSTREAM_PORT, QVariant(configuration.upstreamPort));
+
+      settings.setValue(WCL::settings::WEATHER_DATABASE, QVariant(configuration.database.driver));
+
+      if (configuration.database.driver == "MYSQL")
+      {
+        settings.setValue(WCL::settings::WEATHER_MYSQL_DRIVERNAME, QVariant(QCL::QDRV_MYSQL));
+        settings.setValue(WCL::settings::WEATHER_MYSQL_HOSTADDRESS, QVariant(configuration.database.hostAddress));
+        settings.setValue(WCL::settings::WEATHER_MYSQL_PORT, QVariant(configuration.database.port));
+        settings.setValue(WCL::settings::WEATHER_MYSQL_DATABASENAME, QVariant(configuration.database.databaseName));
+        settings.setValue(WCL::settings::WEATHER_MYSQL_USERNAME, QVariant(configuration.database.userName));
+        settings.setValue(WCL::settings::WEATHER_MYSQL_PASSWORD, QVariant(configuration.database.password));
+      }
+      else if (configuration.database.driver == "SQLITE")
+      {
+          // The database name is the file of the SQLite database. It is read from the same key for both drivers.
+
+        settings.setValue(WCL::settings::WEATHER_MYSQL_DATABASENAME, QVariant(configuration.database.databaseName));
+      };
+
+      settings.sync();
+
+      return (settings.status() == QSettings::NoError);
+    }
+
+    /// @brief      Returns the currently installed configuration snapshot.
+    /// @returns    The current snapshot. (nullptr if no snapshot has been installed.)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    PConfiguration current()
+    {
+      return std::atomic_load(&currentConfiguration);
+    }
+
+    /// @brief      Installs a new configuration snapshot. Holders of the previous snapshot are not affected.
+    /// @param[in]  configuration: The snapshot to install.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void install(PConfiguration configuration)
+    {
+      std::atomic_store(&currentConfiguration, std::move(configuration));
+    }
+
+  } // namespace configuration
+} // namespace WSd
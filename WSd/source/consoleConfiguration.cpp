@@ -0,0 +1,415 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								consoleConfiguration
+// SUBSYSTEM:						Console transactions
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt, WCL
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Cache of the configuration and calibration area of the console EEPROM. The area is read from the console
+//                      with EEBRD and kept in a local file, so that the setup of the console is known without a round trip on each
+//                      poll.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/consoleConfiguration.h"
+
+  // Standard C++ library header files
+
+#include <cmath>
+
+  // Miscellaneous library header files
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <WCL>
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+    // Cache file: magic, version, the length of the identity (uint16) and the identity, the EEPROM address and size (uint16) and
+    // the image as read from the console. (Including its CRC.) Integers are little endian.
+
+  static char const CACHE_MAGIC[4] = { 'W', 'S', 'D', 'E' };
+  static char const CACHE_VERSION = 1;
+
+    // Addresses in the configuration area of the EEPROM. (Vantage Serial Protocol.)
+
+  static std::size_t const EE_LATITUDE = 0x0B;              // int16, 0.1 degree. (North positive.)
+  static std::size_t const EE_LONGITUDE = 0x0D;             // int16, 0.1 degree. (East positive.)
+  static std::size_t const EE_ELEVATION = 0x0F;             // int16, ft.
+  static std::size_t const EE_USED_TRANSMITTERS = 0x17;     // Bit n set if transmitter n + 1 is received.
+  static std::size_t const EE_STATION_LIST = 0x19;          // Two bytes per transmitter. Type in the low nibble of the first.
+  static std::size_t const EE_UNIT_BITS = 0x29;
+  static std::size_t const EE_SETUP_BITS = 0x2B;            // Rain collector in bits 4 and 5.
+  static std::size_t const EE_ARCHIVE_PERIOD = 0x2D;        // Minutes.
+  static std::size_t const EE_TEMP_IN_CAL = 0x32;           // int8, 0.1 °F.
+  static std::size_t const EE_TEMP_OUT_CAL = 0x34;          // int8, 0.1 °F.
+  static std::size_t const EE_HUM_IN_CAL = 0x44;            // int8, %.
+  static std::size_t const EE_HUM_OUT_CAL = 0x45;           // int8, %.
+  static std::size_t const EE_DIR_CAL = 0x4D;               // int16, degrees.
+
+    // Offsets of the rain fields in a Rev B archive record.
+
+  static std::size_t const RECORD_RAINFALL = 10;
+  static std::size_t const RECORD_HIGH_RAIN_RATE = 12;
+
+  /// @brief      Appends a little endian 16 bit integer.
+  /// @param[in]  data: The buffer to append to.
+  /// @param[in]  value: The value to append.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static void appendUInt16(QByteArray &data, std::uint16_t value)
+  {
+    data.append(static_cast<char>(value & 0xFF));
+    data.append(static_cast<char>(value >> 8));
+  }
+
+  /// @brief      Reads a little endian 16 bit integer.
+  /// @param[in]  data: The buffer.
+  /// @param[in]  offset: The offset of the integer.
+  /// @returns    The integer.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::uint16_t readUInt16(QByteArray const &data, qsizetype offset)
+  {
+    return static_cast<std::uint16_t>(static_cast<std::uint8_t>(data[offset]) |
+                                      (static_cast<std::uint8_t>(data[offset + 1]) << 8));
+  }
+
+  /// @brief      Sets the cache file and the identity of the console, and loads the cached image. A cached image of a different
+  ///             console, or of a different version of the cache, is discarded.
+  /// @param[in]  newFileName: The cache file.
+  /// @param[in]  newIdentity: The identity of the console.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CConsoleConfiguration::setCache(QString const &newFileName, QString const &newIdentity)
+  {
+    QFile file(newFileName);
+    QByteArray data;
+    QByteArray identityData = newIdentity.toUtf8();
+    qsizetype imageOffset = sizeof(CACHE_MAGIC) + 3 + identityData.size() + 4;
+
+    fileName = newFileName;
+    identity = newIdentity;
+    image.clear();
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      return;
+    };
+
+    data = file.readAll();
+
+    if ( (data.size() < static_cast<qsizetype>(sizeof(CACHE_MAGIC)) + 3) ||
+         !data.startsWith(QByteArray(CACHE_MAGIC, sizeof(CACHE_MAGIC))) || (data[sizeof(CACHE_MAGIC)] != CACHE_VERSION) )
+    {
+      LOGINFO("Console configuration cache {} is not valid. Discarded.", fileName.toStdString());
+    }
+    else if ( (readUInt16(data, sizeof(CACHE_MAGIC) + 1) != identityData.size()) ||
+              (data.mid(sizeof(CACHE_MAGIC) + 3, identityData.size()) != identityData) )
+    {
+      LOGINFO("Console configuration cache {} is of a different console. Discarded.", fileName.toStdString());
+    }
+    else if ( (data.size() != imageOffset + EEPROM_SIZE + 2) || (readUInt16(data, imageOffset - 4) != EEPROM_ADDRESS) ||
+              (readUInt16(data, imageOffset - 2) != EEPROM_SIZE) ||
+              (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), imageOffset, EEPROM_SIZE + 2) != 0) )
+    {
+      LOGINFO("Console configuration cache {} is not valid. Discarded.", fileName.toStdString());
+    }
+    else
+    {
+      image = data.mid(imageOffset);
+      LOGDEBUG("Console configuration loaded from {}.", fileName.toStdString());
+    };
+  }
+
+  /// @brief      Replaces the image with an image read from the console. The cache file is rewritten if the image has changed.
+  /// @param[in]  response: The EEPROM_SIZE bytes read with EEBRD followed by the CRC. The CRC must have been checked.
+  /// @returns    true if the image has changed.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CConsoleConfiguration::update(QByteArray const &response)
+  {
+    QByteArray data;
+    QString temporaryName = fileName + ".new";
+    QFile file(temporaryName);
+
+    if (response == image)
+    {
+      return false;
+    };
+
+    image = response;
+    rainRemainder = 0;
+
+    LOGINFO("Console configuration changed. Archive period {} minutes, rain collector {} mm, unit bits {}.", archivePeriod(),
+            rainClick(), unitBits());
+
+    if (fileName.isEmpty())
+    {
+      return true;
+    };
+
+    data.append(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    data.append(CACHE_VERSION);
+    appendUInt16(data, static_cast<std::uint16_t>(identity.toUtf8().size()));
+    data.append(identity.toUtf8());
+    appendUInt16(data, EEPROM_ADDRESS);
+    appendUInt16(data, EEPROM_SIZE);
+    data.append(image);
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || (file.write(data) != data.size()) || !file.flush())
+    {
+      LOGERROR("Unable to write console configuration cache {}.", temporaryName.toStdString());
+    }
+    else
+    {
+      file.close();
+      QFile::remove(fileName);
+      if (!QFile::rename(temporaryName, fileName))
+      {
+        LOGERROR("Unable to replace console configuration cache {}.", fileName.toStdString());
+      };
+    };
+
+    return true;
+  }
+
+  /// @brief      Reads a 16 bit integer from the image.
+  /// @param[in]  offset: The EEPROM address.
+  /// @returns    The integer.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int16_t CConsoleConfiguration::int16(std::size_t offset) const
+  {
+    return static_cast<std::int16_t>(readUInt16(image, static_cast<qsizetype>(offset)));
+  }
+
+  /// @brief      Returns the archive period of the console.
+  /// @returns    The archive period (minutes). 0 if the setup is not known.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint8_t CConsoleConfiguration::archivePeriod() const
+  {
+    return valid() ? byte(EE_ARCHIVE_PERIOD) : 0;
+  }
+
+  /// @brief      Returns the size of a click of the rain collector.
+  /// @returns    The click size (mm). RAIN_CLICK_DEFAULT if the setup is not known.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double CConsoleConfiguration::rainClick() const
+  {
+    if (valid())
+    {
+      switch ((byte(EE_SETUP_BITS) >> 4) & 0x03)
+      {
+        case 0:
+          return 0.254;                                       // 0.01 in
+        case 2:
+          return 0.1;
+        default:
+          break;
+      };
+    };
+
+    return RAIN_CLICK_DEFAULT;
+  }
+
+  /// @brief      Returns the display units of the console. (Barometer bits 0-1, temperature 2-3, elevation 4, rain 5, wind 6-7.)
+  /// @returns    The unit bits. 0 if the setup is not known.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint8_t CConsoleConfiguration::unitBits() const
+  {
+    return valid() ? byte(EE_UNIT_BITS) : 0;
+  }
+
+  /// @brief      Returns the latitude of the station.
+  /// @returns    The latitude (degrees, north positive).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double CConsoleConfiguration::latitude() const
+  {
+    return valid() ? int16(EE_LATITUDE) / 10.0 : 0;
+  }
+
+  /// @brief      Returns the longitude of the station.
+  /// @returns    The longitude (degrees, east positive).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double CConsoleConfiguration::longitude() const
+  {
+    return valid() ? int16(EE_LONGITUDE) / 10.0 : 0;
+  }
+
+  /// @brief      Returns the elevation of the station.
+  /// @returns    The elevation (ft).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int16_t CConsoleConfiguration::elevation() const
+  {
+    return valid() ? int16(EE_ELEVATION) : 0;
+  }
+
+  /// @brief      Returns the transmitters received by the console.
+  /// @returns    Bit n is set if transmitter n + 1 is received.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint8_t CConsoleConfiguration::usedTransmitters() const
+  {
+    return valid() ? byte(EE_USED_TRANSMITTERS) : 0;
+  }
+
+  /// @brief      Returns the type of a transmitter in the station list. (0 - ISS, 1 - temperature, 2 - humidity, 3 - temperature
+  ///             and humidity, 4 - wind, 5 - rain, 6 - leaf, 7 - soil, 8 - soil and leaf, 9 - SensorLink, 10 - none.)
+  /// @param[in]  transmitter: The transmitter ID. (1 - 8)
+  /// @returns    The type. 10 if the transmitter is not known.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint8_t CConsoleConfiguration::transmitterType(int transmitter) const
+  {
+    if (!valid() || (transmitter < 1) || (transmitter > 8))
+    {
+      return 10;
+    };
+
+    return byte(EE_STATION_LIST + 2 * (transmitter - 1)) & 0x0F;
+  }
+
+  /// @brief      Returns the calibration offset of the inside temperature.
+  /// @returns    The offset (0.1 °F).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int8_t CConsoleConfiguration::insideTemperatureCalibration() const
+  {
+    return valid() ? static_cast<std::int8_t>(byte(EE_TEMP_IN_CAL)) : 0;
+  }
+
+  /// @brief      Returns the calibration offset of the outside temperature.
+  /// @returns    The offset (0.1 °F).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int8_t CConsoleConfiguration::outsideTemperatureCalibration() const
+  {
+    return valid() ? static_cast<std::int8_t>(byte(EE_TEMP_OUT_CAL)) : 0;
+  }
+
+  /// @brief      Returns the calibration offset of the inside humidity.
+  /// @returns    The offset (%).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int8_t CConsoleConfiguration::insideHumidityCalibration() const
+  {
+    return valid() ? static_cast<std::int8_t>(byte(EE_HUM_IN_CAL)) : 0;
+  }
+
+  /// @brief      Returns the calibration offset of the outside humidity.
+  /// @returns    The offset (%).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int8_t CConsoleConfiguration::outsideHumidityCalibration() const
+  {
+    return valid() ? static_cast<std::int8_t>(byte(EE_HUM_OUT_CAL)) : 0;
+  }
+
+  /// @brief      Returns the calibration offset of the wind direction.
+  /// @returns    The offset (degrees).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int16_t CConsoleConfiguration::windDirectionCalibration() const
+  {
+    return valid() ? int16(EE_DIR_CAL) : 0;
+  }
+
+  /// @brief      Converts the rain fields of an archive record read from the console to clicks of the rain collector assumed by
+  ///             the weather database. (As is done for records imported from .wlk files.) The rainfall of each record is rounded
+  ///             to whole clicks and the part of a click that is left is carried to the next record, so the rainfall totals
+  ///             are not biased by the rounding. The records must be normalised in time order.
+  /// @param[in,out] record: The archive record.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Rounding remainder of the rainfall carried to the next record.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CConsoleConfiguration::normaliseRecord(TRawRecord &record)
+  {
+    double click = rainClick();
+
+    if (click != RAIN_CLICK_DEFAULT)
+    {
+      double scale = click / RAIN_CLICK_DEFAULT;
+
+      for (std::size_t offset : { RECORD_RAINFALL, RECORD_HIGH_RAIN_RATE })
+      {
+        std::uint16_t clicks = static_cast<std::uint16_t>(record[offset] | (record[offset + 1] << 8));
+        long value;
+
+        if (offset == RECORD_RAINFALL)
+        {
+          double exact = clicks * scale + rainRemainder;
+
+          value = std::lround(exact);
+          rainRemainder = exact - value;
+        }
+        else
+        {
+          value = std::lround(clicks * scale);                  // A rate, not accumulated.
+        };
+
+        if (value > 0xFFFF)
+        {
+          value = 0xFFFF;
+        };
+
+        record[offset] = static_cast<std::uint8_t>(value & 0xFF);
+        record[offset + 1] = static_cast<std::uint8_t>((value >> 8) & 0xFF);
+      };
+    };
+  }
+
+} // namespace WSd
@@ -0,0 +1,459 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Derived
+// SUBSYSTEM:						Ingest
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Derived meteorological quantities (dew point, heat index, wind chill, THSW index, absolute humidity and
+//                      station pressure) computed for batches of decoded records when they are ingested. The kernels work on one
+//                      array per quantity and are branch free so that they are vectorised; a scalar reference implementation using
+//                      the standard library is used to check them and as the benchmark baseline.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/derived.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+
+  // WSd header files
+
+#include "include/tracer.h"
+
+namespace WSd
+{
+  namespace derived
+  {
+    float const MAGNUS_A = 17.625f;                   // Magnus coefficients. (Alduchov and Eskridge)
+    float const MAGNUS_B = 243.04f;                   // °C
+    float const GRAVITY_OVER_RD = 0.0341632f;         // g / Rd (K/m)
+    float const LAPSE_RATE = 0.0065f;                 // K/m
+    float const THSW_ABSORPTION = 0.1f;               // Fraction of the global radiation absorbed per unit of body surface.
+
+    //*****************************************************************************************************************************
+    //
+    // Vector kernel helpers. Branch free, with no library calls, so that the loops that use them can be vectorised.
+    //
+    //*****************************************************************************************************************************
+
+    /// @brief      Natural logarithm of a positive, normal value. The argument is reduced to [√½, √2) and the series of
+    ///             atanh used. (Accurate to a few ulp.)
+    /// @param[in]  x: The value. (Must be positive and normal.)
+    /// @returns    ln(x)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static inline float fastLog(float x)
+    {
+      std::int32_t bits = std::bit_cast<std::int32_t>(x);
+      float exponent = static_cast<float>(((bits >> 23) & 0xFF) - 127);
+      float mantissa = std::bit_cast<float>((bits & 0x007FFFFF) | 0x3F800000);
+      bool high = (mantissa > 1.41421356f);
+
+      mantissa = high ? mantissa * 0.5f : mantissa;
+      exponent = high ? exponent + 1.0f : exponent;
+
+      float t = (mantissa - 1.0f) / (mantissa + 1.0f);
+      float t2 = t * t;
+      float series = t * (2.0f + t2 * (0.66666667f + t2 * (0.4f + t2 * (0.28571429f + t2 * 0.22222222f))));
+
+      return exponent * 0.69314718f + series;
+    }
+
+    /// @brief      Limits a value to a range. (Takes its arguments by value, unlike std::clamp, so that it does not stop the loops
+    ///             that use it being vectorised.)
+    /// @param[in]  x: The value.
+    /// @param[in]  minimum: The minimum value.
+    /// @param[in]  maximum: The maximum value.
+    /// @returns    The limited value.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static inline float limit(float x, float minimum, float maximum)
+    {
+      x = (x < minimum) ? minimum : x;
+      return (x > maximum) ? maximum : x;
+    }
+
+    /// @brief      Exponential function. The argument is split into an integer and fractional power of 2.
+    /// @param[in]  x: The value. (Results that would underflow or overflow a float are clamped.)
+    /// @returns    e^x
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static inline float fastExp(float x)
+    {
+      float y = x * 1.44269504f;
+
+      y = limit(y, -126.0f, 126.0f);
+
+      std::int32_t integer = static_cast<std::int32_t>(y + (y < 0.0f ? -0.5f : 0.5f));
+      float z = (y - static_cast<float>(integer)) * 0.69314718f;
+      float polynomial = 1.0f + z * (1.0f + z * (0.5f + z * (0.16666667f + z * (0.041666668f + z * (0.0083333338f +
+                         z * 0.0013888889f)))));
+      return polynomial * std::bit_cast<float>((integer + 127) << 23);
+    }
+
+    /// @brief      Raises a positive value to a power.
+    /// @param[in]  x: The value. (Values less than 1e-6 are treated as 1e-6.)
+    /// @param[in]  power: The power.
+    /// @returns    x^power
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static inline float fastPow(float x, float power)
+    {
+      return fastExp(power * fastLog((x < 1e-6f) ? 1e-6f : x));
+    }
+
+    /// @brief      Resizes all the arrays of the batch.
+    /// @param[in]  size: The number of records.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void SBatch::resize(std::size_t size)
+    {
+      for (std::vector<float> *array : { &temperature, &humidity, &windSpeed, &solarRadiation, &barometer, &dewPoint, &heatIndex,
+                                         &windChill, &thswIndex, &absoluteHumidity, &stationPressure })
+      {
+        array->resize(size);
+      };
+    }
+
+    /// @brief      Computes the derived quantities one record at a time, using the standard library. This is the reference
+    ///             implementation for the vector kernels.
+    /// @param[in]  batch: The batch. The outputs are written.
+    /// @param[in]  elevation: The elevation of the station (m).
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void computeScalar(SBatch &batch, float elevation)
+    {
+      for (std::size_t index = 0; index < batch.size(); index++)
+      {
+        double temperature = batch.temperature[index];
+        double humidity = std::clamp<double>(batch.humidity[index], 1, 100);
+        double windSpeed = batch.windSpeed[index];
+        double fahrenheit = temperature * 9 / 5 + 32;
+        double mph = windSpeed / 0.44704;
+
+          // Dew point. (Magnus)
+
+        double gamma = std::log(humidity / 100) + MAGNUS_A * temperature / (MAGNUS_B + temperature);
+
+        batch.dewPoint[index] = static_cast<float>(MAGNUS_B * gamma / (MAGNUS_A - gamma));
+
+          // Heat index. (NWS: Steadman's simple formula, and the Rothfusz regression with its adjustments above 80 °F.)
+
+        double heatIndex = 0.5 * (fahrenheit + 61 + (fahrenheit - 68) * 1.2 + humidity * 0.094);
+
+        if ((heatIndex + fahrenheit) / 2 >= 80)
+        {
+          heatIndex = -42.379 + 2.04901523 * fahrenheit + 10.14333127 * humidity - 0.22475541 * fahrenheit * humidity -
+                      0.00683783 * fahrenheit * fahrenheit - 0.05481717 * humidity * humidity +
+                      0.00122874 * fahrenheit * fahrenheit * humidity + 0.00085282 * fahrenheit * humidity * humidity -
+                      0.00000199 * fahrenheit * fahrenheit * humidity * humidity;
+
+          if ( (humidity < 13) && (fahrenheit >= 80) && (fahrenheit <= 112) )
+          {
+            heatIndex -= ((13 - humidity) / 4) * std::sqrt((17 - std::fabs(fahrenheit - 95)) / 17);
+          }
+          else if ( (humidity > 85) && (fahrenheit >= 80) && (fahrenheit <= 87) )
+          {
+            heatIndex += ((humidity - 85) / 10) * ((87 - fahrenheit) / 5);
+          };
+        };
+        batch.heatIndex[index] = static_cast<float>((heatIndex - 32) * 5 / 9);
+
+          // Wind chill. (NWS 2001. Only defined at or below 50 °F and at or above 3 mph.)
+
+        if ( (fahrenheit <= 50) && (mph >= 3) )
+        {
+          double power = std::pow(mph, 0.16);
+          double windChill = 35.74 + 0.6215 * fahrenheit - 35.75 * power + 0.4275 * fahrenheit * power;
+
+          batch.windChill[index] = static_cast<float>((windChill - 32) * 5 / 9);
+        }
+        else
+        {
+          batch.windChill[index] = static_cast<float>(temperature);
+        };
+
+          // THSW. (Steadman's apparent temperature including the radiation absorbed.)
+
+        double vapourPressure = humidity / 100 * 6.105 * std::exp(17.27 * temperature / (237.7 + temperature));
+        double absorbed = THSW_ABSORPTION * batch.solarRadiation[index];
+
+        batch.thswIndex[index] = static_cast<float>(temperature + 0.348 * vapourPressure - 0.70 * windSpeed +
+                                                    0.70 * absorbed / (windSpeed + 10) - 4.25);
+
+          // Absolute humidity.
+
+        batch.absoluteHumidity[index] = static_cast<float>(6.112 * std::exp(17.67 * temperature / (temperature + 243.5)) *
+                                                           humidity * 2.1674 / (273.15 + temperature));
+
+          // Station pressure. (Hypsometric equation, using the mean temperature of the layer below the station.)
+
+        double meanTemperature = temperature + 273.15 + LAPSE_RATE * elevation / 2;
+
+        batch.stationPressure[index] = static_cast<float>(batch.barometer[index] *
+                                                          std::exp(-GRAVITY_OVER_RD * elevation / meanTemperature));
+      };
+    }
+
+    /// @brief      Computes the derived quantities with branch free kernels, one quantity at a time, so that each loop is
+    ///             vectorised.
+    /// @param[in]  batch: The batch. The outputs are written.
+    /// @param[in]  elevation: The elevation of the station (m).
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void computeVector(SBatch &batch, float elevation)
+    {
+      int const size = static_cast<int>(batch.size());
+      float const *temperature = batch.temperature.data();
+      float const *humidity = batch.humidity.data();
+      float const *windSpeed = batch.windSpeed.data();
+      float const *solarRadiation = batch.solarRadiation.data();
+      float const *barometer = batch.barometer.data();
+      float *dewPoint = batch.dewPoint.data();
+      float *heatIndex = batch.heatIndex.data();
+      float *windChill = batch.windChill.data();
+      float *thswIndex = batch.thswIndex.data();
+      float *absoluteHumidity = batch.absoluteHumidity.data();
+      float *stationPressure = batch.stationPressure.data();
+
+#pragma omp simd
+      for (int index = 0; index < size; index++)
+      {
+        float t = temperature[index];
+        float rh = limit(humidity[index], 1.0f, 100.0f);
+        float gamma = fastLog(rh * 0.01f) + MAGNUS_A * t / (MAGNUS_B + t);
+
+        dewPoint[index] = MAGNUS_B * gamma / (MAGNUS_A - gamma);
+      };
+
+#pragma omp simd
+      for (int index = 0; index < size; index++)
+      {
+        float f = temperature[index] * 1.8f + 32.0f;
+        float rh = limit(humidity[index], 1.0f, 100.0f);
+        float simple = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f + rh * 0.094f);
+        float full = -42.379f + 2.04901523f * f + 10.14333127f * rh - 0.22475541f * f * rh - 0.00683783f * f * f -
+                     0.05481717f * rh * rh + 0.00122874f * f * f * rh + 0.00085282f * f * rh * rh - 0.00000199f * f * f * rh * rh;
+        float dry = ((13.0f - rh) * 0.25f) * fastPow((17.0f - std::fabs(f - 95.0f)) * (1.0f / 17.0f), 0.5f);
+        float wet = ((rh - 85.0f) * 0.1f) * ((87.0f - f) * 0.2f);
+
+        float dryAdjusted = (std::fabs(f - 96.0f) <= 16.0f) ? full - dry : full;          // 80 - 112 °F
+        float wetAdjusted = (std::fabs(f - 83.5f) <= 3.5f) ? full + wet : full;           // 80 - 87 °F
+
+        full = (rh < 13.0f) ? dryAdjusted : ((rh > 85.0f) ? wetAdjusted : full);
+
+        float result = ((simple + f) * 0.5f >= 80.0f) ? full : simple;
+
+        heatIndex[index] = (result - 32.0f) * (5.0f / 9.0f);
+      };
+
+#pragma omp simd
+      for (int index = 0; index < size; index++)
+      {
+        float t = temperature[index];
+        float f = t * 1.8f + 32.0f;
+        float mph = windSpeed[index] * (1.0f / 0.44704f);
+        float power = fastPow(mph, 0.16f);
+        float chill = (35.74f + 0.6215f * f - 35.75f * power + 0.4275f * f * power - 32.0f) * (5.0f / 9.0f);
+
+        windChill[index] = ( (f <= 50.0f) & (mph >= 3.0f) ) ? chill : t;
+      };
+
+#pragma omp simd
+      for (int index = 0; index < size; index++)
+      {
+        float t = temperature[index];
+        float rh = limit(humidity[index], 1.0f, 100.0f);
+        float v = windSpeed[index];
+        float saturation = fastExp(17.27f * t / (237.7f + t));
+        float vapourPressure = rh * 0.01f * 6.105f * saturation;
+
+        thswIndex[index] = t + 0.348f * vapourPressure - 0.70f * v + 0.70f * THSW_ABSORPTION * solarRadiation[index] / (v + 10.0f) -
+                           4.25f;
+        absoluteHumidity[index] = 6.112f * fastExp(17.67f * t / (t + 243.5f)) * rh * 2.1674f / (273.15f + t);
+      };
+
+#pragma omp simd
+      for (int index = 0; index < size; index++)
+      {
+        float meanTemperature = temperature[index] + 273.15f + LAPSE_RATE * elevation * 0.5f;
+
+        stationPressure[index] = barometer[index] * fastExp(-GRAVITY_OVER_RD * elevation / meanTemperature);
+      };
+    }
+
+    /// @brief      Converts a temperature to console units.
+    /// @param[in]  celsius: The temperature (°C).
+    /// @returns    The temperature (0.1 °F).
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::int32_t consoleTemperature(float celsius)
+    {
+      return static_cast<std::int32_t>(std::lround((celsius * 1.8f + 32.0f) * 10.0f));
+    }
+
+    /// @brief      Computes the derived columns of a batch of decoded records. A derived column is only set if the columns it
+    ///             is derived from have good values; otherwise it is NO_VALUE.
+    /// @param[in]  records: The records. The derived columns are written.
+    /// @param[in]  elevation: The elevation of the station (m).
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Values flagged by the quality control are not used.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void compute(std::vector<SArchiveRecord> &records, double elevation)
+    {
+      SBatch batch;
+
+      TRACESPAN("derived", records.size());
+
+      batch.resize(records.size());
+
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        SArchiveRecord const &record = records[index];
+
+        batch.temperature[index] = record.isGood(COL_OUTSIDE_TEMPERATURE) ?
+                                     static_cast<float>(record.value(COL_OUTSIDE_TEMPERATURE)) : 0.0f;
+        batch.humidity[index] = record.isGood(COL_OUTSIDE_HUMIDITY) ? record.values[COL_OUTSIDE_HUMIDITY] : 50.0f;
+        batch.windSpeed[index] = record.isGood(COL_AVERAGE_WIND_SPEED) ?
+                                   static_cast<float>(record.value(COL_AVERAGE_WIND_SPEED)) : 0.0f;
+        batch.solarRadiation[index] = record.isGood(COL_SOLAR_RADIATION) ? record.values[COL_SOLAR_RADIATION] : 0.0f;
+        batch.barometer[index] = record.isGood(COL_BAROMETER) ? static_cast<float>(record.value(COL_BAROMETER)) : 1013.25f;
+      };
+
+      computeVector(batch, static_cast<float>(elevation));
+
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        SArchiveRecord &record = records[index];
+        bool temperature = record.isGood(COL_OUTSIDE_TEMPERATURE);
+        bool humidity = temperature && record.isGood(COL_OUTSIDE_HUMIDITY);
+        bool wind = temperature && record.isGood(COL_AVERAGE_WIND_SPEED);
+
+        record.values[COL_DEW_POINT] = humidity ? consoleTemperature(batch.dewPoint[index]) : NO_VALUE;
+        record.values[COL_HEAT_INDEX] = humidity ? consoleTemperature(batch.heatIndex[index]) : NO_VALUE;
+        record.values[COL_WIND_CHILL] = wind ? consoleTemperature(batch.windChill[index]) : NO_VALUE;
+        record.values[COL_THSW_INDEX] = (humidity && wind && record.isGood(COL_SOLAR_RADIATION)) ?
+                                          consoleTemperature(batch.thswIndex[index]) : NO_VALUE;
+        record.values[COL_ABSOLUTE_HUMIDITY] = humidity ?
+                                                 static_cast<std::int32_t>(std::lround(batch.absoluteHumidity[index] * 100.0f)) :
+                                                 NO_VALUE;
+        record.values[COL_STATION_PRESSURE] = (temperature && record.isGood(COL_BAROMETER)) ?
+              static_cast<std::int32_t>(std::lround(batch.stationPressure[index] / 0.0338638866667)) : NO_VALUE;
+      };
+    }
+
+    /// @brief      Times the scalar and vector implementations over a synthetic batch and writes the results.
+    /// @param[in]  os: The stream to write the results to.
+    /// @param[in]  size: The number of records in the batch.
+    /// @param[in]  elevation: The elevation of the station (m).
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void benchmark(std::ostream &os, std::size_t size, double elevation)
+    {
+      typedef std::chrono::steady_clock TClock;
+
+      SBatch scalar;
+      SBatch vector;
+      std::uint32_t seed = 1;
+      auto random = [&seed](float minimum, float maximum)
+      {
+        seed = seed * 1664525 + 1013904223;
+        return minimum + (maximum - minimum) * static_cast<float>(seed >> 8) / 16777216.0f;
+      };
+
+      scalar.resize(size);
+
+      for (std::size_t index = 0; index < size; index++)
+      {
+        scalar.temperature[index] = random(-30, 45);
+        scalar.humidity[index] = random(5, 100);
+        scalar.windSpeed[index] = random(0, 25);
+        scalar.solarRadiation[index] = random(0, 1100);
+        scalar.barometer[index] = random(960, 1045);
+      };
+      vector = scalar;
+
+      auto time = [&](auto function, SBatch &batch)
+      {
+        double best = 1e300;
+
+        for (int pass = 0; pass < 5; pass++)
+        {
+          TClock::time_point start = TClock::now();
+
+          function(batch, static_cast<float>(elevation));
+          best = std::min(best, std::chrono::duration<double, std::nano>(TClock::now() - start).count());
+        };
+
+        return best / static_cast<double>(size);
+      };
+
+      double scalarTime = time(computeScalar, scalar);
+      double vectorTime = time(computeVector, vector);
+
+      float maximumError = 0;
+      float maximumPressureError = 0;
+      float maximumHumidityError = 0;
+
+      for (std::size_t index = 0; index < size; index++)
+      {
+        for (auto member : { &SBatch::dewPoint, &SBatch::heatIndex, &SBatch::windChill, &SBatch::thswIndex })
+        {
+          maximumError = std::max(maximumError, std::fabs((scalar.*member)[index] - (vector.*member)[index]));
+        };
+        maximumHumidityError = std::max(maximumHumidityError,
+                                        std::fabs(scalar.absoluteHumidity[index] - vector.absoluteHumidity[index]));
+        maximumPressureError = std::max(maximumPressureError,
+                                        std::fabs(scalar.stationPressure[index] - vector.stationPressure[index]));
+      };
+
+      os << std::defaultfloat << "Derived quantities, " << size << " records, elevation " << elevation << " m" << std::endl;
+      os << std::fixed << std::setprecision(2);
+      os << "  scalar: " << scalarTime << " ns/record" << std::endl;
+      os << "  vector: " << vectorTime << " ns/record" << std::endl;
+      os << "  speedup: " << scalarTime / vectorTime << "x" << std::endl;
+      os << std::setprecision(5);
+      os << "  maximum difference: " << maximumError << " °C, " << maximumHumidityError << " g/m³, " << maximumPressureError
+         << " hPa" << std::endl;
+    }
+
+  } // namespace derived
+} // namespace WSd
@@ -0,0 +1,309 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								executor
+// SUBSYSTEM:						Executor
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Work stealing executor. One worker thread per core, each with its own queue of tasks. A worker runs the
+//                      newest task of its own queue and, when its queue is empty, steals the oldest task of another worker, so that
+//                      CPU heavy work is spread over all the cores.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/executor.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <exception>
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+    // The executor and queue of the worker running on the current thread. Tasks submitted by a worker are queued on its own
+    // queue, where they are run newest first while their data is still in the cache of the core.
+
+  static std::size_t const NO_QUEUE = static_cast<std::size_t>(-1);
+  static thread_local CExecutor const *currentExecutor = nullptr;
+  static thread_local std::size_t currentQueue = NO_QUEUE;
+
+  /// @brief      Constructor. Starts the workers.
+  /// @param[in]  threads: The number of workers. 0 for one per core.
+  /// @throws     std::bad_alloc, std::system_error
+  /// @version    2026-10-19/GGB - Function created.
+
+  CExecutor::CExecutor(unsigned int threads)
+  {
+    if (threads == 0)
+    {
+      threads = std::max(1U, std::thread::hardware_concurrency());
+    };
+
+    for (unsigned int index = 0; index < threads; index++)
+    {
+      queues.push_back(std::make_unique<SQueue>());
+    };
+
+    for (unsigned int index = 0; index < threads; index++)
+    {
+      workers.emplace_back(&CExecutor::workerFunction, this, index);
+    };
+  }
+
+  /// @brief      Destructor. The queued tasks are run before the workers stop.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CExecutor::~CExecutor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+    }
+    wakeup.notify_all();
+
+    for (std::thread &worker : workers)
+    {
+      worker.join();
+    };
+  }
+
+  /// @brief      Returns the executor shared by the daemon. It is created when it is first used.
+  /// @returns    The executor.
+  /// @throws     std::bad_alloc, std::system_error
+  /// @version    2026-10-19/GGB - Function created.
+
+  CExecutor &CExecutor::global()
+  {
+    static CExecutor executor;
+
+    return executor;
+  }
+
+  /// @brief      Queues a task. The task must not throw.
+  /// @param[in]  task: The task.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CExecutor::submit(TTask task)
+  {
+    std::size_t index = (currentExecutor == this) ? currentQueue : nextQueue++ % queues.size();
+
+    {
+      std::lock_guard<std::mutex> lock(queues[index]->mutex);
+      queues[index]->tasks.push_back(std::move(task));
+    }
+    queuedTasks++;
+
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);     // Orders the count with the test made by a worker going to sleep.
+    }
+    wakeup.notify_one();
+  }
+
+  /// @brief      Takes a task. The newest task of the own queue is taken, otherwise the oldest task of another queue.
+  /// @param[in]  own: The queue of the calling worker. NO_QUEUE if the caller is not a worker.
+  /// @param[out] task: The task taken.
+  /// @returns    true if a task was taken.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CExecutor::takeTask(std::size_t own, TTask &task)
+  {
+    if (queuedTasks == 0)
+    {
+      return false;
+    };
+
+    if (own != NO_QUEUE)
+    {
+      std::lock_guard<std::mutex> lock(queues[own]->mutex);
+
+      if (!queues[own]->tasks.empty())
+      {
+        task = std::move(queues[own]->tasks.back());
+        queues[own]->tasks.pop_back();
+        queuedTasks--;
+        return true;
+      };
+    };
+
+    for (std::size_t offset = 1; offset <= queues.size(); offset++)
+    {
+      std::size_t victim = ((own == NO_QUEUE) ? offset : own + offset) % queues.size();
+      std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+
+      if (!queues[victim]->tasks.empty())
+      {
+        task = std::move(queues[victim]->tasks.front());
+        queues[victim]->tasks.pop_front();
+        queuedTasks--;
+        return true;
+      };
+    };
+
+    return false;
+  }
+
+  /// @brief      Runs one queued task on the calling thread. Used by threads that are waiting for tasks to complete.
+  /// @returns    true if a task was run.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CExecutor::runPending()
+  {
+    TTask task;
+
+    if (takeTask((currentExecutor == this) ? currentQueue : NO_QUEUE, task))
+    {
+      try
+      {
+        task();
+      }
+      catch (...)
+      {
+        LOGERROR("Executor task failed.");
+      };
+      return true;
+    };
+
+    return false;
+  }
+
+  /// @brief      The worker thread. Runs tasks until the executor is destroyed and the queues are empty.
+  /// @param[in]  index: The queue of the worker.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CExecutor::workerFunction(std::size_t index)
+  {
+    currentExecutor = this;
+    currentQueue = index;
+
+    while (true)
+    {
+      TTask task;
+
+      if (takeTask(index, task))
+      {
+        try
+        {
+          task();
+        }
+        catch (...)
+        {
+          LOGERROR("Executor task failed.");
+        };
+      }
+      else
+      {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+
+        wakeup.wait(lock, [this]() { return stopping || (queuedTasks != 0); });
+
+        if (stopping && (queuedTasks == 0))
+        {
+          break;
+        };
+      };
+    };
+  }
+
+  /// @brief      Calls a function for each index in [0, count) on the pool and waits for all the calls to complete. The indexes
+  ///             are taken from a shared counter, so the work is balanced between the workers. The calling thread also takes
+  ///             indexes, and runs queued tasks while it waits.
+  /// @param[in]  count: The number of indexes.
+  /// @param[in]  function: The function to call.
+  /// @throws     The first exception thrown by the function. (The remaining indexes are not called.)
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CExecutor::parallelFor(std::size_t count, std::function<void(std::size_t)> const &function)
+  {
+    struct SState
+    {
+      std::atomic<std::size_t> next = 0;
+      std::atomic<std::size_t> active = 0;
+      std::mutex mutex;
+      std::exception_ptr exception;
+    };
+
+    std::shared_ptr<SState> state = std::make_shared<SState>();
+    std::size_t helpers = std::min(workers.size(), (count == 0) ? 0 : count - 1);
+
+    auto body = [state, &function, count]()
+    {
+      try
+      {
+        for (std::size_t index = state->next++; index < count; index = state->next++)
+        {
+          function(index);
+        };
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+
+        if (!state->exception)
+        {
+          state->exception = std::current_exception();
+        };
+        state->next = count;
+      };
+    };
+
+    state->active = helpers;
+
+    for (std::size_t helper = 0; helper < helpers; helper++)
+    {
+      submit([state, body]()
+      {
+        body();
+        state->active--;
+      });
+    };
+
+    body();
+
+      // The helpers reference the function, so they must all complete before returning. Helpers that have not started yet are
+      // run here if no worker has taken them.
+
+    while (state->active != 0)
+    {
+      if (!runPending())
+      {
+        std::this_thread::yield();
+      };
+    };
+
+    if (state->exception)
+    {
+      std::rethrow_exception(state->exception);
+    };
+  }
+
+} // namespace WSd
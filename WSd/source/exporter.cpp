@@ -0,0 +1,476 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								exporter
+// SUBSYSTEM:						Export
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Bulk export of the history of a station to CSV or columnar files. The records are read in chunks from the
+//                      local store and the weather database, and the chunks are encoded in parallel and written in order.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/exporter.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+
+  // Miscellaneous library header files
+
+#include <QFile>
+
+  // WSd header files
+
+#include "include/compression.h"
+#include "include/executor.h"
+#include "include/logger.h"
+#include "include/sqlArchive.h"
+#include "include/timeSeriesStore.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+  namespace exporter
+  {
+    static std::size_t const CHUNK_RECORDS = 16384;             // Records read, encoded and written at a time.
+    static std::int64_t const CHUNK_SECONDS = 16384 * 60;       // Store window. Archive periods are at least a minute.
+    static char const COLUMNAR_MAGIC[] = { 'W', 'S', 'D', 'C' };
+    static std::uint8_t const COLUMNAR_VERSION = 1;
+    static char const DATABASE_CONNECTION[] = "WSd-export";
+
+    /// @brief      Appends a little endian 32 bit integer.
+    /// @param[in]  buffer: The buffer to append to.
+    /// @param[in]  value: The value.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void appendUInt32(std::string &buffer, std::uint32_t value)
+    {
+      for (int byte = 0; byte < 4; byte++)
+      {
+        buffer.push_back(static_cast<char>((value >> (8 * byte)) & 0xFF));
+      };
+    }
+
+    /// @brief      Encodes a chunk of records as CSV lines. The time is written as YYYY-MM-DDTHH:MM, the values in SI units
+    ///             with an empty field for missing values, and the last field lists the values flagged by the quality control.
+    /// @param[in]  records: The records.
+    /// @param[in]  columns: The columns to write.
+    /// @returns    The lines.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::string encodeCsv(std::vector<SArchiveRecord> const &records, std::vector<EColumn> const &columns)
+    {
+      std::string buffer;
+      char text[32];
+
+      buffer.reserve(records.size() * (18 + 8 * columns.size()));
+
+      for (SArchiveRecord const &record : records)
+      {
+        int year, month, day, hour, minute;
+
+        SArchiveRecord::splitTimeStamp(record.timeStamp, year, month, day, hour, minute);
+        std::snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d", year, month, day, hour, minute);
+        buffer.append(text);
+
+        for (EColumn column : columns)
+        {
+          double value = record.value(column);
+
+          buffer.push_back(',');
+          if (!std::isnan(value))
+          {
+            std::to_chars_result result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, 6);
+
+            buffer.append(text, result.ptr);
+          };
+        };
+
+        buffer.push_back(',');
+        if (record.qualityCodes != 0)
+        {
+          bool first = true;
+
+          for (EColumn column : columns)
+          {
+            if (!record.isGood(column))
+            {
+              buffer.append(first ? "" : ";").append(columnName(column)).append("=").append(qualityName(record.quality(column)));
+              first = false;
+            };
+          };
+        };
+        buffer.push_back('\n');
+      };
+
+      return buffer;
+    }
+
+    /// @brief      Encodes a chunk of records as a columnar block. The block is the number of records and the length of the
+    ///             data (uint32, little endian), followed by the data: the time stamps (delta of delta), the values of each
+    ///             column in console units (delta) and the quality codes (delta), as a bit stream.
+    /// @param[in]  records: The records.
+    /// @param[in]  columns: The columns to write.
+    /// @returns    The block.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::string encodeColumnar(std::vector<SArchiveRecord> const &records, std::vector<EColumn> const &columns)
+    {
+      std::vector<std::uint8_t> data;
+      CBitWriter writer(data);
+      std::string buffer;
+
+      data.reserve(records.size() * (2 + columns.size()));
+
+      {
+        CDeltaEncoder encoder(true);
+
+        for (SArchiveRecord const &record : records)
+        {
+          encoder.encode(writer, record.timeStamp);
+        };
+      };
+
+      for (EColumn column : columns)
+      {
+        CDeltaEncoder encoder;
+
+        for (SArchiveRecord const &record : records)
+        {
+          encoder.encode(writer, record.values[column]);
+        };
+      };
+
+      {
+        CDeltaEncoder encoder;
+
+        for (SArchiveRecord const &record : records)
+        {
+          encoder.encode(writer, static_cast<std::int64_t>(record.qualityCodes));
+        };
+      };
+
+      buffer.reserve(8 + data.size());
+      appendUInt32(buffer, static_cast<std::uint32_t>(records.size()));
+      appendUInt32(buffer, static_cast<std::uint32_t>(data.size()));
+      buffer.append(reinterpret_cast<char const *>(data.data()), data.size());
+
+      return buffer;
+    }
+
+    /// @brief      Parses the name of an export format.
+    /// @param[in]  text: The name. (csv or columnar)
+    /// @param[out] format: The format.
+    /// @returns    true if the name is valid.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool parseFormat(std::string const &text, EFormat &format)
+    {
+      if (text == "csv")
+      {
+        format = FMT_CSV;
+      }
+      else if (text == "columnar")
+      {
+        format = FMT_COLUMNAR;
+      }
+      else
+      {
+        return false;
+      };
+
+      return true;
+    }
+
+    /// @brief      Parses a comma separated list of column names.
+    /// @param[in]  text: The list.
+    /// @param[out] columns: The columns.
+    /// @returns    true if all the names are valid.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool parseColumns(std::string const &text, std::vector<EColumn> &columns)
+    {
+      std::size_t start = 0;
+
+      columns.clear();
+
+      while (start <= text.size())
+      {
+        std::size_t end = std::min(text.find(',', start), text.size());
+        std::string name = text.substr(start, end - start);
+
+        if (!name.empty())
+        {
+          std::size_t column = 0;
+
+          while ( (column < COL_COUNT) && (name != columnName(static_cast<EColumn>(column))) )
+          {
+            column++;
+          };
+
+          if (column == COL_COUNT)
+          {
+            return false;
+          };
+          columns.push_back(static_cast<EColumn>(column));
+        };
+        start = end + 1;
+      };
+
+      return !columns.empty();
+    }
+
+    /// @brief      Exports the records of the configured station in a time range. Records from the start of the local store
+    ///             are read from the store and older records from the weather database, a chunk at a time. Each chunk is
+    ///             encoded by a worker while the next chunk is read, and the encoded chunks are written in order. The number of
+    ///             chunks in flight is bounded, so the memory used does not depend on the length of the range.
+    /// @param[in]  parameters: The file, format, range and columns.
+    /// @param[in]  configuration: The configuration snapshot.
+    /// @param[in]  out: The stream progress is written to.
+    /// @returns    true if the export succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Store chunks are time windows, sorted by time.
+    /// @version    2026-10-19/GGB - Chunks encoded on the shared executor.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool exportRange(SExport const &parameters, configuration::SConfiguration const &configuration, std::ostream &out)
+    {
+      std::uint32_t siteID = configuration.station.siteID;
+      std::uint32_t instrumentID = configuration.station.instrumentID;
+      std::vector<EColumn> columns = parameters.columns;
+      std::unique_ptr<CTimeSeriesStore> store;
+      std::int64_t storeFirst = INT64_MAX;
+      std::int64_t storeLast = INT64_MIN;
+      bool databaseOpen = false;
+      bool databaseFailed = false;
+      QFile file(parameters.fileName);
+      std::deque<std::future<std::string>> pending;
+      std::size_t maximumPending = std::max<std::size_t>(2, CExecutor::global().size() + 1);
+      std::int64_t nextTime = parameters.from;
+      std::size_t totalRecords = 0;
+      std::uint64_t totalBytes = 0;
+      bool returnValue = true;
+      auto startTime = std::chrono::steady_clock::now();
+
+      TRACESPAN("export");
+
+      if (columns.empty())
+      {
+        for (std::size_t column = 0; column < COL_COUNT; column++)
+        {
+          columns.push_back(static_cast<EColumn>(column));
+        };
+      };
+
+      if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      {
+        out << "Unable to create " << parameters.fileName.toStdString() << std::endl;
+        return false;
+      };
+
+        // Writes the encoded chunks until no more than 'keep' are in flight.
+
+      auto write = [&](std::size_t keep)
+      {
+        while (pending.size() > keep)
+        {
+          std::string block = pending.front().get();
+
+          pending.pop_front();
+          if (returnValue && (file.write(block.data(), static_cast<qint64>(block.size())) != static_cast<qint64>(block.size())))
+          {
+            out << "Unable to write " << parameters.fileName.toStdString() << std::endl;
+            returnValue = false;
+          };
+          totalBytes += block.size();
+        };
+      };
+
+      {
+        std::string header;
+
+        if (parameters.format == FMT_CSV)
+        {
+          header = "time";
+          for (EColumn column : columns)
+          {
+            header.append(",").append(columnName(column));
+          };
+          header.append(",quality\n");
+        }
+        else
+        {
+          header.append(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+          header.push_back(static_cast<char>(COLUMNAR_VERSION));
+          appendUInt32(header, siteID);
+          appendUInt32(header, instrumentID);
+          header.push_back(static_cast<char>(columns.size()));
+          for (EColumn column : columns)
+          {
+            header.push_back(static_cast<char>(column));
+          };
+        };
+
+        if (file.write(header.data(), static_cast<qint64>(header.size())) != static_cast<qint64>(header.size()))
+        {
+          out << "Unable to write " << parameters.fileName.toStdString() << std::endl;
+          return false;
+        };
+        totalBytes += header.size();
+      };
+
+      if (!configuration.storeDirectory.isEmpty())
+      {
+        QString directory = QString("%1/%2-%3").arg(configuration.storeDirectory).arg(siteID).arg(instrumentID);
+
+        store = std::make_unique<CTimeSeriesStore>(directory);
+        if (store->open() && (store->recordCount() != 0))
+        {
+          storeFirst = store->firstTime();
+          storeLast = store->lastTime();
+        };
+      };
+
+      if (nextTime < storeFirst)
+      {
+        databaseOpen = sql::openConnection(DATABASE_CONNECTION, configuration.database);
+        if (!databaseOpen)
+        {
+          out << "Unable to open the weather database. Records before the local store are not exported." << std::endl;
+          nextTime = storeFirst;
+          databaseFailed = true;
+        };
+      };
+
+        // The store is scanned in storage order and backfilled records may be out of order, so the store is read a time
+        // window at a time and each window is sorted. The database returns records in time order, so the database chunks
+        // use keyset pagination: each chunk starts after the last record of the previous chunk.
+
+      while (returnValue && (nextTime <= parameters.to))
+      {
+        std::vector<SArchiveRecord> records;
+        std::int64_t chunkEnd = parameters.to;
+        std::int64_t lastTime = INT64_MIN;
+        bool keyset = false;
+
+        records.reserve(CHUNK_RECORDS);
+
+        if (nextTime >= storeFirst)
+        {
+          chunkEnd = std::min({chunkEnd, storeLast, nextTime + CHUNK_SECONDS - 1});
+          returnValue = store->scan(nextTime, chunkEnd, [&records](SArchiveRecord const &record)
+          {
+            records.push_back(record);
+            return true;
+          });
+          std::stable_sort(records.begin(), records.end(), [](SArchiveRecord const &lhs, SArchiveRecord const &rhs)
+          {
+            return lhs.timeStamp < rhs.timeStamp;
+          });
+          if (chunkEnd == storeLast)
+          {
+            chunkEnd = parameters.to;                             // Nothing follows the end of the store.
+          };
+        }
+        else
+        {
+          chunkEnd = std::min(chunkEnd, storeFirst - 1);
+          returnValue = sql::readRecords(DATABASE_CONNECTION, siteID, instrumentID, nextTime, chunkEnd, CHUNK_RECORDS,
+                                         [&](SArchiveRecord const &record)
+          {
+            records.push_back(record);
+            lastTime = record.timeStamp;
+            return (records.size() < CHUNK_RECORDS);
+          });
+          keyset = (records.size() == CHUNK_RECORDS);
+        };
+
+        if (keyset)
+        {
+          nextTime = lastTime + 1;
+        }
+        else if (chunkEnd < parameters.to)
+        {
+          nextTime = chunkEnd + 1;
+        }
+        else
+        {
+          nextTime = INT64_MAX;
+        };
+
+        if (!records.empty())
+        {
+          totalRecords += records.size();
+          write(maximumPending - 1);
+          pending.push_back(CExecutor::global().async([records = std::move(records), &columns, &parameters]()
+          {
+            return (parameters.format == FMT_CSV) ? encodeCsv(records, columns) : encodeColumnar(records, columns);
+          }));
+        };
+
+        if (nextTime == INT64_MAX)
+        {
+          break;
+        };
+      };
+
+      write(0);
+      file.close();
+
+      if (databaseOpen)
+      {
+        sql::closeConnection(DATABASE_CONNECTION);
+      };
+
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+      out << totalRecords << " records, " << totalBytes << " bytes written to " << parameters.fileName.toStdString() << " in "
+          << seconds << " s." << std::endl;
+
+      returnValue = returnValue && !databaseFailed;
+
+      if (!returnValue)
+      {
+        LOGERROR("Export to {} failed.", parameters.fileName.toStdString());
+      };
+
+      return returnValue;
+    }
+
+  } // namespace exporter
+} // namespace WSd
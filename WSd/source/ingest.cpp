@@ -0,0 +1,609 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Ingest
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Ingest pipeline of a station. The archive records downloaded from the console are decoded, written to the
+//                      weather database, appended to the local store and added to the rollups.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/ingest.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <set>
+#include <utility>
+
+  // WSd header files
+
+#include "include/derived.h"
+#include "include/executor.h"
+#include "include/logger.h"
+#include "include/tracer.h"
+#include "include/weatherDatabase.h"
+
+namespace WSd
+{
+  std::map<CIngest::TStationKey, CIngest *> CIngest::registry;
+
+  /// @brief      Returns the maximum age of the records that alert events are published for. Records are downloaded once per
+  ///             poll, so the age allows for the poll interval.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The maximum age (s).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::int64_t alertAge(configuration::SConfiguration const &configuration)
+  {
+    return (static_cast<std::int64_t>(configuration.pollInterval) + 5) * 60;
+  }
+
+  /// @brief      Constructor. Registers the station and starts opening the local store on the executor, so the console and the
+  ///             database connections are made while the store is opened. The station is only visible to find() and
+  ///             stations() once the store is open.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Local store opened on the executor.
+  /// @version    2026-10-19/GGB - Alert rules added.
+  /// @version    2026-10-19/GGB - Quality control added.
+  /// @version    2026-10-19/GGB - Recent window and registration added.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CIngest::CIngest(std::uint32_t sid, std::uint32_t iid, configuration::SConfiguration const &configuration)
+    : siteID(sid), instrumentID(iid), elevation(configuration.elevation), window(WINDOW_RECORDS),
+      qualityControl(configuration.quality), qualityEnabled(configuration.quality.enabled),
+      qualityReject(configuration.quality.reject), alertRules(sid, iid, alertAge(configuration))
+  {
+    alertRules.setRules(configuration.alertRules);
+
+    if (!configuration.storeDirectory.isEmpty())
+    {
+      QString directory = QString("%1/%2-%3").arg(configuration.storeDirectory).arg(siteID).arg(instrumentID);
+
+      CExecutor::global().submit([this, directory, result = opening]() mutable
+      {
+        auto open = [this, &directory]() { openStore(directory); return true; };
+
+        result.run(open);
+      });
+    }
+    else
+    {
+      opening.set(true);
+    };
+
+    registry[TStationKey(siteID, instrumentID)] = this;
+  }
+
+  /// @brief      Destructor. Waits for the store to be opened and removes the station from the registry.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Waits for the store to be opened.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CIngest::~CIngest()
+  {
+    waitOpen();
+
+    auto iterator = registry.find(TStationKey(siteID, instrumentID));
+
+    if ( (iterator != registry.end()) && (iterator->second == this) )
+    {
+      registry.erase(iterator);
+    };
+  }
+
+  /// @brief      Opens the local store, the rollups and the replication journal of the station and primes the recent window
+  ///             and the quality control from the store. Runs on the executor; nothing else touches the store, the window or the
+  ///             quality control until it has completed.
+  /// @param[in]  directory: The directory of the store of the station.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Replication journal opened.
+  /// @version    2026-10-19/GGB - Function created from the constructor.
+
+  void CIngest::openStore(QString const &directory)
+  {
+    TRACESPAN("openStore");
+
+    try
+    {
+      store = std::make_unique<CTimeSeriesStore>(directory);
+      if (store->open())
+      {
+        rollups = std::make_unique<CRollups>(directory + "/rollups.wsr");
+        if (!rollups->open(store.get()))
+        {
+          rollups.reset();
+        };
+
+        journal = std::make_unique<CReplicationJournal>(directory + "/replication.journal");
+        if (!journal->open())
+        {
+          journal.reset();
+        };
+      }
+      else
+      {
+        store.reset();
+      };
+
+      if (store && (store->recordCount() != 0))
+      {
+        TRACESPAN("primeWindow");
+
+        store->scan(store->lastTime() - static_cast<std::int64_t>(WINDOW_RECORDS) * 60, store->lastTime(),
+                    [this](SArchiveRecord const &record)
+                    {
+                      window.insert(record);
+                      qualityControl.prime(record);
+                      return true;
+                    });
+      };
+    }
+    catch (std::exception const &e)
+    {
+      LOGERROR("Unable to open local store {}: {}", directory.toStdString(), e.what());
+      journal.reset();
+      rollups.reset();
+      store.reset();
+    };
+  }
+
+  /// @brief      Waits for the store to be opened. Blocks the calling thread; the event loop awaits opened() before the first
+  ///             download, so this does not wait when called from the event loop.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Opening shared with opened().
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CIngest::waitOpen()
+  {
+    if (!opening.ready())
+    {
+      TRACESPAN("waitOpen");
+      opening.wait();
+    };
+  }
+
+  /// @brief      Determines if the store has been opened, without waiting.
+  /// @returns    true if the store is open (or there is no store).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Opening shared with opened().
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CIngest::isOpen()
+  {
+    return opening.ready();
+  }
+
+  /// @brief      Finds the ingest pipeline of a station.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @returns    The pipeline. nullptr if the station is not being acquired or its store is still being opened.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Stations being opened are not returned.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CIngest *CIngest::find(std::uint32_t sid, std::uint32_t iid)
+  {
+    auto iterator = registry.find(TStationKey(sid, iid));
+
+    return ( (iterator != registry.end()) && iterator->second->isOpen() ) ? iterator->second : nullptr;
+  }
+
+  /// @brief      Returns the stations that are being acquired.
+  /// @returns    The site and instrument IDs of the stations. (Stations whose store is still being opened are not included.)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Stations being opened are not returned.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::vector<CIngest::TStationKey> CIngest::stations()
+  {
+    std::vector<TStationKey> returnValue;
+
+    returnValue.reserve(registry.size());
+    for (auto const &entry : registry)
+    {
+      if (entry.second->isOpen())
+      {
+        returnValue.push_back(entry.first);
+      };
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Ingests a batch of archive records. The records are quality checked and checked against the alert rules, then
+  ///             written to the database and appended to the local store. Records already in the local store are not appended
+  ///             again; the records that are appended are first appended to the replication journal, in the order they were
+  ///             received. If the journal cannot be written nothing of the batch is stored, and the batch is downloaded again.
+  ///             The rollups are kept with the store: exactly the records appended to the store are added to them. All records
+  ///             are added to the recent window.
+  ///             The batch is written on the database thread while the caller is suspended, so the event loop is not blocked.
+  ///             Nothing is stored once the write deadline has passed, and no record is written to the database after it.
+  /// @param[in]  records: The raw archive records. (Must remain valid until the task completes.)
+  /// @returns    The number of records written to the database.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Records looked up in the store with one scan per batch.
+  /// @version    2026-10-19/GGB - Archive period counted in the hold time of the alert rules.
+  /// @version    2026-10-19/GGB - Rollups fed the records appended to the store.
+  /// @version    2026-10-19/GGB - Batch not written after the write deadline.
+  /// @version    2026-10-19/GGB - Converted to a coroutine. The write to the database is awaited.
+  /// @version    2026-10-19/GGB - Records written to the database with one switch to the database thread.
+  /// @version    2026-10-19/GGB - Records journaled before they are stored.
+  /// @version    2026-10-19/GGB - Latest record and rollups only advanced by committed records, and not past a failed record.
+  /// @version    2026-10-19/GGB - Records new to the local store appended to the replication journal.
+  /// @version    2026-10-19/GGB - Latest record written to the database kept for the high-water mark.
+  /// @version    2026-10-19/GGB - Waits for the local store to be opened.
+  /// @version    2026-10-19/GGB - Large batches (backfills and imports) decoded on the executor.
+  /// @version    2026-10-19/GGB - Records written through weatherDatabase as one batch.
+  /// @version    2026-10-19/GGB - Alert rules checked before the records are stored.
+  /// @version    2026-10-19/GGB - Quality control added.
+  /// @version    2026-10-19/GGB - Records decoded as a batch and the derived columns computed.
+  /// @version    2026-10-19/GGB - Recent window updated.
+  /// @version    2026-10-19/GGB - Rollups updated.
+  /// @version    2026-10-19/GGB - Function created. (Database insert moved from CTCPSocket::readArchive())
+
+  CTask<std::size_t> CIngest::ingest(std::vector<TRawRecord> const &records)
+  {
+    std::size_t recordCount = 0;
+    std::vector<SArchiveRecord> decodedRecords(records.size());
+    std::vector<std::uint8_t> decodedFlags(records.size());       // Not vector<bool>, the chunks are decoded concurrently.
+    std::vector<std::uint8_t> storeFlags(records.size());
+    std::vector<std::uint8_t> insertFlags(records.size());        // 0 - failed, 1 - inserted, 2 - not inserted.
+    std::vector<TRawRecord> journalRecords;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    bool batchCommitted;
+
+    TRACESPAN("ingest", records.size());
+
+    if (writeDeadline)
+    {
+      deadline = writeDeadline();
+    };
+
+    if (std::chrono::steady_clock::now() >= deadline)
+    {
+      LOGWARNING("Write deadline passed. Batch of {} records not stored.", records.size());
+      latestBlocked = true;
+      batchStored = false;
+      co_return 0;
+    };
+
+    waitOpen();
+
+    auto decodeChunk = [&records, &decodedRecords, &decodedFlags](std::size_t chunk)
+    {
+      std::size_t end = std::min(records.size(), (chunk + 1) * DECODE_CHUNK);
+
+      for (std::size_t index = chunk * DECODE_CHUNK; index < end; index++)
+      {
+        decodedFlags[index] = decodedRecords[index].decode(records[index].data());
+      };
+    };
+
+    if (records.size() > DECODE_CHUNK)
+    {
+      CExecutor::global().parallelFor((records.size() + DECODE_CHUNK - 1) / DECODE_CHUNK, decodeChunk);
+    }
+    else
+    {
+      decodeChunk(0);
+    };
+
+    if (qualityEnabled)
+    {
+      std::size_t flagged = 0;
+
+      TRACESPAN("qualityControl");
+
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        if (decodedFlags[index])
+        {
+          flagged += qualityControl.check(decodedRecords[index]);
+        };
+      };
+
+      if (flagged != 0)
+      {
+        LOGINFO("Quality control flagged {} values.", flagged);
+      };
+    };
+
+    derived::compute(decodedRecords, elevation);
+
+      // A record is journaled before it is appended to the store. A crash between the two leaves the record journaled and not
+      // stored; it is journaled again when it is downloaded again, and the duplicate is ignored downstream. A record is never
+      // stored without being journaled, which would stop it from being journaled at all.
+
+    if (store)
+    {
+      std::set<std::int64_t> batchTimes;
+      std::set<std::int64_t> storedTimes;
+      std::int64_t from = INT64_MAX;
+      std::int64_t to = INT64_MIN;
+
+        // Records after the last record of the store are new. The others are looked up with one scan of the store.
+
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        if (decodedFlags[index] && (decodedRecords[index].timeStamp <= store->lastTime()))
+        {
+          from = std::min(from, decodedRecords[index].timeStamp);
+          to = std::max(to, decodedRecords[index].timeStamp);
+        };
+      };
+
+      if (from <= to)
+      {
+        storedTimes = store->storedTimes(from, to);
+      };
+
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        std::int64_t timeStamp = decodedRecords[index].timeStamp;
+
+        if (decodedFlags[index] && !storedTimes.contains(timeStamp) && batchTimes.insert(timeStamp).second)
+        {
+          storeFlags[index] = 1;
+
+            // The journal holds the record as received, so a downstream daemon applies its own quality control.
+
+          if (journal)
+          {
+            journalRecords.push_back(records[index]);
+          };
+        };
+      };
+
+      if (journal && !journalRecords.empty() && !journal->append(journalRecords))
+      {
+        LOGERROR("Batch of {} records not stored. It is downloaded again.", records.size());
+        latestBlocked = true;
+        batchStored = false;
+        co_return 0;
+      };
+    };
+
+    if (!alertRules.empty())
+    {
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        if (decodedFlags[index])
+        {
+          alertRules.evaluate(decodedRecords[index], archivePeriod);
+        };
+      };
+    };
+
+      // The latest record is only advanced once the batch has been committed, and never past a record that failed.
+
+    std::int64_t previousTimeStamp = latestTimeStamp;
+    std::uint16_t previousDate = latestDate;
+    std::uint16_t previousTime = latestTime;
+
+      // The batch is written on the database thread. The caller is resumed when it has been written; the next batch is not
+      // started before that, so the records are written in the order received. The batch may wait behind other work on the
+      // database thread, so the deadline is checked again before each record. The records after the deadline are not stored.
+
+    batchCommitted = co_await weatherDatabase::executeAsync([&]()
+    {
+      weatherDatabase::beginBatch();
+
+      for (std::size_t index = 0; index < records.size(); index++)
+      {
+        SArchiveRecord const &record = decodedRecords[index];
+        TRawRecord rawRecord = records[index];
+        bool inserted;
+
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+          break;                                  // insertFlags is 0 (failed) for the remaining records.
+        };
+
+        if (qualityReject && decodedFlags[index] && (record.qualityCodes != 0))
+        {
+            // The database has no quality flags. Flagged values are written as "no sensor" where the column has a dash value.
+
+          for (std::size_t column = 0; column < COL_FIRST_DERIVED; column++)
+          {
+            if (record.quality(static_cast<EColumn>(column)) != QC_GOOD)
+            {
+              setDashValue(rawRecord.data(), static_cast<EColumn>(column));
+            };
+          };
+        };
+
+        TRACESPAN("insertRecord");
+        if (!weatherDatabase::insertRecord(siteID, instrumentID, rawRecord, inserted))
+        {
+          insertFlags[index] = 0;
+        }
+        else
+        {
+          insertFlags[index] = inserted ? 1 : 2;
+        };
+      };
+
+      return weatherDatabase::endBatch();
+    });
+
+    batchStored = true;
+
+    for (std::size_t index = 0; index < records.size(); index++)
+    {
+      SArchiveRecord const &record = decodedRecords[index];
+      bool decoded = decodedFlags[index];
+
+      if (insertFlags[index] == 0)
+      {
+        batchStored = false;
+        latestBlocked = true;
+      }
+      else if (insertFlags[index] == 1)
+      {
+        recordCount++;
+
+        if (decoded && !latestBlocked && (record.timeStamp > latestTimeStamp))
+        {
+          latestTimeStamp = record.timeStamp;
+          latestDate = static_cast<std::uint16_t>(records[index][0] | (records[index][1] << 8));
+          latestTime = static_cast<std::uint16_t>(records[index][2] | (records[index][3] << 8));
+        };
+      };
+
+      if (decoded)
+      {
+        window.insert(record);
+      };
+
+      if (storeFlags[index])
+      {
+        store->append(record);
+
+        if (rollups)
+        {
+          rollups->add(record);
+        };
+      };
+    };
+
+    if (!batchCommitted)
+    {
+        // None of the records of the batch were stored. They are downloaded again from the high-water mark.
+
+      latestTimeStamp = previousTimeStamp;
+      latestDate = previousDate;
+      latestTime = previousTime;
+      latestBlocked = true;
+      batchStored = false;
+      recordCount = 0;
+    };
+
+    co_return recordCount;
+  }
+
+  /// @brief      Starts a download. The latest record written is advanced again by the records of the download, up to the first
+  ///             record that is not stored.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CIngest::startDownload()
+  {
+    latestBlocked = false;
+  }
+
+  /// @brief      Ends a download. The open block of the store and the rollups are written to disk. This is done once per download
+  ///             rather than per batch, as the whole open block is written each time.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CIngest::endDownload()
+  {
+    waitOpen();
+
+    if (store)
+    {
+      store->flush();
+    };
+    if (rollups)
+    {
+      rollups->flush();
+    };
+  }
+
+  /// @brief      Returns the date and time of the latest record in the local store. Records written to the database after it
+  ///             may not have reached the store if the daemon stopped during a download.
+  /// @param[out] date: The date of the record. (Console format)
+  /// @param[out] time: The time of the record. (HHMM)
+  /// @returns    false if there is no local store or it is empty.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CIngest::latestStored(std::uint16_t &date, std::uint16_t &time)
+  {
+    int year, month, day, hour, minute;
+
+    waitOpen();
+
+    if (!store || (store->recordCount() == 0))
+    {
+      return false;
+    };
+
+    SArchiveRecord::splitTimeStamp(store->lastTime(), year, month, day, hour, minute);
+    date = static_cast<std::uint16_t>(day + month * 32 + (year - 2000) * 512);
+    time = static_cast<std::uint16_t>(hour * 100 + minute);
+
+    return true;
+  }
+
+  /// @brief      Changes the quality control settings. The history of the quality control is retained.
+  /// @param[in]  quality: The new settings.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Waits for the quality control to be primed.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CIngest::setQualityConfiguration(configuration::SQualityConfiguration const &quality)
+  {
+    waitOpen();
+    qualityControl.setConfiguration(quality);
+    qualityEnabled = quality.enabled;
+    qualityReject = quality.reject;
+  }
+
+  /// @brief      Replaces the alert rules. The state of the alerts is cleared.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CIngest::setAlertRules(configuration::SConfiguration const &configuration)
+  {
+    alertRules.setMaximumAge(alertAge(configuration));
+    alertRules.setRules(configuration.alertRules);
+  }
+
+  /// @brief      Checks the current conditions of the station (LOOP packet) against the alert rules. The conditions are not
+  ///             quality checked or stored.
+  /// @param[in]  conditions: The current conditions.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CIngest::checkAlerts(SArchiveRecord const &conditions)
+  {
+    std::vector<SArchiveRecord> samples { conditions };
+
+    derived::compute(samples, elevation);
+    alertRules.evaluate(samples.front(), 0);
+  }
+
+} // namespace WSd
@@ -0,0 +1,194 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								lease
+// SUBSYSTEM:						Lease
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Lease that lets two daemons acquire the same station as an active/standby pair. The lease is a row of the
+//                      weather database (TBL_LEASE) with the name of the daemon holding it and the time it expires by the clock of
+//                      the database server. The active daemon renews the lease at a third of its duration; the standby tries to
+//                      take it at the same rate, and gets it once it has expired or been released. The lease is read and written on
+//                      the database thread, so an unreachable database does not block the event loop.
+//
+// HISTORY:             2026-10-19/GGB - Lease renewed and released on the database thread.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/lease.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+
+  // Miscellaneous library header files
+
+#include <QCoreApplication>
+#include <QSysInfo>
+
+  // WSd header files
+
+#include "include/logger.h"
+#include "include/sqlArchive.h"
+#include "include/tracer.h"
+#include "include/weatherDatabase.h"
+
+namespace WSd
+{
+  static char const LEASE_CONNECTION[] = "WSd-lease";
+
+  /// @brief      Constructor. The lease is not acquired until renew() is called.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @param[in]  configuration: The configuration snapshot. (Database and lease time.)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CLease::CLease(std::uint32_t sid, std::uint32_t iid, configuration::SConfiguration const &configuration)
+    : siteID(sid), instrumentID(iid), database(configuration.database), duration(configuration.leaseTime),
+      name(QString("%1:%2").arg(QSysInfo::machineHostName()).arg(QCoreApplication::applicationPid()))
+  {
+  }
+
+  /// @brief      Destructor. Releases the lease if it is held and closes the lease connection on the database thread, without
+  ///             waiting.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Connection closed on the database thread.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CLease::~CLease()
+  {
+    release();
+    weatherDatabase::executeAsync([]() { sql::closeConnection(LEASE_CONNECTION); return true; });
+  }
+
+  /// @brief      Returns true if this daemon holds the lease and may poll the console.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CLease::held() const
+  {
+    return active && (std::chrono::steady_clock::now() < expiry);
+  }
+
+  /// @brief      Returns the time the lease is given up locally. Writes for the station must not be started after this time.
+  /// @returns    The time. (A time in the past if the lease is not held.)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::chrono::steady_clock::time_point CLease::heldUntil() const
+  {
+    return active ? expiry : std::chrono::steady_clock::time_point::min();
+  }
+
+  /// @brief      Acquires the lease, or renews it if it is held. If the database cannot be reached a lease that is held is kept
+  ///             until it expires locally; the other daemon cannot take it before it expires in the database. The lease is
+  ///             written on the database thread while the coroutine is suspended. The lease must not be destroyed before the
+  ///             task has completed.
+  /// @returns    true if the lease is held.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Converted to a coroutine. The lease is written on the database thread.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<bool> CLease::renew()
+  {
+    std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+    std::int64_t remaining = 0;
+    QString holder;
+    bool renewed;
+
+    TRACESPAN("renewLease");
+
+    renewed = co_await weatherDatabase::executeAsync([this, &holder, &remaining]()
+    {
+      if (!sql::openConnection(LEASE_CONNECTION, database) ||
+          (!tableCreated && !(tableCreated = sql::createLeaseTable(LEASE_CONNECTION))) ||
+          !sql::acquireLease(LEASE_CONNECTION, siteID, instrumentID, name, duration, holder, remaining))
+      {
+        sql::closeConnection(LEASE_CONNECTION);               // Connect again at the next renewal.
+        tableCreated = false;
+        return false;
+      };
+
+      return true;
+    });
+
+    if (!renewed)
+    {
+      LOGWARNING("Lease of station {}-{} not renewed.", siteID, instrumentID);
+    }
+    else
+    {
+      currentHolder = holder;
+      active = (currentHolder == name);
+
+        // The remaining time is measured by the database after the renewal was sent, so the lease is never held locally for
+        // longer than in the database.
+
+      if (active)
+      {
+        expiry = sent + std::chrono::seconds(std::min<std::int64_t>(remaining, duration) - SAFETY_MARGIN);
+      };
+    };
+
+    co_return held();
+  }
+
+  /// @brief      Releases the lease, so that the other daemon can take over without waiting for the lease to expire. The lease
+  ///             is given up locally straight away and released in the database on the database thread. (The result may be
+  ///             awaited or waited for, or ignored.)
+  /// @returns    The result of the release. true if the lease was released or was not held.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Released on the database thread.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CAsyncResult<bool> CLease::release()
+  {
+    CAsyncResult<bool> returnValue;
+
+    if (active)
+    {
+      active = false;
+
+        // The lease may be destroyed before the release has run, so the release does not use it.
+
+      returnValue = weatherDatabase::executeAsync([sid = siteID, iid = instrumentID, database = database, name = name]()
+      {
+        if (sql::openConnection(LEASE_CONNECTION, database) && sql::releaseLease(LEASE_CONNECTION, sid, iid, name))
+        {
+          LOGINFO("Lease of station {}-{} released.", sid, iid);
+          return true;
+        };
+
+        return false;
+      });
+    }
+    else
+    {
+      returnValue.set(true);
+    };
+
+    return returnValue;
+  }
+
+} // namespace WSd
@@ -0,0 +1,381 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Logger
+// SUBSYSTEM:						Asynchronous logging
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd::logging
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Asynchronous logging backend. The ring is a bounded multi-producer queue (D. Vyukov) with a single consumer,
+//                      the writer thread.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/logger.h"
+
+  // Standard C++ library header files
+
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <thread>
+
+namespace WSd
+{
+  namespace logging
+  {
+    std::size_t const RING_CAPACITY = 4096;         // Must be a power of 2.
+    std::size_t const RING_MASK = RING_CAPACITY - 1;
+    std::size_t const MAX_BATCH = 256;              // Maximum records formatted per write.
+    std::size_t const FILE_BUFFER_SIZE = 64 * 1024;
+
+    struct SCell
+    {
+      std::atomic<std::size_t> sequence;
+      SLogRecord record;
+    };
+
+    std::atomic<std::uint8_t> severityMask(0);
+
+    static std::unique_ptr<SCell[]> ring;
+    alignas(64) static std::atomic<std::size_t> enqueuePosition(0);
+    alignas(64) static std::size_t dequeuePosition = 0;
+    static std::atomic<std::uint64_t> dropped(0);
+    static std::atomic<bool> running(false);
+    static std::atomic<bool> accepting(false);      // Producers may claim records.
+    alignas(64) static std::atomic<std::size_t> producers(0);   // Producers between acquireRecord() and publishRecord().
+    static std::thread writerThread;
+    static std::FILE *logFile = nullptr;
+    static std::uint8_t pendingMask = 0;            // Severities to enable once the logger is running.
+
+    static char const *severityText[] = { "CRITICAL", "ERROR", "WARNING", "NOTICE", "INFO", "DEBUG", "TRACE" };
+
+    /// @brief      Formats a record into the output buffer.
+    /// @param[in]  record: The record to format.
+    /// @param[out] buffer: The buffer to append to.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Local time converted with localtime_r. (Runs on the writer thread.)
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void formatRecord(SLogRecord const &record, std::string &buffer)
+    {
+      char text[64];
+      std::time_t time = std::chrono::system_clock::to_time_t(record.timeStamp);
+      struct tm localTime;
+      long milliseconds = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                              record.timeStamp.time_since_epoch()).count() % 1000);
+
+      localtime_r(&time, &localTime);
+
+      std::size_t length = std::strftime(text, sizeof(text), "[%Y-%m-%d %H:%M:%S", &localTime);
+      std::snprintf(text + length, sizeof(text) - length, ".%03ld] %s - ", milliseconds, severityText[record.severity]);
+      buffer.append(text);
+
+      std::uint8_t argument = 0;
+
+      for (char const *p = record.format; *p; ++p)
+      {
+        if ( (p[0] == '{') && (p[1] == '}') && (argument < record.argumentCount) )
+        {
+          SArgument const &arg = record.arguments[argument++];
+
+          switch (arg.type)
+          {
+            case SArgument::SIGNED:
+            {
+              std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(arg.s));
+              buffer.append(text);
+              break;
+            };
+            case SArgument::UNSIGNED:
+            {
+              std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(arg.u));
+              buffer.append(text);
+              break;
+            };
+            case SArgument::REAL:
+            {
+              std::snprintf(text, sizeof(text), "%g", arg.d);
+              buffer.append(text);
+              break;
+            };
+            case SArgument::STRING:
+            {
+              buffer.append(arg.string);
+              break;
+            };
+          };
+          ++p;
+        }
+        else
+        {
+          buffer.push_back(*p);
+        };
+      };
+
+      buffer.push_back('\n');
+    }
+
+    /// @brief      Drains up to MAX_BATCH records from the ring into the buffer.
+    /// @param[out] buffer: The buffer to append the formatted records to.
+    /// @returns    The number of records drained.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::size_t drainRing(std::string &buffer)
+    {
+      std::size_t count = 0;
+
+      while (count < MAX_BATCH)
+      {
+        SCell &cell = ring[dequeuePosition & RING_MASK];
+
+        if (cell.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+        {
+          break;
+        };
+
+        formatRecord(cell.record, buffer);
+        cell.sequence.store(dequeuePosition + RING_CAPACITY, std::memory_order_release);
+        ++dequeuePosition;
+        ++count;
+      };
+
+      return count;
+    }
+
+    /// @brief      Appends a notice to the buffer if messages have been dropped since the last notice.
+    /// @param[out] buffer: The buffer to append to.
+    /// @param[in,out] droppedReported: The number of dropped messages already reported.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void appendDroppedNotice(std::string &buffer, std::uint64_t &droppedReported)
+    {
+      std::uint64_t droppedNow = dropped.load(std::memory_order_relaxed);
+
+      if (droppedNow != droppedReported)
+      {
+        buffer.append("Log ring full. " + std::to_string(droppedNow - droppedReported) + " messages dropped.\n");
+        droppedReported = droppedNow;
+      };
+    }
+
+    /// @brief      Writer thread. Formats and writes the records in batches; sleeps briefly when the ring is empty.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void writerFunction()
+    {
+      std::string buffer;
+      std::uint64_t droppedReported = 0;
+
+      buffer.reserve(MAX_BATCH * 128);
+
+      while (running.load(std::memory_order_acquire))
+      {
+        buffer.clear();
+
+        if (drainRing(buffer) == 0)
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        else
+        {
+          appendDroppedNotice(buffer, droppedReported);
+          std::fwrite(buffer.data(), 1, buffer.size(), logFile);
+          std::fflush(logFile);
+        };
+      };
+
+        // Flush anything left in the ring.
+
+      do
+      {
+        buffer.clear();
+        drainRing(buffer);
+        appendDroppedNotice(buffer, droppedReported);
+        std::fwrite(buffer.data(), 1, buffer.size(), logFile);
+      }
+      while (!buffer.empty());
+
+      std::fflush(logFile);
+    }
+
+    /// @brief      Sets the severities that are recorded.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void setSeverity(bool fCritical, bool fError, bool fWarning, bool fNotice, bool fInfo, bool fDebug, bool fTrace)
+    {
+      std::uint8_t mask = 0;
+
+      mask |= fCritical ? (1 << critical) : 0;
+      mask |= fError ? (1 << error) : 0;
+      mask |= fWarning ? (1 << warning) : 0;
+      mask |= fNotice ? (1 << notice) : 0;
+      mask |= fInfo ? (1 << info) : 0;
+      mask |= fDebug ? (1 << debug) : 0;
+      mask |= fTrace ? (1 << trace) : 0;
+
+      severityMask.store(running ? mask : 0, std::memory_order_relaxed);
+      if (!running)
+      {
+        pendingMask = mask;
+      };
+    }
+
+    /// @brief      Allocates the ring, opens the log file and starts the writer thread.
+    /// @param[in]  fileName: The log file to append to.
+    /// @returns    true if the logger was started.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool start(std::string const &fileName)
+    {
+      if (running)
+      {
+        return true;
+      };
+
+      logFile = std::fopen(fileName.c_str(), "a");
+
+      if (!logFile)
+      {
+        return false;
+      };
+
+      std::setvbuf(logFile, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+
+      ring = std::make_unique<SCell[]>(RING_CAPACITY);
+      for (std::size_t index = 0; index < RING_CAPACITY; index++)
+      {
+        ring[index].sequence.store(index, std::memory_order_relaxed);
+      };
+      enqueuePosition.store(0, std::memory_order_relaxed);
+      dequeuePosition = 0;
+
+      running = true;
+      writerThread = std::thread(writerFunction);
+
+      accepting = true;
+      severityMask.store(pendingMask, std::memory_order_relaxed);
+
+      return true;
+    }
+
+    /// @brief      Stops the writer thread after all recorded messages have been written, and closes the log file. A producer
+    ///             may have passed the severity test before the mask was cleared, so new records are refused and the producers
+    ///             that have claimed a record are waited for before the writer makes its final pass over the ring.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Waits for the producers that are filling in a record.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void stop()
+    {
+      if (running)
+      {
+        pendingMask = severityMask.exchange(0, std::memory_order_relaxed);
+        accepting = false;
+        while (producers.load(std::memory_order_acquire) != 0)
+        {
+          std::this_thread::yield();
+        };
+        running = false;
+        writerThread.join();
+        std::fclose(logFile);
+        logFile = nullptr;
+      };
+    }
+
+    /// @brief      Returns the number of messages that have been dropped because the ring was full.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    std::uint64_t droppedMessages()
+    {
+      return dropped.load(std::memory_order_relaxed);
+    }
+
+    /// @brief      Claims the next free record in the ring. The caller is counted as a producer until the record is published.
+    /// @returns    The record to fill in, or nullptr if the ring is full (the message is counted as dropped) or the logger is
+    ///             stopping.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Producers counted. No records are claimed while the logger is stopping.
+    /// @version    2026-10-19/GGB - Function created.
+
+    SLogRecord *acquireRecord()
+    {
+        // Sequentially consistent with stop(): either stop() sees this producer or this producer sees that the logger is
+        // stopping.
+
+      producers.fetch_add(1);
+      if (!accepting.load())
+      {
+        producers.fetch_sub(1, std::memory_order_release);
+        return nullptr;
+      };
+
+      std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+
+      for (;;)
+      {
+        SCell &cell = ring[position & RING_MASK];
+        std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+        if (difference == 0)
+        {
+          if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          {
+            cell.record.position = position;
+            return &cell.record;
+          };
+        }
+        else if (difference < 0)
+        {
+          dropped.fetch_add(1, std::memory_order_relaxed);
+          producers.fetch_sub(1, std::memory_order_release);
+          return nullptr;
+        }
+        else
+        {
+          position = enqueuePosition.load(std::memory_order_relaxed);
+        };
+      };
+    }
+
+    /// @brief      Makes a filled in record visible to the writer thread.
+    /// @param[in]  record: The record returned by acquireRecord().
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Ends the producer count taken by acquireRecord().
+    /// @version    2026-10-19/GGB - Function created.
+
+    void publishRecord(SLogRecord *record)
+    {
+      ring[record->position & RING_MASK].sequence.store(record->position + 1, std::memory_order_release);
+      producers.fetch_sub(1, std::memory_order_release);
+    }
+
+  } // namespace logging
+} // namespace WSd
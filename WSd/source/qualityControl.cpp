@@ -0,0 +1,277 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								qualityControl
+// SUBSYSTEM:						Quality Control
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Streaming quality control of the archive records. Range, rate of change, spike (median/MAD) and flatline
+//                      checks of each raw column, with O(1) work per sample.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/qualityControl.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <cmath>
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+  /// @brief      Adds a sample to the window. The oldest sample is removed once the window is full.
+  /// @param[in]  value: The sample.
+  /// @param[in]  timeStamp: The time of the sample.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CQualityControl::SColumnState::add(double value, std::int64_t timeStamp)
+  {
+    std::size_t index;
+
+    if (count == WINDOW_SAMPLES)
+    {
+        // Remove the oldest sample from the sorted samples.
+
+      index = static_cast<std::size_t>(std::lower_bound(sorted.begin(), sorted.end(), samples[next]) - sorted.begin());
+      std::copy(sorted.begin() + index + 1, sorted.end(), sorted.begin() + index);
+      count--;
+    };
+
+    samples[next] = value;
+    next = (next + 1) % WINDOW_SAMPLES;
+
+    index = static_cast<std::size_t>(std::upper_bound(sorted.begin(), sorted.begin() + count, value) - sorted.begin());
+    std::copy_backward(sorted.begin() + index, sorted.begin() + count, sorted.begin() + count + 1);
+    sorted[index] = value;
+    count++;
+
+    sampleTime = timeStamp;
+  }
+
+  /// @brief      Discards the samples in the window if they are too old to be used.
+  /// @param[in]  timeStamp: The time of the record being checked.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CQualityControl::SColumnState::expire(std::int64_t timeStamp)
+  {
+    if ( (sampleTime != INT64_MIN) && (timeStamp - sampleTime > MAXIMUM_GAP) )
+    {
+      count = 0;
+      next = 0;
+    };
+  }
+
+  /// @brief      Returns the median of the samples in the window.
+  /// @returns    The median.
+  /// @throws     None.
+  /// @pre        The window is not empty.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double CQualityControl::SColumnState::median() const
+  {
+    return (count % 2 == 1) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+  }
+
+  /// @brief      Returns the median absolute deviation of the samples in the window.
+  /// @param[in]  centre: The median of the samples.
+  /// @returns    The MAD.
+  /// @throws     None.
+  /// @pre        The window is not empty.
+  /// @version    2026-10-19/GGB - Function created.
+
+  double CQualityControl::SColumnState::mad(double centre) const
+  {
+    std::array<double, WINDOW_SAMPLES> deviations;
+
+    for (std::size_t index = 0; index < count; index++)
+    {
+      deviations[index] = std::fabs(sorted[index] - centre);
+    };
+
+    std::nth_element(deviations.begin(), deviations.begin() + count / 2, deviations.begin() + count);
+
+    return deviations[count / 2];
+  }
+
+  /// @brief      Constructor.
+  /// @param[in]  qualityConfiguration: The thresholds of the station.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CQualityControl::CQualityControl(configuration::SQualityConfiguration const &qualityConfiguration)
+    : configuration(qualityConfiguration)
+  {
+  }
+
+  /// @brief      Changes the thresholds. The history of the columns is retained.
+  /// @param[in]  qualityConfiguration: The new thresholds.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CQualityControl::setConfiguration(configuration::SQualityConfiguration const &qualityConfiguration)
+  {
+    configuration = qualityConfiguration;
+  }
+
+  /// @brief      Updates the history of a column with a value that is in range.
+  /// @param[in]  column: The column.
+  /// @param[in]  value: The value.
+  /// @param[in]  timeStamp: The time of the record.
+  /// @param[in]  good: true if the value passed all the checks.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CQualityControl::update(EColumn column, double value, std::int64_t timeStamp, bool good)
+  {
+    SColumnState &columnState = state[column];
+
+    columnState.expire(timeStamp);
+    columnState.add(value, timeStamp);
+
+    if (good)
+    {
+      columnState.lastValue = value;
+      columnState.lastTime = timeStamp;
+    };
+
+    if ( (columnState.flatSince == INT64_MIN) || (value != columnState.flatValue) )
+    {
+      columnState.flatValue = value;
+      columnState.flatSince = timeStamp;
+    };
+  }
+
+  /// @brief      Adds a record that has already been checked to the history. (Used to prime the history from the records
+  ///             that are already stored.)
+  /// @param[in]  record: The record. The stored quality codes are used.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CQualityControl::prime(SArchiveRecord const &record)
+  {
+    if (record.timeStamp > lastTimeStamp)
+    {
+      for (std::size_t index = 0; index < COL_FIRST_DERIVED; index++)
+      {
+        EColumn column = static_cast<EColumn>(index);
+
+        if (record.hasValue(column) && (record.quality(column) != QC_RANGE))
+        {
+          update(column, record.value(column), record.timeStamp, (record.quality(column) == QC_GOOD));
+        };
+      };
+
+      lastTimeStamp = record.timeStamp;
+    };
+  }
+
+  /// @brief      Checks the raw columns of a record and sets the quality codes. The checks are made in the order range, rate
+  ///             of change, spike and flatline, and the first check that fails gives the code. Records that are not newer
+  ///             than the last record checked are only range checked.
+  /// @param[in]  record: The decoded record.
+  /// @returns    The number of values flagged.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::size_t CQualityControl::check(SArchiveRecord &record)
+  {
+    std::size_t flagged = 0;
+    bool inOrder = (record.timeStamp > lastTimeStamp);
+
+    for (std::size_t index = 0; index < COL_FIRST_DERIVED; index++)
+    {
+      EColumn column = static_cast<EColumn>(index);
+      configuration::SQualityLimits const &limits = configuration.limits[index];
+      EQuality code = QC_GOOD;
+
+      if (!record.hasValue(column))
+      {
+        record.setQuality(column, QC_GOOD);
+        continue;
+      };
+
+      double value = record.value(column);
+
+      if ( (value < limits.minimum) || (value > limits.maximum) )
+      {
+        code = QC_RANGE;
+      }
+      else if (inOrder)
+      {
+        SColumnState &columnState = state[index];
+
+        columnState.expire(record.timeStamp);
+
+        if ( (limits.maximumRate > 0) && (columnState.lastTime != INT64_MIN) &&
+             (record.timeStamp - columnState.lastTime <= MAXIMUM_GAP) &&
+             (std::fabs(value - columnState.lastValue) > limits.maximumRate * (record.timeStamp - columnState.lastTime) / 60.0) )
+        {
+          code = QC_RATE;
+        }
+        else if ( (limits.spikeFactor > 0) && (columnState.count >= MINIMUM_SAMPLES) )
+        {
+          double centre = columnState.median();
+
+            // 1.4826 scales the MAD to the standard deviation of a normal distribution.
+
+          if (std::fabs(value - centre) > std::max(limits.spikeFactor * 1.4826 * columnState.mad(centre), limits.spikeFloor))
+          {
+            code = QC_SPIKE;
+          };
+        };
+
+        if ( (code == QC_GOOD) && (limits.flatlineMinutes != 0) && (columnState.flatSince != INT64_MIN) &&
+             (value == columnState.flatValue) &&
+             (record.timeStamp - columnState.flatSince >= static_cast<std::int64_t>(limits.flatlineMinutes) * 60) )
+        {
+          code = QC_FLATLINE;
+        };
+
+        update(column, value, record.timeStamp, (code == QC_GOOD));
+      };
+
+      record.setQuality(column, code);
+
+      if (code != QC_GOOD)
+      {
+        LOGDEBUG("Record {}: {} = {} flagged {}.", record.timeStamp, columnName(column), value, qualityName(code));
+        flagged++;
+      };
+    };
+
+    if (inOrder)
+    {
+      lastTimeStamp = record.timeStamp;
+    };
+
+    return flagged;
+  }
+
+} // namespace WSd
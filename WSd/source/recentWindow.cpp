@@ -0,0 +1,147 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								RecentWindow
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            In memory window of the most recent archive records of a station. Queries for recent data (the last hour of
+//                      wind) are answered from the window without touching the local store or the database.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/recentWindow.h"
+
+namespace WSd
+{
+  /// @brief      Constructor.
+  /// @param[in]  capacity: The number of records held in the window.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CRecentWindow::CRecentWindow(std::size_t capacity) : buffer(capacity > 0 ? capacity : 1)
+  {
+  }
+
+  /// @brief      Finds the first record with a time stamp that is not less than the time stamp.
+  /// @param[in]  timeStamp: The time stamp to search for.
+  /// @returns    The (logical) index of the record. size() if there is no such record.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::size_t CRecentWindow::lowerBound(std::int64_t timeStamp) const
+  {
+    std::size_t first = 0;
+    std::size_t length = count;
+
+    while (length > 0)
+    {
+      std::size_t half = length / 2;
+
+      if (at(first + half).timeStamp < timeStamp)
+      {
+        first += half + 1;
+        length -= half + 1;
+      }
+      else
+      {
+        length = half;
+      };
+    };
+
+    return first;
+  }
+
+  /// @brief      Inserts a record in time order. When the window is full the oldest record is dropped. Records that are older
+  ///             than all the records in a full window, and records that are already held, are ignored.
+  /// @param[in]  record: The record to insert.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CRecentWindow::insert(SArchiveRecord const &record)
+  {
+    if ( (count == 0) || (record.timeStamp > latest().timeStamp) )
+    {
+        // Normal case. Append the record.
+
+      if (count == buffer.size())
+      {
+        head = physical(1);
+        count--;
+      };
+      buffer[physical(count)] = record;
+      count++;
+    }
+    else
+    {
+      std::size_t position = lowerBound(record.timeStamp);
+
+      if ( (position < count) && (at(position).timeStamp == record.timeStamp) )
+      {
+        return;
+      };
+
+      if (count == buffer.size())
+      {
+        if (position == 0)
+        {
+          return;
+        };
+
+        head = physical(1);
+        count--;
+        position--;
+      };
+
+      for (std::size_t index = count; index > position; index--)
+      {
+        buffer[physical(index)] = buffer[physical(index - 1)];
+      };
+      buffer[physical(position)] = record;
+      count++;
+    };
+  }
+
+  /// @brief      Scans the records in a time range, in time order.
+  /// @param[in]  from: The start of the range (inclusive).
+  /// @param[in]  to: The end of the range (inclusive).
+  /// @param[in]  function: Called for each record. Return false to stop the scan.
+  /// @returns    true
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CRecentWindow::scan(std::int64_t from, std::int64_t to, CTimeSeriesStore::TScanFunction const &function) const
+  {
+    for (std::size_t index = lowerBound(from); (index < count) && (at(index).timeStamp <= to); index++)
+    {
+      if (!function(at(index)))
+      {
+        break;
+      };
+    };
+
+    return true;
+  }
+
+} // namespace WSd
@@ -0,0 +1,640 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								receptionLog
+// SUBSYSTEM:						Reception Diagnostics
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Radio reception diagnostics of a station. The console diagnostics (RXCHECK: packets received and missed,
+//                      resynchronisations, longest run of packets received and CRC errors) are sampled at a low rate and the raw
+//                      packets received from the transmitters (STRMON) may be captured. Both are kept as a compact time series per
+//                      station and are served as metrics by the read API.
+//
+// HISTORY:             2026-10-19/GGB - Sparse time index added. Time ranges read without parsing the whole file.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/receptionLog.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+  // Miscellaneous library header files
+
+#include <QDir>
+#include <QFileInfo>
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+  static char const MAGIC[] = "WSDR";
+  static qsizetype const MAGIC_SIZE = 4;
+  static char const VERSION = 1;
+  static qsizetype const HEADER_SIZE = MAGIC_SIZE + 1;
+  static std::size_t const COUNTERS = 5;              // Counters of a sample.
+  static qsizetype const PACKET_SIZE = 8;
+
+  std::map<CReceptionLog::TStationKey, CReceptionLog *> CReceptionLog::registry;
+
+  /// @brief      Constructor. Registers the station. The file is not opened until open() is called.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @param[in]  fileName: The reception file of the station.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReceptionLog::CReceptionLog(std::uint32_t sid, std::uint32_t iid, QString const &fileName)
+    : siteID(sid), instrumentID(iid), file(fileName)
+  {
+    registry[TStationKey(siteID, instrumentID)] = this;
+  }
+
+  /// @brief      Destructor. Removes the station from the registry.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReceptionLog::~CReceptionLog()
+  {
+    auto iterator = registry.find(TStationKey(siteID, instrumentID));
+
+    if ( (iterator != registry.end()) && (iterator->second == this) )
+    {
+      registry.erase(iterator);
+    };
+  }
+
+  /// @brief      Opens the reception file for appending. The header is written if the file is new. A truncated final record is
+  ///             removed, and a file that is not a reception file is replaced. The time index is built from the file.
+  /// @returns    true if the file was opened.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Time index built.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReceptionLog::open()
+  {
+    std::vector<SReceptionSample> samples;
+    std::vector<SRadioPacket> packets;
+    QByteArray data;
+    qsizetype end = -1;
+
+    QDir().mkpath(QFileInfo(file.fileName()).absolutePath());
+
+    if (!file.open(QIODevice::ReadWrite))
+    {
+      LOGERROR("Unable to open reception file {}.", file.fileName().toStdString());
+      return false;
+    };
+
+    data = file.readAll();
+    timeIndex.clear();
+    previousTime = 0;
+
+    if ( (data.size() >= HEADER_SIZE) && data.startsWith(QByteArray(MAGIC, MAGIC_SIZE)) && (data[MAGIC_SIZE] == VERSION) )
+    {
+      end = parse(data, HEADER_SIZE, previousTime, samples, packets, &timeIndex);
+    };
+
+    if (end < 0)
+    {
+      QByteArray header(MAGIC, MAGIC_SIZE);
+
+      if (file.size() != 0)
+      {
+        LOGWARNING("Reception file {} is not valid. Replaced.", file.fileName().toStdString());
+      };
+
+      header.append(VERSION);
+      fileSize = 0;
+
+      if (!file.resize(0) || !file.seek(0) || !write(header, 0))
+      {
+        file.close();
+        return false;
+      };
+    }
+    else
+    {
+      if (end != file.size())
+      {
+        LOGWARNING("Truncated record removed from reception file {}.", file.fileName().toStdString());
+        file.resize(end);
+      };
+      fileSize = end;
+    };
+
+    return file.seek(file.size());
+  }
+
+  /// @brief      Writes records to the file. An entry is added to the time index when INDEX_BYTES have been written since the
+  ///             last entry.
+  /// @param[in]  data: The records.
+  /// @param[in]  time: The time of the record preceding the records. (ms since 1970)
+  /// @returns    true if the records were written.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Time index maintained.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReceptionLog::write(QByteArray const &data, std::int64_t time)
+  {
+    bool returnValue = file.isOpen() && (file.write(data) == data.size()) && file.flush();
+
+    if (!returnValue)
+    {
+      LOGERROR("Unable to write reception file {}.", file.fileName().toStdString());
+      fileSize = file.size();
+    }
+    else
+    {
+      if ( (fileSize >= HEADER_SIZE) && (fileSize - (timeIndex.empty() ? HEADER_SIZE : timeIndex.back().offset) >= INDEX_BYTES) )
+      {
+        timeIndex.push_back({ fileSize, time });
+      };
+      fileSize += data.size();
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Appends the type and the time of a record. The time is written as the time since the previous record; a time
+  ///             before the previous record (the clock was set back) is written as the time of the previous record.
+  /// @param[in]  output: The buffer to append to.
+  /// @param[in]  type: The type of the record.
+  /// @param[in]  timeStamp: The time of the record. (ms since 1970)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReceptionLog::appendRecord(QByteArray &output, ERecord type, std::int64_t timeStamp)
+  {
+    output.append(static_cast<char>(type));
+
+    if (timeStamp > previousTime)
+    {
+      appendVarint(output, static_cast<std::uint64_t>(timeStamp - previousTime));
+      previousTime = timeStamp;
+    }
+    else
+    {
+      appendVarint(output, 0);
+    };
+  }
+
+  /// @brief      Appends an unsigned LEB128 varint.
+  /// @param[in]  output: The buffer to append to.
+  /// @param[in]  value: The value to append.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReceptionLog::appendVarint(QByteArray &output, std::uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      output.append(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    };
+
+    output.append(static_cast<char>(value));
+  }
+
+  /// @brief      Reads an unsigned LEB128 varint.
+  /// @param[in]  input: The buffer to read from.
+  /// @param[in,out] position: The position of the varint. Updated to the byte following the varint.
+  /// @param[out] value: The value read.
+  /// @returns    false if the varint is truncated or too long.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReceptionLog::readVarint(QByteArray const &input, qsizetype &position, std::uint64_t &value)
+  {
+    value = 0;
+
+    for (int shift = 0; (shift < 64) && (position < input.size()); shift += 7)
+    {
+      std::uint8_t byte = static_cast<std::uint8_t>(input[position++]);
+
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+      if ((byte & 0x80) == 0)
+      {
+        return true;
+      };
+    };
+
+    return false;
+  }
+
+  /// @brief      Parses records of a reception file. A truncated final record (the daemon stopped while writing) is ignored.
+  /// @param[in]  data: The records. (The contents of the file, or a part of it.)
+  /// @param[in]  begin: The offset of the first record in data.
+  /// @param[in,out] lastTime: The time of the record preceding the first record (ms since 1970, 0 at the start of the file).
+  ///             Updated to the time of the last record parsed.
+  /// @param[out] samples: The samples parsed are appended.
+  /// @param[out] packets: The packets parsed are appended.
+  /// @param[out] index: Entries of the time index are appended. (nullptr if not required.)
+  /// @returns    The offset in data following the last complete record.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Parses a part of the file. Time index built.
+  /// @version    2026-10-19/GGB - Function created.
+
+  qsizetype CReceptionLog::parse(QByteArray const &data, qsizetype begin, std::int64_t &lastTime,
+                                 std::vector<SReceptionSample> &samples, std::vector<SRadioPacket> &packets,
+                                 std::vector<SIndexEntry> *index)
+  {
+    qsizetype end = begin;
+
+    while (end < data.size())
+    {
+      qsizetype position = end;
+
+      if ( index && (end - (index->empty() ? begin : index->back().offset) >= INDEX_BYTES) )
+      {
+        index->push_back({ end, lastTime });
+      };
+
+      ERecord type = static_cast<ERecord>(data[position++]);
+      std::uint64_t delay;
+
+      if (!readVarint(data, position, delay))
+      {
+        break;
+      }
+      else if (type == RR_SAMPLE)
+      {
+        std::uint64_t counters[COUNTERS];
+        std::size_t count = 0;
+
+        while ( (count < COUNTERS) && readVarint(data, position, counters[count]) )
+        {
+          count++;
+        };
+
+        if (count != COUNTERS)
+        {
+          break;
+        };
+
+        SReceptionSample &sample = samples.emplace_back();
+
+        sample.timeStamp = lastTime + static_cast<std::int64_t>(delay);
+        sample.packets = static_cast<std::uint32_t>(counters[0]);
+        sample.missed = static_cast<std::uint32_t>(counters[1]);
+        sample.resyncs = static_cast<std::uint32_t>(counters[2]);
+        sample.maxInARow = static_cast<std::uint32_t>(counters[3]);
+        sample.crcErrors = static_cast<std::uint32_t>(counters[4]);
+      }
+      else if ( (type == RR_PACKET) && (position + PACKET_SIZE <= data.size()) )
+      {
+        SRadioPacket &packet = packets.emplace_back();
+
+        packet.timeStamp = lastTime + static_cast<std::int64_t>(delay);
+        for (std::uint8_t &byte : packet.data)
+        {
+          byte = static_cast<std::uint8_t>(data[position++]);
+        };
+      }
+      else
+      {
+        break;
+      };
+
+      lastTime += static_cast<std::int64_t>(delay);
+      end = position;
+    };
+
+    return end;
+  }
+
+  /// @brief      Returns the increase of a counter between two samples. The counters of the console fall back to zero at
+  ///             midnight, so a counter that is lower than in the previous sample has counted up from zero.
+  /// @param[in]  previous: The counter in the previous sample.
+  /// @param[in]  current: The counter in this sample.
+  /// @returns    The increase.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint64_t CReceptionLog::increase(std::uint32_t previous, std::uint32_t current)
+  {
+    return (current >= previous) ? (current - previous) : current;
+  }
+
+  /// @brief      Adds a sample of the console diagnostics.
+  /// @param[in]  sample: The sample.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReceptionLog::add(SReceptionSample const &sample)
+  {
+    QByteArray record;
+
+    if (sampled)
+    {
+      totalPackets += increase(latest.packets, sample.packets);
+      totalMissed += increase(latest.missed, sample.missed);
+      totalResyncs += increase(latest.resyncs, sample.resyncs);
+      totalCRCErrors += increase(latest.crcErrors, sample.crcErrors);
+    };
+    latest = sample;
+    sampled = true;
+
+    std::int64_t time = previousTime;
+
+    appendRecord(record, RR_SAMPLE, sample.timeStamp);
+    appendVarint(record, sample.packets);
+    appendVarint(record, sample.missed);
+    appendVarint(record, sample.resyncs);
+    appendVarint(record, sample.maxInARow);
+    appendVarint(record, sample.crcErrors);
+
+    write(record, time);
+  }
+
+  /// @brief      Adds raw packets received from the transmitters. The packets are written with one write.
+  /// @param[in]  packets: The packets.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReceptionLog::add(std::vector<SRadioPacket> const &packets)
+  {
+    QByteArray records;
+    std::int64_t time = previousTime;
+
+    if (packets.empty())
+    {
+      return;
+    };
+
+    records.reserve(static_cast<qsizetype>(packets.size()) * (PACKET_SIZE + 4));
+
+    for (SRadioPacket const &packet : packets)
+    {
+      appendRecord(records, RR_PACKET, packet.timeStamp);
+      records.append(reinterpret_cast<char const *>(packet.data.data()), PACKET_SIZE);
+    };
+
+    totalCaptured += packets.size();
+
+    write(records, time);
+  }
+
+  /// @brief      Finds the part of the file that holds a time range, from the time index. The records before the last index
+  ///             entry preceded by a time before the range, and the records from the first entry preceded by a time after the
+  ///             range, are outside the range. (The times of the records never decrease.)
+  /// @param[in]  from: The start of the range. (ms since 1970, inclusive)
+  /// @param[in]  to: The end of the range. (ms since 1970, inclusive)
+  /// @returns    The part of the file to read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReceptionLog::SRange CReceptionLog::range(std::int64_t from, std::int64_t to) const
+  {
+    SRange returnValue;
+
+    returnValue.fileName = file.fileName();
+    returnValue.begin = HEADER_SIZE;
+    returnValue.end = fileSize;
+    returnValue.time = 0;
+
+    auto first = std::partition_point(timeIndex.begin(), timeIndex.end(),
+                                      [from](SIndexEntry const &entry) { return entry.time < from; });
+    auto last = std::partition_point(first, timeIndex.end(), [to](SIndexEntry const &entry) { return entry.time <= to; });
+
+    if (first != timeIndex.begin())
+    {
+      returnValue.begin = (first - 1)->offset;
+      returnValue.time = (first - 1)->time;
+    };
+    if (last != timeIndex.end())
+    {
+      returnValue.end = last->offset;
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Reads the samples and packets of a time range from the part of the file that holds the range. Only the part of
+  ///             the file is read, so this may run on any thread while records are appended.
+  /// @param[in]  range: The part of the file. (From range().)
+  /// @param[in]  from: The start of the range. (ms since 1970, inclusive)
+  /// @param[in]  to: The end of the range. (ms since 1970, inclusive)
+  /// @param[out] samples: The samples in the range.
+  /// @param[out] packets: The packets in the range.
+  /// @returns    false if the file could not be read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Only the part of the file that holds the range is read.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReceptionLog::read(SRange const &range, std::int64_t from, std::int64_t to, std::vector<SReceptionSample> &samples,
+                           std::vector<SRadioPacket> &packets)
+  {
+    QFile input(range.fileName);
+    std::int64_t lastTime = range.time;
+
+    if (!input.open(QIODevice::ReadOnly) || !input.seek(range.begin))
+    {
+      return false;
+    };
+
+    parse(input.read(std::max<qint64>(range.end - range.begin, 0)), 0, lastTime, samples, packets, nullptr);
+
+    std::erase_if(samples, [from, to](SReceptionSample const &sample)
+    {
+      return (sample.timeStamp < from) || (sample.timeStamp > to);
+    });
+    std::erase_if(packets, [from, to](SRadioPacket const &packet)
+    {
+      return (packet.timeStamp < from) || (packet.timeStamp > to);
+    });
+
+    return true;
+  }
+
+  /// @brief      Parses the counters line of the response to RXCHECK. (eg " 21629 15 0 3204 128")
+  /// @param[in]  line: The line. (The line end may be included.)
+  /// @param[out] sample: The counters. The time of the sample is not changed.
+  /// @returns    true if the line holds the five counters.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReceptionLog::parseRXCHECK(QByteArray const &line, SReceptionSample &sample)
+  {
+    std::string text = line.toStdString();
+    char const *position = text.c_str();
+    std::uint32_t *counters[COUNTERS] = { &sample.packets, &sample.missed, &sample.resyncs, &sample.maxInARow, &sample.crcErrors };
+    std::uint32_t values[COUNTERS];
+
+    for (std::size_t index = 0; index < COUNTERS; index++)
+    {
+      char *end;
+
+      while ( (*position == ' ') || (*position == '\t') )
+      {
+        position++;
+      };
+
+      if ( (*position < '0') || (*position > '9') )
+      {
+        return false;
+      };
+
+      values[index] = static_cast<std::uint32_t>(std::strtoul(position, &end, 10));
+      position = end;
+    };
+
+    while ( (*position == ' ') || (*position == '\t') || (*position == '\n') || (*position == '\r') )
+    {
+      position++;
+    };
+
+    if (*position != 0)
+    {
+      return false;
+    };
+
+    for (std::size_t index = 0; index < COUNTERS; index++)
+    {
+      *counters[index] = values[index];
+    };
+
+    return true;
+  }
+
+  /// @brief      Parses a line of the output of STRMON. Each byte of a packet is given on its own line as the index of the byte
+  ///             and its value in hexadecimal. (eg "0 = 0x81")
+  /// @param[in]  line: The line. (The line end may be included.)
+  /// @param[out] value: The value of the byte.
+  /// @returns    The index of the byte in the packet (0 - 7). -1 if the line is not a byte of a packet.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  int CReceptionLog::parseSTRMON(QByteArray const &line, std::uint8_t &value)
+  {
+    QList<QByteArray> parts = line.simplified().split('=');
+    bool indexValid;
+    bool valueValid;
+    int index;
+    unsigned int byte;
+
+    if (parts.size() != 2)
+    {
+      return -1;
+    };
+
+    QByteArray text = parts[1].trimmed();
+
+    if (text.startsWith("0x") || text.startsWith("0X"))
+    {
+      text.remove(0, 2);
+    };
+
+    index = parts[0].trimmed().toInt(&indexValid);
+    byte = text.toUInt(&valueValid, 16);
+
+    if (!indexValid || !valueValid || (index < 0) || (index >= PACKET_SIZE) || (byte > 0xFF))
+    {
+      return -1;
+    };
+
+    value = static_cast<std::uint8_t>(byte);
+
+    return index;
+  }
+
+  /// @brief      Appends the reception metrics of the stations in the Prometheus text format. The totals count from the start
+  ///             of the daemon.
+  /// @param[in]  output: The buffer to append to.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReceptionLog::metrics(QByteArray &output)
+  {
+    struct SMetric
+    {
+      char const *name;
+      char const *type;
+      char const *help;
+      bool sampleOnly;
+      double (*value)(CReceptionLog const &);
+    };
+
+    static SMetric const metricList[] =
+    {
+      { "wsd_reception_packets_total", "counter", "Packets received from the transmitters.", true,
+        [](CReceptionLog const &log) { return static_cast<double>(log.totalPackets); } },
+      { "wsd_reception_missed_total", "counter", "Packets missed.", true,
+        [](CReceptionLog const &log) { return static_cast<double>(log.totalMissed); } },
+      { "wsd_reception_resyncs_total", "counter", "Resynchronisations with the transmitters.", true,
+        [](CReceptionLog const &log) { return static_cast<double>(log.totalResyncs); } },
+      { "wsd_reception_crc_errors_total", "counter", "Packets received with a CRC error.", true,
+        [](CReceptionLog const &log) { return static_cast<double>(log.totalCRCErrors); } },
+      { "wsd_reception_max_in_a_row", "gauge", "Longest run of packets received today.", true,
+        [](CReceptionLog const &log) { return static_cast<double>(log.latest.maxInARow); } },
+      { "wsd_reception_ratio", "gauge", "Fraction of the packets received today.", true,
+        [](CReceptionLog const &log)
+        {
+          std::uint64_t expected = static_cast<std::uint64_t>(log.latest.packets) + log.latest.missed;
+
+          return (expected == 0) ? 1.0 : static_cast<double>(log.latest.packets) / expected;
+        } },
+      { "wsd_reception_sample_timestamp_seconds", "gauge", "Time of the last sample of the console diagnostics.", true,
+        [](CReceptionLog const &log) { return static_cast<double>(log.latest.timeStamp) / 1000; } },
+      { "wsd_radio_packets_captured_total", "counter", "Raw packets captured with STRMON.", false,
+        [](CReceptionLog const &log) { return static_cast<double>(log.totalCaptured); } },
+    };
+
+    for (SMetric const &metric : metricList)
+    {
+      output.append("# HELP ").append(metric.name).append(' ').append(metric.help).append('\n');
+      output.append("# TYPE ").append(metric.name).append(' ').append(metric.type).append('\n');
+
+      for (auto const &entry : registry)
+      {
+        if (!metric.sampleOnly || entry.second->sampled)
+        {
+          output.append(metric.name).append("{station=\"").append(QByteArray::number(entry.first.first)).append('-');
+          output.append(QByteArray::number(entry.first.second)).append("\"} ");
+          output.append(QByteArray::number(metric.value(*entry.second), 'g', 12)).append('\n');
+        };
+      };
+    };
+  }
+
+  /// @brief      Finds the reception log of a station.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @returns    The reception log. nullptr if the reception of the station is not sampled.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReceptionLog *CReceptionLog::find(std::uint32_t sid, std::uint32_t iid)
+  {
+    auto iterator = registry.find(TStationKey(sid, iid));
+
+    return (iterator != registry.end()) ? iterator->second : nullptr;
+  }
+
+} // namespace WSd
@@ -0,0 +1,326 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								replicationJournal
+// SUBSYSTEM:						Replication
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Replication journal of a station. Each record that is new to the local store is appended to the journal in
+//                      the order it was ingested and is numbered by its log sequence number (LSN), starting from 1. The journal
+//                      holds the raw archive records, so a downstream daemon applies them through its own ingest pipeline. Entries
+//                      are fixed size, so the entries following a sequence number are read without an index. Entries are synced to
+//                      disk before they are numbered, so an entry that has been served survives a crash.
+//
+// HISTORY:             2026-10-19/GGB - Entries synced to disk before they are served.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/replicationJournal.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <chrono>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <WCL>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+  // WSd header files
+
+#include "include/logger.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+    // Journal file: magic, version, three reserved bytes and the epoch (int64, little endian), followed by the entries. Each entry
+    // is a raw archive record and the CRC of the record (CRC-CCITT, big endian as used by the console). The entry with sequence
+    // number n is at HEADER_SIZE + (n - 1) * ENTRY_SIZE.
+
+  static char const JOURNAL_MAGIC[4] = { 'W', 'S', 'D', 'J' };
+  static char const JOURNAL_VERSION = 1;
+
+  /// @brief      Writes the data of a file that has been flushed through to the disk.
+  /// @param[in]  file: The open file.
+  /// @returns    true if the data is on the disk.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static bool syncFile(QFile &file)
+  {
+#if defined(Q_OS_WIN)
+    return (_commit(file.handle()) == 0);
+#elif defined(Q_OS_MACOS)
+    return (fsync(file.handle()) == 0);
+#else
+    return (fdatasync(file.handle()) == 0);
+#endif
+  }
+
+  /// @brief      Constructor. The file is not opened until open() is called.
+  /// @param[in]  fileName: The journal file of the station.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReplicationJournal::CReplicationJournal(QString const &fileName) : file(fileName)
+  {
+  }
+
+  /// @brief      Opens the journal for appending. The journal is created with a new epoch if it does not exist or is not a
+  ///             journal. Entries left incomplete or corrupted by a crash are removed from the end of the journal. Removed entries
+  ///             may already have been served, and their sequence numbers are used again, so the journal is given a new epoch and
+  ///             the replicas start again from the first entry.
+  /// @returns    true if the journal was opened.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - New epoch when entries are removed.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReplicationJournal::open()
+  {
+    QByteArray header;
+    qint64 size;
+
+    QDir().mkpath(QFileInfo(file.fileName()).absolutePath());
+
+    if (!file.open(QIODevice::ReadWrite))
+    {
+      LOGERROR("Unable to open replication journal {}.", file.fileName().toStdString());
+      return false;
+    };
+
+    header = file.read(HEADER_SIZE);
+
+    if ( (header.size() != HEADER_SIZE) || !header.startsWith(QByteArray(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) ||
+         (header[sizeof(JOURNAL_MAGIC)] != JOURNAL_VERSION) )
+    {
+      if (file.size() != 0)
+      {
+        LOGWARNING("Replication journal {} is not valid. Replaced.", file.fileName().toStdString());
+      };
+      return create();
+    };
+
+    journalEpoch = 0;
+    for (int index = 0; index < 8; index++)
+    {
+      journalEpoch |= static_cast<std::int64_t>(static_cast<std::uint8_t>(header[8 + index])) << (8 * index);
+    };
+
+      // Only the end of the journal can be damaged by a crash. Entries are removed from the end until one is intact.
+
+    size = file.size();
+    entryCount = static_cast<std::uint64_t>((size - HEADER_SIZE) / ENTRY_SIZE);
+
+    while (entryCount != 0)
+    {
+      QByteArray entry;
+
+      file.seek(HEADER_SIZE + static_cast<qint64>(entryCount - 1) * ENTRY_SIZE);
+      entry = file.read(ENTRY_SIZE);
+
+      if ( (entry.size() == ENTRY_SIZE) &&
+           (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(entry.data()), 0, ENTRY_SIZE) == 0) )
+      {
+        break;
+      };
+      entryCount--;
+    };
+
+    if (HEADER_SIZE + static_cast<qint64>(entryCount) * ENTRY_SIZE != size)
+    {
+      std::int64_t previousEpoch = journalEpoch;
+
+      LOGWARNING("Incomplete entries removed from replication journal {}. New epoch.", file.fileName().toStdString());
+
+      journalEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+      if (journalEpoch <= previousEpoch)
+      {
+        journalEpoch = previousEpoch + 1;
+      };
+
+      if (!file.resize(HEADER_SIZE + static_cast<qint64>(entryCount) * ENTRY_SIZE) || !writeHeader())
+      {
+        LOGERROR("Unable to repair replication journal {}.", file.fileName().toStdString());
+        file.close();
+        return false;
+      };
+    };
+
+    return true;
+  }
+
+  /// @brief      Creates an empty journal with a new epoch.
+  /// @returns    true if the journal was created.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReplicationJournal::create()
+  {
+    journalEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::system_clock::now().time_since_epoch()).count();
+    entryCount = 0;
+
+    if (!file.resize(0) || !writeHeader())
+    {
+      LOGERROR("Unable to create replication journal {}.", file.fileName().toStdString());
+      file.close();
+      return false;
+    };
+
+    return true;
+  }
+
+  /// @brief      Writes the header of the journal with the current epoch and syncs it to disk.
+  /// @returns    true if the header was written.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Synced to disk.
+  /// @version    2026-10-19/GGB - Function created from create().
+
+  bool CReplicationJournal::writeHeader()
+  {
+    QByteArray header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+
+    header.append(JOURNAL_VERSION);
+    header.append(3, '\0');
+    for (int index = 0; index < 8; index++)
+    {
+      header.append(static_cast<char>((static_cast<std::uint64_t>(journalEpoch) >> (8 * index)) & 0xFF));
+    };
+
+    return (file.seek(0) && (file.write(header) == HEADER_SIZE) && file.flush() && syncFile(file));
+  }
+
+  /// @brief      Appends records to the journal. The records are numbered in the order they are given. They are only numbered
+  ///             (and so served to the replicas) once they are on the disk; otherwise a crash could lose entries that a replica
+  ///             has applied, and their sequence numbers would be used again for other records in the same epoch.
+  /// @param[in]  records: The raw archive records.
+  /// @returns    true if the records were appended.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Entries synced to disk before they are numbered.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReplicationJournal::append(std::vector<TRawRecord> const &records)
+  {
+    QByteArray data;
+
+    TRACESPAN("appendJournal", records.size());
+
+    if (!file.isOpen())
+    {
+      return false;
+    };
+
+    data.reserve(static_cast<qsizetype>(records.size() * ENTRY_SIZE));
+
+    for (TRawRecord const &record : records)
+    {
+      qsizetype offset = data.size();
+      std::uint16_t CRC;
+
+      data.append(reinterpret_cast<char const *>(record.data()), ARCHIVE_RECORD_SIZE);
+      CRC = WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), offset, ARCHIVE_RECORD_SIZE);
+      data.append(static_cast<char>(CRC >> 8));
+      data.append(static_cast<char>(CRC & 0xFF));
+    };
+
+    if (!file.seek(HEADER_SIZE + static_cast<qint64>(entryCount) * ENTRY_SIZE) || (file.write(data) != data.size()) ||
+        !file.flush() || !syncFile(file))
+    {
+      LOGERROR("Unable to write replication journal {}.", file.fileName().toStdString());
+
+        // The entries that were written are not numbered, and are overwritten by the next append.
+
+      return false;
+    };
+
+    entryCount += records.size();
+
+    return true;
+  }
+
+  /// @brief      Reads the entries that follow a sequence number.
+  /// @param[in]  after: The sequence number to read after. (0 to read from the first entry.)
+  /// @param[in]  maximum: The maximum number of entries to read.
+  /// @param[out] records: The raw archive records. The first record has the sequence number after + 1.
+  /// @returns    false if the journal could not be read or an entry is corrupted.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReplicationJournal::read(std::uint64_t after, std::size_t maximum, std::vector<TRawRecord> &records)
+  {
+    QByteArray data;
+    std::size_t count;
+
+    records.clear();
+
+    if (!file.isOpen())
+    {
+      return false;
+    }
+    else if (after >= entryCount)
+    {
+      return true;
+    };
+
+    count = static_cast<std::size_t>(std::min<std::uint64_t>(entryCount - after, maximum));
+
+    if (!file.seek(HEADER_SIZE + static_cast<qint64>(after) * ENTRY_SIZE))
+    {
+      return false;
+    };
+
+    data = file.read(static_cast<qint64>(count) * ENTRY_SIZE);
+    if (data.size() != static_cast<qsizetype>(count) * ENTRY_SIZE)
+    {
+      return false;
+    };
+
+    records.resize(count);
+    for (std::size_t index = 0; index < count; index++)
+    {
+      std::uint8_t *entry = reinterpret_cast<std::uint8_t *>(data.data()) + index * ENTRY_SIZE;
+
+      if (WCL::calculateCRC(entry, 0, ENTRY_SIZE) != 0)
+      {
+        LOGERROR("Replication journal {} corrupted at sequence {}.", file.fileName().toStdString(), after + index + 1);
+        records.resize(index);
+        return false;
+      };
+
+      std::copy(entry, entry + ARCHIVE_RECORD_SIZE, records[index].begin());
+    };
+
+    return true;
+  }
+
+} // namespace WSd
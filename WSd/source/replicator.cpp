@@ -0,0 +1,370 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								replicator
+// SUBSYSTEM:						Replication
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Replication of a station from an upstream daemon. The entries of the replication journal of the upstream
+//                      daemon are requested in batches through its read API, from the last sequence number applied, and each batch
+//                      is applied through the ingest pipeline of the station. The epoch of the journal and the last sequence number
+//                      applied are saved after each batch, so replication resumes where it stopped when the daemon is restarted.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/replicator.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <WCL>
+
+  // WSd header files
+
+#include "include/archiveRecord.h"
+#include "include/logger.h"
+#include "include/tracer.h"
+#include "include/transaction.h"
+
+namespace WSd
+{
+    // Position file: magic, version, the epoch (int64) and the last sequence number applied (uint64), little endian, and the
+    // CRC of the two (CRC-CCITT, big endian as used by the console).
+
+  static char const POSITION_MAGIC[4] = { 'W', 'S', 'D', 'P' };
+  static char const POSITION_VERSION = 1;
+  static qsizetype const POSITION_FIELDS = 16;
+  static char const REPLICATION_MAGIC[4] = { 'W', 'S', 'D', 'L' };
+  static char const REPLICATION_VERSION = 1;
+
+  /// @brief      Reads a little endian integer.
+  /// @param[in]  data: The data to read from.
+  /// @param[in]  offset: The offset of the integer.
+  /// @param[in]  size: The size of the integer. (bytes)
+  /// @returns    The integer.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::uint64_t readInteger(QByteArray const &data, qsizetype offset, int size)
+  {
+    std::uint64_t value = 0;
+
+    for (int index = 0; index < size; index++)
+    {
+      value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[offset + index])) << (8 * index);
+    };
+
+    return value;
+  }
+
+  /// @brief      Appends a little endian integer.
+  /// @param[in]  data: The data to append to.
+  /// @param[in]  value: The value to append.
+  /// @param[in]  size: The size of the integer. (bytes)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static void appendInteger(QByteArray &data, std::uint64_t value, int size)
+  {
+    for (int index = 0; index < size; index++)
+    {
+      data.append(static_cast<char>((value >> (8 * index)) & 0xFF));
+    };
+  }
+
+  /// @brief      Constructor. The position saved by a previous run is loaded.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @param[in]  host: The address of the upstream daemon.
+  /// @param[in]  p: The read API port of the upstream daemon.
+  /// @param[in]  fileName: The file the position is saved in.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReplicator::CReplicator(std::uint32_t sid, std::uint32_t iid, QString const &host, std::uint16_t p, QString const &fileName)
+    : siteID(sid), instrumentID(iid), hostAddress(host), port(p), positionFile(fileName)
+  {
+    loadPosition();
+  }
+
+  /// @brief      Loads the position saved by a previous run. Replication starts from the first entry if there is no valid
+  ///             position.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReplicator::loadPosition()
+  {
+    QFile file(positionFile);
+    QByteArray data;
+    qsizetype offset = sizeof(POSITION_MAGIC) + 1;
+
+    if (file.open(QIODevice::ReadOnly))
+    {
+      data = file.readAll();
+
+      if ( (data.size() != offset + POSITION_FIELDS + 2) ||
+           !data.startsWith(QByteArray(POSITION_MAGIC, sizeof(POSITION_MAGIC))) || (data[offset - 1] != POSITION_VERSION) ||
+           (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), offset, POSITION_FIELDS + 2) != 0) )
+      {
+        LOGWARNING("Replication position {} is not valid. Replicating from the first entry.", positionFile.toStdString());
+      }
+      else
+      {
+        epoch = static_cast<std::int64_t>(readInteger(data, offset, 8));
+        appliedSequence = readInteger(data, offset + 8, 8);
+        LOGINFO("Replication resumed after sequence {}.", appliedSequence);
+      };
+    };
+  }
+
+  /// @brief      Saves the position. The file is written to disk and replaced atomically.
+  /// @returns    true if the position was saved.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Written with QSaveFile.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CReplicator::savePosition() const
+  {
+    QByteArray data(POSITION_MAGIC, sizeof(POSITION_MAGIC));
+    QSaveFile file(positionFile);
+    std::uint16_t CRC;
+
+    data.append(POSITION_VERSION);
+    appendInteger(data, static_cast<std::uint64_t>(epoch), 8);
+    appendInteger(data, appliedSequence, 8);
+
+    CRC = WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), sizeof(POSITION_MAGIC) + 1, POSITION_FIELDS);
+    data.append(static_cast<char>(CRC >> 8));
+    data.append(static_cast<char>(CRC & 0xFF));
+
+    QDir().mkpath(QFileInfo(positionFile).absolutePath());
+
+    if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit())
+    {
+      LOGERROR("Unable to write replication position {}.", positionFile.toStdString());
+      return false;
+    };
+
+    return true;
+  }
+
+  /// @brief      Requests the journal entries that follow a sequence number from the upstream daemon. The read API closes the
+  ///             connection after each response, so each request is made on a new connection.
+  /// @param[in]  after: The sequence number to request the entries after.
+  /// @returns    The body of the response. Empty if the request failed or replication has been cancelled.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Not connected once replication has been cancelled.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<QByteArray> CReplicator::request(std::uint64_t after)
+  {
+    QByteArray header;
+    QByteArray body;
+    qint64 contentLength = -1;
+
+    if (cancelled)
+    {
+      co_return QByteArray();
+    };
+
+    if (!co_await CConnectAwaiter(socket, hostAddress, port, CONNECT_TIMEOUT))
+    {
+      LOGWARNING("Unable to connect to upstream daemon {}:{}.", hostAddress.toStdString(), port);
+      co_return QByteArray();
+    };
+
+    socket.write(QString("GET /stations/%1-%2/replication?after=%3&limit=%4 HTTP/1.1\r\nHost: %5\r\nConnection: close\r\n\r\n")
+                 .arg(siteID).arg(instrumentID).arg(after).arg(BATCH_RECORDS).arg(hostAddress).toLatin1());
+
+    while (!header.endsWith("\r\n\r\n") && (header.size() < MAX_HEADER_SIZE))
+    {
+      QByteArray byte = co_await CReadAwaiter(socket, 1, RESPONSE_TIMEOUT);
+
+      if (byte.isEmpty())
+      {
+        break;
+      };
+
+      header.append(byte);
+    };
+
+    for (QByteArray const &line : header.split('\n'))
+    {
+      if (line.toLower().startsWith("content-length:"))
+      {
+        bool valid;
+
+        contentLength = line.mid(15).trimmed().toLongLong(&valid);
+        if (!valid)
+        {
+          contentLength = -1;
+        };
+      };
+    };
+
+    if (!header.startsWith("HTTP/1.1 200") || (contentLength < 0))
+    {
+      LOGWARNING("Upstream daemon {}:{} refused replication: {}", hostAddress.toStdString(), port,
+                 header.left(header.indexOf('\r')).toStdString());
+      socket.abort();
+      co_return QByteArray();
+    };
+
+    body = co_await CReadAwaiter(socket, contentLength, RESPONSE_TIMEOUT);
+    socket.abort();
+
+    if (body.size() != contentLength)
+    {
+      LOGWARNING("Replication response from upstream daemon {}:{} incomplete.", hostAddress.toStdString(), port);
+      co_return QByteArray();
+    };
+
+    co_return body;
+  }
+
+  /// @brief      Cancels replication (eg the daemon is stopping). The connection is aborted, so a pull waiting for the upstream
+  ///             daemon completes straight away, and the upstream daemon is not connected again.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReplicator::cancel()
+  {
+    cancelled = true;
+    socket.abort();
+  }
+
+  /// @brief      Pulls the journal entries that have not been applied from the upstream daemon and applies them, one batch at a
+  ///             time, until replication has caught up. The position is saved after each batch that has been stored; a batch
+  ///             that is not stored is requested again by the next pull. If the upstream journal has been created again (a
+  ///             different epoch, or fewer entries than have been applied) replication starts again from the first entry.
+  /// @param[in]  ingest: The ingest pipeline of the station. The database must be open.
+  /// @returns    true if replication has caught up with the upstream daemon.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Batches written to the database without blocking the event loop.
+  /// @version    2026-10-19/GGB - Store written once per response.
+  /// @version    2026-10-19/GGB - Position only advanced by stored batches.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<bool> CReplicator::pull(CIngest &ingest)
+  {
+    std::uint64_t applied = 0;
+    bool caughtUp = false;
+
+    TRACESPAN("replicate");
+
+    ingest.startDownload();
+
+    while (!caughtUp)
+    {
+      QByteArray body = co_await request(appliedSequence);
+      std::vector<TRawRecord> records;
+      std::int64_t responseEpoch;
+      std::uint64_t lastSequence;
+      std::uint64_t firstSequence;
+      std::uint32_t count;
+
+      if ( (body.size() < RESPONSE_HEADER_SIZE) || !body.startsWith(QByteArray(REPLICATION_MAGIC, sizeof(REPLICATION_MAGIC))) ||
+           (body[sizeof(REPLICATION_MAGIC)] != REPLICATION_VERSION) )
+      {
+        if (!body.isEmpty())
+        {
+          LOGERROR("Replication response from upstream daemon {}:{} not valid.", hostAddress.toStdString(), port);
+        };
+        co_return false;
+      };
+
+      responseEpoch = static_cast<std::int64_t>(readInteger(body, 5, 8));
+      lastSequence = readInteger(body, 13, 8);
+      firstSequence = readInteger(body, 21, 8);
+      count = static_cast<std::uint32_t>(readInteger(body, 29, 4));
+
+      if ( (body.size() != RESPONSE_HEADER_SIZE + static_cast<qsizetype>(count) * static_cast<qsizetype>(ARCHIVE_RECORD_SIZE)) ||
+           (firstSequence != appliedSequence + 1) )
+      {
+        LOGERROR("Replication response from upstream daemon {}:{} not valid.", hostAddress.toStdString(), port);
+        co_return false;
+      };
+
+      if ( (responseEpoch != epoch) || (lastSequence < appliedSequence) )
+      {
+        if (appliedSequence != 0)
+        {
+          LOGWARNING("Journal of upstream daemon {}:{} created again. Replicating from the first entry.",
+                     hostAddress.toStdString(), port);
+        };
+
+        epoch = responseEpoch;
+        if (appliedSequence != 0)
+        {
+          appliedSequence = 0;
+          continue;                                   // The entries received follow a sequence number of the old journal.
+        };
+      };
+
+      if (count != 0)
+      {
+        records.resize(count);
+        for (std::uint32_t index = 0; index < count; index++)
+        {
+          char const *entry = body.constData() + RESPONSE_HEADER_SIZE + index * ARCHIVE_RECORD_SIZE;
+
+          std::copy(entry, entry + ARCHIVE_RECORD_SIZE, records[index].begin());
+        };
+
+        co_await ingest.ingest(records);
+        if (!ingest.lastBatchStored())
+        {
+          LOGWARNING("Replicated records after sequence {} not stored. Requested again.", appliedSequence);
+          co_return false;
+        };
+
+          // The store is written before the position is saved, so the position never runs ahead of the store.
+
+        ingest.endDownload();
+        appliedSequence += count;
+        applied += count;
+        savePosition();
+      };
+
+      caughtUp = (count == 0) || (appliedSequence >= lastSequence);
+    };
+
+    if (applied != 0)
+    {
+      LOGINFO("{} records replicated from {}:{}. Applied up to sequence {}.", applied, hostAddress.toStdString(), port,
+              appliedSequence);
+    };
+
+    co_return true;
+  }
+
+} // namespace WSd
@@ -0,0 +1,462 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Rollups
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Hourly and daily rollups (minimum, maximum, sum and count, so the mean) of temperature, humidity, pressure,
+//                      wind speed and rainfall. The rollups are updated as each new record is ingested. Because the aggregates are
+//                      commutative a late or backfilled record is simply added to its bucket. Aggregate queries read O(buckets)
+//                      instead of O(records).
+//                      The rollups are held in memory and the changed buckets are appended to a rollup file in the station
+//                      directory of the local store.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/rollups.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <cstring>
+
+  // Miscellaneous library header files
+
+#include <QFile>
+
+  // WSd header files
+
+#include "include/logger.h"
+#include "include/timeSeriesStore.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+    // The rollup file is a log of bucket updates. Each time the rollups are flushed the buckets that have changed are appended
+    // to the file. When the file is loaded the last entry of a bucket wins. The file is compacted when it has more than twice as
+    // many entries as buckets.
+
+  static char const ROLLUP_MAGIC[8] = { 'W', 'S', 'D', 'R', 'O', 'L', 'L', '1' };
+
+  struct SMeasureDefinition
+  {
+    char const *name;
+    EColumn value;                    // Column used for the mean and sum.
+    EColumn minimum;                  // Column used for the minimum.
+    EColumn maximum;                  // Column used for the maximum.
+  };
+
+  static SMeasureDefinition const measureDefinition[RM_COUNT] =
+  {
+    { "temperature",  COL_OUTSIDE_TEMPERATURE,  COL_LOW_OUTSIDE_TEMPERATURE,  COL_HIGH_OUTSIDE_TEMPERATURE },
+    { "humidity",     COL_OUTSIDE_HUMIDITY,     COL_OUTSIDE_HUMIDITY,         COL_OUTSIDE_HUMIDITY },
+    { "barometer",    COL_BAROMETER,            COL_BAROMETER,                COL_BAROMETER },
+    { "windSpeed",    COL_AVERAGE_WIND_SPEED,   COL_AVERAGE_WIND_SPEED,       COL_HIGH_WIND_SPEED },
+    { "rainfall",     COL_RAINFALL,             COL_RAINFALL,                 COL_RAINFALL },
+  };
+
+  struct SEntryHeader
+  {
+    std::uint8_t period;
+    std::uint8_t measureCount;
+    std::uint16_t reserved;
+    std::uint32_t reserved2;
+    std::int64_t start;
+  };
+
+  struct SEntryMeasure
+  {
+    std::int32_t minimum;
+    std::int32_t maximum;
+    std::int64_t sum;
+    std::uint32_t count;
+    std::uint32_t reserved;
+  };
+
+  static_assert(sizeof(SEntryHeader) == 16, "Rollup entry layout");
+  static_assert(sizeof(SEntryMeasure) == 24, "Rollup entry layout");
+
+  /// @brief      Adds a value to the aggregate.
+  /// @param[in]  minimumValue: The minimum value of the record.
+  /// @param[in]  maximumValue: The maximum value of the record.
+  /// @param[in]  value: The (mean) value of the record.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void SAggregate::add(std::int32_t minimumValue, std::int32_t maximumValue, std::int32_t value)
+  {
+    minimum = std::min(minimum, minimumValue);
+    maximum = std::max(maximum, maximumValue);
+    sum += value;
+    count++;
+  }
+
+  /// @brief      Merges another aggregate into this one.
+  /// @param[in]  other: The aggregate to merge.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void SAggregate::merge(SAggregate const &other)
+  {
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+    sum += other.sum;
+    count += other.count;
+  }
+
+  /// @brief      Constructor.
+  /// @param[in]  file: The rollup file.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CRollups::CRollups(QString const &file) : fileName(file)
+  {
+  }
+
+  /// @brief      Destructor. Writes the changed buckets.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CRollups::~CRollups()
+  {
+    flush();
+  }
+
+  /// @brief      Returns the start of the bucket holding a time stamp.
+  /// @param[in]  period: The rollup period.
+  /// @param[in]  timeStamp: The time stamp.
+  /// @returns    The start of the bucket.
+  /// @note       An archive record is time stamped at the end of its archive interval, so the record stamped 01:00 belongs to
+  ///             the hour starting at 00:00.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int64_t CRollups::bucketStart(ERollupPeriod period, std::int64_t timeStamp)
+  {
+    std::int64_t length = (period == RP_HOUR) ? 3600 : 86400;
+    std::int64_t time = timeStamp - 1;
+
+    return (time >= 0) ? (time / length) * length : ((time - length + 1) / length) * length;
+  }
+
+  /// @brief      Returns the column that the values of a measure are taken from. (Used to convert the values to SI units.)
+  /// @param[in]  measure: The measure.
+  /// @returns    The column.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  EColumn CRollups::measureColumn(ERollupMeasure measure)
+  {
+    return measureDefinition[measure].value;
+  }
+
+  /// @brief      Returns the name of a measure.
+  /// @param[in]  measure: The measure.
+  /// @returns    The name.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  char const *CRollups::measureName(ERollupMeasure measure)
+  {
+    return (measure < RM_COUNT) ? measureDefinition[measure].name : "unknown";
+  }
+
+  /// @brief      Returns the name of a period.
+  /// @param[in]  period: The period.
+  /// @returns    The name.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  char const *CRollups::periodName(ERollupPeriod period)
+  {
+    return (period == RP_HOUR) ? "hourly" : "daily";
+  }
+
+  /// @brief      Opens the rollups. If there is no rollup file the rollups are rebuilt from the local store.
+  /// @param[in]  store: The local store of the station. (May be nullptr.)
+  /// @returns    true if the rollups were opened.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CRollups::open(CTimeSeriesStore const *store)
+  {
+    TRACESPAN("rollupsOpen");
+
+    if (QFile::exists(fileName))
+    {
+      return load();
+    }
+    else
+    {
+      if (store != nullptr)
+      {
+        LOGINFO("Rebuilding rollups from the local store.");
+
+        store->scan(std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(),
+                    [this](SArchiveRecord const &record)
+        {
+          add(record);
+          return true;
+        });
+      };
+
+      return compact();
+    };
+  }
+
+  /// @brief      Loads the rollup file.
+  /// @returns    true if the file was loaded.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CRollups::load()
+  {
+    QFile file(fileName);
+    std::size_t bucketCount = 0;
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      LOGERROR("Unable to open rollup file {}.", fileName.toStdString());
+      return false;
+    };
+
+    QByteArray data = file.readAll();
+    std::size_t offset = sizeof(ROLLUP_MAGIC);
+
+    if ( (static_cast<std::size_t>(data.size()) < sizeof(ROLLUP_MAGIC)) ||
+         (std::memcmp(data.constData(), ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC)) != 0) )
+    {
+      LOGERROR("Rollup file {} is not valid.", fileName.toStdString());
+      return false;
+    };
+
+    logEntries = 0;
+
+    while (offset + sizeof(SEntryHeader) <= static_cast<std::size_t>(data.size()))
+    {
+      SEntryHeader header;
+
+      std::memcpy(&header, data.constData() + offset, sizeof(header));
+
+      std::size_t length = sizeof(header) + header.measureCount * sizeof(SEntryMeasure);
+
+      if ( (header.period >= RP_COUNT) || (offset + length > static_cast<std::size_t>(data.size())) )
+      {
+        LOGWARNING("Rollup file {} truncated at offset {}.", fileName.toStdString(), offset);
+        break;
+      };
+
+      TAggregates &aggregates = buckets[header.period][header.start];
+
+      aggregates = TAggregates();
+      for (std::size_t measure = 0; (measure < header.measureCount) && (measure < RM_COUNT); measure++)
+      {
+        SEntryMeasure entry;
+
+        std::memcpy(&entry, data.constData() + offset + sizeof(header) + measure * sizeof(entry), sizeof(entry));
+        aggregates[measure].minimum = entry.minimum;
+        aggregates[measure].maximum = entry.maximum;
+        aggregates[measure].sum = entry.sum;
+        aggregates[measure].count = entry.count;
+      };
+
+      logEntries++;
+      offset += length;
+    };
+
+    for (auto const &period : buckets)
+    {
+      bucketCount += period.size();
+    };
+
+    if (logEntries > 2 * bucketCount)
+    {
+      return compact();
+    };
+
+    return true;
+  }
+
+  /// @brief      Writes bucket entries to a file.
+  /// @param[in]  name: The file name.
+  /// @param[in]  entries: The buckets to write.
+  /// @param[in]  create: true to create the file, false to append to the file.
+  /// @returns    true if the entries were written.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CRollups::writeEntries(QString const &name, std::vector<std::pair<ERollupPeriod, std::int64_t>> const &entries,
+                              bool create)
+  {
+    QFile file(name);
+    QByteArray data;
+
+    if (create)
+    {
+      data.append(ROLLUP_MAGIC, sizeof(ROLLUP_MAGIC));
+    };
+
+    for (auto const &entry : entries)
+    {
+      SEntryHeader header = { entry.first, RM_COUNT, 0, 0, entry.second };
+      TAggregates const &aggregates = buckets[entry.first].at(entry.second);
+
+      data.append(reinterpret_cast<char const *>(&header), sizeof(header));
+
+      for (SAggregate const &aggregate : aggregates)
+      {
+        SEntryMeasure measure = { aggregate.minimum, aggregate.maximum, aggregate.sum, aggregate.count, 0 };
+
+        data.append(reinterpret_cast<char const *>(&measure), sizeof(measure));
+      };
+    };
+
+    if (!file.open(create ? (QIODevice::WriteOnly | QIODevice::Truncate) : (QIODevice::WriteOnly | QIODevice::Append)) ||
+        (file.write(data) != data.size()) || !file.flush())
+    {
+      LOGERROR("Unable to write rollup file {}.", name.toStdString());
+      return false;
+    };
+
+    return true;
+  }
+
+  /// @brief      Rewrites the rollup file with one entry per bucket.
+  /// @returns    true if successful.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CRollups::compact()
+  {
+    std::vector<std::pair<ERollupPeriod, std::int64_t>> entries;
+    QString temporaryName = fileName + ".new";
+
+    for (std::size_t period = 0; period < RP_COUNT; period++)
+    {
+      for (auto const &bucket : buckets[period])
+      {
+        entries.emplace_back(static_cast<ERollupPeriod>(period), bucket.first);
+      };
+    };
+
+    if (!writeEntries(temporaryName, entries, true))
+    {
+      return false;
+    };
+
+    QFile::remove(fileName);
+    if (!QFile::rename(temporaryName, fileName))
+    {
+      LOGERROR("Unable to replace rollup file {}.", fileName.toStdString());
+      return false;
+    };
+
+    logEntries = entries.size();
+    dirty.clear();
+
+    return true;
+  }
+
+  /// @brief      Adds a newly ingested record to the rollups. Each record must only be added once. Values flagged by the quality
+  ///             control are not added.
+  /// @param[in]  record: The record to add.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Values flagged by the quality control excluded.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CRollups::add(SArchiveRecord const &record)
+  {
+    for (std::size_t period = 0; period < RP_COUNT; period++)
+    {
+      std::int64_t start = bucketStart(static_cast<ERollupPeriod>(period), record.timeStamp);
+      TAggregates &aggregates = buckets[period][start];
+
+      for (std::size_t measure = 0; measure < RM_COUNT; measure++)
+      {
+        SMeasureDefinition const &definition = measureDefinition[measure];
+        std::int32_t value = record.values[definition.value];
+
+        if (record.isGood(definition.value))
+        {
+          std::int32_t minimum = record.isGood(definition.minimum) ? record.values[definition.minimum] : NO_VALUE;
+          std::int32_t maximum = record.isGood(definition.maximum) ? record.values[definition.maximum] : NO_VALUE;
+
+          aggregates[measure].add((minimum == NO_VALUE) ? value : minimum, (maximum == NO_VALUE) ? value : maximum, value);
+        };
+      };
+
+      dirty.emplace(static_cast<ERollupPeriod>(period), start);
+    };
+  }
+
+  /// @brief      Appends the changed buckets to the rollup file.
+  /// @returns    true if successful.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CRollups::flush()
+  {
+    bool returnValue = true;
+
+    if (!dirty.empty())
+    {
+      std::vector<std::pair<ERollupPeriod, std::int64_t>> entries(dirty.begin(), dirty.end());
+
+      if (writeEntries(fileName, entries, false))
+      {
+        logEntries += entries.size();
+        dirty.clear();
+      }
+      else
+      {
+        returnValue = false;
+      };
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Returns the buckets in a time range.
+  /// @param[in]  period: The rollup period.
+  /// @param[in]  from: The start of the range (inclusive).
+  /// @param[in]  to: The end of the range (inclusive).
+  /// @returns    The buckets that start in the range.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::vector<SRollup> CRollups::query(ERollupPeriod period, std::int64_t from, std::int64_t to) const
+  {
+    std::vector<SRollup> returnValue;
+
+    for (auto iterator = buckets[period].lower_bound(from);
+         (iterator != buckets[period].end()) && (iterator->first <= to); ++iterator)
+    {
+      returnValue.push_back({ iterator->first, iterator->second });
+    };
+
+    return returnValue;
+  }
+
+} // namespace WSd
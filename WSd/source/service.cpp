@@ -34,9 +34,13 @@
 
   // Standard C++ library header files
 
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <string>
+
   // Miscellaneous library header files
 
-#include "boost/format.hpp"
 #include <GCL>
 #include <Qt>
 #include <QCoreApplication>
@@ -44,10 +48,19 @@
 #include <QTimer>
 #include <QtNetwork>
 
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
   // WSd header files
 
+#include "include/configuration.h"
 #include "include/database.h"
+#include "include/logger.h"
 #include "include/settings.h"
+#include "include/systemd.h"
+#include "include/tracer.h"
 
 namespace WSd
 {
@@ -100,13 +113,15 @@ namespace WSd
 
   namespace service
   {
+    int CWSService::signalFD[2] = { -1, -1 };
 
     /// @brief Constructor for the service.
     ///
+    /// @version 2026-10-19/GGB - Site and instrument ID taken from the configuration snapshot.
     /// @version 2015-05-17/GGB - Function created.
 
-    CWSService::CWSService(int argc, char **argv, std::uint32_t sid, std::uint32_t iid)
-      : QtService<QCoreApplication>(argc, argv, "WSd"), stateMachine(nullptr), siteID(sid), instrumentID(iid)
+    CWSService::CWSService(int argc, char **argv)
+      : QtService<QCoreApplication>(argc, argv, "WSd"), stateMachine(nullptr)
     {
       TRACEENTER;
 
@@ -125,45 +140,410 @@ namespace WSd
       stateMachine->start();
     }
 
-    /// @brief    This is the main part of the service. All the code for the service creation needs to go in here.
+    /// @brief      Handles custom commands sent to the service through the service controller.
+    /// @param[in]  code: The command code.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::processCommand(int code)
+    {
+      switch (code)
+      {
+        case COMMAND_RELOAD:
+        {
+          reloadConfiguration();
+          break;
+        };
+        case COMMAND_TRACE_START:
+        {
+          startTracing();
+          break;
+        };
+        case COMMAND_TRACE_STOP:
+        {
+          stopTracing();
+          break;
+        };
+        default:
+        {
+          LOGWARNING("Unknown service command: {}.", code);
+          break;
+        };
+      };
+    }
+
+    /// @brief      Installs the SIGHUP, SIGTERM and SIGINT handlers. The handler only writes the signal number to a socket pair;
+    ///             the reload or the stop is performed on the event loop when the notifier fires.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - SIGTERM and SIGINT stop the daemon cleanly.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::installSignalHandlers()
+    {
+#ifdef Q_OS_UNIX
+      if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, signalFD) != 0)
+      {
+        LOGERROR("Unable to create signal socket pair. Configuration reload by signal disabled.");
+      }
+      else
+      {
+        signalNotifier = new QSocketNotifier(signalFD[1], QSocketNotifier::Read, this);
+        connect(signalNotifier, SIGNAL(activated(int)), this, SLOT(handleSignal()));
+
+        struct sigaction action;
+        action.sa_handler = CWSService::signalHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+
+        for (int signalNumber : { SIGHUP, SIGTERM, SIGINT })
+        {
+          if (sigaction(signalNumber, &action, nullptr) != 0)
+          {
+            LOGERROR("Unable to install handler of signal {}.", signalNumber);
+          };
+        };
+      };
+#endif
+    }
+
+    /// @brief      Unix signal handler. Only async-signal-safe functions may be called.
+    /// @param[in]  signalNumber: The signal received.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Signal number passed to the event loop.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::signalHandler(int signalNumber)
+    {
+#ifdef Q_OS_UNIX
+      char a = static_cast<char>(signalNumber);
+      [[maybe_unused]] auto rv = ::write(signalFD[0], &a, sizeof(a));
+#endif
+    }
+
+    /// @brief      Slot called on the event loop after a signal has been received. SIGHUP reloads the configuration, SIGTERM and
+    ///             SIGINT stop the daemon.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - SIGTERM and SIGINT handled. (Renamed from handleSigHup)
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::handleSignal()
+    {
+#ifdef Q_OS_UNIX
+      signalNotifier->setEnabled(false);
+
+      char signalNumber;
+      [[maybe_unused]] auto rv = ::read(signalFD[1], &signalNumber, sizeof(signalNumber));
+
+      if (signalNumber == SIGHUP)
+      {
+        LOGINFO("SIGHUP received.");
+        reloadConfiguration();
+      }
+      else
+      {
+        LOGINFO("Signal {} received. Stopping.", static_cast<int>(signalNumber));
+        terminate();
+      };
+
+      signalNotifier->setEnabled(true);
+#endif
+    }
+
+    /// @brief      Stops the daemon and leaves the event loop.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::terminate()
+    {
+      stop();
+      QCoreApplication::quit();
+    }
+
+    /// @brief      Slot called by the watchdog timer. The timer runs on the event loop, so systemd restarts the daemon if the
+    ///             event loop stops running for longer than WatchdogSec.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::resetWatchdog()
+    {
+      systemd::watchdog();
+    }
+
+    /// @brief      Creates the control server on the control socket passed by socket activation (if there is one). The commands
+    ///             are those of the service controller: "alive", "terminate" and "num:<code>", one per line, each answered with
+    ///             "true" or "false".
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::startControlServer()
+    {
+#ifdef Q_OS_UNIX
+      int descriptor = systemd::listenSocket("control");
+
+      if (descriptor >= 0)
+      {
+        controlServer = new QLocalServer(this);
+        connect(controlServer, SIGNAL(newConnection()), this, SLOT(acceptControlConnection()));
+
+        if (controlServer->listen(descriptor))
+        {
+          LOGINFO("Control commands accepted on the socket passed by systemd.");
+        }
+        else
+        {
+          LOGERROR("Unable to use the control socket passed by systemd: {}", controlServer->errorString().toStdString());
+          ::close(descriptor);
+          delete controlServer;
+          controlServer = nullptr;
+        };
+      };
+#endif
+    }
+
+    /// @brief      Slot called when there are connections waiting on the control socket.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::acceptControlConnection()
+    {
+      while (controlServer->hasPendingConnections())
+      {
+        QLocalSocket *socket = controlServer->nextPendingConnection();
+
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]()
+        {
+          while (socket->canReadLine())
+          {
+            socket->write(controlCommand(socket->readLine().trimmed()) ? "true\r\n" : "false\r\n");
+          };
+          socket->flush();
+        });
+      };
+    }
+
+    /// @brief      Executes a command received on the control socket.
+    /// @param[in]  command: The command.
+    /// @returns    true if the command was accepted.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool CWSService::controlCommand(QByteArray const &command)
+    {
+      bool returnValue = false;
+
+      if (command == "alive")
+      {
+        returnValue = true;
+      }
+      else if (command == "terminate")
+      {
+        QTimer::singleShot(0, this, [this]() { terminate(); });     // After the answer has been written.
+        returnValue = true;
+      }
+      else if (command.startsWith("num:"))
+      {
+        int code = command.mid(4).toInt(&returnValue);
+
+        if (returnValue)
+        {
+          processCommand(code);
+        };
+      }
+      else
+      {
+        LOGWARNING("Unknown control command: {}.", command.toStdString());
+      };
+
+      return returnValue;
+    }
+
+    /// @brief      Creates the read API server. Any existing server is closed first. No server is created if the API port is 0.
+    /// @param[in]  config: The configuration snapshot.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::startApiServer(configuration::PConfiguration config)
+    {
+      apiServer.reset();
+
+      if (config->apiPort != 0)
+      {
+        apiServer = std::make_unique<CApiServer>(config);
+        if (!apiServer->listen())
+        {
+          apiServer.reset();
+        };
+      };
+    }
+
+    /// @brief      Loads a new configuration snapshot, installs it and passes it to the subsystems. Each subsystem only rebuilds
+    ///             what has changed.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Reload reported to systemd.
+    /// @version    2026-10-19/GGB - Read API server rebuilt if its settings have changed.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::reloadConfiguration()
+    {
+      TRACEENTER;
+
+      std::string errorMessage;
+
+      LOGINFO("Reloading configuration.");
+      systemd::reloading();
+
+      configuration::PConfiguration oldConfiguration = configuration::current();
+      configuration::PConfiguration newConfiguration = configuration::load(errorMessage);
+
+      if (!newConfiguration)
+      {
+        LOGERROR("Invalid configuration, current configuration retained: {}", errorMessage);
+        systemd::ready("Invalid configuration, current configuration retained.");
+      }
+      else
+      {
+        configuration::install(newConfiguration);
+
+        if ( (newConfiguration->apiAddress != oldConfiguration->apiAddress) ||
+             (newConfiguration->apiPort != oldConfiguration->apiPort) ||
+             (newConfiguration->database != oldConfiguration->database) )
+        {
+          startApiServer(newConfiguration);
+        };
+
+        if (stateMachine)
+        {
+          stateMachine->reconfigure(newConfiguration);
+        };
+
+        LOGINFO("Configuration reloaded.");
+        systemd::ready("Configuration reloaded.");
+      };
+
+      TRACEEXIT;
+    }
+
+    /// @brief      Discards any previously recorded spans and starts recording trace spans.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::startTracing()
+    {
+      tracing::clear();
+      tracing::enable();
+      LOGINFO("Span tracing started.");
+    }
+
+    /// @brief      Stops recording trace spans and exports the recorded spans to the trace file.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void CWSService::stopTracing()
+    {
+      std::string fileName = configuration::current()->traceFile.toStdString();
+
+      tracing::disable();
+
+      if (tracing::exportChromeTrace(fileName))
+      {
+        LOGINFO("Span tracing stopped. Trace written to {}.", fileName);
+      }
+      else
+      {
+        LOGERROR("Span tracing stopped. Unable to write trace file {}.", fileName);
+      };
+    }
+
+    /// @brief    This is the main part of the service. All the code for the service creation needs to go in here. Nothing that
+    ///           waits for the console, the database or the local store is done here, so the daemon reports ready as soon as the
+    ///           read API and the control socket are up. The first poll is made from the event loop.
+    /// @version  2026-10-19/GGB - Ready reported before the first poll and the messages for the user.
+    /// @version  2026-10-19/GGB - Readiness reported to systemd, watchdog and control socket started.
+    /// @version  2026-10-19/GGB - Read API server started.
+    /// @version  2026-10-19/GGB - Trace span added.
+    /// @version  2026-10-19/GGB - Messages written through the asynchronous logger.
+    /// @version  2026-10-19/GGB - State machine created from the configuration snapshot.
     /// @version  2020-10-25/GGB - Changed logging function to use simple versions.
     /// @version  2014-07-24/GGB - Function created.
 
     void CWSService::start()
     {
       TRACEENTER;
+      TRACESPAN("start");
       std::ostringstream os;
 
-        /* Write some messages for the user. */
+        // Create the state machine. (The local store is opened on the executor and the database is connected by the first poll.)
 
-      INFOMESSAGE("Application: WSd.");
-      INFOMESSAGE("Copyright: Gavin Blakeman 2015, 2020.");
-      INFOMESSAGE("License: GPLv2.");
-      INFOMESSAGE(boost::format("Release Number: %s. Release Date: %s.") % getReleaseString() % getReleaseDate());
+      installSignalHandlers();
 
-        // Create the state machine
+      LOGDEBUG("Creating state machine...");
+      configuration::PConfiguration config = configuration::current();
+      stateMachine = std::make_unique<CStateMachine>(this, config->station.siteID, config->station.instrumentID, config);
+      LOGDEBUG("State machine created.");
 
-      DEBUGMESSAGE("Creating state machine...");
-      stateMachine = std::make_unique<CStateMachine>(this, siteID, instrumentID);
-      DEBUGMESSAGE("State machine created.");
+      startApiServer(config);
+      startControlServer();
+
+      std::chrono::milliseconds interval = systemd::watchdogInterval();
+
+      if (interval.count() != 0)
+      {
+        watchdogTimer = new QTimer(this);
+        connect(watchdogTimer, SIGNAL(timeout()), this, SLOT(resetWatchdog()));
+        watchdogTimer->start(static_cast<int>(std::max<std::chrono::milliseconds::rep>(1, interval.count() / 2)));
+        LOGINFO("systemd watchdog reset every {} ms.", interval.count() / 2);
+      };
+
+      systemd::ready("Polling station " + std::to_string(config->station.siteID) + "-" +
+                     std::to_string(config->station.instrumentID) + " every " + std::to_string(config->pollInterval) +
+                     " minutes.");
 
         /* Indicate that the service is starting. */
 
       GCL::logger::defaultLogger().logMessage(GCL::logger::info, "Daemon Started.");
       stateMachine->start();
 
+        /* Write some messages for the user. */
+
+      LOGINFO("Application: WSd.");
+      LOGINFO("Copyright: Gavin Blakeman 2015, 2020.");
+      LOGINFO("License: GPLv2.");
+      LOGINFO("Release Number: {}. Release Date: {}.", getReleaseString(), getReleaseDate());
+
       TRACEEXIT;
     }
 
-    /// @brief Function to stop the daemon
+    /// @brief Function to stop the daemon. Only the first call has any effect.
     /// @throws none.
+    /// @version 2026-10-19/GGB - Stop reported to systemd.
+    /// @version 2026-10-19/GGB - Read API server closed.
+    /// @version 2026-10-19/GGB - Trace spans exported if tracing is active.
     /// @version 2015-05-28/GGB - Function created.
 
     void CWSService::stop()
     {
+      if (stopped)
+      {
+        return;
+      };
+
+      stopped = true;
       std::cout << "Stop Daemon" << std::endl;
+      systemd::stopping();
 
+      if (watchdogTimer)
+      {
+        watchdogTimer->stop();
+      };
+
+      apiServer.reset();
       stateMachine->stop();
+
+      if (tracing::enabled())
+      {
+        stopTracing();
+      };
     }
   }   // namespace service
 }   // namespace WSd
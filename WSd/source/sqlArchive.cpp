@@ -0,0 +1,999 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								SQLArchive
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Direct SQL access to the archive table (TBL_ARCHIVE) of the weather database through named connections that
+//                      are independent of the WCL connection. Used for the queries that WCL does not provide, and for all access to
+//                      SQLite databases, which WCL does not support. Also holds the leases (TBL_LEASE) that decide which of a pair
+//                      of daemons polls a station.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/sqlArchive.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <vector>
+
+  // Miscellaneous library header files
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+
+  // WSd header files
+
+#include "include/logger.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+  namespace sql
+  {
+    static std::int64_t const MJD_UNIX_EPOCH = 40587;          // MJD of 1970-01-01.
+
+    static char const *const SELECT_ARCHIVE =
+        "SELECT MJD, TIME, outsideTemp, hiOutsideTemp, lowOutsideTemp, insideTemp, barometer, outsideHumidity, "
+        "insideHumidity, rain, hiRainRate, windSpeed, hiWindSpeed, windDirection, solarRad, hiSolarRad, UV, hiUV "
+        "FROM TBL_ARCHIVE WHERE SITE_ID = :siteID AND INSTRUMENT_ID = :instrumentID ";
+
+    static char const *const INSERT_ARCHIVE =
+        "INSERT OR IGNORE INTO TBL_ARCHIVE (SITE_ID, INSTRUMENT_ID, MJD, TIME, outsideTemp, hiOutsideTemp, lowOutsideTemp, "
+        "insideTemp, barometer, outsideHumidity, insideHumidity, rain, hiRainRate, windSpeed, hiWindSpeed, windDirection, "
+        "solarRad, hiSolarRad, UV, hiUV) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+      // SQLite databases are created by WSd. Only the columns read by SELECT_ARCHIVE are held, and the primary key is the key
+      // of a record, so the table is clustered in the order the records are read. (%1 is the name of the table, as the archive
+      // tables of expired months have the same layout.)
+
+    static char const *const SQLITE_TABLE =
+        "CREATE TABLE IF NOT EXISTS %1 (SITE_ID INTEGER NOT NULL, INSTRUMENT_ID INTEGER NOT NULL, MJD INTEGER NOT NULL, "
+        "TIME INTEGER NOT NULL, outsideTemp REAL, hiOutsideTemp REAL, lowOutsideTemp REAL, insideTemp REAL, barometer REAL, "
+        "outsideHumidity REAL, insideHumidity REAL, rain REAL, hiRainRate REAL, windSpeed REAL, hiWindSpeed REAL, "
+        "windDirection REAL, solarRad REAL, hiSolarRad REAL, UV REAL, hiUV REAL, "
+        "PRIMARY KEY (SITE_ID, INSTRUMENT_ID, MJD, TIME)) WITHOUT ROWID";
+
+    static std::int32_t const PARTITIONS_AHEAD = 3;           // Monthly partitions created ahead of the current month.
+    static std::int64_t const RECENT_DAYS = 31;               // Range of the first attempt of lastRecord().
+
+      // Settings of each SQLite connection. WAL lets the readers (API, exporter) run while the acquisition writes, and with WAL a
+      // commit only needs the log to be synchronised at checkpoints. (synchronous=NORMAL) The page cache is 16 MiB.
+
+    static char const *const SQLITE_PRAGMAS[] =
+    {
+      "PRAGMA journal_mode = WAL",
+      "PRAGMA synchronous = NORMAL",
+      "PRAGMA cache_size = -16384",
+      "PRAGMA temp_store = MEMORY",
+      "PRAGMA busy_timeout = 5000",
+    };
+
+      // Prepared insert statements, by connection. Connections are used and closed in the thread that opened them, so each
+      // thread keeps its own statements.
+
+    static thread_local std::map<QString, std::unique_ptr<QSqlQuery>> insertQueries;
+
+      // One lease per station. EXPIRES is seconds since 1970 by the clock of the database server, so the daemons holding and
+      // waiting for a lease do not depend on each other's clocks.
+
+    static char const *const LEASE_TABLE =
+        "CREATE TABLE IF NOT EXISTS TBL_LEASE (SITE_ID INTEGER NOT NULL, INSTRUMENT_ID INTEGER NOT NULL, "
+        "HOLDER VARCHAR(128) NOT NULL, EXPIRES BIGINT NOT NULL, PRIMARY KEY (SITE_ID, INSTRUMENT_ID))";
+
+    /// @brief      Applies the settings to a SQLite connection that has just been opened and creates the archive table if
+    ///             needed.
+    /// @param[in]  connection: The connection.
+    /// @returns    true if successful.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool configureSqlite(QSqlDatabase &connection)
+    {
+      QSqlQuery query(connection);
+
+      for (char const *statement : SQLITE_PRAGMAS)
+      {
+        if (!query.exec(statement))
+        {
+          LOGERROR("SQLite statement {} failed: {}", statement, query.lastError().text().toStdString());
+          return false;
+        };
+      };
+
+      if (!query.exec(QString(SQLITE_TABLE).arg("TBL_ARCHIVE")))
+      {
+        LOGERROR("Unable to create the SQLite archive table: {}", query.lastError().text().toStdString());
+        return false;
+      };
+
+      return true;
+    }
+
+    /// @brief      Opens a named connection to the weather database. The connection is separate from the connection used by
+    ///             WCL, so that it can be used without disturbing the acquisition.
+    /// @param[in]  connectionName: The name of the connection.
+    /// @param[in]  database: The database settings.
+    /// @returns    true if the connection is open.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - SQLite connections configured when opened.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool openConnection(QString const &connectionName, configuration::SDatabaseConfiguration const &database)
+    {
+      QSqlDatabase connection;
+
+      if (QSqlDatabase::contains(connectionName))
+      {
+        connection = QSqlDatabase::database(connectionName, false);
+      }
+      else
+      {
+        connection = QSqlDatabase::addDatabase("Q" + database.driver, connectionName);
+        connection.setHostName(database.hostAddress);
+        connection.setPort(database.port);
+        connection.setDatabaseName(database.databaseName);
+        connection.setUserName(database.userName);
+        connection.setPassword(database.password);
+      };
+
+      if (!connection.isOpen())
+      {
+        if (!connection.open())
+        {
+          LOGERROR("Unable to open database connection {}: {}", connectionName.toStdString(),
+                   connection.lastError().text().toStdString());
+          return false;
+        };
+
+        if ( (database.driver == "SQLITE") && !configureSqlite(connection) )
+        {
+          connection.close();
+          return false;
+        };
+      };
+
+      return true;
+    }
+
+    /// @brief      Closes and removes a named connection.
+    /// @param[in]  connectionName: The name of the connection.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Prepared insert statement released.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void closeConnection(QString const &connectionName)
+    {
+      insertQueries.erase(connectionName);
+
+      if (QSqlDatabase::contains(connectionName))
+      {
+        {
+          QSqlDatabase connection = QSqlDatabase::database(connectionName, false);
+          connection.close();
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+      };
+    }
+
+    /// @brief      Converts a value read from the database to console units.
+    /// @param[in]  value: The value from the database.
+    /// @param[in]  scale: Multiplier to convert to console units.
+    /// @param[in]  offset: Offset added before scaling.
+    /// @returns    The value in console units. NO_VALUE if the value is NULL.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::int32_t consoleValue(QVariant const &value, double scale, double offset = 0)
+    {
+      if (value.isNull())
+      {
+        return NO_VALUE;
+      }
+      else
+      {
+        return static_cast<std::int32_t>(std::lround((value.toDouble() + offset) * scale));
+      };
+    }
+
+    /// @brief      Converts a row of TBL_ARCHIVE to an archive record. (Temperatures are stored in K, pressure in Pa, rain in
+    ///             mm and wind speed in m/s.)
+    /// @param[in]  query: The query positioned on the row.
+    /// @param[out] record: The record.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void rowToRecord(QSqlQuery const &query, SArchiveRecord &record)
+    {
+      double const KELVIN = -273.15;
+      double const TEMPERATURE = 9.0 / 5.0 * 10.0;              // °C -> 0.1 °F (after the offset, 320 added below)
+      std::int64_t mjd = query.value(0).toLongLong();
+      int time = query.value(1).toInt();
+
+      record.timeStamp = (mjd - MJD_UNIX_EPOCH) * 86400 + (time / 100) * 3600 + (time % 100) * 60;
+
+      auto temperature = [&](int index)
+      {
+        std::int32_t value = consoleValue(query.value(index), TEMPERATURE, KELVIN);
+        return (value == NO_VALUE) ? NO_VALUE : value + 320;
+      };
+
+      record.values[COL_OUTSIDE_TEMPERATURE] = temperature(2);
+      record.values[COL_HIGH_OUTSIDE_TEMPERATURE] = temperature(3);
+      record.values[COL_LOW_OUTSIDE_TEMPERATURE] = temperature(4);
+      record.values[COL_INSIDE_TEMPERATURE] = temperature(5);
+      record.values[COL_BAROMETER] = consoleValue(query.value(6), 1000.0 / 3386.38866667);
+      record.values[COL_OUTSIDE_HUMIDITY] = consoleValue(query.value(7), 1);
+      record.values[COL_INSIDE_HUMIDITY] = consoleValue(query.value(8), 1);
+      record.values[COL_RAINFALL] = consoleValue(query.value(9), 1 / RAIN_CLICK_DEFAULT);
+      record.values[COL_HIGH_RAIN_RATE] = consoleValue(query.value(10), 1 / RAIN_CLICK_DEFAULT);
+      record.values[COL_AVERAGE_WIND_SPEED] = consoleValue(query.value(11), 1 / 0.44704);
+      record.values[COL_HIGH_WIND_SPEED] = consoleValue(query.value(12), 1 / 0.44704);
+      record.values[COL_PREVAILING_WIND_DIRECTION] = consoleValue(query.value(13), 1);
+      record.values[COL_SOLAR_RADIATION] = consoleValue(query.value(14), 1);
+      record.values[COL_HIGH_SOLAR_RADIATION] = consoleValue(query.value(15), 1);
+      record.values[COL_UV_INDEX] = consoleValue(query.value(16), 1);
+      record.values[COL_HIGH_UV_INDEX] = consoleValue(query.value(17), 1);
+    }
+
+    /// @brief      Returns the MJD of the first day of a month.
+    /// @param[in]  month: The month. (year * 12 + month - 1)
+    /// @returns    The MJD.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::int64_t monthStart(std::int32_t month)
+    {
+      return SArchiveRecord::makeTimeStamp(month / 12, month % 12 + 1, 1, 0, 0) / 86400 + MJD_UNIX_EPOCH;
+    }
+
+    /// @brief      Returns the month of a date.
+    /// @param[in]  mjd: The date. (MJD)
+    /// @returns    The month. (year * 12 + month - 1)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::int32_t monthOf(std::int64_t mjd)
+    {
+      int year, month, day, hour, minute;
+
+      SArchiveRecord::splitTimeStamp((mjd - MJD_UNIX_EPOCH) * 86400, year, month, day, hour, minute);
+
+      return year * 12 + month - 1;
+    }
+
+    /// @brief      Returns the name of the partition (and archive table suffix) of a month. (pYYYYMM)
+    /// @param[in]  month: The month. (year * 12 + month - 1)
+    /// @returns    The name.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static QString partitionName(std::int32_t month)
+    {
+      return QString("p%1%2").arg(month / 12, 4, 10, QChar('0')).arg(month % 12 + 1, 2, 10, QChar('0'));
+    }
+
+    /// @brief      Parses the name of a monthly partition.
+    /// @param[in]  name: The name.
+    /// @param[out] month: The month. (year * 12 + month - 1)
+    /// @returns    true if the name is the name of a monthly partition.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool parsePartitionName(QString const &name, std::int32_t &month)
+    {
+      bool ok = false;
+      int value = name.mid(1).toInt(&ok);
+
+      if ( (name.length() != 7) || !name.startsWith('p') || !ok || (value % 100 < 1) || (value % 100 > 12) )
+      {
+        return false;
+      };
+
+      month = (value / 100) * 12 + value % 100 - 1;
+
+      return true;
+    }
+
+    /// @brief      Returns the definition of the partition of a month.
+    /// @param[in]  month: The month. (year * 12 + month - 1)
+    /// @returns    The definition.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static QString partitionDefinition(std::int32_t month)
+    {
+      return QString("PARTITION %1 VALUES LESS THAN (%2), ").arg(partitionName(month)).arg(monthStart(month + 1));
+    }
+
+    /// @brief      Executes a statement and logs the error if it fails.
+    /// @param[in]  query: The query to use.
+    /// @param[in]  statement: The statement.
+    /// @returns    true if the statement succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool execute(QSqlQuery &query, QString const &statement)
+    {
+      if (!query.exec(statement))
+      {
+        LOGERROR("Statement {} failed: {}", statement.toStdString(), query.lastError().text().toStdString());
+        return false;
+      };
+
+      return true;
+    }
+
+    /// @brief      Converts a value in console units to the value stored in the database. The inverse of consoleValue().
+    /// @param[in]  value: The value in console units.
+    /// @param[in]  scale: Multiplier to convert to console units.
+    /// @param[in]  offset: Offset added before scaling.
+    /// @returns    The value to store. NULL if the value is NO_VALUE.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static QVariant databaseValue(std::int32_t value, double scale, double offset = 0)
+    {
+      if (value == NO_VALUE)
+      {
+        return QVariant();
+      }
+      else
+      {
+        return QVariant(value / scale - offset);
+      };
+    }
+
+    /// @brief      Binds the values of an archive record to the insert statement. The inverse of rowToRecord().
+    /// @param[in]  query: The prepared insert statement.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  record: The record.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void recordToRow(QSqlQuery &query, std::uint32_t siteID, std::uint32_t instrumentID, SArchiveRecord const &record)
+    {
+      double const KELVIN = -273.15;
+      double const TEMPERATURE = 9.0 / 5.0 * 10.0;
+      std::int64_t day = (record.timeStamp >= 0) ? record.timeStamp / 86400 : (record.timeStamp - 86399) / 86400;
+      std::int64_t seconds = record.timeStamp - day * 86400;
+      int index = 0;
+
+      auto bind = [&](QVariant const &value)
+      {
+        query.bindValue(index++, value);
+      };
+      auto temperature = [&](EColumn column)
+      {
+        std::int32_t value = record.values[column];
+        bind((value == NO_VALUE) ? QVariant() : databaseValue(value - 320, TEMPERATURE, KELVIN));
+      };
+
+      bind(siteID);
+      bind(instrumentID);
+      bind(static_cast<qint64>(day + MJD_UNIX_EPOCH));
+      bind(static_cast<int>((seconds / 3600) * 100 + (seconds % 3600) / 60));
+      temperature(COL_OUTSIDE_TEMPERATURE);
+      temperature(COL_HIGH_OUTSIDE_TEMPERATURE);
+      temperature(COL_LOW_OUTSIDE_TEMPERATURE);
+      temperature(COL_INSIDE_TEMPERATURE);
+      bind(databaseValue(record.values[COL_BAROMETER], 1000.0 / 3386.38866667));
+      bind(databaseValue(record.values[COL_OUTSIDE_HUMIDITY], 1));
+      bind(databaseValue(record.values[COL_INSIDE_HUMIDITY], 1));
+      bind(databaseValue(record.values[COL_RAINFALL], 1 / RAIN_CLICK_DEFAULT));
+      bind(databaseValue(record.values[COL_HIGH_RAIN_RATE], 1 / RAIN_CLICK_DEFAULT));
+      bind(databaseValue(record.values[COL_AVERAGE_WIND_SPEED], 1 / 0.44704));
+      bind(databaseValue(record.values[COL_HIGH_WIND_SPEED], 1 / 0.44704));
+      bind(databaseValue(record.values[COL_PREVAILING_WIND_DIRECTION], 1));
+      bind(databaseValue(record.values[COL_SOLAR_RADIATION], 1));
+      bind(databaseValue(record.values[COL_HIGH_SOLAR_RADIATION], 1));
+      bind(databaseValue(record.values[COL_UV_INDEX], 1));
+      bind(databaseValue(record.values[COL_HIGH_UV_INDEX], 1));
+    }
+
+    /// @brief      Reads the archive records of a station in a time range from the weather database.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  from: The start of the range (inclusive).
+    /// @param[in]  to: The end of the range (inclusive).
+    /// @param[in]  limit: The maximum number of records to read.
+    /// @param[in]  function: Called for each record, in time order. Return false to stop.
+    /// @returns    true if the query succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool readRecords(QString const &connectionName, std::uint32_t siteID, std::uint32_t instrumentID, std::int64_t from,
+                     std::int64_t to, std::size_t limit, CTimeSeriesStore::TScanFunction const &function)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+      std::int64_t fromDay = (from >= 0) ? from / 86400 : (from - 86399) / 86400;
+      std::int64_t toDay = (to >= 0) ? to / 86400 : (to - 86399) / 86400;
+      int fromTime = static_cast<int>(((from - fromDay * 86400) / 3600) * 100 + ((from - fromDay * 86400) % 3600) / 60);
+      int toTime = static_cast<int>(((to - toDay * 86400) / 3600) * 100 + ((to - toDay * 86400) % 3600) / 60);
+
+      TRACESPAN("readRecords");
+
+      query.setForwardOnly(true);
+      query.prepare(QString(SELECT_ARCHIVE) +
+                    "AND (MJD > :fromMJD OR (MJD = :fromMJD2 AND TIME >= :fromTime)) "
+                    "AND (MJD < :toMJD OR (MJD = :toMJD2 AND TIME <= :toTime)) "
+                    "ORDER BY MJD, TIME LIMIT " + QString::number(limit));
+      query.bindValue(":siteID", siteID);
+      query.bindValue(":instrumentID", instrumentID);
+      query.bindValue(":fromMJD", static_cast<qint64>(fromDay + MJD_UNIX_EPOCH));
+      query.bindValue(":fromMJD2", static_cast<qint64>(fromDay + MJD_UNIX_EPOCH));
+      query.bindValue(":fromTime", fromTime);
+      query.bindValue(":toMJD", static_cast<qint64>(toDay + MJD_UNIX_EPOCH));
+      query.bindValue(":toMJD2", static_cast<qint64>(toDay + MJD_UNIX_EPOCH));
+      query.bindValue(":toTime", toTime);
+
+      if (!query.exec())
+      {
+        LOGERROR("Archive query failed: {}", query.lastError().text().toStdString());
+        return false;
+      };
+
+      while (query.next())
+      {
+        SArchiveRecord record;
+
+        rowToRecord(query, record);
+
+        if (!function(record))
+        {
+          break;
+        };
+      };
+
+      return true;
+    }
+
+    /// @brief      Reads the latest archive record of a station from the weather database. The records of the last month are
+    ///             searched first, so that only the latest partitions of a partitioned table are read.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[out] record: The record.
+    /// @param[out] found: true if a record was found.
+    /// @returns    true if the query succeeded.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Failed queries distinguished from stations without records.
+    /// @version    2026-10-19/GGB - Recent records searched first.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool lastRecord(QString const &connectionName, std::uint32_t siteID, std::uint32_t instrumentID, SArchiveRecord &record,
+                    bool &found)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+      std::int64_t recentMJD = static_cast<std::int64_t>(std::time(nullptr)) / 86400 + MJD_UNIX_EPOCH - RECENT_DAYS;
+
+      found = false;
+
+      for (bool recent : { true, false })
+      {
+        query.prepare(QString(SELECT_ARCHIVE) + (recent ? "AND MJD >= :recentMJD " : "") + "ORDER BY MJD DESC, TIME DESC LIMIT 1");
+        query.bindValue(":siteID", siteID);
+        query.bindValue(":instrumentID", instrumentID);
+        if (recent)
+        {
+          query.bindValue(":recentMJD", static_cast<qint64>(recentMJD));
+        };
+
+        if (!query.exec())
+        {
+          LOGERROR("Archive query failed: {}", query.lastError().text().toStdString());
+          return false;
+        };
+
+        if (query.next())
+        {
+          rowToRecord(query, record);
+          found = true;
+          return true;
+        };
+      };
+
+      return true;
+    }
+
+    /// @brief      Inserts an archive record into the archive table. Records that are already in the table are ignored. The
+    ///             insert statement is prepared once per connection.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  record: The record.
+    /// @param[out] inserted: true if the record was inserted.
+    /// @returns    true if the statement succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool insertRecord(QString const &connectionName, std::uint32_t siteID, std::uint32_t instrumentID,
+                      SArchiveRecord const &record, bool &inserted)
+    {
+      std::unique_ptr<QSqlQuery> &query = insertQueries[connectionName];
+
+      inserted = false;
+
+      if (!query)
+      {
+        query = std::make_unique<QSqlQuery>(QSqlDatabase::database(connectionName, false));
+        if (!query->prepare(INSERT_ARCHIVE))
+        {
+          LOGERROR("Unable to prepare the archive insert: {}", query->lastError().text().toStdString());
+          query.reset();
+          return false;
+        };
+      };
+
+      recordToRow(*query, siteID, instrumentID, record);
+
+      if (!query->exec())
+      {
+        LOGERROR("Archive insert failed: {}", query->lastError().text().toStdString());
+        return false;
+      };
+
+      inserted = (query->numRowsAffected() == 1);
+
+      return true;
+    }
+
+    /// @brief      Determines if the archive table holds the record of a station at a time.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  timeStamp: The time of the record. (s since 1970-01-01)
+    /// @param[out] found: true if the record is in the table.
+    /// @returns    true if the query succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool containsRecord(QString const &connectionName, std::uint32_t siteID, std::uint32_t instrumentID,
+                        std::int64_t timeStamp, bool &found)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+      std::int64_t day = (timeStamp >= 0) ? timeStamp / 86400 : (timeStamp - 86399) / 86400;
+      std::int64_t seconds = timeStamp - day * 86400;
+
+      found = false;
+
+      query.prepare("SELECT 1 FROM TBL_ARCHIVE WHERE SITE_ID = :siteID AND INSTRUMENT_ID = :instrumentID AND MJD = :mjd AND "
+                    "TIME = :time");
+      query.bindValue(":siteID", siteID);
+      query.bindValue(":instrumentID", instrumentID);
+      query.bindValue(":mjd", static_cast<qint64>(day + MJD_UNIX_EPOCH));
+      query.bindValue(":time", static_cast<int>((seconds / 3600) * 100 + (seconds % 3600) / 60));
+
+      if (!query.exec())
+      {
+        LOGERROR("Archive lookup failed: {}", query.lastError().text().toStdString());
+        return false;
+      };
+
+      found = query.next();
+
+      return true;
+    }
+
+    /// @brief      Reads the monthly partitions of the archive table of a MySQL database.
+    /// @param[in]  query: A query on an open connection.
+    /// @param[out] months: The months of the partitions, in order.
+    /// @param[out] partitioned: true if the table is partitioned.
+    /// @returns    true if successful.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created. (Moved from maintainPartitions())
+
+    static bool readPartitions(QSqlQuery &query, std::vector<std::int32_t> &months, bool &partitioned)
+    {
+      months.clear();
+      partitioned = false;
+
+      if (!execute(query, "SELECT PARTITION_NAME FROM information_schema.PARTITIONS WHERE TABLE_SCHEMA = DATABASE() "
+                          "AND TABLE_NAME = 'TBL_ARCHIVE' ORDER BY PARTITION_ORDINAL_POSITION"))
+      {
+        return false;
+      };
+
+      while (query.next())
+      {
+        std::int32_t month;
+
+        if (!query.value(0).isNull())
+        {
+          partitioned = true;
+          if (parsePartitionName(query.value(0).toString(), month))
+          {
+            months.push_back(month);
+          };
+        };
+      };
+
+      return true;
+    }
+
+    /// @brief      Partitions the archive table of a MySQL database by month. The table is rebuilt, and is locked while it is
+    ///             rebuilt, so this is an offline migration (--partition) run while the daemon is stopped, rather than part of
+    ///             the maintenance. A table that is already partitioned is not changed.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  currentMonth: The current month. (year * 12 + month - 1)
+    /// @returns    true if the table is partitioned.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created. (Moved from maintainPartitions())
+
+    bool partitionArchive(QString const &connectionName, std::int32_t currentMonth)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+      std::vector<std::int32_t> months;
+      bool partitioned;
+      std::int32_t firstMonth = currentMonth;
+      QString statement = "ALTER TABLE TBL_ARCHIVE PARTITION BY RANGE (MJD) (";
+
+      TRACESPAN("partitionArchive");
+
+      if (!readPartitions(query, months, partitioned))
+      {
+        return false;
+      }
+      else if (partitioned)
+      {
+        LOGINFO("TBL_ARCHIVE is already partitioned.");
+        return true;
+      };
+
+      if (execute(query, "SELECT MIN(MJD) FROM TBL_ARCHIVE") && query.next() && !query.value(0).isNull())
+      {
+        firstMonth = std::min(firstMonth, monthOf(query.value(0).toLongLong()));
+      };
+
+      for (std::int32_t month = firstMonth; month <= currentMonth + PARTITIONS_AHEAD; month++)
+      {
+        statement += partitionDefinition(month);
+      };
+      statement += "PARTITION pmax VALUES LESS THAN MAXVALUE)";
+
+      LOGINFO("Partitioning TBL_ARCHIVE into {} monthly partitions.", currentMonth + PARTITIONS_AHEAD - firstMonth + 1);
+
+      if (!execute(query, statement))
+      {
+        LOGERROR("TBL_ARCHIVE could not be partitioned. (MJD must be part of every unique key of the table.)");
+        return false;
+      };
+
+      return true;
+    }
+
+    /// @brief      Moves the rows of a partition of the archive table of a MySQL database to its archive table by exchanging the
+    ///             partition with an empty table. Each step is only made if it has not been made already, so a move that was
+    ///             interrupted is completed by the next maintenance.
+    /// @param[in]  query: A query on an open connection.
+    /// @param[in]  name: The name of the partition.
+    /// @returns    true if the rows are in the archive table.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created. (Moved from maintainPartitions())
+
+    static bool archivePartition(QSqlQuery &query, QString const &name)
+    {
+      QString table = "TBL_ARCHIVE_" + name;
+
+      if (!execute(query, "CREATE TABLE IF NOT EXISTS " + table + " LIKE TBL_ARCHIVE") ||
+          !execute(query, "SELECT COUNT(*) FROM information_schema.PARTITIONS WHERE TABLE_SCHEMA = DATABASE() "
+                          "AND TABLE_NAME = '" + table + "' AND PARTITION_NAME IS NOT NULL"))
+      {
+        return false;
+      };
+
+      if (query.next() && (query.value(0).toLongLong() != 0) && !execute(query, "ALTER TABLE " + table + " REMOVE PARTITIONING"))
+      {
+        return false;
+      };
+
+        // The archive table only holds rows once the partition has been exchanged.
+
+      if (!execute(query, "SELECT 1 FROM " + table + " LIMIT 1"))
+      {
+        return false;
+      };
+
+      return (query.next() || execute(query, "ALTER TABLE TBL_ARCHIVE EXCHANGE PARTITION " + name + " WITH TABLE " + table));
+    }
+
+    /// @brief      Maintains the monthly partitions of the archive table of a MySQL database. The table is partitioned by range
+    ///             of MJD, one partition per month, with an empty MAXVALUE partition (pmax) at the end. Partitions are created
+    ///             PARTITIONS_AHEAD months ahead by splitting pmax, which holds no rows, so no rows are copied. Expired
+    ///             partitions are exchanged with an empty archive table (TBL_ARCHIVE_pYYYYMM), if they are archived, and then
+    ///             dropped. Neither is a row by row delete, so the table is not locked for the time a purge would take.
+    ///             An archive table that is not partitioned is not maintained; it is partitioned with partitionArchive().
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  currentMonth: The current month. (year * 12 + month - 1)
+    /// @param[in]  retentionMonths: The number of months to keep, including the current month. 0 to keep all.
+    /// @param[in]  archive: true to move expired months to archive tables, false to drop them.
+    /// @returns    true if successful.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Table no longer partitioned here. Archive tables created if they do not exist.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool maintainPartitions(QString const &connectionName, std::int32_t currentMonth, std::uint32_t retentionMonths,
+                            bool archive)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+      std::vector<std::int32_t> months;
+      bool partitioned;
+      std::int32_t lastMonth = currentMonth + PARTITIONS_AHEAD;
+
+      TRACESPAN("maintainPartitions");
+
+      if (!readPartitions(query, months, partitioned))
+      {
+        return false;
+      };
+
+      if (!partitioned)
+      {
+        LOGWARNING("TBL_ARCHIVE is not partitioned. Partitions are not maintained. (Run WSd --partition with the daemon stopped.)");
+        return false;
+      }
+      else if (months.empty())
+      {
+        LOGWARNING("TBL_ARCHIVE is partitioned, but not by month. Partitions are not maintained.");
+        return false;
+      }
+      else if (months.back() < lastMonth)
+      {
+        QString statement = "ALTER TABLE TBL_ARCHIVE REORGANIZE PARTITION pmax INTO (";
+
+        for (std::int32_t month = months.back() + 1; month <= lastMonth; month++)
+        {
+          statement += partitionDefinition(month);
+          months.push_back(month);
+        };
+        statement += "PARTITION pmax VALUES LESS THAN MAXVALUE)";
+
+        if (!execute(query, statement))
+        {
+          return false;
+        };
+      };
+
+      if (retentionMonths != 0)
+      {
+        for (std::int32_t month : months)
+        {
+          if (month <= currentMonth - static_cast<std::int32_t>(retentionMonths))
+          {
+            QString name = partitionName(month);
+
+            if (archive && !archivePartition(query, name))
+            {
+              return false;
+            };
+
+            if (!execute(query, "ALTER TABLE TBL_ARCHIVE DROP PARTITION " + name))
+            {
+              return false;
+            };
+
+            LOGINFO("Records of {} {} the weather database.", name.mid(1).toStdString(),
+                    archive ? "moved to an archive table of" : "dropped from");
+          };
+        };
+      };
+
+      return true;
+    }
+
+    /// @brief      Removes the expired months from the archive table of a SQLite database. SQLite has no partitions, so each
+    ///             expired month is moved to its archive table (TBL_ARCHIVE_pYYYYMM), if it is archived, and deleted in one
+    ///             transaction per month. The readers are not blocked, as the database is in WAL mode.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  currentMonth: The current month. (year * 12 + month - 1)
+    /// @param[in]  retentionMonths: The number of months to keep, including the current month. 0 to keep all.
+    /// @param[in]  archive: true to move expired months to archive tables, false to delete them.
+    /// @returns    true if successful.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool expireRecords(QString const &connectionName, std::int32_t currentMonth, std::uint32_t retentionMonths, bool archive)
+    {
+      QSqlDatabase connection = QSqlDatabase::database(connectionName, false);
+      QSqlQuery query(connection);
+      std::int64_t firstKept = monthStart(currentMonth - static_cast<std::int32_t>(retentionMonths) + 1);
+
+      TRACESPAN("expireRecords");
+
+      if (retentionMonths == 0)
+      {
+        return true;
+      };
+
+      while (execute(query, QString("SELECT MIN(MJD) FROM TBL_ARCHIVE WHERE MJD < %1").arg(firstKept)) && query.next() &&
+             !query.value(0).isNull())
+      {
+        std::int32_t month = monthOf(query.value(0).toLongLong());
+        QString name = partitionName(month);
+        QString range = QString("WHERE MJD >= %1 AND MJD < %2").arg(monthStart(month)).arg(monthStart(month + 1));
+        bool success;
+
+        query.finish();
+        connection.transaction();
+
+        success = !archive ||
+                  ( execute(query, QString(SQLITE_TABLE).arg("TBL_ARCHIVE_" + name)) &&
+                    execute(query, "INSERT OR IGNORE INTO TBL_ARCHIVE_" + name + " SELECT * FROM TBL_ARCHIVE " + range) );
+        success = success && execute(query, "DELETE FROM TBL_ARCHIVE " + range);
+
+        if (!success || !connection.commit())
+        {
+          connection.rollback();
+          return false;
+        };
+
+        LOGINFO("Records of {} {} the weather database.", name.mid(1).toStdString(),
+                archive ? "moved to an archive table of" : "deleted from");
+      };
+
+      return true;
+    }
+
+    /// @brief      Returns the SQL expression for the current time of the database server. (Seconds since 1970.)
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @returns    The expression.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static char const *serverTime(QString const &connectionName)
+    {
+      if (QSqlDatabase::database(connectionName, false).driverName() == "QSQLITE")
+      {
+        return "CAST(strftime('%s', 'now') AS INTEGER)";
+      }
+      else
+      {
+        return "UNIX_TIMESTAMP()";
+      };
+    }
+
+    /// @brief      Creates the lease table if it does not exist.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @returns    true if successful.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool createLeaseTable(QString const &connectionName)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+
+      return execute(query, LEASE_TABLE);
+    }
+
+    /// @brief      Acquires or renews the lease of a station. The lease is taken if it is held by the holder already, has
+    ///             expired or does not exist. Each step is a single statement, so of two daemons racing for an expired lease only
+    ///             one gets it.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  holder: The name of the daemon asking for the lease.
+    /// @param[in]  duration: The time the lease is held for. (s)
+    /// @param[out] currentHolder: The holder of the lease after the attempt. Empty if the lease is not held.
+    /// @param[out] remaining: The time until the lease expires. (s)
+    /// @returns    true if the statements succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool acquireLease(QString const &connectionName, std::uint32_t siteID, std::uint32_t instrumentID, QString const &holder,
+                      std::uint32_t duration, QString &currentHolder, std::int64_t &remaining)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+      QString now = serverTime(connectionName);
+
+      currentHolder.clear();
+      remaining = 0;
+
+      query.prepare(QString("UPDATE TBL_LEASE SET HOLDER = :holder, EXPIRES = %1 + :duration WHERE SITE_ID = :siteID AND "
+                            "INSTRUMENT_ID = :instrumentID AND (HOLDER = :currentHolder OR EXPIRES < %1)").arg(now));
+      query.bindValue(":holder", holder);
+      query.bindValue(":duration", duration);
+      query.bindValue(":siteID", siteID);
+      query.bindValue(":instrumentID", instrumentID);
+      query.bindValue(":currentHolder", holder);
+
+      if (!query.exec())
+      {
+        LOGERROR("Unable to renew the lease: {}", query.lastError().text().toStdString());
+        return false;
+      };
+
+        // MySQL counts the rows changed rather than the rows matched, so a renewal in the same second as the previous one is not
+        // counted. The insert then fails on the primary key, and the holder is read back in either case.
+
+      if (query.numRowsAffected() <= 0)
+      {
+        query.prepare(QString("INSERT INTO TBL_LEASE (SITE_ID, INSTRUMENT_ID, HOLDER, EXPIRES) VALUES (:siteID, :instrumentID, "
+                              ":holder, %1 + :duration)").arg(now));
+        query.bindValue(":siteID", siteID);
+        query.bindValue(":instrumentID", instrumentID);
+        query.bindValue(":holder", holder);
+        query.bindValue(":duration", duration);
+        query.exec();
+      };
+
+      query.prepare(QString("SELECT HOLDER, EXPIRES - %1 FROM TBL_LEASE WHERE SITE_ID = :siteID AND "
+                            "INSTRUMENT_ID = :instrumentID").arg(now));
+      query.bindValue(":siteID", siteID);
+      query.bindValue(":instrumentID", instrumentID);
+
+      if (!query.exec())
+      {
+        LOGERROR("Unable to read the lease: {}", query.lastError().text().toStdString());
+        return false;
+      };
+
+      if (query.next() && (query.value(1).toLongLong() > 0))
+      {
+        currentHolder = query.value(0).toString();
+        remaining = query.value(1).toLongLong();
+      };
+
+      return true;
+    }
+
+    /// @brief      Releases the lease of a station, so that the other daemon can take it without waiting for it to expire.
+    /// @param[in]  connectionName: The name of an open connection.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  holder: The name of the daemon releasing the lease. A lease held by another daemon is not changed.
+    /// @returns    true if the statement succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool releaseLease(QString const &connectionName, std::uint32_t siteID, std::uint32_t instrumentID, QString const &holder)
+    {
+      QSqlQuery query(QSqlDatabase::database(connectionName, false));
+
+      query.prepare("UPDATE TBL_LEASE SET EXPIRES = 0 WHERE SITE_ID = :siteID AND INSTRUMENT_ID = :instrumentID AND "
+                    "HOLDER = :holder");
+      query.bindValue(":siteID", siteID);
+      query.bindValue(":instrumentID", instrumentID);
+      query.bindValue(":holder", holder);
+
+      if (!query.exec())
+      {
+        LOGERROR("Unable to release the lease: {}", query.lastError().text().toStdString());
+        return false;
+      };
+
+      return true;
+    }
+
+  } // namespace sql
+} // namespace WSd
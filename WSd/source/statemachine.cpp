@@ -34,132 +34,1040 @@
 
   // Standard C++ library header files
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
+#include <exception>
+#include <string>
 #include <thread>
 
   // Miscellaneous library header files
 
 #include "include/database.h"
 #include <GCL>
+#include <QCL>
+#include <QCoreApplication>
+#include <QEventLoop>
 #include <WCL>
 
   // WSd header files
 
 #include "include/error.h"
+#include "include/logger.h"
+#include "include/stationSnapshot.h"
+#include "include/systemd.h"
+#include "include/tracer.h"
+#include "include/transaction.h"
 #include "include/settings.h"
+#include "include/weatherDatabase.h"
 
 namespace WSd
 {
+    // Time the process started. (Initialised before main() is entered.) Used to report the time to the first archive read.
+
+  static std::chrono::steady_clock::time_point const processStartTime = std::chrono::steady_clock::now();
+
+    // Age up to which the console configuration check of a snapshot is trusted. (s)
+
+  static std::int64_t const SNAPSHOT_VALIDITY = 60 * 60;
+
+  /// @brief      Returns the delay of the first poll of a station. When many daemons are started together (eg after a reboot)
+  ///             their first polls are spread evenly over the startup spread, so the consoles and the database are not all
+  ///             connected at once. The delay is derived from the station, so it is the same each time the station starts.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The delay (ms).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static int startupDelay(configuration::SConfiguration const &configuration)
+  {
+    std::uint64_t hash = ((static_cast<std::uint64_t>(configuration.station.siteID) << 32) | configuration.station.instrumentID) *
+                         UINT64_C(0x9E3779B97F4A7C15);
+
+    if (configuration.startupSpread == 0)
+    {
+      return 0;
+    }
+    else
+    {
+      return static_cast<int>((hash >> 32) % (static_cast<std::uint64_t>(configuration.startupSpread) * 1000));
+    };
+  }
+
+  /// @brief      Returns the file the console configuration of the station is cached in. The file is kept with the local store
+  ///             of the station, or in the working directory if the local store is disabled.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The cache file.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static QString consoleCacheFile(configuration::SConfiguration const &configuration)
+  {
+    if (configuration.storeDirectory.isEmpty())
+    {
+      return QString("WSd-console-%1-%2.eeprom").arg(configuration.station.siteID).arg(configuration.station.instrumentID);
+    }
+    else
+    {
+      return QString("%1/%2-%3/console.eeprom").arg(configuration.storeDirectory).arg(configuration.station.siteID)
+                                                .arg(configuration.station.instrumentID);
+    };
+  }
+
+  /// @brief      Creates the reception log of the station if the console diagnostics are sampled. The log is kept with the local
+  ///             store of the station, or in the working directory if the local store is disabled.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The reception log. nullptr if the console diagnostics are not sampled.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::unique_ptr<CReceptionLog> openReception(configuration::SConfiguration const &configuration)
+  {
+    std::unique_ptr<CReceptionLog> returnValue;
+    QString fileName;
+
+    if (configuration.receptionInterval != 0)
+    {
+      if (configuration.storeDirectory.isEmpty())
+      {
+        fileName = QString("WSd-reception-%1-%2.series").arg(configuration.station.siteID)
+                                                         .arg(configuration.station.instrumentID);
+      }
+      else
+      {
+        fileName = QString("%1/%2-%3/reception.series").arg(configuration.storeDirectory).arg(configuration.station.siteID)
+                                                        .arg(configuration.station.instrumentID);
+      };
+
+      returnValue = std::make_unique<CReceptionLog>(configuration.station.siteID, configuration.station.instrumentID,
+                                                    fileName);
+      returnValue->open();
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Creates the replicator of the station if it is replicated from an upstream daemon. The replication position is
+  ///             kept with the local store of the station, or in the working directory if the local store is disabled.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The replicator. nullptr if the console is polled.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::unique_ptr<CReplicator> openReplicator(configuration::SConfiguration const &configuration)
+  {
+    std::unique_ptr<CReplicator> returnValue;
+    QString fileName;
+
+    if (!configuration.upstreamAddress.isEmpty())
+    {
+      if (configuration.storeDirectory.isEmpty())
+      {
+        fileName = QString("WSd-replica-%1-%2.position").arg(configuration.station.siteID)
+                                                        .arg(configuration.station.instrumentID);
+      }
+      else
+      {
+        fileName = QString("%1/%2-%3/replica.position").arg(configuration.storeDirectory).arg(configuration.station.siteID)
+                                                       .arg(configuration.station.instrumentID);
+      };
+
+      returnValue = std::make_unique<CReplicator>(configuration.station.siteID, configuration.station.instrumentID,
+                                                  configuration.upstreamAddress, configuration.upstreamPort, fileName);
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Returns the file the runtime state of the station is saved in. The file is kept with the local store of the
+  ///             station, or in the working directory if the local store is disabled.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The snapshot file.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static QString snapshotFile(configuration::SConfiguration const &configuration)
+  {
+    if (configuration.storeDirectory.isEmpty())
+    {
+      return QString("WSd-state-%1-%2.snapshot").arg(configuration.station.siteID).arg(configuration.station.instrumentID);
+    }
+    else
+    {
+      return QString("%1/%2-%3/state.snapshot").arg(configuration.storeDirectory).arg(configuration.station.siteID)
+                                               .arg(configuration.station.instrumentID);
+    };
+  }
+
+  /// @brief      Returns the identity of the runtime state of the station: the station, its console and its database. A
+  ///             snapshot saved for a different identity is not restored.
+  /// @param[in]  configuration: The configuration snapshot.
+  /// @returns    The identity.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static QString snapshotIdentity(configuration::SConfiguration const &configuration)
+  {
+    return QString("%1-%2 %3:%4 %5 %6:%7/%8").arg(configuration.station.siteID).arg(configuration.station.instrumentID)
+                                            .arg(configuration.station.ipAddress).arg(configuration.station.port)
+                                            .arg(configuration.database.driver).arg(configuration.database.hostAddress)
+                                            .arg(configuration.database.port).arg(configuration.database.databaseName);
+  }
+
   /// @brief Constructor for the state machine class.
   /// @param[in] np:
   /// @param[in] sid:
   /// @param[in] iid:
+  /// @param[in] config: The configuration snapshot to use.
+  /// @version 2026-10-19/GGB - Records not written by the ingest pipeline once the lease has been given up.
+  /// @version 2026-10-19/GGB - Replicator created if the station is replicated from an upstream daemon.
+  /// @version 2026-10-19/GGB - Lease created if the station is shared with a standby daemon.
+  /// @version 2026-10-19/GGB - Reception log opened.
+  /// @version 2026-10-19/GGB - Runtime state restored from the snapshot.
+  /// @version 2026-10-19/GGB - Database connected by the first poll rather than during start up.
+  /// @version 2026-10-19/GGB - Cached console configuration loaded.
+  /// @version 2026-10-19/GGB - Console traffic captured if a capture file is configured.
+  /// @version 2026-10-19/GGB - Ingest pipeline created.
+  /// @version 2026-10-19/GGB - Settings taken from the configuration snapshot. Database connected from the snapshot.
   /// @version 2015-05-17/GGB - Function created.
 
-  CStateMachine::CStateMachine(QObject *np, std::uint32_t sid, std::uint32_t iid)
-    : siteID(sid), instrumentID(iid), parent(np), pollTimer(nullptr)
+  CStateMachine::CStateMachine(QObject *np, std::uint32_t sid, std::uint32_t iid, configuration::PConfiguration config)
+    : siteID(sid), instrumentID(iid), parent(np), pollTimer(nullptr), configuration(std::move(config))
   {
-    tcpSocket = new CTCPSocket(parent, siteID, instrumentID);
+    tcpSocket = new CTCPSocket(parent, siteID, instrumentID, configuration->station);
+    tcpSocket->setCapture(configuration->captureFile);
+    tcpSocket->setConsoleCache(consoleCacheFile(*configuration));
+    ingest = std::make_unique<CIngest>(siteID, instrumentID, *configuration);
+    ingest->setWriteDeadline([this]() { return writeDeadline(); });
+    reception = openReception(*configuration);
+    replicator = openReplicator(*configuration);
+    tcpSocket->setRadioMonitor(configuration->radioMonitor);
 
     //std::this_thread::sleep_for(std::chrono::seconds(60));
 
     pollTimer = new QTimer();
     connect(pollTimer, SIGNAL(timeout()), this, SLOT(pollModeTimer()));
-    pollTimer->setInterval(WCL::settings::settings.value(WCL::settings::WS_POLLINTERVAL, 5).toInt() * 60000);
+    pollTimer->setInterval(configuration->pollInterval * 60000);
 
-    WCL::database.connectToDatabase();
+    leaseTimer = new QTimer();
+    connect(leaseTimer, SIGNAL(timeout()), this, SLOT(renewLease()));
+    openLease(*configuration);
+
+    restoreSnapshot();
   }
 
-  /// @brief Destructor - Frees dynamically allocated objects
+  /// @brief Destructor - Frees dynamically allocated objects. The state machine is stopped first, so a poll in progress has
+  ///        completed before the objects it uses are deleted.
   /// @throws None
+  /// @version 2026-10-19/GGB - Lease closed before the weather database is disconnected.
+  /// @version 2026-10-19/GGB - Stopped before anything is deleted.
+  /// @version 2026-10-19/GGB - Lease timer deleted.
+  /// @version 2026-10-19/GGB - Weather database disconnected.
   /// @version 2015-05-17/GGB - Function created.
 
   CStateMachine::~CStateMachine()
   {
+    stop();
+
     if (pollTimer)
     {
       delete pollTimer;
       pollTimer = nullptr;
     };
 
+    if (leaseTimer)
+    {
+      delete leaseTimer;
+      leaseTimer = nullptr;
+    };
+
     if (tcpSocket)
     {
       delete tcpSocket;
       tcpSocket = nullptr;
     }
+
+    lease.reset();                                // Lease connection closed on the database thread before the disconnect.
+    weatherDatabase::disconnect();
   }
 
-  /// @brief      Slot for the poll mode timer.
+  /// @brief      Creates the lease of the station if it is shared with a standby daemon. A lease that is held is released first,
+  ///             so the other daemon can take over straight away.
+  /// @param[in]  newConfiguration: The configuration snapshot.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStateMachine::openLease(configuration::SConfiguration const &newConfiguration)
+  {
+    leaseTimer->stop();
+    lease.reset();
+    leaseHeld = false;
+
+    if (newConfiguration.leaseTime != 0)
+    {
+      lease = std::make_unique<CLease>(newConfiguration.station.siteID, newConfiguration.station.instrumentID,
+                                       newConfiguration);
+
+        // Renewed at a third of the lease time, so a renewal can fail once without the lease being lost.
+
+      leaseTimer->setInterval(newConfiguration.leaseTime * 1000 / 3);
+    };
+  }
+
+  /// @brief      Slot for the lease timer. Starts the renewal of the lease, unless the previous renewal is still waiting for the
+  ///             database. A configuration received during the renewal is applied when it completes.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Lease renewed as a coroutine on the database thread.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStateMachine::renewLease()
+  {
+    auto renewalCompleted = [this](bool, std::exception_ptr exception)
+    {
+      if (exception)
+      {
+        try
+        {
+          std::rethrow_exception(exception);
+        }
+        catch (std::exception const &e)
+        {
+          LOGERROR("Lease renewal failed: {}", e.what());
+        }
+        catch (...)
+        {
+          LOGERROR("Lease renewal failed.");
+        };
+      };
+
+      leaseRenewing = false;
+
+      if (!stopped && !pollInProgress && pendingConfiguration)
+      {
+        reconfigure(std::move(pendingConfiguration));
+      };
+    };
+
+    if (leaseRenewing)
+    {
+      LOGWARNING("Previous lease renewal still in progress. Renewal skipped.");
+      return;
+    };
+
+    leaseRenewing = true;
+    leaseTask.reset();
+    leaseTask.emplace(refreshLease());
+    leaseTask->launch(renewalCompleted);
+  }
+
+  /// @brief      Renews the lease, or tries to acquire it when standing by. When the lease is acquired the station is polled
+  ///             straight away, starting from the high-water mark in the database. When it is lost the poll in progress stops
+  ///             writing at the write deadline.
+  /// @returns    true if the lease is held.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created from the body of renewLease().
+
+  CTask<bool> CStateMachine::refreshLease()
+  {
+    bool held = co_await lease->renew();
+
+    if (stopped)
+    {
+      co_return held;                             // The lease is released by stop().
+    };
+
+    if (held && !leaseHeld)
+    {
+      LOGINFO("Lease of station {}-{} acquired by {}. Polling station.", siteID, instrumentID,
+              lease->instance().toStdString());
+      systemd::status("Lease acquired. Polling station " + std::to_string(siteID) + "-" + std::to_string(instrumentID) + ".");
+
+        // The other daemon may have written records since the last refresh. One query of the last record before the download.
+        // The console configuration cache is read again in case it was updated while standing by.
+
+      tcpSocket->invalidateHighWater();
+      highWaterCheck = false;
+      tcpSocket->setConsoleCache(consoleCacheFile(*configuration));
+
+      if (!pollInProgress && pollTimer->isActive())
+      {
+        pollTimer->start(0);                      // The poll interval is restored by the poll.
+      };
+    }
+    else if (!held && leaseHeld)
+    {
+      LOGWARNING("Lease of station {}-{} lost. Standing by.", siteID, instrumentID);
+      systemd::status("Standing by for station " + std::to_string(siteID) + "-" + std::to_string(instrumentID) + ".");
+    };
+
+    leaseHeld = held;
+    co_return held;
+  }
+
+  /// @brief      Returns the time after which the ingest pipeline does not write records. This is the time the lease is given
+  ///             up locally, which is before the other daemon can take it.
+  /// @returns    The deadline. (No deadline if the station is not shared with a standby daemon.)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::chrono::steady_clock::time_point CStateMachine::writeDeadline() const
+  {
+    if (!lease)
+    {
+      return std::chrono::steady_clock::time_point::max();
+    }
+    else if (!leaseHeld)
+    {
+      return std::chrono::steady_clock::time_point::min();
+    }
+    else
+    {
+      return lease->heldUntil();
+    };
+  }
+
+  /// @brief      Keeps the state of a standby daemon warm. The high-water mark is read from the database, so the download
+  ///             starts from the last record written by the active daemon when the lease is acquired. The console is not
+  ///             contacted.
+  /// @returns    true if the high-water mark was read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - High-water mark read and database closed on the database thread.
+  /// @version    2026-10-19/GGB - Converted to a coroutine. The database is opened on the database thread.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<bool> CStateMachine::refreshStandby()
+  {
+    bool databaseOpen;
+
+    TRACESPAN("refreshStandby");
+
+    if (lease->holder().isEmpty())
+    {
+      LOGDEBUG("Standing by. Lease not held.");
+    }
+    else
+    {
+      LOGDEBUG("Standing by. Lease held by {}.", lease->holder().toStdString());
+    };
+
+    databaseOpen = co_await weatherDatabase::openAsync(configuration->database, !databaseConnected);
+    databaseConnected = true;
+
+    if (databaseOpen)
+    {
+      co_await tcpSocket->loadHighWater();
+      highWaterCheck = false;
+      co_await weatherDatabase::executeAsync([]() { weatherDatabase::close(); return true; });
+    };
+
+    co_return databaseOpen;
+  }
+
+  /// @brief      Restores the runtime state saved before the daemon was restarted. The circuit breaker is always restored, the
+  ///             daily tasks only on the same day and the console configuration check only if the snapshot is recent. The
+  ///             high-water mark is used once it has been checked against the database by the first poll.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Time to the next attempt limited to the maximum backoff.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStateMachine::restoreSnapshot()
+  {
+    SStationSnapshot snapshot;
+    std::time_t now = std::time(nullptr);
+    std::time_t savedTime;
+    struct tm nowDate;
+    struct tm savedDate;
+
+    if (!snapshot.load(snapshotFile(*configuration), snapshotIdentity(*configuration)))
+    {
+      return;
+    };
+
+      // The time of the next attempt is saved as system time, the circuit breaker works in steady time. The wait is limited to
+      // the maximum backoff, so that a system clock that has been set back cannot keep the console from being polled.
+
+    std::int64_t nowMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch()).count();
+    std::chrono::milliseconds untilNextAttempt(0);
+
+    if (snapshot.nextAttempt > nowMilliseconds)
+    {
+      untilNextAttempt = std::min(std::chrono::milliseconds(snapshot.nextAttempt - nowMilliseconds),
+                                  std::chrono::duration_cast<std::chrono::milliseconds>(health.backoffLimit()));
+    };
+
+    health.restore(snapshot.health, snapshot.failures, snapshot.openCount, std::chrono::steady_clock::now() + untilNextAttempt);
+
+    savedTime = static_cast<std::time_t>(snapshot.savedTime);
+    localtime_r(&now, &nowDate);
+    localtime_r(&savedTime, &savedDate);
+
+    if ( (nowDate.tm_year == savedDate.tm_year) && (nowDate.tm_yday == savedDate.tm_yday) )
+    {
+      maintenanceDay = snapshot.maintenanceDay;
+      timeUpdated = snapshot.timeUpdated;
+    };
+
+    if ( snapshot.consoleValidated && (now - snapshot.savedTime >= 0) && (now - snapshot.savedTime < SNAPSHOT_VALIDITY) )
+    {
+      tcpSocket->assumeConsoleValidated();
+    };
+
+    if (snapshot.highWaterValid)
+    {
+      tcpSocket->setHighWater(snapshot.highWaterDate, snapshot.highWaterTime);
+      highWaterCheck = true;
+    };
+
+    LOGINFO("Station state restored from snapshot saved {} s ago. Console {}.", static_cast<long long>(now - snapshot.savedTime),
+            CStationHealth::healthText(health.health()));
+  }
+
+  /// @brief      Saves the runtime state of the station, so that it can be restored when the daemon is restarted.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStateMachine::saveSnapshot()
+  {
+    SStationSnapshot snapshot;
+
+    TRACESPAN("saveSnapshot");
+
+    snapshot.savedTime = static_cast<std::int64_t>(std::time(nullptr));
+    snapshot.highWaterValid = tcpSocket->highWater(snapshot.highWaterDate, snapshot.highWaterTime);
+    snapshot.health = health.health();
+    snapshot.failures = health.failures();
+    snapshot.openCount = health.openings();
+    snapshot.nextAttempt = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch()).count() +
+                           std::chrono::duration_cast<std::chrono::milliseconds>(
+                             health.nextAttemptTime() - std::chrono::steady_clock::now()).count();
+    snapshot.consoleValidated = tcpSocket->consoleConfigurationValidated();
+    snapshot.maintenanceDay = maintenanceDay;
+    snapshot.timeUpdated = timeUpdated;
+
+    snapshot.save(snapshotFile(*configuration), snapshotIdentity(*configuration));
+  }
+
+  /// @brief      Slot for the poll mode timer. The poll runs as a coroutine, so the slot returns as soon as the poll is waiting on
+  ///             the console and the event loop remains free for other stations and service commands.
   /// @throws
+  /// @version    2026-10-19/GGB - Station polled after a standby refresh during which the lease was acquired.
+  /// @version    2026-10-19/GGB - Task of the poll kept, so stop() can wait for it.
+  /// @version    2026-10-19/GGB - Standby state refreshed as a coroutine, not overlapping a poll.
+  /// @version    2026-10-19/GGB - Standby daemon does not poll the console.
+  /// @version    2026-10-19/GGB - Runtime state saved after each poll.
+  /// @version    2026-10-19/GGB - Poll interval set after the first poll.
+  /// @version    2026-10-19/GGB - Poll run as a coroutine. A poll is not started while the previous poll is still running.
+  /// @version    2026-10-19/GGB - Polls gated by the station health (circuit breaker).
+  /// @version    2026-10-19/GGB - Trace spans added.
   /// @version    2015-05-17/GGB - Function created.
 
   void CStateMachine::pollModeTimer()
   {
-    static bool timeUpdated = false;
+    TRACEENTER;
+
+    auto pollCompleted = [this](bool, std::exception_ptr exception)
+    {
+      if (exception)
+      {
+        try
+        {
+          std::rethrow_exception(exception);
+        }
+        catch (std::exception const &e)
+        {
+          LOGERROR("Poll failed: {}", e.what());
+        }
+        catch (...)
+        {
+          LOGERROR("Poll failed.");
+        };
+      };
+
+      pollInProgress = false;
+
+        // A poll cancelled by stop() leaves the configuration and the snapshot to stop().
+
+      if (!stopped)
+      {
+        if (pendingConfiguration)
+        {
+          reconfigure(std::move(pendingConfiguration));
+        };
+
+        saveSnapshot();
+
+          // The lease may have been acquired during a standby refresh. The station is polled straight away.
+
+        if (standingBy && lease && lease->held() && pollTimer->isActive())
+        {
+          pollTimer->start(0);
+        };
+      };
+    };
+
+      // The first poll is made at start up (after the startup delay). The following polls are made at the poll interval.
+
+    if (pollTimer->interval() != static_cast<int>(configuration->pollInterval * 60000))
+    {
+      pollTimer->setInterval(configuration->pollInterval * 60000);
+    };
+
+    if (pollInProgress)
+    {
+      LOGWARNING("Previous poll still in progress. Poll skipped.");
+    }
+
+      // A standby daemon only keeps its high-water mark up to date. The console is polled by the daemon holding the lease.
+
+    else if (lease && !lease->held())
+    {
+      pollInProgress = true;
+      standingBy = true;
+      pollTask.reset();
+      pollTask.emplace(refreshStandby());
+      pollTask->launch(pollCompleted);
+    }
+
+      // A console that has failed repeatedly is not polled until its backoff expires. This costs nothing while the circuit is
+      // open.
+
+    else if (!health.allowAttempt(std::chrono::steady_clock::now()))
+    {
+      LOGDEBUG("Console circuit open. Poll skipped.");
+    }
+    else
+    {
+      pollInProgress = true;
+      standingBy = false;
+      pollTask.reset();
+      pollTask.emplace(poll());
+      pollTask->launch(pollCompleted);
+    };
+
+    TRACEEXIT;
+  }
+
+  /// @brief      Polls the console. Reads the archive and corrects the console time if required. A station replicated from an
+  ///             upstream daemon pulls the journal of the upstream daemon instead; the console is not contacted.
+  /// @returns    true if the archive was read.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Poll abandoned without recording a console failure when the lease is lost.
+  /// @version    2026-10-19/GGB - High-water mark, time check and closing of the database awaited on the database thread.
+  /// @version    2026-10-19/GGB - Database opened and maintained on the database thread. Waits for the local store to be opened
+  ///                              without blocking the event loop.
+  /// @version    2026-10-19/GGB - Local time converted with localtime_r.
+  /// @version    2026-10-19/GGB - Replication from an upstream daemon added.
+  /// @version    2026-10-19/GGB - Console diagnostics sampled with the archive when due.
+  /// @version    2026-10-19/GGB - Restored high-water mark checked against the database. Console time checked against the
+  ///                              high-water mark rather than the database.
+  /// @version    2026-10-19/GGB - Database connected on the first poll. Time to the first archive read reported.
+  /// @version    2026-10-19/GGB - Console health reported to systemd.
+  /// @version    2026-10-19/GGB - Console time tolerance allows for the archive period of the console.
+  /// @version    2026-10-19/GGB - Database partitions and retention maintained once a day.
+  /// @version    2026-10-19/GGB - Database accessed through weatherDatabase. (MySQL or SQLite)
+  /// @version    2026-10-19/GGB - Function created from the body of pollModeTimer().
+
+  CTask<bool> CStateMachine::poll()
+  {
     uint16_t dateValue, timeValue;
     double t1, t2;
+    bool databaseOpen;
+    bool archiveRead = false;
+    EStationHealth previousHealth = health.health();
+    CStationHealth::time_point now = std::chrono::steady_clock::now();
 
-    TRACEENTER;
+    TRACESPAN("poll");
 
-    DEBUGMESSAGE("Connecting to database");
-    if (!WCL::database.openDatabase())
+    LOGDEBUG("Connecting to database");
     {
-      ERRORMESSAGE("Unable to connect to database.");
+      TRACESPAN("openDatabase");
+
+        // The database is connected on the database thread while the local store is being opened on the executor. The event
+        // loop is not blocked while either is waited for.
+
+      CAsyncResult<bool> databaseOpening = weatherDatabase::openAsync(configuration->database, !databaseConnected);
+
+      databaseConnected = true;
+      co_await ingest->opened();
+      databaseOpen = co_await databaseOpening;
+    }
+
+    if (!databaseOpen)
+    {
+      LOGERROR("Unable to connect to database.");
     }
     else
     {
-      DEBUGMESSAGE("Polling Weather System Device.");
+      if (highWaterCheck)
+      {
+        std::uint16_t restoredDate, restoredTime;
+
+          // One query of the last record. The database wins if it differs from the snapshot. (eg records imported while the
+          // daemon was stopped, or a database restored from a backup)
+
+        tcpSocket->highWater(restoredDate, restoredTime);
+        co_await tcpSocket->loadHighWater();
+        tcpSocket->highWater(dateValue, timeValue);
+        highWaterCheck = false;
+
+        if ( (dateValue == restoredDate) && (timeValue == restoredTime) )
+        {
+          LOGINFO("High-water mark of the snapshot confirmed by the database.");
+        }
+        else
+        {
+          LOGWARNING("High-water mark of the snapshot differs from the database. Database used.");
+        };
+      };
+
+      LOGDEBUG("Polling Weather System Device.");
+
+      CReceptionLog *receptionDue = (reception && !replicator && (now >= nextReception)) ? reception.get() : nullptr;
+
+      if (replicator)
+      {
+        archiveRead = co_await replicator->pull(*ingest);
+      }
+      else
+      {
+        tcpSocket->setProbeMode(health.probeOnly());
+        archiveRead = co_await tcpSocket->readArchive(*ingest, receptionDue);
+      };
 
-      tcpSocket->readArchive();
+      if (!ingest->writable())
+      {
+          // The lease was lost during the poll. The download was abandoned; this says nothing about the console.
+
+        LOGWARNING("Lease of station {}-{} lost during the poll. Poll abandoned.", siteID, instrumentID);
+        archiveRead = false;
+      }
+      else if (archiveRead)
+      {
+        health.recordSuccess();
+
+        if (receptionDue)
+        {
+          nextReception = now + std::chrono::minutes(configuration->receptionInterval);
+        };
+
+        if (!firstReadReported)
+        {
+          long long startTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                      processStartTime).count();
+
+          firstReadReported = true;
+          LOGINFO("First archive read {} ms after start.", startTime);
+          systemd::status("Polling station " + std::to_string(siteID) + "-" + std::to_string(instrumentID) +
+                          ". First archive read " + std::to_string(startTime) + " ms after start.");
+        };
+      }
+      else
+      {
+        health.recordFailure(now);
+      };
+
+      if (health.health() != previousHealth)
+      {
+        LOGWARNING("Console health changed from {} to {}.", CStationHealth::healthText(previousHealth),
+                   CStationHealth::healthText(health.health()));
+        systemd::status(std::string("Console ") + CStationHealth::healthText(health.health()) + ".");
+
+        if (health.health() == SH_OPEN)
+        {
+          LOGWARNING("Console not responding. Next attempt in {} seconds.",
+                     std::chrono::duration_cast<std::chrono::seconds>(health.nextAttemptTime() - now).count());
+        };
+      };
 
       std::time_t time = std::time(&time);
-      struct tm *currentTime = std::localtime(&time);
+      struct tm currentTime;
 
-      if ( (currentTime->tm_hour == 0) && (currentTime->tm_min < 10) && (!timeUpdated))
+      localtime_r(&time, &currentTime);                 // Not localtime(), the result is used across co_await.
+
+      if (!archiveRead || replicator)
+      {
+          // Don't attempt to set the time on a console that did not respond, or on the console of the upstream daemon.
+      }
+      else if ( (currentTime.tm_hour == 0) && (currentTime.tm_min < 10) && (!timeUpdated))
       {
-        timeUpdated = tcpSocket->setTime();
+        TRACESPAN("setTime");
+        timeUpdated = co_await tcpSocket->setTime();
       }
-      else if ( (currentTime->tm_hour == 23) && (timeUpdated) )
+      else if ( (currentTime.tm_hour == 23) && (timeUpdated) )
       {
         timeUpdated = false;
       }
       else
       {
-        WCL::database.lastWeatherRecord(siteID, instrumentID, dateValue, timeValue);
-        dateValue = currentTime->tm_hour * 60 + currentTime->tm_min;                 // Time in minutes after start of day
+        if (!tcpSocket->highWater(dateValue, timeValue))
+        {
+          co_await weatherDatabase::executeAsync([sid = siteID, iid = instrumentID, &dateValue, &timeValue]()
+          {
+            return weatherDatabase::lastWeatherRecord(sid, iid, dateValue, timeValue);
+          });
+        };
+        dateValue = currentTime.tm_hour * 60 + currentTime.tm_min;                 // Time in minutes after start of day
         timeValue = (timeValue / 100) * 60 + (timeValue % 100);                                  // Convert time to minutes.
 
         t1 = std::abs(720 - dateValue);
         t2 = std::abs(720 - timeValue);
 
-        if (std::abs(t1 - t2) > 5)        // If time difference greater than 5 minutes.
+          // The last record can be up to one archive period old. (Taken from the cached console configuration.)
+
+        if (std::abs(t1 - t2) > 5 + tcpSocket->consoleConfiguration().archivePeriod())
         {
-          timeUpdated = tcpSocket->setTime();
+          TRACESPAN("setTime");
+          timeUpdated = co_await tcpSocket->setTime();
         }
       }
 
-      WCL::database.closeDatabase();
+        // The partitions and the retention of the database are maintained once a day, after the archive has been read.
+
+      if (archiveRead && (currentTime.tm_yday != maintenanceDay))
+      {
+        maintenanceDay = currentTime.tm_yday;
+        if (!co_await weatherDatabase::maintainAsync(configuration))
+        {
+          LOGWARNING("Weather database maintenance failed.");
+        };
+      };
+
+      TRACESPAN("closeDatabase");
+      co_await weatherDatabase::executeAsync([]() { weatherDatabase::close(); return true; });
+    };
+
+    co_return archiveRead;
+  }
+
+  /// @brief      Applies a new configuration snapshot. Only the parts of the state machine that are affected by the changes are
+  ///             rebuilt. The console connection and the poll timer phase are retained where possible.
+  /// @param[in]  newConfiguration: The new configuration snapshot.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Replicator created again when the station, the store or the upstream daemon changes.
+  /// @version    2026-10-19/GGB - Lease created again when the station, the database or the lease time changes.
+  /// @version    2026-10-19/GGB - Reception log reopened when the station, the store or the sampling changes.
+  /// @version    2026-10-19/GGB - High-water mark read again from the new database.
+  /// @version    2026-10-19/GGB - Database reconnected by the next poll.
+  /// @version    2026-10-19/GGB - Console configuration cache changed with the station or the store.
+  /// @version    2026-10-19/GGB - Capture of the console traffic started or stopped.
+  /// @version    2026-10-19/GGB - Database maintained at the next poll when the database or the retention changes.
+  /// @version    2026-10-19/GGB - Alert rules applied to the ingest pipeline.
+  /// @version    2026-10-19/GGB - Quality control settings applied to the ingest pipeline.
+  /// @version    2026-10-19/GGB - Ingest pipeline rebuilt when the station or the store changes.
+  /// @version    2026-10-19/GGB - Deferred while a poll or a renewal of the lease is in progress.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStateMachine::reconfigure(configuration::PConfiguration newConfiguration)
+  {
+    bool leaseChanged;
+
+    TRACEENTER;
+
+    if (pollInProgress || leaseRenewing)
+    {
+        // The poll is using the console connection and the database, or the renewal is using the lease. Apply the new
+        // configuration when it completes.
+
+      LOGINFO("Poll or lease renewal in progress. New configuration applied when it completes.");
+      pendingConfiguration = std::move(newConfiguration);
+      TRACEEXIT;
+      return;
+    };
+
+    if (newConfiguration->station != configuration->station)
+    {
+      siteID = newConfiguration->station.siteID;
+      instrumentID = newConfiguration->station.instrumentID;
+      tcpSocket->reconfigure(newConfiguration->station);
+      health.recordSuccess();                     // A different console, forget the health of the old one.
+    };
+
+    if (newConfiguration->captureFile != configuration->captureFile)
+    {
+      tcpSocket->setCapture(newConfiguration->captureFile);
+    };
+
+    if ( (newConfiguration->station != configuration->station) ||
+         (newConfiguration->storeDirectory != configuration->storeDirectory) )
+    {
+      tcpSocket->setConsoleCache(consoleCacheFile(*newConfiguration));
+    };
+
+    if ( (newConfiguration->station.siteID != configuration->station.siteID) ||
+         (newConfiguration->station.instrumentID != configuration->station.instrumentID) ||
+         (newConfiguration->storeDirectory != configuration->storeDirectory) ||
+         (newConfiguration->elevation != configuration->elevation) )
+    {
+      ingest.reset();                             // Flush and close the old store before opening the new one.
+      ingest = std::make_unique<CIngest>(newConfiguration->station.siteID, newConfiguration->station.instrumentID,
+                                         *newConfiguration);
+      ingest->setWriteDeadline([this]() { return writeDeadline(); });
+    }
+    else
+    {
+      if (newConfiguration->quality != configuration->quality)
+      {
+        LOGINFO("Quality control settings changed.");
+        ingest->setQualityConfiguration(newConfiguration->quality);
+      };
+      if ( (newConfiguration->alertRules != configuration->alertRules) ||
+           (newConfiguration->pollInterval != configuration->pollInterval) )
+      {
+        LOGINFO("Alert rules updated.");
+        ingest->setAlertRules(*newConfiguration);
+      };
+    };
+
+    if ( (newConfiguration->station.siteID != configuration->station.siteID) ||
+         (newConfiguration->station.instrumentID != configuration->station.instrumentID) ||
+         (newConfiguration->storeDirectory != configuration->storeDirectory) ||
+         (newConfiguration->receptionInterval != configuration->receptionInterval) )
+    {
+      reception.reset();
+      reception = openReception(*newConfiguration);
+      nextReception = std::chrono::steady_clock::time_point();
+    };
+
+    if ( (newConfiguration->station.siteID != configuration->station.siteID) ||
+         (newConfiguration->station.instrumentID != configuration->station.instrumentID) ||
+         (newConfiguration->storeDirectory != configuration->storeDirectory) ||
+         (newConfiguration->upstreamAddress != configuration->upstreamAddress) ||
+         (newConfiguration->upstreamPort != configuration->upstreamPort) )
+    {
+      replicator = openReplicator(*newConfiguration);
+    };
+
+    if (newConfiguration->radioMonitor != configuration->radioMonitor)
+    {
+      tcpSocket->setRadioMonitor(newConfiguration->radioMonitor);
+    };
+
+    if (newConfiguration->pollInterval != configuration->pollInterval)
+    {
+      LOGINFO("Poll interval changed to {} minutes.", newConfiguration->pollInterval);
+
+        // QTimer::setInterval() restarts an active timer.
+
+      pollTimer->setInterval(newConfiguration->pollInterval * 60000);
+    };
+
+    if (newConfiguration->database != configuration->database)
+    {
+      LOGINFO("Database settings changed. Database reconnected by the next poll.");
+      weatherDatabase::disconnect();
+      databaseConnected = false;
+      tcpSocket->invalidateHighWater();
+      highWaterCheck = false;
+    };
+
+    if ( (newConfiguration->database != configuration->database) ||
+         (newConfiguration->retentionMonths != configuration->retentionMonths) ||
+         (newConfiguration->retentionArchive != configuration->retentionArchive) )
+    {
+      maintenanceDay = -1;                        // Maintain the database at the next poll.
+    };
+
+    leaseChanged = (newConfiguration->station.siteID != configuration->station.siteID) ||
+                   (newConfiguration->station.instrumentID != configuration->station.instrumentID) ||
+                   (newConfiguration->database != configuration->database) ||
+                   (newConfiguration->leaseTime != configuration->leaseTime);
+
+    configuration = std::move(newConfiguration);
+
+    if (leaseChanged)
+    {
+      openLease(*configuration);
+
+      if (lease && pollTimer->isActive())
+      {
+        renewLease();
+        leaseTimer->start();
+      };
     };
 
     TRACEEXIT;
   }
 
-  /// @brief      Function to start the poll mode.
+  /// @brief      Function to start the poll mode. The first poll is made after the startup delay, rather than after a full poll
+  ///             interval.
   /// @throws
+  /// @version    2026-10-19/GGB - Lease acquired before the first poll.
+  /// @version    2026-10-19/GGB - First poll made at start up.
   /// @version    2015-04-11/GGB - Function created.
 
   void CStateMachine::start()
   {
-    pollTimer->start();
+    int delay = startupDelay(*configuration);
+
+      // The lease is acquired before the poll timer is started, so the daemon holding it still waits for the startup delay.
+
+    if (lease)
+    {
+      renewLease();
+      leaseTimer->start();
+    };
+
+    LOGINFO("First poll in {} ms.", delay);
+    pollTimer->start(delay);
   }
 
-  /// @brief      Function to stop the polling timer.
+  /// @brief      Function to stop the polling timer. A poll in progress is cancelled by aborting the console connection, so that
+  ///             its transactions complete straight away, and is waited for before anything it uses is released. A renewal of
+  ///             the lease in progress is also waited for. The runtime state is then saved for the next start. The lease is
+  ///             released once nothing is being written, so the standby daemon takes over without waiting for the lease to
+  ///             expire. Only the first call has any effect.
+  /// @version    2026-10-19/GGB - Lease released after the poll and the renewal have completed.
+  /// @version    2026-10-19/GGB - Poll in progress cancelled and waited for.
+  /// @version    2026-10-19/GGB - Lease released.
+  /// @version    2026-10-19/GGB - Runtime state saved.
   /// @version    2015-04-11/GGB - Function created.
 
   void CStateMachine::stop()
   {
+    if (stopped)
+    {
+      return;
+    };
+
+    stopped = true;
     pollTimer->stop();
+    leaseTimer->stop();
+
+    if (pollTask && !pollTask->done())
+    {
+      LOGINFO("Poll in progress. Poll cancelled.");
+      tcpSocket->cancel();
+      if (replicator)
+      {
+        replicator->cancel();
+      };
+
+        // The poll is resumed from the event loop. A poll waiting for the database completes when the database call does.
+
+      while (!pollTask->done())
+      {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+      };
+    };
+    pollTask.reset();
+
+      // A renewal waiting for the database completes when the database call does.
+
+    while (leaseRenewing)
+    {
+      QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    };
+    leaseTask.reset();
+
+    if (lease)
+    {
+      leaseHeld = false;
+      lease->release().wait();
+    };
+    saveSnapshot();
   }
 
 } // namespace OCWS
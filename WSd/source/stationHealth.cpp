@@ -0,0 +1,181 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								StationHealth
+// SUBSYSTEM:						StateMachine
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Per station health (circuit breaker).
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/stationHealth.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+
+namespace WSd
+{
+  /// @brief      Constructor.
+  /// @param[in]  threshold: Number of consecutive failures that open the circuit.
+  /// @param[in]  initial: The backoff the first time the circuit opens.
+  /// @param[in]  maximum: The maximum backoff.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CStationHealth::CStationHealth(std::uint32_t threshold, duration initial, duration maximum)
+    : randomGenerator(std::random_device{}()), failureThreshold(threshold), initialBackoff(initial), maximumBackoff(maximum)
+  {
+  }
+
+  /// @brief      Calculates the backoff for the current open count. The backoff is doubled each time the circuit re-opens, up
+  ///             to the maximum, and a random jitter of up to half the backoff is subtracted.
+  /// @returns    The backoff period.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CStationHealth::duration CStationHealth::backoff()
+  {
+    duration period = initialBackoff;
+
+    for (std::uint32_t index = 1; (index < openCount) && (period < maximumBackoff); index++)
+    {
+      period *= 2;
+    };
+    period = std::min(period, maximumBackoff);
+
+    std::uniform_int_distribution<duration::rep> jitter(0, period.count() / 2);
+
+    return period - duration(jitter(randomGenerator));
+  }
+
+  /// @brief      Determines if a poll may be attempted. When the backoff of an open circuit has expired the state changes to
+  ///             half-open and probes are allowed until the outcome of a probe is recorded. (Polls of a station are never
+  ///             concurrent so only one probe is outstanding.)
+  /// @param[in]  now: The current time.
+  /// @returns    true if the poll should be attempted.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CStationHealth::allowAttempt(time_point now)
+  {
+    bool returnValue = true;
+
+    switch (state)
+    {
+      case SH_OPEN:
+      {
+        if (now >= nextAttempt)
+        {
+          state = SH_HALFOPEN;
+        }
+        else
+        {
+          returnValue = false;
+        };
+        break;
+      };
+      default:
+      {
+        break;
+      };
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Records a successful poll. The circuit is closed.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStationHealth::recordSuccess()
+  {
+    state = SH_HEALTHY;
+    consecutiveFailures = 0;
+    openCount = 0;
+  }
+
+  /// @brief      Records a failed poll.
+  /// @param[in]  now: The current time.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStationHealth::recordFailure(time_point now)
+  {
+    consecutiveFailures++;
+
+    if ( (state == SH_HALFOPEN) || (consecutiveFailures >= failureThreshold) )
+    {
+      state = SH_OPEN;
+      openCount++;
+      nextAttempt = now + backoff();
+    }
+    else
+    {
+      state = SH_DEGRADED;
+    };
+  }
+
+  /// @brief      Restores the state saved before a restart, so that a console that was failing is not polled again before its
+  ///             backoff has expired.
+  /// @param[in]  health: The state.
+  /// @param[in]  failures: The number of consecutive failures.
+  /// @param[in]  openings: The number of times the circuit has opened without a success.
+  /// @param[in]  next: The time the next attempt is allowed if the circuit is open.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CStationHealth::restore(EStationHealth health, std::uint32_t failures, std::uint32_t openings, time_point next)
+  {
+    state = health;
+    consecutiveFailures = failures;
+    openCount = openings;
+    nextAttempt = next;
+  }
+
+  /// @brief      Converts the health state to text.
+  /// @param[in]  health: The health state.
+  /// @returns    The text.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  char const *CStationHealth::healthText(EStationHealth health)
+  {
+    switch (health)
+    {
+      case SH_HEALTHY:
+        return "healthy";
+      case SH_DEGRADED:
+        return "degraded";
+      case SH_OPEN:
+        return "open";
+      case SH_HALFOPEN:
+        return "half-open";
+    };
+
+    return "unknown";
+  }
+
+} // namespace WSd
@@ -0,0 +1,211 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								stationSnapshot
+// SUBSYSTEM:						Station Snapshot
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt, WCL
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Snapshot of the runtime state of a station: the high-water mark of the database, the circuit breaker,
+//                      whether the console configuration has been checked and the daily tasks done. The snapshot is written after
+//                      each poll and when the daemon stops, and loaded when it starts, so a restarted daemon resumes polling where
+//                      it left off.
+//
+// HISTORY:             2026-10-19/GGB - Snapshot written with QSaveFile.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/stationSnapshot.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+
+  // Miscellaneous library header files
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <WCL>
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+    // Snapshot file: magic, version, the length of the identity (uint16) and the identity, the fields of the snapshot and the
+    // CRC of the fields (CRC-CCITT, big endian as used by the console). Integers are little endian.
+
+  static char const SNAPSHOT_MAGIC[4] = { 'W', 'S', 'D', 'S' };
+  static char const SNAPSHOT_VERSION = 1;
+  static qsizetype const SNAPSHOT_FIELDS = 8 + 1 + 2 + 2 + 1 + 4 + 4 + 8 + 1 + 4 + 1;
+
+  /// @brief      Appends a little endian integer.
+  /// @param[in]  data: The data to append to.
+  /// @param[in]  value: The value to append.
+  /// @param[in]  size: The size of the integer. (bytes)
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  static void appendInteger(QByteArray &data, std::uint64_t value, int size)
+  {
+    for (int index = 0; index < size; index++)
+    {
+      data.append(static_cast<char>((value >> (8 * index)) & 0xFF));
+    };
+  }
+
+  /// @brief      Reads a little endian integer.
+  /// @param[in]  data: The data to read from.
+  /// @param[in,out] offset: The offset of the integer. Advanced past the integer.
+  /// @param[in]  size: The size of the integer. (bytes)
+  /// @returns    The integer.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::uint64_t readInteger(QByteArray const &data, qsizetype &offset, int size)
+  {
+    std::uint64_t value = 0;
+
+    for (int index = 0; index < size; index++)
+    {
+      value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[offset + index])) << (8 * index);
+    };
+    offset += size;
+
+    return value;
+  }
+
+  /// @brief      Loads the snapshot of a station. A snapshot of a different identity, or of a different version, is discarded.
+  /// @param[in]  fileName: The snapshot file.
+  /// @param[in]  identity: The identity of the station, its console and its database.
+  /// @returns    true if the snapshot was loaded. The snapshot is unchanged if it was not loaded.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool SStationSnapshot::load(QString const &fileName, QString const &identity)
+  {
+    QFile file(fileName);
+    QByteArray data;
+    QByteArray identityData = identity.toUtf8();
+    qsizetype offset = sizeof(SNAPSHOT_MAGIC) + 3 + identityData.size();
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      return false;
+    };
+
+    data = file.readAll();
+
+    if ( (data.size() < static_cast<qsizetype>(sizeof(SNAPSHOT_MAGIC)) + 3) ||
+         !data.startsWith(QByteArray(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))) ||
+         (data[sizeof(SNAPSHOT_MAGIC)] != SNAPSHOT_VERSION) )
+    {
+      LOGINFO("Station snapshot {} is not valid. Discarded.", fileName.toStdString());
+      return false;
+    }
+    else
+    {
+      qsizetype identityOffset = sizeof(SNAPSHOT_MAGIC) + 1;
+
+      if ( (readInteger(data, identityOffset, 2) != static_cast<std::uint64_t>(identityData.size())) ||
+           (data.mid(identityOffset, identityData.size()) != identityData) )
+      {
+        LOGINFO("Station snapshot {} is of a different station, console or database. Discarded.", fileName.toStdString());
+        return false;
+      }
+      else if ( (data.size() != offset + SNAPSHOT_FIELDS + 2) ||
+                (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), offset, SNAPSHOT_FIELDS + 2) != 0) )
+      {
+        LOGINFO("Station snapshot {} is not valid. Discarded.", fileName.toStdString());
+        return false;
+      };
+    };
+
+    savedTime = static_cast<std::int64_t>(readInteger(data, offset, 8));
+    highWaterValid = (readInteger(data, offset, 1) != 0);
+    highWaterDate = static_cast<std::uint16_t>(readInteger(data, offset, 2));
+    highWaterTime = static_cast<std::uint16_t>(readInteger(data, offset, 2));
+    health = static_cast<EStationHealth>(std::min<std::uint64_t>(readInteger(data, offset, 1), SH_HALFOPEN));
+    failures = static_cast<std::uint32_t>(readInteger(data, offset, 4));
+    openCount = static_cast<std::uint32_t>(readInteger(data, offset, 4));
+    nextAttempt = static_cast<std::int64_t>(readInteger(data, offset, 8));
+    consoleValidated = (readInteger(data, offset, 1) != 0);
+    maintenanceDay = static_cast<std::int32_t>(readInteger(data, offset, 4));
+    timeUpdated = (readInteger(data, offset, 1) != 0);
+
+    return true;
+  }
+
+  /// @brief      Saves the snapshot of a station. The file is replaced atomically, so a snapshot interrupted by a crash leaves the
+  ///             previous snapshot in place. (QSaveFile writes a temporary file, syncs it and renames it over the snapshot.)
+  /// @param[in]  fileName: The snapshot file.
+  /// @param[in]  identity: The identity of the station, its console and its database.
+  /// @returns    true if the snapshot was saved.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Written with QSaveFile. (Remove and rename was not atomic and was not synced.)
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool SStationSnapshot::save(QString const &fileName, QString const &identity) const
+  {
+    QByteArray data;
+    QSaveFile file(fileName);
+    qsizetype fieldsOffset;
+    std::uint16_t CRC;
+
+    data.append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    data.append(SNAPSHOT_VERSION);
+    appendInteger(data, static_cast<std::uint16_t>(identity.toUtf8().size()), 2);
+    data.append(identity.toUtf8());
+
+    fieldsOffset = data.size();
+    appendInteger(data, static_cast<std::uint64_t>(savedTime), 8);
+    appendInteger(data, highWaterValid ? 1 : 0, 1);
+    appendInteger(data, highWaterDate, 2);
+    appendInteger(data, highWaterTime, 2);
+    appendInteger(data, health, 1);
+    appendInteger(data, failures, 4);
+    appendInteger(data, openCount, 4);
+    appendInteger(data, static_cast<std::uint64_t>(nextAttempt), 8);
+    appendInteger(data, consoleValidated ? 1 : 0, 1);
+    appendInteger(data, static_cast<std::uint32_t>(maintenanceDay), 4);
+    appendInteger(data, timeUpdated ? 1 : 0, 1);
+
+    CRC = WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), fieldsOffset, SNAPSHOT_FIELDS);
+    data.append(static_cast<char>(CRC >> 8));
+    data.append(static_cast<char>(CRC & 0xFF));
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit())
+    {
+      LOGERROR("Unable to write station snapshot {}.", fileName.toStdString());
+      return false;
+    };
+
+    return true;
+  }
+
+} // namespace WSd
@@ -0,0 +1,319 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								systemd
+// SUBSYSTEM:						Systemd
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Integration with systemd. Readiness, status and watchdog notifications are sent as datagrams to the notify
+//                      socket ($NOTIFY_SOCKET) and the listening sockets passed by socket activation ($LISTEN_FDS) are taken by
+//                      name. The protocol is implemented directly, libsystemd is not required. Without systemd all the functions do
+//                      nothing.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/systemd.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+  namespace systemd
+  {
+    int const LISTEN_FDS_START = 3;                 ///< First descriptor passed by socket activation. (SD_LISTEN_FDS_START)
+
+    static std::once_flag initialised;
+    static int notifyFD = -1;
+    static std::chrono::milliseconds watchdogTime(0);
+    static std::map<std::string, int> listenSockets;
+
+#ifdef __linux__
+    static sockaddr_un notifyAddress;
+    static socklen_t notifyAddressLength = 0;
+#endif
+
+    /// @brief      Parses a decimal environment variable.
+    /// @param[in]  name: The name of the variable.
+    /// @param[out] value: The value of the variable.
+    /// @returns    true if the variable is set and is a decimal number.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool environmentValue(char const *name, unsigned long long &value)
+    {
+      char const *text = std::getenv(name);
+      char *end;
+
+      if ( (text == nullptr) || (*text == 0) )
+      {
+        return false;
+      }
+      else
+      {
+        value = std::strtoull(text, &end, 10);
+        return (*end == 0);
+      };
+    }
+
+    /// @brief      Reads the systemd environment: the notify socket, the watchdog interval and the sockets passed by socket
+    ///             activation. The socket activation variables are removed from the environment so that they are not inherited
+    ///             by the processes started by the daemon. Only the first call has any effect.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void initialise()
+    {
+      std::call_once(initialised, []()
+      {
+#ifdef __linux__
+        unsigned long long value;
+        char const *socketName = std::getenv("NOTIFY_SOCKET");
+
+          // Notify socket. A path, or an abstract socket if it starts with '@'.
+
+        if ( (socketName != nullptr) && ((socketName[0] == '/') || (socketName[0] == '@')) &&
+             (std::strlen(socketName) < sizeof(notifyAddress.sun_path)) )
+        {
+          std::memset(&notifyAddress, 0, sizeof(notifyAddress));
+          notifyAddress.sun_family = AF_UNIX;
+          std::memcpy(notifyAddress.sun_path, socketName, std::strlen(socketName));
+          notifyAddressLength = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + std::strlen(socketName));
+
+          if (notifyAddress.sun_path[0] == '@')
+          {
+            notifyAddress.sun_path[0] = 0;
+          };
+
+          notifyFD = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        };
+
+          // Watchdog. WATCHDOG_PID is optional, if it is set the watchdog is only for that process.
+
+        if ( (notifyFD >= 0) && environmentValue("WATCHDOG_USEC", value) && (value != 0) )
+        {
+          unsigned long long pid;
+
+          if (!environmentValue("WATCHDOG_PID", pid) || (pid == static_cast<unsigned long long>(::getpid())))
+          {
+            watchdogTime = std::chrono::milliseconds(std::max<unsigned long long>(1, value / 1000));
+          };
+        };
+
+          // Socket activation. The sockets are named with FileDescriptorName= in the socket unit.
+
+        unsigned long long pid, count;
+
+        if ( environmentValue("LISTEN_PID", pid) && (pid == static_cast<unsigned long long>(::getpid())) &&
+             environmentValue("LISTEN_FDS", count) )
+        {
+          std::string names = std::getenv("LISTEN_FDNAMES") ? std::getenv("LISTEN_FDNAMES") : "";
+
+          for (unsigned long long index = 0; index < count; index++)
+          {
+            int descriptor = LISTEN_FDS_START + static_cast<int>(index);
+            std::size_t separator = names.find(':');
+            std::string name = names.substr(0, separator);
+
+            names = (separator == std::string::npos) ? std::string() : names.substr(separator + 1);
+
+            ::fcntl(descriptor, F_SETFD, FD_CLOEXEC);
+
+            if (name.empty() || listenSockets.contains(name))
+            {
+              LOGWARNING("Socket {} passed by systemd has no name or a duplicate name. Ignored.", descriptor);
+            }
+            else
+            {
+              listenSockets[name] = descriptor;
+            };
+          };
+        };
+
+        ::unsetenv("LISTEN_PID");
+        ::unsetenv("LISTEN_FDS");
+        ::unsetenv("LISTEN_FDNAMES");
+#endif
+      });
+    }
+
+    /// @brief      Determines if the daemon has been started by systemd. (There is a notify socket or sockets have been passed.)
+    /// @returns    true if started by systemd.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool supervised()
+    {
+      initialise();
+
+      return ( (notifyFD >= 0) || !listenSockets.empty() );
+    }
+
+    /// @brief      Sends a notification to systemd. The state is one or more newline separated assignments. (eg "READY=1")
+    /// @param[in]  state: The state to send.
+    /// @returns    true if the notification was sent.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool notify(std::string const &state)
+    {
+      initialise();
+
+#ifdef __linux__
+      if (notifyFD < 0)
+      {
+        return false;
+      }
+      else
+      {
+        return (::sendto(notifyFD, state.data(), state.size(), MSG_NOSIGNAL, reinterpret_cast<sockaddr const *>(&notifyAddress),
+                         notifyAddressLength) == static_cast<ssize_t>(state.size()));
+      };
+#else
+      return false;
+#endif
+    }
+
+    /// @brief      Tells systemd that the start up has completed.
+    /// @param[in]  text: The status shown by systemctl status.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void ready(std::string const &text)
+    {
+      std::string state = "READY=1\nSTATUS=" + text;
+
+#ifdef __linux__
+      state += "\nMAINPID=" + std::to_string(::getpid());
+#endif
+
+      notify(state);
+    }
+
+    /// @brief      Sets the status shown by systemctl status.
+    /// @param[in]  text: The status.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void status(std::string const &text)
+    {
+      notify("STATUS=" + text);
+    }
+
+    /// @brief      Tells systemd that the configuration is being reloaded. READY=1 is sent when the reload is complete.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void reloading()
+    {
+#ifdef __linux__
+      timespec now;
+
+      ::clock_gettime(CLOCK_MONOTONIC, &now);
+
+        // MONOTONIC_USEC is required by Type=notify-reload.
+
+      notify("RELOADING=1\nSTATUS=Reloading configuration.\nMONOTONIC_USEC=" +
+             std::to_string(static_cast<unsigned long long>(now.tv_sec) * 1000000 + now.tv_nsec / 1000));
+#endif
+    }
+
+    /// @brief      Tells systemd that the daemon is stopping.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void stopping()
+    {
+      notify("STOPPING=1\nSTATUS=Stopping.");
+    }
+
+    /// @brief      Resets the watchdog timer of systemd.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    void watchdog()
+    {
+      notify("WATCHDOG=1");
+    }
+
+    /// @brief      Returns the watchdog interval of the service. (WatchdogSec=) The watchdog should be reset at half the interval.
+    /// @returns    The interval. Zero if the watchdog is not enabled.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    std::chrono::milliseconds watchdogInterval()
+    {
+      initialise();
+
+      return watchdogTime;
+    }
+
+    /// @brief      Returns a socket passed by socket activation. The passed socket is kept open for the life of the process and a
+    ///             duplicate is returned, so the server using it can be closed and recreated (eg on a configuration reload) without
+    ///             losing the socket or the connections waiting on it.
+    /// @param[in]  name: The name of the socket. (FileDescriptorName= of the socket unit)
+    /// @returns    A duplicate of the socket, owned by the caller. -1 if no socket of that name was passed.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    int listenSocket(std::string const &name)
+    {
+      initialise();
+
+#ifdef __linux__
+      auto iterator = listenSockets.find(name);
+
+      if (iterator == listenSockets.end())
+      {
+        return -1;
+      }
+      else
+      {
+        return ::fcntl(iterator->second, F_DUPFD_CLOEXEC, LISTEN_FDS_START);
+      };
+#else
+      return -1;
+#endif
+    }
+
+  } // namespace systemd
+} // namespace WSd
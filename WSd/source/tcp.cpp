@@ -34,420 +34,931 @@
 
   // Standard C++ library header files
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <ctime>
-#include <thread>
+#include <vector>
 
   // Miscellaneous library header files
 
 #include <ACL>
+#include <QDateTime>
 #include <WCL>
 
+  // WSd header files
+
+#include "include/logger.h"
+#include "include/tracer.h"
+#include "include/transaction.h"
+#include "include/weatherDatabase.h"
+
 namespace WSd
 {
 
-  CTCPSocket::CTCPSocket(QObject *parent, std::uint32_t sid, std::uint32_t iid)
-    : siteID(sid), instrumentID(iid), QTcpSocket(parent)
+  /// @brief      Constructor for the socket.
+  /// @param[in]  parent: The parent object.
+  /// @param[in]  sid: The site ID.
+  /// @param[in]  iid: The instrument ID.
+  /// @param[in]  station: The console connection settings.
+  /// @version    2026-10-19/GGB - Disconnections recorded in the capture file.
+  /// @version    2026-10-19/GGB - Connection settings passed from the configuration snapshot.
+  /// @version    2015-05-17/GGB - Function created.
+
+  CTCPSocket::CTCPSocket(QObject *parent, std::uint32_t sid, std::uint32_t iid,
+                         configuration::SStationConfiguration const &station)
+    : QTcpSocket(parent), siteID(sid), instrumentID(iid), ipAddress(station.ipAddress), port(station.port)
   {
-    ipAddress = WCL::settings::settings.value(WCL::settings::WS_IPADDRESS, "192.168.8.129").toString();
-    port = WCL::settings::settings.value(WCL::settings::WS_PORT, 22222).toInt();
+    connect(this, &QAbstractSocket::disconnected, this, [this]()
+    {
+      if (capture)
+      {
+        capture->record(CWireCapture::WR_DISCONNECT, nullptr, 0);
+      };
+    });
   }
 
-  /// @brief Command to request the start and end archive pointers from the WeatherLinkIP module.
-  /// @throws
-  /// @version 2015-05-17/GGB - Function created.
+  /// @brief      Destructor. The connection is closed while the capture file is still open.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
 
-  bool CTCPSocket::readArchive()
+  CTCPSocket::~CTCPSocket()
   {
-    char command[WCL::WL_MTU];
-    size_t index;
-    std::uint16_t date;
-    std::uint16_t time;
+    abort();
+  }
+
+  /// @brief      Applies new console connection settings. Any connection that is open to the old address is aborted, the next
+  ///             transaction connects to the new address.
+  /// @param[in]  station: The new connection settings.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - High-water mark read again from the database.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTCPSocket::reconfigure(configuration::SStationConfiguration const &station)
+  {
+    if ( (station.siteID != siteID) || (station.instrumentID != instrumentID) )
+    {
+      highWaterValid = false;
+    };
+
+    siteID = station.siteID;
+    instrumentID = station.instrumentID;
+
+    if ( (station.ipAddress != ipAddress) || (station.port != port) )
+    {
+      LOGINFO("Console address changed to {}:{}.", station.ipAddress.toStdString(), station.port);
+      abort();
+      ipAddress = station.ipAddress;
+      port = station.port;
+    };
+  }
+
+  /// @brief      Reads the high-water mark (the last record of the station) from the database. After that the high-water mark is
+  ///             advanced by the records written by each download, so the database is not queried on every poll.
+  ///             The query runs on the database thread while the coroutine is suspended.
+  /// @returns    true if the database has a record of the station.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Converted to a coroutine. The query is awaited.
+  /// @version    2026-10-19/GGB - Function created from readArchive().
+
+  CTask<bool> CTCPSocket::loadHighWater()
+  {
+    std::uint16_t date = 0;
+    std::uint16_t time = 0;
     struct std::tm timeDate;
-    std::uint16_t CRC;
-    bool returnValue = false;
-    bool exitWhile;
-    int loopCount;
-    qint64 dataLength;
-    int recordCount = 0;
+    bool recordFound;
 
-    DEBUGMESSAGE("Reading last weather record.");
-    WCL::database.lastWeatherRecord(siteID, instrumentID, date, time);
+    LOGDEBUG("Reading last weather record.");
+    {
+      TRACESPAN("lastWeatherRecord");
+      recordFound = co_await weatherDatabase::executeAsync([sid = siteID, iid = instrumentID, &date, &time]()
+      {
+        return weatherDatabase::lastWeatherRecord(sid, iid, date, time);
+      });
+    }
 
     ACL::TJD JD = ACL::TJD(static_cast<ACL::FP_t>(date) + ACL::MJD0);
 
-    if (JD.gregorianDate(&timeDate))
+    if (recordFound && JD.gregorianDate(&timeDate))
     {
-      date = timeDate.tm_mday + (timeDate.tm_mon + 1) * 32 + (timeDate.tm_year - 100) * 512;
+      highWaterDate = timeDate.tm_mday + (timeDate.tm_mon + 1) * 32 + (timeDate.tm_year - 100) * 512;
+      highWaterTime = time;
     }
     else
     {
-      date = 0;
-      time = 0;
+      highWaterDate = 0;
+      highWaterTime = 0;
     };
+    highWaterValid = true;
+
+    co_return recordFound;
+  }
+
+  /// @brief      Returns the high-water mark.
+  /// @param[out] date: The date of the last record in the database. (Console format, 0 if there are no records.)
+  /// @param[out] time: The time of the last record in the database. (HHMM)
+  /// @returns    true if the high-water mark is known.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTCPSocket::highWater(std::uint16_t &date, std::uint16_t &time) const
+  {
+    date = highWaterDate;
+    time = highWaterTime;
+
+    return highWaterValid;
+  }
+
+  /// @brief      Sets the high-water mark. (eg from the snapshot saved before a restart.)
+  /// @param[in]  date: The date of the last record in the database. (Console format, 0 if there are no records.)
+  /// @param[in]  time: The time of the last record in the database. (HHMM)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
 
+  void CTCPSocket::setHighWater(std::uint16_t date, std::uint16_t time)
+  {
+    highWaterDate = date;
+    highWaterTime = time;
+    highWaterValid = true;
+  }
+
+  /// @brief      Sets probe mode. In probe mode the console is given a single wakeup attempt and a short connect timeout so that
+  ///             an unresponsive console costs as little as possible.
+  /// @param[in]  probe: true to enable probe mode.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTCPSocket::setProbeMode(bool probe)
+  {
+    wakeupAttempts = probe ? 1 : WAKEUP_ATTEMPTS;
+    connectTimeout = probe ? PROBE_CONNECT_TIMEOUT : CONNECT_TIMEOUT;
+  }
+
+  /// @brief      Starts or stops capturing the traffic with the console. The capture file is opened for appending.
+  /// @param[in]  fileName: The capture file. Empty to stop capturing.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTCPSocket::setCapture(QString const &fileName)
+  {
+    if (fileName.isEmpty())
+    {
+      capture.reset();
+    }
+    else if (!capture || (capture->fileName() != fileName))
+    {
+      capture = std::make_unique<CWireCapture>(fileName);
+
+      if (capture->open())
+      {
+        LOGINFO("Console traffic captured to {}.", fileName.toStdString());
+      }
+      else
+      {
+        capture.reset();
+      };
+    };
+  }
+
+  /// @brief      Sets the file the console configuration is cached in and loads the cached configuration. The cache is keyed by
+  ///             the station and the address of the console. The configuration is checked against the console when the archive
+  ///             is next read.
+  /// @param[in]  fileName: The cache file.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTCPSocket::setConsoleCache(QString const &fileName)
+  {
+    console.setCache(fileName, QString("%1-%2 %3:%4").arg(siteID).arg(instrumentID).arg(ipAddress).arg(port));
+    consoleValidated = false;
+  }
+
+  /// @brief      Sets the time the raw radio packets are captured for (STRMON) each time the console diagnostics are read.
+  /// @param[in]  seconds: The capture time. (s, 0 to disable, at most 60)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTCPSocket::setRadioMonitor(std::uint32_t seconds)
+  {
+    radioMonitorTime = std::min(seconds, MAX_RADIO_MONITOR);
+  }
+
+  /// @brief      Cancels the transactions with the console (eg the daemon is stopping). The connection is aborted, so a transaction
+  ///             waiting for the console completes straight away, and the console is not connected again.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTCPSocket::cancel()
+  {
+    cancelled = true;
     abort();
-    connectToHost(ipAddress, port);
+  }
+
+  /// @brief      Writes data to the socket. The data is recorded in the capture file.
+  /// @param[in]  data: The data to write.
+  /// @param[in]  size: The number of bytes to write.
+  /// @returns    The number of bytes written, -1 on error.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  qint64 CTCPSocket::writeData(char const *data, qint64 size)
+  {
+    qint64 returnValue = QTcpSocket::writeData(data, size);
+
+    if (capture && (returnValue > 0))
+    {
+      capture->record(CWireCapture::WR_SENT, data, returnValue);
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Records data read from the console in the capture file. The data is recorded when it is consumed by the
+  ///             transaction, so the time of the record includes the wait for the console.
+  /// @param[in]  data: The data read.
+  /// @returns    data
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  QByteArray CTCPSocket::received(QByteArray data)
+  {
+    if (capture && !data.isEmpty())
+    {
+      capture->record(CWireCapture::WR_RECEIVED, data.constData(), data.size());
+    };
+
+    return data;
+  }
+
+  /// @brief      Connects to the console and wakes it up. Each step is awaited, so the thread is not blocked while waiting for
+  ///             the console.
+  /// @param[in]  transaction: The name of the transaction. (Recorded in the capture file.)
+  /// @returns    true if the console is awake.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Not connected once the transactions have been cancelled.
+  /// @version    2026-10-19/GGB - Console configuration checked again after a failed connection.
+  /// @version    2026-10-19/GGB - Connection recorded in the capture file.
+  /// @version    2026-10-19/GGB - Function created from the common code of the transactions.
+
+  CTask<bool> CTCPSocket::connectAndWake(QByteArray const &transaction)
+  {
+    bool returnValue = false;
+    bool connected;
+
+    if (cancelled)
+    {
+      co_return false;
+    };
 
-    if (waitForConnected(1000))
     {
-      index = 0;
-      command[index++] = WCL::wlLF;
+      TRACESPAN("connect");
+      connected = co_await CConnectAwaiter(*this, ipAddress, port, connectTimeout);
+    }
 
-      loopCount = 0;
-      exitWhile = false;
+    if (connected)
+    {
+      TRACESPAN("wakeup");
 
-      while ((loopCount < 3) && !exitWhile)
+      if (capture)
       {
-        writeData(command, index);
-        if (waitForReadyRead(1000))
-        {
-          readData(static_cast<char *>(command), WCL::WL_MTU);
-          exitWhile = true;
-        }
-        else
-        {
-          loopCount++;
-        };
+        capture->record(CWireCapture::WR_CONNECT, transaction.constData(), transaction.size());
       };
 
-      if (loopCount < 3)
+      for (int loopCount = 0; (loopCount < wakeupAttempts) && !returnValue; loopCount++)
       {
-        for (index = 0; index < sizeof(WCL::commandDMPAFT); index++)
-        {
-          command[index] = WCL::commandDMPAFT[index];
-        };
-        command[index++] = WCL::wlLF;
+        write(QByteArray(1, static_cast<char>(WCL::wlLF)));
 
-        writeData(command, index);
+        QByteArray response = received(co_await CReadAwaiter(*this, 2, WAKEUP_TIMEOUT));      // "\n\r"
 
-        if (waitForReadyRead(5000))
-        {
-          dataLength = readData(static_cast<char *>(command), WCL::WL_MTU);
-          index = 0;
-          command[index++] = reinterpret_cast<char *>(&date)[0];
-          command[index++] = reinterpret_cast<char *>(&date)[1];
-          command[index++] = reinterpret_cast<char *>(&time)[0];
-          command[index++] = reinterpret_cast<char *>(&time)[1];
-
-          CRC = WCL::calculateCRC(reinterpret_cast<uint8_t *>(&command), 0, 4);
-          command[index++] = reinterpret_cast<char *>(&CRC)[1];
-          command[index++] = reinterpret_cast<char *>(&CRC)[0];
-          writeData(command, index);
-
-          if (waitForReadyRead(5000))
-          {
-            dataLength = readData(static_cast<char *>(command), WCL::WL_MTU);
+        returnValue = !response.isEmpty();
+      };
 
-            if (dataLength == 7 && command[0] == WCL::wlACK)
-            {
-              WCL::SDMPAFTResponse *response = reinterpret_cast<WCL::SDMPAFTResponse *>(command + 1);
+      if (!returnValue)
+      {
+        LOGERROR("No response from WeatherLinkIP module.");
+        disconnectFromHost();
+      };
+    }
+    else
+    {
+      LOGERROR("Unable to connect to WeatherLinkIP module.");
+    };
 
-              std::uint16_t pageCount = response->pages;
-              std::uint8_t firstRecord = response->firstRecord;
+      // The console may have been set up differently while it was not reachable.
 
-              DEBUGMESSAGE("Reading: " + std::to_string(pageCount) + " Pages from WeatherView.");
+    if (!returnValue)
+    {
+      consoleValidated = false;
+    };
 
-              while (pageCount > 0)
-              {
-                index = 0;
-                command[index++] = WCL::wlACK;
-                writeData(command, index);
-
-                if (waitForReadyRead(5000))
-                {
-                  dataLength = readData(static_cast<char *>(command), WCL::WL_MTU);
-                  WCL::SDumpPage *dataResponse = reinterpret_cast<WCL::SDumpPage *>(command);
-
-                  for (index = firstRecord; index < 5; index++)
-                  {
-                    if (WCL::database.insertRecord(siteID, instrumentID, dataResponse->record[index]))
-                    {
-                      recordCount++;
-                    };
-                  };
-                  firstRecord = 0;
-                }
-                else
-                {
-                  break;
-                };
-              };
+    co_return returnValue;
+  }
 
-                // All records processed.
+  /// @brief      Sends a command to an awake console and waits for the ACK. If data is supplied, it is sent after the command
+  ///             has been acknowledged and must also be acknowledged.
+  /// @param[in]  command: The command (without the line feed).
+  /// @param[in]  data: The data to send after the command. (Including the CRC.) May be empty.
+  /// @returns    true if the console acknowledged the command (and data).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Responses recorded in the capture file.
+  /// @version    2026-10-19/GGB - Function created.
 
-              if (pageCount == 0)
-              {
-                returnValue = true;
-              };
+  CTask<bool> CTCPSocket::sendCommand(QByteArray command, QByteArray data)
+  {
+    bool returnValue = false;
+    QByteArray response;
 
-              DEBUGMESSAGE("Completed Reading Pages from WeatherView.");
+    command.append(static_cast<char>(WCL::wlLF));
+    write(command);
 
-              INFOMESSAGE(std::to_string(recordCount) + " records written to database.");
-            };
-          }
-          else
-          {
-            ERRORMESSAGE("No response from WeatherLinkIP module.");
-          };
-        }
-        else
-        {
-          ERRORMESSAGE("No response from WeatherLinkIP module.");
-        };
+    response = received(co_await CReadAwaiter(*this, 1, RESPONSE_TIMEOUT));
+
+    if ( (response.size() == 1) && (response[0] == static_cast<char>(WCL::wlACK)) )
+    {
+      if (data.isEmpty())
+      {
+        returnValue = true;
       }
       else
       {
-        ERRORMESSAGE("No response from WeatherLinkIP module.");
+        write(data);
+
+        response = received(co_await CReadAwaiter(*this, 1, RESPONSE_TIMEOUT));
+        returnValue = ( (response.size() == 1) && (response[0] == static_cast<char>(WCL::wlACK)) );
       };
+    };
 
-      disconnectFromHost();
-    }
-    else
+    co_return returnValue;
+  }
+
+  /// @brief      Reads the configuration area of the console EEPROM (EEBRD) and updates the cached configuration. The console has
+  ///             no command that returns only a checksum, so the area (178 bytes) is read and compared with the cache. This is
+  ///             only done after (re)connecting to the console.
+  /// @returns    true if the configuration was read.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<bool> CTCPSocket::readConsoleConfiguration()
+  {
+    QByteArray command("EEBRD ");
+    bool returnValue = false;
+
+    command.append(QByteArray::number(CConsoleConfiguration::EEPROM_ADDRESS, 16).rightJustified(2, '0').toUpper());
+    command.append(' ');
+    command.append(QByteArray::number(CConsoleConfiguration::EEPROM_SIZE, 16).rightJustified(2, '0').toUpper());
+
+    if (co_await sendCommand(command, QByteArray()))
     {
-      ERRORMESSAGE("Unable to connect to WeatherLinkIP module.");
+      QByteArray response = received(co_await CReadAwaiter(*this, CConsoleConfiguration::EEPROM_SIZE + 2, RESPONSE_TIMEOUT));
+
+      if ( (response.size() == CConsoleConfiguration::EEPROM_SIZE + 2) &&
+           (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(response.data()), 0, response.size()) == 0) )
+      {
+        console.update(response);
+        consoleValidated = true;
+        returnValue = true;
+      };
     };
 
-    return returnValue;
+    if (!returnValue)
+    {
+      LOGWARNING("Console configuration not read from WeatherLinkIP module.");
+    };
+
+    co_return returnValue;
   }
 
-  /// @brief    Sets the time on the weather station.
-  /// @throws
-  /// @version  2015-06-04/GGB - Function created.
+  /// @brief      Reads a line of a text response. The console ends lines with "\n\r".
+  /// @param[in]  timeout: The time to wait for each byte. (ms)
+  /// @returns    The line, including the line end. A partial line if the console stopped sending, empty if nothing was received.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
 
-  bool CTCPSocket::setTime()
+  CTask<QByteArray> CTCPSocket::readLine(int timeout)
   {
-    std::time_t time = std::time(&time);
-    struct tm *currentTime = std::localtime(&time);
-    char command[WCL::WL_MTU];
-    size_t index;
-    bool exitWhile = false;
-    int loopCount = 0;
-    std::uint16_t CRC;
-    qint64 dataLength;
+    QByteArray line;
+
+    while (!line.endsWith("\n\r") && (line.size() < MAX_LINE_SIZE))
+    {
+      QByteArray byte = co_await CReadAwaiter(*this, 1, timeout);
+
+      if (byte.isEmpty())
+      {
+        break;
+      };
+
+      line.append(byte);
+    };
+
+    co_return received(line);
+  }
+
+  /// @brief      Reads the console diagnostics (RXCHECK) and adds them to the reception log. The radio packets are then captured
+  ///             (STRMON) if a capture time has been set. Runs on the connection of the archive download, after the download has
+  ///             completed.
+  /// @param[in]  reception: The reception log of the station.
+  /// @returns    true if the diagnostics were read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<bool> CTCPSocket::readReception(CReceptionLog &reception)
+  {
+    SReceptionSample sample;
     bool returnValue = false;
 
-    abort();
-    connectToHost(ipAddress, port);
-    if (waitForConnected(1000))
     {
-      index = 0;
-      command[index++] = WCL::wlLF;
+      TRACESPAN("RXCHECK");
 
-      loopCount = 0;
-      exitWhile = false;
+      write("RXCHECK\n");
 
-      while ((loopCount < 3) && !exitWhile)
+        // The response is "\n\rOK\n\r" followed by the counters on a line of their own.
+
+      for (int lineCount = 0; (lineCount < 4) && !returnValue; lineCount++)
       {
-        writeData(command, index);
-        if (waitForReadyRead(1000))
-        {
-          auto bytesRead = readData(static_cast<char *>(command), WCL::WL_MTU);
-          if (bytesRead != 0)
-          {
-            exitWhile = true;
-          }
-          else
-          {
-            loopCount++;
-          }
-        }
-        else
+        QByteArray line = co_await readLine(RESPONSE_TIMEOUT);
+
+        if (line.isEmpty())
         {
-          loopCount++;
+          break;
         };
+
+        returnValue = CReceptionLog::parseRXCHECK(line, sample);
+      };
+    }
+
+    if (returnValue)
+    {
+      sample.timeStamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count();
+      reception.add(sample);
+
+      LOGDEBUG("Console diagnostics: {} packets, {} missed, {} resyncs, {} CRC errors.", sample.packets, sample.missed,
+               sample.resyncs, sample.crcErrors);
+
+      if (radioMonitorTime != 0)
+      {
+        co_await monitorRadio(reception);
+      };
+    }
+    else
+    {
+      LOGWARNING("Console diagnostics not read from WeatherLinkIP module.");
+    };
+
+    co_return returnValue;
+  }
+
+  /// @brief      Captures the raw packets received by the console (STRMON) for the capture time and adds them to the reception
+  ///             log. Each byte of a packet is sent on a line of its own; a packet is kept once all eight bytes have been
+  ///             received. The console leaves STRMON when it receives any character.
+  /// @param[in]  reception: The reception log of the station.
+  /// @returns    The number of packets captured.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<std::size_t> CTCPSocket::monitorRadio(CReceptionLog &reception)
+  {
+    std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now() + std::chrono::seconds(radioMonitorTime);
+    std::vector<SRadioPacket> packets;
+    SRadioPacket packet;
+    unsigned int bytesReceived = 0;                   // Bit mask of the bytes of the packet received.
+
+    TRACESPAN("STRMON");
+
+    write("STRMON\n");
+
+    for (;;)
+    {
+      long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(endTime -
+                                                                                  std::chrono::steady_clock::now()).count();
+      std::uint8_t value;
+      int index;
+
+      if (remaining <= 0)
+      {
+        break;
       };
 
-      if (loopCount < 3)
+      QByteArray line = co_await readLine(static_cast<int>(remaining));
+
+      if (line.isEmpty())
       {
-        for (index = 0; index < sizeof(WCL::commandSETTIME); index++)
+        break;
+      };
+
+      if ((index = CReceptionLog::parseSTRMON(line, value)) >= 0)
+      {
+        if (index == 0)
         {
-          command[index] = WCL::commandSETTIME[index];
+          packet.timeStamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch()).count();
+          bytesReceived = 0;
         };
-        command[index++] = WCL::wlLF;
-        writeData(command, index);
 
-        if (waitForReadyRead(5000))
-        {
-          dataLength = readData(static_cast<char *>(command), WCL::WL_MTU);
-          index = 0;
-          command[index++] = static_cast<uint8_t>(currentTime->tm_sec);
-          command[index++] = static_cast<uint8_t>(currentTime->tm_min);
-          command[index++] = static_cast<uint8_t>(currentTime->tm_hour);
-          command[index++] = static_cast<uint8_t>(currentTime->tm_mday);
-          command[index++] = static_cast<uint8_t>(currentTime->tm_mon + 1);
-          command[index++] = static_cast<uint8_t>(currentTime->tm_year);
-
-          CRC = WCL::calculateCRC(reinterpret_cast<uint8_t *>(&command), 0, 6);
-          command[index++] = reinterpret_cast<char *>(&CRC)[1];
-          command[index++] = reinterpret_cast<char *>(&CRC)[0];
-          writeData(command, index);
-          if (waitForReadyRead(5000))
-          {
-            dataLength = readData(static_cast<char *>(command), WCL::WL_MTU);
-            if (dataLength == 1 && command[0] == WCL::wlACK)
-            {
-              returnValue = true;
-            };
-          };
+        packet.data[index] = value;
+        bytesReceived |= 1u << index;
 
+        if (bytesReceived == 0xFF)
+        {
+          packets.push_back(packet);
+          bytesReceived = 0;
         };
       };
     };
 
-    if (returnValue)
-    {
-      INFOMESSAGE("Console time updated.");
-    }
-    else
+    write("\n");
+
+    reception.add(packets);
+    LOGDEBUG("{} radio packets captured.", packets.size());
+
+    co_return packets.size();
+  }
+
+  /// @brief      Reads the current conditions (one LOOP packet) and checks them against the alert rules of the station. Runs on
+  ///             the connection of the archive download, after the download has completed.
+  /// @param[in]  ingest: The ingest pipeline of the station.
+  /// @returns    true if the packet was read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTask<bool> CTCPSocket::readLoop(CIngest &ingest)
+  {
+    bool returnValue = false;
+
+    TRACESPAN("LOOP");
+
+    if (co_await sendCommand("LOOP 1", QByteArray()))
     {
-      if (loopCount < 3)
-      {
-        INFOMESSAGE("Console time not updated.");
-      }
-      else
+      QByteArray packet = received(co_await CReadAwaiter(*this, LOOP_PACKET_SIZE, RESPONSE_TIMEOUT));
+
+      if ( (packet.size() == static_cast<qsizetype>(LOOP_PACKET_SIZE)) &&
+           (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(packet.data()), 0, LOOP_PACKET_SIZE) == 0) )
       {
-        ERRORMESSAGE("Unable to connect to console.");
-      }
+        QDateTime now = QDateTime::currentDateTime();
+        SArchiveRecord conditions;
 
-    }
+          // The packet has no time. It is the time of the console, taken as the local time.
 
-    return returnValue;
+        if (conditions.decodeLoop(reinterpret_cast<std::uint8_t const *>(packet.constData()),
+                                  SArchiveRecord::makeTimeStamp(now.date().year(), now.date().month(), now.date().day(),
+                                                                now.time().hour(), now.time().minute()) + now.time().second()))
+        {
+          ingest.checkAlerts(conditions);
+          returnValue = true;
+        };
+      };
+    };
+
+    if (!returnValue)
+    {
+      LOGWARNING("Current conditions not read from WeatherLinkIP module.");
+    };
+
+    co_return returnValue;
   }
 
-  /// @brief      Set the logging interval of the logger.
-  /// @param[in]  period: The logging period to set.
-  /// @returns    true if succesfull.
-  /// @version    2020-10-25/GGB - Function created.
+  /// @brief Downloads the archive records after the last record in the database (DMPAFT) and passes them to the ingest pipeline.
+  ///        When a reception log is given the console diagnostics are read on the same connection after the download.
+  /// @param[in] ingest: The ingest pipeline of the station.
+  /// @param[in] reception: The reception log of the station. nullptr if the diagnostics are not due.
+  /// @throws
+  /// @version 2026-10-19/GGB - Current conditions checked against the alert rules after the download. Archive period passed to
+  ///                           the ingest pipeline.
+  /// @version 2026-10-19/GGB - Download abandoned when the ingest pipeline can no longer write. (Lease lost)
+  /// @version 2026-10-19/GGB - Records and the high-water mark written to the database without blocking the event loop.
+  /// @version 2026-10-19/GGB - Store written once per download. First download started from the latest record in the store.
+  /// @version 2026-10-19/GGB - High-water mark not advanced past a record that was not stored.
+  /// @version 2026-10-19/GGB - Console diagnostics read after the download.
+  /// @version 2026-10-19/GGB - Download starts from the high-water mark, advanced by the records written.
+  /// @version 2026-10-19/GGB - Console configuration checked after connecting. Rain converted using the rain collector size.
+  /// @version 2026-10-19/GGB - Traffic recorded in the capture file.
+  /// @version 2026-10-19/GGB - Last record read through weatherDatabase. (Whole archive downloaded if there is none.)
+  /// @version 2026-10-19/GGB - Records passed to the ingest pipeline.
+  /// @version 2026-10-19/GGB - Converted to a coroutine. Pages are checked by CRC and requested again if corrupted.
+  /// @version 2026-10-19/GGB - Page count decremented so that the download completes after the last page.
+  /// @version 2026-10-19/GGB - Wakeup attempts and connect timeout reduced when probing an unhealthy console.
+  /// @version 2026-10-19/GGB - Trace spans added.
+  /// @version 2026-10-19/GGB - Messages written through the asynchronous logger.
+  /// @version 2015-05-17/GGB - Function created.
 
-  bool CTCPSocket::setInterval(std::uint8_t period)
+  CTask<bool> CTCPSocket::readArchive(CIngest &ingest, CReceptionLog *reception)
   {
-    char command[WCL::WL_MTU];
-    size_t index;
-    bool exitWhile = false;
-    int loopCount = 0;
-    qint64 dataLength;
+    QByteArray command;
+    std::uint16_t date;
+    std::uint16_t time;
+    std::uint16_t CRC;
     bool returnValue = false;
+    std::size_t recordCount = 0;
 
-    abort();
-    connectToHost(ipAddress, port);
-    if (waitForConnected(1000))
+    TRACESPAN("readArchive");
+
+    if (!highWaterValid)
     {
-      index = 0;
-      command[index++] = WCL::wlLF;
+      co_await loadHighWater();
+    };
+    date = highWaterDate;
+    time = highWaterTime;
 
-      loopCount = 0;
-      exitWhile = false;
+      // The local store is written once per download. Records that reached the database but not the store before a restart
+      // are downloaded again, by starting the first download from the latest record in the store.
 
-        // Try to wake the console up.
+    if (!storeChecked)
+    {
+      std::uint16_t storeDate;
+      std::uint16_t storeTime;
 
-      while ((loopCount < 3) && !exitWhile)
+      if (ingest.latestStored(storeDate, storeTime) && ((storeDate < date) || ((storeDate == date) && (storeTime < time))))
       {
-        writeData(command, index);
-        if (waitForReadyRead(1000))
-        {
-          auto bytesRead = readData(static_cast<char *>(command), WCL::WL_MTU);
-          if (bytesRead != 0)
-          {
-            exitWhile = true;
-          }
-          else
-          {
-            loopCount++;
-          }
-        }
-        else
-        {
-          loopCount++;
-        };
+        date = storeDate;
+        time = storeTime;
+      };
+    };
+
+    ingest.startDownload();
+
+    if (co_await connectAndWake("readArchive"))
+    {
+      bool acknowledged;
+
+      if (!consoleValidated)
+      {
+        TRACESPAN("EEBRD");
+        co_await readConsoleConfiguration();
+      };
+      ingest.setArchivePeriod(console.archivePeriod() * 60);
+
+      for (std::size_t index = 0; index < sizeof(WCL::commandDMPAFT); index++)
+      {
+        command.append(static_cast<char>(WCL::commandDMPAFT[index]));
       };
 
-      if (loopCount < 3)
       {
-        for (index = 0; index < sizeof(WCL::commandSETTIME); index++)
+        TRACESPAN("DMPAFT");
+        acknowledged = co_await sendCommand(command, QByteArray());
+      }
+
+      if (acknowledged)
+      {
+        QByteArray header;
+
+        command.clear();
+        command.append(static_cast<char>(date & 0xFF));
+        command.append(static_cast<char>(date >> 8));
+        command.append(static_cast<char>(time & 0xFF));
+        command.append(static_cast<char>(time >> 8));
+
+        CRC = WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(command.data()), 0, 4);
+        command.append(static_cast<char>(CRC >> 8));
+        command.append(static_cast<char>(CRC & 0xFF));
+        write(command);
+
         {
-          command[index] = WCL::commandSETPER[index];
-        };
+          TRACESPAN("DMPAFT header");
+          header = received(co_await CReadAwaiter(*this, DMPAFT_HEADER_SIZE, RESPONSE_TIMEOUT));
+        }
 
-        switch (period)
+        if ( (header.size() == DMPAFT_HEADER_SIZE) && (header[0] == static_cast<char>(WCL::wlACK)) &&
+             (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(header.data()), 1, DMPAFT_HEADER_SIZE - 1) == 0) )
         {
-          case 1:
-          {
-            command[index++] = '1';
-            break;
-          };
-          case 5:
-          {
-            command[index++] = '5';
-            break;
-          };
-          case 10:
-          {
-            command[index++] = '1';
-            command[index++] = '0';
-            break;
-          };
-          case 15:
-          {
-            command[index++] = '1';
-            command[index++] = '5';
-            break;
-          };
-          case 30:
-          {
-            command[index++] = '3';
-            command[index++] = '0';
-            break;
-          };
-          case 60:
+          WCL::SDMPAFTResponse const *response = reinterpret_cast<WCL::SDMPAFTResponse const *>(header.constData() + 1);
+
+          std::uint16_t pageCount = response->pages;
+          std::uint8_t firstRecord = response->firstRecord;
+
+          LOGDEBUG("Reading: {} Pages from WeatherView.", pageCount);
+
+          while (pageCount > 0)
           {
-            command[index++] = '6';
-            command[index++] = '0';
-            break;
+            TRACESPAN("page", pageCount);
+
+            QByteArray page;
+            char reply = static_cast<char>(WCL::wlACK);
+            bool pageValid = false;
+
+            if (!ingest.writable())
+            {
+              LOGWARNING("Records can no longer be written. Download abandoned.");
+              write(&ESC, 1);
+              break;
+            };
+
+              // The CRC of a page (including the transmitted CRC) is zero if the page is not corrupted. A corrupted page is
+              // requested again with a NAK.
+
+            for (int attempt = 0; (attempt <= PAGE_RETRIES) && !pageValid; attempt++)
+            {
+              write(&reply, 1);
+              page = received(co_await CReadAwaiter(*this, DUMP_PAGE_SIZE, RESPONSE_TIMEOUT));
+
+              if (page.size() != DUMP_PAGE_SIZE)
+              {
+                break;
+              };
+
+              pageValid = (WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(page.data()), 0, DUMP_PAGE_SIZE) == 0);
+              reply = NAK;
+            };
+
+            if (!pageValid)
+            {
+              LOGERROR("Archive page not received from WeatherLinkIP module.");
+              write(&ESC, 1);
+              break;
+            };
+
+              // The page is a sequence number followed by 5 archive records.
+
+            std::vector<TRawRecord> records;
+
+            for (std::size_t index = firstRecord; index < 5; index++)
+            {
+              TRawRecord &record = records.emplace_back();
+
+              std::memcpy(record.data(), page.constData() + 1 + index * ARCHIVE_RECORD_SIZE, ARCHIVE_RECORD_SIZE);
+              console.normaliseRecord(record);
+            };
+
+            recordCount += co_await ingest.ingest(records);
+            firstRecord = 0;
+            pageCount--;
           };
-          case 120:
-          default:
+
+          ingest.endDownload();
+
+            // All records processed.
+
+          if (pageCount == 0)
           {
-            command[index++] = '1';
-            command[index++] = '2';
-            command[index++] = '0';
-            break;
+            returnValue = true;
+            storeChecked = true;
           };
-        };
 
-        command[index++] = WCL::wlLF;
-        writeData(command, index);
+          LOGDEBUG("Completed Reading Pages from WeatherView.");
 
-        if (waitForReadyRead(5000))
-        {
-          dataLength = readData(static_cast<char *>(command), WCL::WL_MTU);
-          if (dataLength == 1 && command[0] == WCL::wlACK)
+          LOGINFO("{} records written to database.", recordCount);
+
+            // Records that were not stored (eg the database failed) are downloaded again by the next poll. The latest record
+            // is only advanced by committed records that precede the first record that was not stored.
+
+          std::uint16_t latestDate;
+          std::uint16_t latestTime;
+
+          if ( ingest.latestInserted(latestDate, latestTime) &&
+               ((latestDate > highWaterDate) || ((latestDate == highWaterDate) && (latestTime > highWaterTime))) )
           {
-            returnValue = true;
+            setHighWater(latestDate, latestTime);
           };
+        }
+        else
+        {
+          LOGERROR("No response from WeatherLinkIP module.");
         };
+      }
+      else
+      {
+        LOGERROR("No response from WeatherLinkIP module.");
+      };
+
+        // The current conditions and the diagnostics are only read after a complete download, so they never delay or interrupt
+        // the archive.
+
+      if (returnValue && ingest.hasAlertRules())
+      {
+        co_await readLoop(ingest);
+      };
+
+      if (returnValue && reception)
+      {
+        co_await readReception(*reception);
       };
+
+      disconnectFromHost();
     };
 
-    if (returnValue)
-    {
-      INFOMESSAGE("Console archive interval updated.");
-    }
-    else
+    co_return returnValue;
+  }
+
+  /// @brief    Sets the time on the weather station. The time is read once the console has been woken.
+  /// @throws
+  /// @version  2026-10-19/GGB - Local time converted with localtime_r after the console has been woken.
+  /// @version  2026-10-19/GGB - Traffic recorded in the capture file.
+  /// @version  2026-10-19/GGB - Converted to a coroutine.
+  /// @version  2026-10-19/GGB - Wakeup attempts and connect timeout reduced when probing an unhealthy console.
+  /// @version  2026-10-19/GGB - Messages written through the asynchronous logger.
+  /// @version  2015-06-04/GGB - Function created.
+
+  CTask<bool> CTCPSocket::setTime()
+  {
+    std::time_t time;
+    struct tm currentTime;
+    QByteArray command;
+    QByteArray data;
+    std::uint16_t CRC;
+    bool returnValue = false;
+
+    if (co_await connectAndWake("setTime"))
     {
-      if (loopCount < 3)
+      for (std::size_t index = 0; index < sizeof(WCL::commandSETTIME); index++)
+      {
+        command.append(static_cast<char>(WCL::commandSETTIME[index]));
+      };
+
+      time = std::time(nullptr);
+      localtime_r(&time, &currentTime);
+
+      data.append(static_cast<char>(currentTime.tm_sec));
+      data.append(static_cast<char>(currentTime.tm_min));
+      data.append(static_cast<char>(currentTime.tm_hour));
+      data.append(static_cast<char>(currentTime.tm_mday));
+      data.append(static_cast<char>(currentTime.tm_mon + 1));
+      data.append(static_cast<char>(currentTime.tm_year));
+
+      CRC = WCL::calculateCRC(reinterpret_cast<std::uint8_t *>(data.data()), 0, 6);
+      data.append(static_cast<char>(CRC >> 8));
+      data.append(static_cast<char>(CRC & 0xFF));
+
+      returnValue = co_await sendCommand(command, data);
+
+      if (returnValue)
       {
-        INFOMESSAGE("Console archive interval not updated.");
+        LOGINFO("Console time updated.");
       }
       else
       {
-        ERRORMESSAGE("Unable to connect to console.");
+        LOGINFO("Console time not updated.");
+      };
+
+      disconnectFromHost();
+    };
+
+    co_return returnValue;
+  }
+
+  /// @brief      Set the logging interval of the logger.
+  /// @param[in]  period: The logging period to set. (1, 5, 10, 15, 30, 60 or 120 minutes. Any other value sets 120 minutes.)
+  /// @returns    true if succesfull.
+  /// @version    2026-10-19/GGB - Not sent if the console is known to have the archive period.
+  /// @version    2026-10-19/GGB - Traffic recorded in the capture file.
+  /// @version    2026-10-19/GGB - Converted to a coroutine. Command length taken from commandSETPER.
+  /// @version    2026-10-19/GGB - Wakeup attempts and connect timeout reduced when probing an unhealthy console.
+  /// @version    2026-10-19/GGB - Messages written through the asynchronous logger.
+  /// @version    2020-10-25/GGB - Function created.
+
+  CTask<bool> CTCPSocket::setInterval(std::uint8_t period)
+  {
+    QByteArray command;
+    bool returnValue = false;
+
+    switch (period)
+    {
+      case 1:
+      case 5:
+      case 10:
+      case 15:
+      case 30:
+      case 60:
+      case 120:
+      {
+        break;
+      };
+      default:
+      {
+        period = 120;
+        break;
+      };
+    };
+
+    if (consoleValidated && (console.archivePeriod() == period))
+    {
+      LOGDEBUG("Console archive interval already {} minutes.", period);
+      co_return true;
+    };
+
+    if (co_await connectAndWake("setInterval " + QByteArray::number(period)))
+    {
+      for (std::size_t index = 0; index < sizeof(WCL::commandSETPER); index++)
+      {
+        command.append(static_cast<char>(WCL::commandSETPER[index]));
+      };
+      command.append(QByteArray::number(period));
+
+      returnValue = co_await sendCommand(command, QByteArray());
+
+      if (returnValue)
+      {
+        LOGINFO("Console archive interval updated.");
+        consoleValidated = false;                 // The cached configuration is read again with the next archive.
       }
+      else
+      {
+        LOGINFO("Console archive interval not updated.");
+      };
 
-    }
+      disconnectFromHost();
+    };
 
-    return returnValue;
+    co_return returnValue;
   }
 
 }   // namespace WSd
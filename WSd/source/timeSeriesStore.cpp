@@ -0,0 +1,866 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								TimeSeriesStore
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Embedded, append only, columnar time series store for the archive records of a station. The store is kept in
+//                      a directory per station with one chunk file per month (time partition). Each chunk file holds a sequence of
+//                      blocks of up to 1024 records. Within a block each column is compressed separately (delta of delta for the
+//                      time stamps, delta for the values) and the block header holds the time range of the block. The block headers
+//                      form a sparse time index, so a range scan only decodes the blocks that overlap the range, directly from the
+//                      memory mapped chunk files.
+//                      The last block is kept open in memory and saved to a file of its own each time the store is flushed. It is
+//                      appended to its chunk file when it is full, so the chunk files are only appended to.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/timeSeriesStore.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <cstring>
+
+  // Miscellaneous library header files
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+  // WSd header files
+
+#include "include/compression.h"
+#include "include/logger.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+    // File layout. (All values little endian.)
+    //  Chunk file:   SChunkHeader, blocks.
+    //  Block:        SBlockHeader, for each column SColumnHeader followed by the bit stream of the column.
+    //  Open block:   SOpenHeader, block. (open.wsb)
+
+  static char const CHUNK_MAGIC[8] = { 'W', 'S', 'D', 'C', 'H', 'N', 'K', 0 };
+  static std::uint32_t const CHUNK_VERSION = 1;
+  static std::uint32_t const BLOCK_MAGIC = 0x31425357;          // "WSB1"
+  static char const OPEN_MAGIC[8] = { 'W', 'S', 'D', 'O', 'P', 'E', 'N', 0 };
+  static std::uint32_t const OPEN_VERSION = 1;
+  static std::uint8_t const COLUMN_TIME = 0xFF;
+  static std::uint8_t const COLUMN_QUALITY = 0xFE;
+  static std::int64_t const MINIMUM_TIME = -62135596800;         // 0001-01-01. (Limits of the partition calculation.)
+  static std::int64_t const MAXIMUM_TIME = 253402300799;         // 9999-12-31 23:59:59
+
+  enum EEncoding : std::uint8_t
+  {
+    ENC_DELTA_OF_DELTA = 1,
+    ENC_DELTA = 2,
+  };
+
+  struct SChunkHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::int32_t partition;
+  };
+
+  struct SBlockHeader
+  {
+    std::uint32_t magic;
+    std::uint16_t recordCount;
+    std::uint8_t columnCount;
+    std::uint8_t reserved;
+    std::uint32_t length;                   // Length of the data following the header.
+    std::uint32_t checksum;                 // FNV-1a of the data following the header.
+    std::int64_t minimumTime;
+    std::int64_t maximumTime;
+  };
+
+  struct SColumnHeader
+  {
+    std::uint8_t column;
+    std::uint8_t encoding;
+    std::uint16_t reserved;
+    std::uint32_t length;
+  };
+
+  struct SOpenHeader
+  {
+    char magic[8];
+    std::uint32_t version;
+    std::int32_t partition;
+    std::int64_t offset;                    // Size of the chunk file when the block was saved. (Where it is to be sealed.)
+  };
+
+  static_assert(sizeof(SChunkHeader) == 16, "Chunk header layout");
+  static_assert(sizeof(SBlockHeader) == 32, "Block header layout");
+  static_assert(sizeof(SColumnHeader) == 8, "Column header layout");
+  static_assert(sizeof(SOpenHeader) == 24, "Open block header layout");
+
+  /// @brief      Calculates the checksum of a block.
+  /// @param[in]  data: The data.
+  /// @param[in]  size: The size of the data.
+  /// @returns    The FNV-1a hash of the data.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  static std::uint32_t checksum(std::uint8_t const *data, std::size_t size)
+  {
+    std::uint32_t hash = 2166136261U;
+
+    for (std::size_t index = 0; index < size; index++)
+    {
+      hash = (hash ^ data[index]) * 16777619U;
+    };
+
+    return hash;
+  }
+
+  /// @brief      Constructor.
+  /// @param[in]  dir: The directory holding the chunk files of the station.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTimeSeriesStore::CTimeSeriesStore(QString const &dir) : directory(dir)
+  {
+  }
+
+  /// @brief      Destructor. Saves the open block.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CTimeSeriesStore::~CTimeSeriesStore()
+  {
+    flush();
+  }
+
+  /// @brief      Returns the partition (month) of a time stamp.
+  /// @param[in]  timeStamp: The time stamp.
+  /// @returns    year * 12 + month - 1
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::int32_t CTimeSeriesStore::partition(std::int64_t timeStamp)
+  {
+    int year, month, day, hour, minute;
+
+    SArchiveRecord::splitTimeStamp(timeStamp, year, month, day, hour, minute);
+
+    return year * 12 + month - 1;
+  }
+
+  /// @brief      Returns the name of the chunk file of a partition.
+  /// @param[in]  p: The partition.
+  /// @returns    The file name. (directory/YYYYMM.wsc)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  QString CTimeSeriesStore::chunkFileName(std::int32_t p) const
+  {
+    return QString("%1/%2%3.wsc").arg(directory).arg(p / 12, 4, 10, QChar('0')).arg(p % 12 + 1, 2, 10, QChar('0'));
+  }
+
+  /// @brief      Opens the store. The chunk files are indexed (the block headers are read to build the sparse time index) and the
+  ///             open block is loaded. A chunk file is only valid up to the first corrupted block; the remainder is overwritten
+  ///             by the next write to the chunk.
+  /// @returns    true if the store was opened.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Open block loaded from the open block file.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTimeSeriesStore::open()
+  {
+    QDir dir(directory);
+
+    TRACESPAN("storeOpen");
+
+    if (!dir.mkpath("."))
+    {
+      LOGERROR("Unable to create store directory {}.", directory.toStdString());
+      return false;
+    };
+
+    chunks.clear();
+    totalRecords = 0;
+    firstTimeStamp = INT64_MAX;
+    lastTimeStamp = INT64_MIN;
+
+    for (QString const &fileName : dir.entryList(QStringList() << "*.wsc", QDir::Files, QDir::Name))
+    {
+      bool yearValid, monthValid;
+      int year = fileName.left(4).toInt(&yearValid);
+      int month = fileName.mid(4, 2).toInt(&monthValid);
+
+      if (yearValid && monthValid && (fileName.length() == 10) && (month >= 1) && (month <= 12))
+      {
+        std::int32_t p = year * 12 + month - 1;
+        SChunk &chunk = chunks[p];
+
+        chunk.fileName = chunkFileName(p);
+        indexChunk(p, chunk);
+      };
+    };
+
+    loadOpenBlock();
+
+    LOGINFO("Store {} opened. {} records in {} chunks.", directory.toStdString(), totalRecords, chunks.size());
+
+    return true;
+  }
+
+  /// @brief      Builds the sparse time index of a chunk file.
+  /// @param[in]  p: The partition of the chunk.
+  /// @param[out] chunk: The chunk to index.
+  /// @returns    true if the whole file is valid.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTimeSeriesStore::indexChunk(std::int32_t p, SChunk &chunk)
+  {
+    QFile file(chunk.fileName);
+    bool returnValue = true;
+
+    chunk.blocks.clear();
+    chunk.validSize = 0;
+
+    if (!file.open(QIODevice::ReadOnly) || (file.size() < static_cast<qint64>(sizeof(SChunkHeader))))
+    {
+      LOGWARNING("Chunk file {} could not be read.", chunk.fileName.toStdString());
+      return false;
+    };
+
+    std::int64_t fileSize = file.size();
+    std::uint8_t const *map = file.map(0, fileSize);
+
+    if (map == nullptr)
+    {
+      LOGWARNING("Chunk file {} could not be mapped.", chunk.fileName.toStdString());
+      return false;
+    };
+
+    SChunkHeader chunkHeader;
+
+    std::memcpy(&chunkHeader, map, sizeof(chunkHeader));
+    if ( (std::memcmp(chunkHeader.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) || (chunkHeader.version != CHUNK_VERSION) ||
+         (chunkHeader.partition != p) )
+    {
+      LOGWARNING("Chunk file {} is not valid.", chunk.fileName.toStdString());
+      file.unmap(const_cast<std::uint8_t *>(map));
+      return false;
+    };
+
+    std::int64_t offset = sizeof(SChunkHeader);
+
+    while (offset < fileSize)
+    {
+      SBlockHeader blockHeader;
+
+      if (offset + static_cast<std::int64_t>(sizeof(blockHeader)) > fileSize)
+      {
+        returnValue = false;
+        break;
+      };
+
+      std::memcpy(&blockHeader, map + offset, sizeof(blockHeader));
+
+      if ( (blockHeader.magic != BLOCK_MAGIC) ||
+           (offset + static_cast<std::int64_t>(sizeof(blockHeader) + blockHeader.length) > fileSize) ||
+           (checksum(map + offset + sizeof(blockHeader), blockHeader.length) != blockHeader.checksum) )
+      {
+        returnValue = false;
+        break;
+      };
+
+      chunk.blocks.push_back({ blockHeader.minimumTime, blockHeader.maximumTime, offset,
+                               static_cast<std::uint32_t>(sizeof(blockHeader) + blockHeader.length), blockHeader.recordCount });
+      totalRecords += blockHeader.recordCount;
+      firstTimeStamp = std::min(firstTimeStamp, blockHeader.minimumTime);
+      lastTimeStamp = std::max(lastTimeStamp, blockHeader.maximumTime);
+      offset += sizeof(blockHeader) + blockHeader.length;
+    };
+
+    chunk.validSize = offset;
+    file.unmap(const_cast<std::uint8_t *>(map));
+
+    if (!returnValue)
+    {
+      LOGWARNING("Chunk file {} corrupted at offset {}. Remainder of the file discarded.", chunk.fileName.toStdString(), offset);
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Encodes a block.
+  /// @param[in]  records: The records to encode.
+  /// @param[out] buffer: The encoded block, including the block header.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Quality codes stored.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTimeSeriesStore::encodeBlock(std::vector<SArchiveRecord> const &records, std::vector<std::uint8_t> &buffer)
+  {
+    SBlockHeader blockHeader = { BLOCK_MAGIC, static_cast<std::uint16_t>(records.size()), COL_COUNT + 2, 0, 0, 0,
+                                 INT64_MAX, INT64_MIN };
+    std::vector<std::uint8_t> bits;
+
+    buffer.assign(sizeof(blockHeader), 0);
+
+    for (std::size_t column = 0; column <= COL_COUNT + 1; column++)
+    {
+      SColumnHeader columnHeader;
+      CBitWriter writer(bits);
+
+      bits.clear();
+
+      if (column == 0)
+      {
+        CDeltaEncoder encoder(true);
+
+        columnHeader.column = COLUMN_TIME;
+        columnHeader.encoding = ENC_DELTA_OF_DELTA;
+
+        for (SArchiveRecord const &record : records)
+        {
+          encoder.encode(writer, record.timeStamp);
+          blockHeader.minimumTime = std::min(blockHeader.minimumTime, record.timeStamp);
+          blockHeader.maximumTime = std::max(blockHeader.maximumTime, record.timeStamp);
+        };
+      }
+      else if (column == COL_COUNT + 1)
+      {
+        CDeltaEncoder encoder;
+
+        columnHeader.column = COLUMN_QUALITY;
+        columnHeader.encoding = ENC_DELTA;
+
+        for (SArchiveRecord const &record : records)
+        {
+          encoder.encode(writer, static_cast<std::int64_t>(record.qualityCodes));
+        };
+      }
+      else
+      {
+        CDeltaEncoder encoder;
+
+        columnHeader.column = static_cast<std::uint8_t>(column - 1);
+        columnHeader.encoding = ENC_DELTA;
+
+        for (SArchiveRecord const &record : records)
+        {
+          encoder.encode(writer, record.values[column - 1]);
+        };
+      };
+
+      columnHeader.reserved = 0;
+      columnHeader.length = static_cast<std::uint32_t>(bits.size());
+
+      std::uint8_t const *headerBytes = reinterpret_cast<std::uint8_t const *>(&columnHeader);
+
+      buffer.insert(buffer.end(), headerBytes, headerBytes + sizeof(columnHeader));
+      buffer.insert(buffer.end(), bits.begin(), bits.end());
+    };
+
+    blockHeader.length = static_cast<std::uint32_t>(buffer.size() - sizeof(blockHeader));
+    blockHeader.checksum = checksum(buffer.data() + sizeof(blockHeader), blockHeader.length);
+    std::memcpy(buffer.data(), &blockHeader, sizeof(blockHeader));
+  }
+
+  /// @brief      Decodes a block. Columns that are not known are skipped, columns that are not present in the block are set to
+  ///             NO_VALUE.
+  /// @param[in]  data: The block (starting at the block header).
+  /// @param[in]  size: The size of the data available.
+  /// @param[out] records: The decoded records are appended to this vector.
+  /// @returns    true if the block was decoded.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Quality codes read.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTimeSeriesStore::decodeBlock(std::uint8_t const *data, std::size_t size, std::vector<SArchiveRecord> &records)
+  {
+    SBlockHeader blockHeader;
+
+    if (size < sizeof(blockHeader))
+    {
+      return false;
+    };
+
+    std::memcpy(&blockHeader, data, sizeof(blockHeader));
+
+    if ( (blockHeader.magic != BLOCK_MAGIC) || (sizeof(blockHeader) + blockHeader.length > size) )
+    {
+      return false;
+    };
+
+    std::size_t first = records.size();
+    std::size_t offset = sizeof(blockHeader);
+    std::size_t end = sizeof(blockHeader) + blockHeader.length;
+
+    records.resize(first + blockHeader.recordCount);
+
+    for (std::uint8_t column = 0; column < blockHeader.columnCount; column++)
+    {
+      SColumnHeader columnHeader;
+
+      if (offset + sizeof(columnHeader) > end)
+      {
+        return false;
+      };
+
+      std::memcpy(&columnHeader, data + offset, sizeof(columnHeader));
+      offset += sizeof(columnHeader);
+
+      if (offset + columnHeader.length > end)
+      {
+        return false;
+      };
+
+      CBitReader reader(data + offset, columnHeader.length);
+
+      if ( (columnHeader.column == COLUMN_TIME) && (columnHeader.encoding == ENC_DELTA_OF_DELTA) )
+      {
+        CDeltaEncoder encoder(true);
+
+        for (std::size_t index = first; index < records.size(); index++)
+        {
+          records[index].timeStamp = encoder.decode(reader);
+        };
+      }
+      else if ( (columnHeader.column == COLUMN_QUALITY) && (columnHeader.encoding == ENC_DELTA) )
+      {
+        CDeltaEncoder encoder;
+
+        for (std::size_t index = first; index < records.size(); index++)
+        {
+          records[index].qualityCodes = static_cast<std::uint64_t>(encoder.decode(reader));
+        };
+      }
+      else if ( (columnHeader.column < COL_COUNT) && (columnHeader.encoding == ENC_DELTA) )
+      {
+        CDeltaEncoder encoder;
+
+        for (std::size_t index = first; index < records.size(); index++)
+        {
+          records[index].values[columnHeader.column] = static_cast<std::int32_t>(encoder.decode(reader));
+        };
+      };
+
+      offset += columnHeader.length;
+    };
+
+    return true;
+  }
+
+  /// @brief      Returns the name of the open block file.
+  /// @returns    The file name. (directory/open.wsb)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  QString CTimeSeriesStore::openBlockFileName() const
+  {
+    return directory + "/open.wsb";
+  }
+
+  /// @brief      Loads the open block saved by the last flush. The block is discarded if it is not valid, or if it has been
+  ///             sealed since it was saved (the chunk file has grown past the offset the block was saved for).
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CTimeSeriesStore::loadOpenBlock()
+  {
+    QFile file(openBlockFileName());
+    QByteArray data;
+    SOpenHeader openHeader;
+    SBlockHeader blockHeader;
+
+    openRecords.clear();
+    openPartition = -1;
+    openDirty = false;
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+      return;
+    };
+
+    data = file.readAll();
+
+    if (static_cast<std::size_t>(data.size()) < sizeof(openHeader) + sizeof(blockHeader))
+    {
+      LOGWARNING("Open block file {} is not valid. Discarded.", file.fileName().toStdString());
+      return;
+    };
+
+    std::uint8_t const *block = reinterpret_cast<std::uint8_t const *>(data.constData()) + sizeof(openHeader);
+    std::size_t blockSize = data.size() - sizeof(openHeader);
+
+    std::memcpy(&openHeader, data.constData(), sizeof(openHeader));
+    std::memcpy(&blockHeader, block, sizeof(blockHeader));
+
+    if ( (std::memcmp(openHeader.magic, OPEN_MAGIC, sizeof(OPEN_MAGIC)) != 0) || (openHeader.version != OPEN_VERSION) ||
+         (blockHeader.magic != BLOCK_MAGIC) || (sizeof(blockHeader) + blockHeader.length != blockSize) ||
+         (checksum(block + sizeof(blockHeader), blockHeader.length) != blockHeader.checksum) ||
+         !decodeBlock(block, blockSize, openRecords) )
+    {
+      LOGWARNING("Open block file {} is not valid. Discarded.", file.fileName().toStdString());
+      openRecords.clear();
+      return;
+    };
+
+    SChunk &chunk = chunks[openHeader.partition];
+
+    if (chunk.validSize > openHeader.offset)
+    {
+      openRecords.clear();                    // Sealed after it was saved.
+      return;
+    };
+
+    if (chunk.fileName.isEmpty())
+    {
+      chunk.fileName = chunkFileName(openHeader.partition);
+    };
+
+    openPartition = openHeader.partition;
+    totalRecords += openRecords.size();
+    for (SArchiveRecord const &record : openRecords)
+    {
+      firstTimeStamp = std::min(firstTimeStamp, record.timeStamp);
+      lastTimeStamp = std::max(lastTimeStamp, record.timeStamp);
+    };
+  }
+
+  /// @brief      Saves the open block to the open block file. The file is written to disk and replaced atomically, and the
+  ///             chunk files are not written, so a crash leaves either the previous or the new copy of the block.
+  /// @returns    true if the block was saved.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created. (Replaces rewriting the block at the end of its chunk file.)
+
+  bool CTimeSeriesStore::saveOpenBlock()
+  {
+    SOpenHeader openHeader;
+    std::vector<std::uint8_t> buffer;
+    QSaveFile file(openBlockFileName());
+
+    std::memcpy(openHeader.magic, OPEN_MAGIC, sizeof(OPEN_MAGIC));
+    openHeader.version = OPEN_VERSION;
+    openHeader.partition = openPartition;
+    openHeader.offset = chunks[openPartition].validSize;
+
+    encodeBlock(openRecords, buffer);
+
+    if (!file.open(QIODevice::WriteOnly) ||
+        (file.write(reinterpret_cast<char const *>(&openHeader), sizeof(openHeader)) != sizeof(openHeader)) ||
+        (file.write(reinterpret_cast<char const *>(buffer.data()), buffer.size()) != static_cast<qint64>(buffer.size())) ||
+        !file.commit())
+    {
+      LOGERROR("Unable to write open block file {}.", file.fileName().toStdString());
+      return false;
+    };
+
+    openDirty = false;
+
+    return true;
+  }
+
+  /// @brief      Seals the open block: appends it to the end of its chunk file. Only the part of the file past the last valid
+  ///             block is overwritten, so a crash cannot damage the blocks already written.
+  /// @returns    true if the block was written.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Block appended rather than rewritten in place.
+  /// @version    2026-10-19/GGB - Function created. (writeOpenBlock)
+
+  bool CTimeSeriesStore::sealOpenBlock()
+  {
+    SChunk &chunk = chunks[openPartition];
+    std::vector<std::uint8_t> buffer;
+    std::int64_t offset;
+    QFile file(chunk.fileName);
+
+    encodeBlock(openRecords, buffer);
+
+    if (!file.open(QIODevice::ReadWrite))
+    {
+      LOGERROR("Unable to open chunk file {}.", chunk.fileName.toStdString());
+      return false;
+    };
+
+    if (chunk.validSize < static_cast<std::int64_t>(sizeof(SChunkHeader)))
+    {
+      SChunkHeader chunkHeader;
+
+      std::memcpy(chunkHeader.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+      chunkHeader.version = CHUNK_VERSION;
+      chunkHeader.partition = openPartition;
+
+      file.resize(0);
+      file.write(reinterpret_cast<char const *>(&chunkHeader), sizeof(chunkHeader));
+      chunk.validSize = sizeof(chunkHeader);
+      chunk.blocks.clear();
+    };
+
+    offset = chunk.validSize;
+
+    if ( ((file.size() > offset) && !file.resize(offset)) || !file.seek(offset) ||
+        (file.write(reinterpret_cast<char const *>(buffer.data()), buffer.size()) != static_cast<qint64>(buffer.size())) ||
+        !file.flush())
+    {
+      LOGERROR("Unable to write chunk file {}.", chunk.fileName.toStdString());
+      return false;
+    };
+
+    chunk.validSize = offset + buffer.size();
+
+    SBlockIndex block = { INT64_MAX, INT64_MIN, offset, static_cast<std::uint32_t>(buffer.size()),
+                          static_cast<std::uint16_t>(openRecords.size()) };
+
+    for (SArchiveRecord const &record : openRecords)
+    {
+      block.minimumTime = std::min(block.minimumTime, record.timeStamp);
+      block.maximumTime = std::max(block.maximumTime, record.timeStamp);
+    };
+
+    chunk.blocks.push_back(block);
+
+      // The saved copy of the block is now stale. It would be discarded by loadOpenBlock() in any case.
+
+    QFile::remove(openBlockFileName());
+    openRecords.clear();
+    openDirty = false;
+
+    return true;
+  }
+
+  /// @brief      Appends a record to the store. The record is held in the open block until the store is flushed or the block
+  ///             is full. Records may be appended in any order, but records out of time order (backfill) cost a block each time
+  ///             the partition changes.
+  /// @param[in]  record: The record to append.
+  /// @returns    true if successful.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Open block sealed when the partition changes.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTimeSeriesStore::append(SArchiveRecord const &record)
+  {
+    std::int32_t p = partition(record.timeStamp);
+
+    if (p != openPartition)
+    {
+      if (!openRecords.empty() && !sealOpenBlock())
+      {
+        return false;
+      };
+
+      openPartition = p;
+
+      SChunk &chunk = chunks[p];
+
+      if (chunk.fileName.isEmpty())
+      {
+        chunk.fileName = chunkFileName(p);
+      };
+    };
+
+    openRecords.push_back(record);
+    openDirty = true;
+    totalRecords++;
+    firstTimeStamp = std::min(firstTimeStamp, record.timeStamp);
+    lastTimeStamp = std::max(lastTimeStamp, record.timeStamp);
+
+    if ( (openRecords.size() >= BLOCK_RECORDS) && !sealOpenBlock() )
+    {
+      return false;
+    };
+
+    return true;
+  }
+
+  /// @brief      Saves the open block to disk. The owner flushes the store once per download rather than per record, as the
+  ///             whole open block is written each time.
+  /// @returns    true if successful.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Open block saved to the open block file.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTimeSeriesStore::flush()
+  {
+    if (openDirty && !openRecords.empty())
+    {
+      TRACESPAN("storeFlush");
+      return saveOpenBlock();
+    }
+    else
+    {
+      return true;
+    };
+  }
+
+  /// @brief      Scans the records in a time range. The chunk files are memory mapped and only the blocks that overlap the range
+  ///             (from the sparse time index) are decoded. Records are returned in storage order, which is time order except
+  ///             for backfilled records.
+  /// @param[in]  from: The start of the range (inclusive).
+  /// @param[in]  to: The end of the range (inclusive).
+  /// @param[in]  function: Called for each record in the range. Return false to stop the scan.
+  /// @returns    true if all the chunks could be read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CTimeSeriesStore::scan(std::int64_t from, std::int64_t to, TScanFunction const &function) const
+  {
+    bool returnValue = true;
+    std::vector<SArchiveRecord> records;
+
+    TRACESPAN("storeScan");
+
+    std::int32_t firstPartition = partition(std::clamp(from, MINIMUM_TIME, MAXIMUM_TIME));
+    std::int32_t lastPartition = partition(std::clamp(to, MINIMUM_TIME, MAXIMUM_TIME));
+
+    for (auto iterator = chunks.lower_bound(firstPartition);
+         (iterator != chunks.end()) && (iterator->first <= lastPartition); ++iterator)
+    {
+      SChunk const &chunk = iterator->second;
+      QFile file(chunk.fileName);
+      std::uint8_t const *map = nullptr;
+
+      if (chunk.validSize > 0)
+      {
+        if (file.open(QIODevice::ReadOnly))
+        {
+          map = file.map(0, chunk.validSize);
+        };
+
+        if (map == nullptr)
+        {
+          LOGERROR("Unable to map chunk file {}.", chunk.fileName.toStdString());
+          returnValue = false;
+          continue;
+        };
+      };
+
+      for (SBlockIndex const &block : chunk.blocks)
+      {
+        if ( (block.maximumTime >= from) && (block.minimumTime <= to) )
+        {
+          records.clear();
+          decodeBlock(map + block.offset, block.length, records);
+
+          for (SArchiveRecord const &record : records)
+          {
+            if ( (record.timeStamp >= from) && (record.timeStamp <= to) && !function(record) )
+            {
+              file.unmap(const_cast<std::uint8_t *>(map));
+              return returnValue;
+            };
+          };
+        };
+      };
+
+      if (map != nullptr)
+      {
+        file.unmap(const_cast<std::uint8_t *>(map));
+      };
+
+        // The open block is scanned from memory as it may hold records that have not been written.
+
+      if (iterator->first == openPartition)
+      {
+        for (SArchiveRecord const &record : openRecords)
+        {
+          if ( (record.timeStamp >= from) && (record.timeStamp <= to) && !function(record) )
+          {
+            return returnValue;
+          };
+        };
+      };
+    };
+
+    return returnValue;
+  }
+
+  /// @brief      Reads the records in a time range, sorted by time.
+  /// @param[in]  from: The start of the range (inclusive).
+  /// @param[in]  to: The end of the range (inclusive).
+  /// @returns    The records.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::vector<SArchiveRecord> CTimeSeriesStore::read(std::int64_t from, std::int64_t to) const
+  {
+    std::vector<SArchiveRecord> records;
+
+    scan(from, to, [&records](SArchiveRecord const &record)
+    {
+      records.push_back(record);
+      return true;
+    });
+
+    std::stable_sort(records.begin(), records.end(), [](SArchiveRecord const &lhs, SArchiveRecord const &rhs)
+    {
+      return lhs.timeStamp < rhs.timeStamp;
+    });
+
+    return records;
+  }
+
+  /// @brief      Returns the time stamps of the records stored in a time range. Used to check a batch of records against the
+  ///             store with one scan: only the blocks of the sparse index that overlap the range are decoded.
+  /// @param[in]  from: The start of the range (inclusive).
+  /// @param[in]  to: The end of the range (inclusive).
+  /// @returns    The time stamps.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Replaces contains(), which scanned the store for each record.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::set<std::int64_t> CTimeSeriesStore::storedTimes(std::int64_t from, std::int64_t to) const
+  {
+    std::set<std::int64_t> times;
+
+    if ( (from <= lastTimeStamp) && (to >= firstTimeStamp) )
+    {
+      scan(from, to, [&times](SArchiveRecord const &record)
+      {
+        times.insert(record.timeStamp);
+        return true;
+      });
+    };
+
+    return times;
+  }
+
+  /// @brief      Returns the size of the chunk files.
+  /// @returns    The size (bytes).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  std::uint64_t CTimeSeriesStore::storageSize() const
+  {
+    std::uint64_t size = 0;
+
+    for (auto const &chunk : chunks)
+    {
+      size += chunk.second.validSize;
+    };
+
+    return size;
+  }
+
+} // namespace WSd
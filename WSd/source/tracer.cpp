@@ -0,0 +1,271 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Tracer
+// SUBSYSTEM:						Span tracing
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	None.
+// NAMESPACE:						WSd::tracing
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Low overhead span tracer. Each thread that records a span is given its own ring buffer the first time it
+//                      records. The buffers are kept until the process exits so that they can be exported after the thread has
+//                      finished. Spans recorded while an export is in progress may be omitted from that export. Each slot of a
+//                      ring is a seqlock: the export copies a span and keeps it only if the slot was not rewritten during the copy.
+//
+// HISTORY:             2026-10-19/GGB - Slots read under a seqlock. Spans overwritten during an export dropped.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/tracer.h"
+
+  // Standard C++ library header files
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+namespace WSd
+{
+  namespace tracing
+  {
+    std::size_t const RING_CAPACITY = 16384;        // Spans per thread. Must be a power of 2.
+    std::size_t const RING_MASK = RING_CAPACITY - 1;
+
+    struct SSpan
+    {
+      char const *name;
+      std::uint64_t startTime;
+      std::uint64_t duration;
+      std::int64_t argument;
+    };
+
+      // A slot of the ring. The fields are atomic (relaxed) so that the export can read a slot while it is being rewritten;
+      // the sequence tells it whether the copy is the span it wanted.
+
+    struct SSlot
+    {
+      std::atomic<std::uint64_t> sequence;          // 2 * position + 2 once the span at position is written. Odd while writing.
+      std::atomic<char const *> name;
+      std::atomic<std::uint64_t> startTime;
+      std::atomic<std::uint64_t> duration;
+      std::atomic<std::int64_t> argument;
+    };
+
+    struct SThreadBuffer
+    {
+      std::uint32_t threadID;
+      std::atomic<std::uint64_t> head;              // Total number of spans written.
+      std::uint64_t clearedAt;                      // Spans before this position have been cleared.
+      SSlot spans[RING_CAPACITY];
+
+      explicit SThreadBuffer(std::uint32_t tid) : threadID(tid), head(0), clearedAt(0) {}
+    };
+
+    std::atomic<bool> tracingEnabled(false);
+
+    static std::mutex buffersMutex;
+    static std::vector<std::unique_ptr<SThreadBuffer>> buffers;
+    static thread_local SThreadBuffer *threadBuffer = nullptr;
+
+    /// @brief      Returns the calling thread's buffer, creating it on first use.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static SThreadBuffer *getThreadBuffer()
+    {
+      if (!threadBuffer)
+      {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+
+        buffers.push_back(std::make_unique<SThreadBuffer>(static_cast<std::uint32_t>(buffers.size() + 1)));
+        threadBuffer = buffers.back().get();
+      };
+
+      return threadBuffer;
+    }
+
+    /// @brief      Records a completed span in the calling thread's buffer. The oldest span is overwritten when the buffer is full.
+    /// @param[in]  name: The span name.
+    /// @param[in]  startTime: The start time (ns, monotonic).
+    /// @param[in]  duration: The duration (ns).
+    /// @param[in]  argument: Optional argument (page number, record count), or NO_ARGUMENT.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Slot written under its sequence.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void recordSpan(char const *name, std::uint64_t startTime, std::uint64_t duration, std::int64_t argument)
+    {
+      SThreadBuffer *buffer = getThreadBuffer();
+      std::uint64_t position = buffer->head.load(std::memory_order_relaxed);
+      SSlot &slot = buffer->spans[position & RING_MASK];
+
+      slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      slot.name.store(name, std::memory_order_relaxed);
+      slot.startTime.store(startTime, std::memory_order_relaxed);
+      slot.duration.store(duration, std::memory_order_relaxed);
+      slot.argument.store(argument, std::memory_order_relaxed);
+
+      slot.sequence.store(2 * position + 2, std::memory_order_release);
+      buffer->head.store(position + 1, std::memory_order_release);
+    }
+
+    /// @brief      Copies the span at a position of a buffer. The copy fails if the slot holds another span, or was rewritten
+    ///             while it was being copied.
+    /// @param[in]  buffer: The buffer.
+    /// @param[in]  position: The position of the span.
+    /// @param[out] span: The copy of the span.
+    /// @returns    true if the span was copied.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool readSpan(SThreadBuffer const &buffer, std::uint64_t position, SSpan &span)
+    {
+      SSlot const &slot = buffer.spans[position & RING_MASK];
+      std::uint64_t written = 2 * position + 2;
+
+      if (slot.sequence.load(std::memory_order_acquire) != written)
+      {
+        return false;
+      };
+
+      span.name = slot.name.load(std::memory_order_relaxed);
+      span.startTime = slot.startTime.load(std::memory_order_relaxed);
+      span.duration = slot.duration.load(std::memory_order_relaxed);
+      span.argument = slot.argument.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      return (slot.sequence.load(std::memory_order_relaxed) == written);
+    }
+
+    /// @brief      Enables the recording of spans.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void enable()
+    {
+      tracingEnabled.store(true, std::memory_order_relaxed);
+    }
+
+    /// @brief      Disables the recording of spans. Spans already recorded are retained for export.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void disable()
+    {
+      tracingEnabled.store(false, std::memory_order_relaxed);
+    }
+
+    /// @brief      Discards all the recorded spans.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> lock(buffersMutex);
+
+      for (auto &buffer : buffers)
+      {
+        buffer->clearedAt = buffer->head.load(std::memory_order_acquire);
+      };
+    }
+
+    /// @brief      Writes the recorded spans to a file in the Chrome trace event (JSON) format. The threads keep recording; spans
+    ///             that are overwritten before they have been copied are left out.
+    /// @param[in]  fileName: The file to write.
+    /// @returns    true if the file was written.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Spans copied under the sequence of their slot.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool exportChromeTrace(std::string const &fileName)
+    {
+      std::FILE *file = std::fopen(fileName.c_str(), "w");
+      bool first = true;
+      long processID = 0;
+
+      if (!file)
+      {
+        return false;
+      };
+
+#ifdef __unix__
+      processID = static_cast<long>(::getpid());
+#endif
+
+      std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+
+      std::lock_guard<std::mutex> lock(buffersMutex);
+
+      for (auto const &buffer : buffers)
+      {
+        std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        std::uint64_t tail = (head > RING_CAPACITY) ? head - RING_CAPACITY : 0;
+
+        if (tail < buffer->clearedAt)
+        {
+          tail = buffer->clearedAt;
+        };
+
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%ld,\"tid\":%u,\"args\":{\"name\":\"WSd-%u\"}}",
+                     first ? "" : ",\n", processID, buffer->threadID, buffer->threadID);
+        first = false;
+
+        for (std::uint64_t position = tail; position < head; position++)
+        {
+          SSpan span;
+
+          if (!readSpan(*buffer, position, span))
+          {
+            continue;                             // Overwritten by the thread.
+          };
+
+            // Timestamps are in microseconds. Three decimals retain the nanosecond resolution.
+
+          std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"WSd\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%u",
+                       span.name, span.startTime / 1000.0, span.duration / 1000.0, processID, buffer->threadID);
+
+          if (span.argument != NO_ARGUMENT)
+          {
+            std::fprintf(file, ",\"args\":{\"value\":%lld}", static_cast<long long>(span.argument));
+          };
+
+          std::fputs("}", file);
+        };
+      };
+
+      std::fputs("\n]}\n", file);
+
+      bool returnValue = (std::ferror(file) == 0);
+      std::fclose(file);
+
+      return returnValue;
+    }
+
+  } // namespace tracing
+} // namespace WSd
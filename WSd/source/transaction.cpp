@@ -0,0 +1,176 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Transaction
+// SUBSYSTEM:						Console transactions
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Awaitables for writing console transactions as coroutines over an asynchronous socket.
+//
+// HISTORY:             2026-10-19/GGB - Reads on an unconnected socket completed straight away.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/transaction.h"
+
+  // Miscellaneous library header files
+
+#include <QMetaObject>
+
+namespace WSd
+{
+  /// @brief      Constructor.
+  /// @param[in]  s: The socket to wait on.
+  /// @param[in]  timeout: The timeout (ms).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CSocketAwaiter::CSocketAwaiter(QAbstractSocket &s, int timeout) : socket(s)
+  {
+    timer.setSingleShot(true);
+    timer.setInterval(timeout);
+  }
+
+  /// @brief      Records the suspended coroutine and starts the timeout. The timer is the context object of all the signal
+  ///             connections made by the awaitables, so the connections are removed when the awaitable is destroyed.
+  /// @param[in]  handle: The suspended coroutine.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CSocketAwaiter::suspend(std::coroutine_handle<> handle)
+  {
+    awaiting = handle;
+
+    QObject::connect(&timer, &QTimer::timeout, &timer, [this]()
+    {
+      timedOut = true;
+      finish();
+    });
+
+    timer.start();
+  }
+
+  /// @brief      Completes the wait. The coroutine is resumed from the event loop once the current signal has been handled.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CSocketAwaiter::finish()
+  {
+    if (!finished)
+    {
+      finished = true;
+      timer.stop();
+      QObject::disconnect(&socket, nullptr, &timer, nullptr);
+
+      std::coroutine_handle<> handle = awaiting;
+      QMetaObject::invokeMethod(&socket, [handle]() { handle.resume(); }, Qt::QueuedConnection);
+    };
+  }
+
+  /// @brief      Constructor.
+  /// @param[in]  s: The socket to connect.
+  /// @param[in]  host: The host address.
+  /// @param[in]  p: The port.
+  /// @param[in]  timeout: The connection timeout (ms).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CConnectAwaiter::CConnectAwaiter(QAbstractSocket &s, QString const &host, std::uint16_t p, int timeout)
+    : CSocketAwaiter(s, timeout), hostAddress(host), port(p)
+  {
+  }
+
+  /// @brief      Starts the connection. A connection that has not completed when the timeout expires is aborted, so the socket
+  ///             does not connect after the coroutine has been resumed.
+  /// @param[in]  handle: The suspended coroutine.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Connection aborted on timeout.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CConnectAwaiter::await_suspend(std::coroutine_handle<> handle)
+  {
+    socket.abort();
+
+      // Connected before the timeout handler of suspend(), so the socket is aborted before the wait is completed.
+
+    QObject::connect(&timer, &QTimer::timeout, &timer, [this]()
+    {
+      QObject::disconnect(&socket, nullptr, &timer, nullptr);
+      socket.abort();
+    });
+
+    QObject::connect(&socket, &QAbstractSocket::stateChanged, &timer, [this](QAbstractSocket::SocketState state)
+    {
+      if (state == QAbstractSocket::ConnectedState)
+      {
+        connected = true;
+        finish();
+      }
+      else if (state == QAbstractSocket::UnconnectedState)
+      {
+        finish();
+      };
+    });
+
+    suspend(handle);
+    socket.connectToHost(hostAddress, port);
+  }
+
+  /// @brief      Constructor.
+  /// @param[in]  s: The socket to read from.
+  /// @param[in]  bytes: The number of bytes to read.
+  /// @param[in]  timeout: The timeout (ms).
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReadAwaiter::CReadAwaiter(QAbstractSocket &s, qint64 bytes, int timeout) : CSocketAwaiter(s, timeout), size(bytes)
+  {
+  }
+
+  /// @brief      Waits for the data to arrive. Nothing arrives on a socket that is not connected (eg a connection aborted to
+  ///             cancel the transaction), so the wait is completed straight away.
+  /// @param[in]  handle: The suspended coroutine.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Completed straight away if the socket is not connected.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReadAwaiter::await_suspend(std::coroutine_handle<> handle)
+  {
+    QObject::connect(&socket, &QIODevice::readyRead, &timer, [this]()
+    {
+      if (socket.bytesAvailable() >= size)
+      {
+        finish();
+      };
+    });
+    QObject::connect(&socket, &QAbstractSocket::disconnected, &timer, [this]() { finish(); });
+
+    suspend(handle);
+
+    if (socket.state() == QAbstractSocket::UnconnectedState)
+    {
+      finish();
+    };
+  }
+
+} // namespace WSd
@@ -0,0 +1,519 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								weatherDatabase
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt, WCL
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Access to the weather database by the acquisition. MySQL databases are accessed through WCL. SQLite
+//                      databases, which WCL does not support, are accessed directly through a single long lived connection with
+//                      prepared statements and batched transactions.
+//                      A Qt SQL connection may only be used by the thread that created it. The weather database is only accessed
+//                      from a thread of its own (the database thread), so connecting to the database never blocks the event loop.
+//                      The functions may be called from any thread; they run on the database thread and wait for the result. The
+//                      event loop does not wait: it awaits the Async functions, which resume it when the database thread is done.
+//
+// HISTORY:             2026-10-19/GGB - Database accessed from the database thread.
+//                      2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/weatherDatabase.h"
+
+  // Standard C++ library header files
+
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+#include <utility>
+
+  // Miscellaneous library header files
+
+#include <QCL>
+#include <QSqlDatabase>
+#include <WCL>
+
+  // WSd header files
+
+#include "include/executor.h"
+#include "include/logger.h"
+#include "include/sqlArchive.h"
+#include "include/tracer.h"
+
+namespace WSd
+{
+  namespace weatherDatabase
+  {
+    typedef std::remove_reference_t<decltype(std::declval<WCL::SDumpPage &>().record[0])> TWCLRecord;
+
+    static_assert(sizeof(TWCLRecord) == ARCHIVE_RECORD_SIZE, "WCL archive record is not a Rev B archive record.");
+
+    static char const SQLITE_CONNECTION[] = "WSd-archive";
+    static char const MAINTENANCE_CONNECTION[] = "WSd-maintenance";
+    static char const LOOKUP_CONNECTION[] = "WSd-lookup";       // Records not inserted by WCL looked up. (MySQL)
+    static std::int64_t const MJD_UNIX_EPOCH = 40587;          // MJD of 1970-01-01.
+
+    static bool sqlite = false;
+    static configuration::SDatabaseConfiguration sqliteDatabase;
+    static configuration::SDatabaseConfiguration mysqlDatabase;
+    static bool batchOpen = false;
+    static thread_local bool databaseThread = false;           // The calling thread is the database thread.
+
+    /// @brief      Returns the executor of the database thread. (One worker.)
+    /// @returns    The executor.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static CExecutor &databaseExecutor()
+    {
+      static CExecutor executor(1);
+
+      return executor;
+    }
+
+    /// @brief      Runs a function on the database thread and waits for the result. The function is called directly on the
+    ///             database thread.
+    /// @param[in]  function: The function to run.
+    /// @returns    The result of the function.
+    /// @throws     Exceptions thrown by the function.
+    /// @version    2026-10-19/GGB - Function created.
+
+    template<typename F>
+    static std::invoke_result_t<F> run(F function)
+    {
+      if (databaseThread)
+      {
+        return function();
+      }
+      else
+      {
+        return databaseExecutor().async([&function]()
+        {
+          databaseThread = true;
+          return function();
+        }).get();
+      };
+    }
+
+    /// @brief      Runs a function on the database thread without waiting. The awaiting coroutine is resumed by the database
+    ///             thread when the function has completed.
+    /// @param[in]  function: The function to run.
+    /// @returns    The result of the function.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    template<typename F>
+    static CAsyncResult<std::invoke_result_t<F>> post(F function)
+    {
+      CAsyncResult<std::invoke_result_t<F>> result;
+
+      databaseExecutor().submit([result, function]() mutable
+      {
+        databaseThread = true;
+        result.run(function);
+      });
+
+      return result;
+    }
+
+    /// @brief      Runs a sequence of calls on the database thread with one switch of thread (eg a batch of inserts), without
+    ///             waiting.
+    /// @param[in]  function: The function to run.
+    /// @returns    The result of the function, to be awaited.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Awaitable result returned. The calling thread does not wait.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CAsyncResult<bool> executeAsync(std::function<bool()> function)
+    {
+      return post(std::move(function));
+    }
+
+    /// @brief      Opens the database on the database thread without waiting.
+    /// @param[in]  database: The database settings.
+    /// @param[in]  reconnect: The connection is created again from the settings first.
+    /// @returns    The result of open(), to be awaited.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Awaitable result returned.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CAsyncResult<bool> openAsync(configuration::SDatabaseConfiguration const &database, bool reconnect)
+    {
+      return post([database, reconnect]()
+      {
+        if (reconnect)
+        {
+          connect(database);
+        };
+        return open();
+      });
+    }
+
+    /// @brief      Maintains the database on the database thread without waiting.
+    /// @param[in]  configuration: The configuration snapshot.
+    /// @returns    The result of maintain(), to be awaited.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Awaitable result returned.
+    /// @version    2026-10-19/GGB - Function created.
+
+    CAsyncResult<bool> maintainAsync(configuration::PConfiguration configuration)
+    {
+      return post([configuration]()
+      {
+        return maintain(*configuration);
+      });
+    }
+
+    /// @brief      Creates the weather database connection from the configuration snapshot. The settings file is not consulted.
+    ///             An existing SQLite connection is closed.
+    /// @param[in]  database: The database settings.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - SQLite databases added.
+    /// @version    2026-10-19/GGB - Moved from the state machine. (Also used by the importer.)
+    /// @version    2026-10-19/GGB - Function created.
+
+    void connect(configuration::SDatabaseConfiguration const &database)
+    {
+      if (!databaseThread)
+      {
+        run([&]() { connect(database); });
+        return;
+      };
+
+      disconnect();
+
+      sqlite = (database.driver == "SQLITE");
+
+      if (sqlite)
+      {
+        sqliteDatabase = database;
+      }
+      else if (database.driver == "MYSQL")
+      {
+        mysqlDatabase = database;
+        WCL::database.createConnection(QCL::QDRV_MYSQL, database.hostAddress, database.port, database.databaseName,
+                                       database.userName, database.password);
+      };
+    }
+
+    /// @brief      Closes the SQLite connection. (MySQL connections are closed after each poll by close().)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void disconnect()
+    {
+      if (!databaseThread)
+      {
+        run([]() { disconnect(); });
+        return;
+      };
+
+      if (sqlite)
+      {
+        endBatch();
+        sql::closeConnection(SQLITE_CONNECTION);
+      };
+    }
+
+    /// @brief      Opens the database before a poll. A SQLite connection is opened once and then kept open, so that the
+    ///             prepared statements and the page cache are retained between polls.
+    /// @returns    true if the database is open.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool open()
+    {
+      if (!databaseThread)
+      {
+        return run([]() { return open(); });
+      };
+
+      if (sqlite)
+      {
+        return sql::openConnection(SQLITE_CONNECTION, sqliteDatabase);
+      }
+      else
+      {
+        return WCL::database.openDatabase();
+      };
+    }
+
+    /// @brief      Closes the database after a poll. SQLite connections are left open.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Lookup connection closed.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void close()
+    {
+      if (!databaseThread)
+      {
+        run([]() { close(); });
+        return;
+      };
+
+      if (!sqlite)
+      {
+        WCL::database.closeDatabase();
+        sql::closeConnection(LOOKUP_CONNECTION);
+      };
+    }
+
+    /// @brief      Reads the date and time of the latest record of a station.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[out] date: The date of the record. (MJD)
+    /// @param[out] time: The time of the record. (HHMM)
+    /// @returns    false if there are no records. (SQLite only. date and time are set to zero.)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool lastWeatherRecord(std::uint32_t siteID, std::uint32_t instrumentID, std::uint16_t &date, std::uint16_t &time)
+    {
+      if (!databaseThread)
+      {
+        return run([&]() { return lastWeatherRecord(siteID, instrumentID, date, time); });
+      };
+
+      if (sqlite)
+      {
+        SArchiveRecord record;
+        bool found = false;
+
+        if (!sql::lastRecord(SQLITE_CONNECTION, siteID, instrumentID, record, found) || !found)
+        {
+          date = 0;
+          time = 0;
+          return false;
+        };
+
+        std::int64_t day = (record.timeStamp >= 0) ? record.timeStamp / 86400 : (record.timeStamp - 86399) / 86400;
+        std::int64_t seconds = record.timeStamp - day * 86400;
+
+        date = static_cast<std::uint16_t>(day + MJD_UNIX_EPOCH);
+        time = static_cast<std::uint16_t>((seconds / 3600) * 100 + (seconds % 3600) / 60);
+      }
+      else
+      {
+        WCL::database.lastWeatherRecord(siteID, instrumentID, date, time);
+      };
+
+      return true;
+    }
+
+    /// @brief      Starts a batch of inserts. With SQLite the batch is one transaction, so the log is written once per batch
+    ///             rather than once per record. (WCL commits each insert.)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    void beginBatch()
+    {
+      if (!databaseThread)
+      {
+        run([]() { beginBatch(); });
+        return;
+      };
+
+      if (sqlite && !batchOpen)
+      {
+        batchOpen = QSqlDatabase::database(SQLITE_CONNECTION, false).transaction();
+      };
+    }
+
+    /// @brief      Commits a batch of inserts. If the commit fails none of the records of the batch have been stored.
+    /// @returns    true if the batch was committed. (Or there was no batch to commit.)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Result of the commit returned.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool endBatch()
+    {
+      if (!databaseThread)
+      {
+        return run([]() { return endBatch(); });
+      };
+
+      bool returnValue = true;
+
+      if (batchOpen)
+      {
+        TRACESPAN("commitBatch");
+
+        QSqlDatabase database = QSqlDatabase::database(SQLITE_CONNECTION, false);
+
+        if (!database.commit())
+        {
+          LOGERROR("Unable to commit the archive records.");
+          database.rollback();
+          returnValue = false;
+        };
+        batchOpen = false;
+      };
+
+      return returnValue;
+    }
+
+    /// @brief      Inserts an archive record. Records already in the database are not inserted.
+    /// @param[in]  siteID: The site ID.
+    /// @param[in]  instrumentID: The instrument ID.
+    /// @param[in]  record: The raw archive record.
+    /// @param[out] inserted: true if the record was inserted, false if it was already in the database or is not a valid record.
+    /// @returns    false if the insert failed.
+    /// @throws     std::bad_alloc
+    /// @note       WCL does not distinguish a record that is already in the database from a failed insert. A record that WCL
+    ///             did not insert is looked up; the insert failed if it is not in the database.
+    /// @version    2026-10-19/GGB - MySQL inserts that failed reported as failed.
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Failed inserts distinguished from records already in the database.
+    /// @version    2026-10-19/GGB - Function created. (Moved from CIngest::ingest())
+
+    bool insertRecord(std::uint32_t siteID, std::uint32_t instrumentID, TRawRecord const &record, bool &inserted)
+    {
+      if (!databaseThread)
+      {
+        return run([&]() { return insertRecord(siteID, instrumentID, record, inserted); });
+      };
+
+      inserted = false;
+
+      if (sqlite)
+      {
+        SArchiveRecord decodedRecord;
+
+        return !decodedRecord.decode(record.data()) ||
+               sql::insertRecord(SQLITE_CONNECTION, siteID, instrumentID, decodedRecord, inserted);
+      }
+      else
+      {
+        TWCLRecord wclRecord;
+        SArchiveRecord decodedRecord;
+        bool found;
+
+        std::memcpy(&wclRecord, record.data(), sizeof(wclRecord));
+        inserted = WCL::database.insertRecord(siteID, instrumentID, wclRecord);
+
+        if (inserted)
+        {
+          return true;
+        }
+        else if (!decodedRecord.decode(record.data()))
+        {
+          return true;                            // Not a valid record. Not inserted, as with SQLite.
+        };
+
+          // Not inserted by WCL. The insert failed unless the record is already in the database.
+
+        return sql::openConnection(LOOKUP_CONNECTION, mysqlDatabase) &&
+               sql::containsRecord(LOOKUP_CONNECTION, siteID, instrumentID, decodedRecord.timeStamp, found) && found;
+      };
+    }
+
+    /// @brief      Returns the current month.
+    /// @returns    The month. (year * 12 + month - 1)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created. (Moved from maintain())
+
+    static std::int32_t thisMonth()
+    {
+      std::time_t now = std::time(nullptr);
+      struct tm currentTime;
+
+      localtime_r(&now, &currentTime);
+
+      return (currentTime.tm_year + 1900) * 12 + currentTime.tm_mon;
+    }
+
+    /// @brief      Partitions the archive table of a MySQL database by month. The table is rebuilt, so this is run with
+    ///             --partition while the daemon is stopped. SQLite databases have no partitions.
+    /// @param[in]  configuration: The configuration snapshot.
+    /// @returns    true if successful.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool partition(configuration::SConfiguration const &configuration)
+    {
+      if (!databaseThread)
+      {
+        return run([&]() { return partition(configuration); });
+      };
+
+      bool returnValue;
+
+      if (sqlite)
+      {
+        LOGINFO("SQLite databases are not partitioned.");
+        return true;
+      };
+
+      returnValue = sql::openConnection(MAINTENANCE_CONNECTION, configuration.database) &&
+                    sql::partitionArchive(MAINTENANCE_CONNECTION, thisMonth());
+      sql::closeConnection(MAINTENANCE_CONNECTION);
+
+      return returnValue;
+    }
+
+    /// @brief      Maintains the archive table: creates the monthly partitions ahead of time (MySQL) and removes the months
+    ///             that are older than the retention period. MySQL tables are maintained through a separate connection, as DDL
+    ///             cannot be run through WCL.
+    /// @param[in]  configuration: The configuration snapshot.
+    /// @returns    true if successful.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Runs on the database thread.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool maintain(configuration::SConfiguration const &configuration)
+    {
+      if (!databaseThread)
+      {
+        return run([&]() { return maintain(configuration); });
+      };
+
+      std::int32_t currentMonth = thisMonth();
+      bool returnValue;
+
+      TRACESPAN("maintainDatabase");
+
+      if (sqlite)
+      {
+        returnValue = sql::expireRecords(SQLITE_CONNECTION, currentMonth, configuration.retentionMonths,
+                                         configuration.retentionArchive);
+      }
+      else
+      {
+        returnValue = sql::openConnection(MAINTENANCE_CONNECTION, configuration.database) &&
+                      sql::maintainPartitions(MAINTENANCE_CONNECTION, currentMonth, configuration.retentionMonths,
+                                              configuration.retentionArchive);
+        sql::closeConnection(MAINTENANCE_CONNECTION);
+      };
+
+      return returnValue;
+    }
+
+  } // namespace weatherDatabase
+} // namespace WSd
@@ -0,0 +1,249 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								wireCapture
+// SUBSYSTEM:						Transport
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Capture of the raw bytes exchanged with the console. Each record is stamped with the monotonic time since
+//                      the previous record, so that a session can be replayed with its original timing.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/wireCapture.h"
+
+  // WSd header files
+
+#include "include/logger.h"
+
+namespace WSd
+{
+  static char const MAGIC[] = "WSDW";
+  static qsizetype const MAGIC_SIZE = 4;
+  static char const VERSION = 1;
+
+  /// @brief      Constructor. The file is not opened until open() is called.
+  /// @param[in]  fileName: The capture file.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CWireCapture::CWireCapture(QString const &fileName) : file(fileName)
+  {
+  }
+
+  /// @brief      Destructor. Writes the buffered records.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CWireCapture::~CWireCapture()
+  {
+    flush();
+  }
+
+  /// @brief      Opens the capture file for appending. The header is written if the file is empty.
+  /// @returns    true if the file was opened.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CWireCapture::open()
+  {
+    bool returnValue = file.open(QIODevice::WriteOnly | QIODevice::Append);
+
+    if (!returnValue)
+    {
+      LOGERROR("Unable to open capture file {}.", file.fileName().toStdString());
+    }
+    else if (file.size() == 0)
+    {
+      buffer.append(MAGIC, MAGIC_SIZE);
+      buffer.append(VERSION);
+      returnValue = flush();
+    };
+
+      // The time of the first record is not related to the records of an earlier capture in the file.
+
+    firstRecord = true;
+
+    return returnValue;
+  }
+
+  /// @brief      Writes the buffered records to the file.
+  /// @returns    true if the records were written.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CWireCapture::flush()
+  {
+    bool returnValue = true;
+
+    if (file.isOpen() && !buffer.isEmpty())
+    {
+      returnValue = (file.write(buffer) == buffer.size()) && file.flush();
+
+      if (!returnValue)
+      {
+        LOGERROR("Unable to write capture file {}.", file.fileName().toStdString());
+      };
+    };
+
+    buffer.clear();
+
+    return returnValue;
+  }
+
+  /// @brief      Appends an unsigned LEB128 varint.
+  /// @param[in]  output: The buffer to append to.
+  /// @param[in]  value: The value to append.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CWireCapture::appendVarint(QByteArray &output, std::uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      output.append(static_cast<char>((value & 0x7F) | 0x80));
+      value >>= 7;
+    };
+
+    output.append(static_cast<char>(value));
+  }
+
+  /// @brief      Reads an unsigned LEB128 varint.
+  /// @param[in]  input: The buffer to read from.
+  /// @param[in,out] position: The position of the varint. Updated to the byte following the varint.
+  /// @param[out] value: The value read.
+  /// @returns    false if the varint is truncated or too long.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CWireCapture::readVarint(QByteArray const &input, qsizetype &position, std::uint64_t &value)
+  {
+    value = 0;
+
+    for (int shift = 0; (shift < 64) && (position < input.size()); shift += 7)
+    {
+      std::uint8_t byte = static_cast<std::uint8_t>(input[position++]);
+
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+      if ((byte & 0x80) == 0)
+      {
+        return true;
+      };
+    };
+
+    return false;
+  }
+
+  /// @brief      Records an event on the connection. The records are buffered and written when the connection is closed, or when
+  ///             the buffer is full, so that capturing does not add file writes to the exchange with the console.
+  /// @param[in]  type: The type of the record.
+  /// @param[in]  data: The data of the record. May be nullptr if size is zero.
+  /// @param[in]  size: The number of bytes of data.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CWireCapture::record(ERecord type, char const *data, qint64 size)
+  {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::uint64_t delay = 0;
+
+    if (!file.isOpen())
+    {
+      return;
+    };
+
+    if (!firstRecord)
+    {
+      delay = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - previousTime).count());
+    };
+    firstRecord = false;
+    previousTime = now;
+
+    buffer.append(static_cast<char>(type));
+    appendVarint(buffer, delay);
+    appendVarint(buffer, static_cast<std::uint64_t>(size));
+    if (size > 0)
+    {
+      buffer.append(data, size);
+    };
+
+    if ( (type == WR_DISCONNECT) || (buffer.size() >= FLUSH_SIZE) )
+    {
+      flush();
+    };
+  }
+
+  /// @brief      Reads all the records of a capture file. A truncated final record (the daemon stopped while capturing) is
+  ///             ignored.
+  /// @param[in]  fileName: The capture file.
+  /// @param[out] records: The records of the file.
+  /// @returns    true if the file was read.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  bool CWireCapture::read(QString const &fileName, std::vector<SRecord> &records)
+  {
+    QFile input(fileName);
+    QByteArray contents;
+    qsizetype position = MAGIC_SIZE + 1;
+
+    records.clear();
+
+    if (!input.open(QIODevice::ReadOnly))
+    {
+      LOGERROR("Unable to open capture file {}.", fileName.toStdString());
+      return false;
+    };
+
+    contents = input.readAll();
+
+    if ( (contents.size() < position) || (contents.left(MAGIC_SIZE) != QByteArray(MAGIC, MAGIC_SIZE)) ||
+         (contents[MAGIC_SIZE] != VERSION) )
+    {
+      LOGERROR("{} is not a capture file.", fileName.toStdString());
+      return false;
+    };
+
+    while (position < contents.size())
+    {
+      std::uint8_t type = static_cast<std::uint8_t>(contents[position++]);
+      std::uint64_t delay;
+      std::uint64_t size;
+
+      if ( (type > WR_DISCONNECT) || !readVarint(contents, position, delay) || !readVarint(contents, position, size) ||
+           (size > static_cast<std::uint64_t>(contents.size() - position)) )
+      {
+        LOGWARNING("Capture file {} truncated after {} records.", fileName.toStdString(), records.size());
+        break;
+      };
+
+      records.push_back(SRecord{static_cast<ERecord>(type), delay, contents.mid(position, static_cast<qsizetype>(size))});
+      position += static_cast<qsizetype>(size);
+    };
+
+    return true;
+  }
+
+} // namespace WSd
@@ -0,0 +1,416 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								wireReplay
+// SUBSYSTEM:						Transport
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Deterministic replay of captured console sessions. A loopback server plays the console side of a capture
+//                      file to a CTCPSocket, either with the original timing or as fast as possible, and the latency and throughput
+//                      of the transactions are reported.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/wireReplay.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <memory>
+
+  // Miscellaneous library header files
+
+#include <QEventLoop>
+#include <QHostAddress>
+
+  // WSd header files
+
+#include "include/ingest.h"
+#include "include/logger.h"
+#include "include/task.h"
+#include "include/tcp.h"
+#include "include/weatherDatabase.h"
+
+namespace WSd
+{
+  /// @brief      Constructor.
+  /// @param[in]  r: The records of the capture. Must remain valid for the life of the server.
+  /// @param[in]  rt: true to replay with the original timing, false to replay as fast as possible.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReplayServer::CReplayServer(std::vector<CWireCapture::SRecord> const &r, bool rt) : QTcpServer(), records(r), realTime(rt)
+  {
+    delayTimer.setSingleShot(true);
+    delayTimer.setTimerType(Qt::PreciseTimer);
+
+    connect(&delayTimer, &QTimer::timeout, this, [this]()
+    {
+      delayed = true;
+      play();
+    });
+    connect(this, &QTcpServer::newConnection, this, [this]() { acceptConnection(); });
+  }
+
+  /// @brief      Destructor.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  CReplayServer::~CReplayServer()
+  {
+    closeConnection();
+  }
+
+  /// @brief      Accepts a connection from the client and starts playing the next session. A connection made while the previous
+  ///             session is still open aborts the previous session.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReplayServer::acceptConnection()
+  {
+    QTcpSocket *socket;
+
+    while ((socket = nextPendingConnection()) != nullptr)
+    {
+      if (connection)
+      {
+        LOGWARNING("Replay session aborted by a new connection.");
+        sessionsAborted++;
+        closeConnection();
+      };
+
+      skipSession();
+
+      if (position >= records.size())
+      {
+        LOGWARNING("Replay connection closed. All the captured sessions have been played.");
+        socket->abort();
+        socket->deleteLater();
+      }
+      else
+      {
+        position++;                                   // The connect record.
+        connection = socket;
+        pending.clear();
+        delayed = false;
+
+        connect(socket, &QIODevice::readyRead, this, [this, socket]()
+        {
+          if (socket == connection)
+          {
+            pending.append(socket->readAll());
+            play();
+          };
+        });
+        connect(socket, &QAbstractSocket::disconnected, this, [this, socket]()
+        {
+          if (socket == connection)
+          {
+            if ( (position < records.size()) && (records[position].type != CWireCapture::WR_CONNECT) )
+            {
+              LOGWARNING("Replay session closed by the client before the end of the session.");
+              sessionsAborted++;
+            };
+            closeConnection();
+          };
+        });
+
+        play();
+      };
+    };
+  }
+
+  /// @brief      Closes the connection to the client.
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReplayServer::closeConnection()
+  {
+    if (connection)
+    {
+      QTcpSocket *socket = connection;
+
+      connection = nullptr;
+      delayTimer.stop();
+      socket->disconnect(this);
+      socket->disconnectFromHost();
+      socket->deleteLater();
+    };
+  }
+
+  /// @brief      Moves to the start of the next session. (The connect record.)
+  /// @throws     None.
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReplayServer::skipSession()
+  {
+    while ( (position < records.size()) && (records[position].type != CWireCapture::WR_CONNECT) )
+    {
+      position++;
+    };
+  }
+
+  /// @brief      Plays the records of the session until the client has to send more data, a delay has to elapse or the session
+  ///             ends.
+  /// @throws     std::bad_alloc
+  /// @version    2026-10-19/GGB - Function created.
+
+  void CReplayServer::play()
+  {
+    while ( (connection != nullptr) && (position < records.size()) )
+    {
+      CWireCapture::SRecord const &record = records[position];
+
+      switch (record.type)
+      {
+        case CWireCapture::WR_SENT:
+        {
+          if (pending.size() < record.data.size())
+          {
+            return;
+          };
+
+          if (!pending.startsWith(record.data))
+          {
+            LOGDEBUG("Replay: bytes sent by the client differ from the capture.");
+            mismatches++;
+          };
+          pending.remove(0, record.data.size());
+          break;
+        };
+        case CWireCapture::WR_RECEIVED:
+        {
+            // The delay of a received record is the response time of the console.
+
+          if (realTime && !delayed && (record.delay >= 1000))
+          {
+            delayTimer.start(static_cast<int>(record.delay / 1000));
+            return;
+          };
+
+          delayed = false;
+          connection->write(record.data);
+          bytesSent += static_cast<std::uint64_t>(record.data.size());
+          break;
+        };
+        case CWireCapture::WR_DISCONNECT:
+        {
+          position++;
+          closeConnection();
+          return;
+        };
+        case CWireCapture::WR_CONNECT:
+        {
+            // The session is complete. The client closes the connection.
+
+          return;
+        };
+      };
+
+      position++;
+    };
+  }
+
+  namespace wire
+  {
+    /// @brief The results of the transactions of a replay.
+
+    struct SStatistics
+    {
+      std::size_t failed = 0;
+      std::vector<double> latencies;                            // ms
+    };
+
+    /// @brief      Runs the transactions of the captured sessions, in order.
+    /// @param[in]  socket: The socket connected to the replay server.
+    /// @param[in]  ingest: The ingest pipeline the archive records are passed to.
+    /// @param[in]  transactions: The transactions of the sessions.
+    /// @param[out] statistics: The results of the transactions.
+    /// @returns    true.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static CTask<bool> runTransactions(CTCPSocket &socket, CIngest &ingest, std::vector<QByteArray> const &transactions,
+                                       SStatistics &statistics)
+    {
+      for (QByteArray const &transaction : transactions)
+      {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool success;
+
+        if (transaction == "readArchive")
+        {
+          success = co_await socket.readArchive(ingest);
+        }
+        else if (transaction == "setTime")
+        {
+          success = co_await socket.setTime();
+        }
+        else
+        {
+          success = co_await socket.setInterval(static_cast<std::uint8_t>(transaction.mid(12).toUInt()));
+        };
+
+        statistics.latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        if (!success)
+        {
+          statistics.failed++;
+        };
+      };
+
+      co_return true;
+    }
+
+    /// @brief      Replays the sessions of a capture file through the console transactions of CTCPSocket and reports the
+    ///             latency and throughput. The archive records downloaded are passed through the ingest pipeline of the station.
+    /// @param[in]  fileName: The capture file.
+    /// @param[in]  realTime: true to replay with the original timing, false to replay as fast as possible.
+    /// @param[in]  configuration: The configuration. (Database, store and ingest settings.)
+    /// @param[in]  output: The stream the report is written to.
+    /// @returns    true if all the transactions succeeded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool replay(QString const &fileName, bool realTime, configuration::SConfiguration const &configuration,
+                std::ostream &output)
+    {
+      std::vector<CWireCapture::SRecord> records;
+      std::vector<QByteArray> transactions;
+      SStatistics statistics;
+      bool returnValue = false;
+
+      if (!CWireCapture::read(fileName, records))
+      {
+        output << "Unable to read capture file " << fileName.toStdString() << "." << std::endl;
+        return false;
+      };
+
+      for (CWireCapture::SRecord const &record : records)
+      {
+        if (record.type == CWireCapture::WR_CONNECT)
+        {
+          if ( (record.data != "readArchive") && (record.data != "setTime") && !record.data.startsWith("setInterval ") )
+          {
+            output << "Unknown transaction in capture file: " << record.data.toStdString() << std::endl;
+            return false;
+          };
+          transactions.push_back(record.data);
+        };
+      };
+
+      if (transactions.empty())
+      {
+        output << "No sessions in capture file " << fileName.toStdString() << "." << std::endl;
+        return false;
+      };
+
+      CReplayServer server(records, realTime);
+
+      if (!server.listen(QHostAddress::LocalHost, 0))
+      {
+        output << "Unable to start the replay server: " << server.errorString().toStdString() << std::endl;
+        return false;
+      };
+
+      weatherDatabase::connect(configuration.database);
+
+      if (!weatherDatabase::open())
+      {
+        output << "Unable to open the weather database." << std::endl;
+        weatherDatabase::disconnect();
+        return false;
+      };
+
+      {
+        configuration::SStationConfiguration station = configuration.station;
+        CIngest ingest(station.siteID, station.instrumentID, configuration);
+        bool completed = false;
+        QEventLoop eventLoop;
+
+        station.ipAddress = "127.0.0.1";
+        station.port = server.serverPort();
+
+        CTCPSocket socket(nullptr, station.siteID, station.instrumentID, station);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        runTransactions(socket, ingest, transactions, statistics).start([&](bool, std::exception_ptr exception)
+        {
+          if (exception)
+          {
+            try
+            {
+              std::rethrow_exception(exception);
+            }
+            catch (std::exception const &e)
+            {
+              LOGERROR("Replay failed: {}", e.what());
+            }
+            catch (...)
+            {
+              LOGERROR("Replay failed.");
+            };
+          };
+
+          completed = true;
+          eventLoop.quit();
+        });
+
+        if (!completed)
+        {
+          eventLoop.exec();
+        };
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::vector<double> latencies = statistics.latencies;
+
+        std::sort(latencies.begin(), latencies.end());
+
+        output << "Replayed " << latencies.size() << " of " << transactions.size() << " sessions from "
+               << fileName.toStdString() << (realTime ? " with the original timing" : " as fast as possible") << " in "
+               << elapsed << " s." << std::endl;
+        output << "Failed transactions: " << statistics.failed << ", aborted sessions: " << server.aborted()
+               << ", mismatched writes: " << server.mismatched() << std::endl;
+        output << "Received " << server.sent() << " bytes. ("
+               << ((elapsed > 0) ? static_cast<double>(server.sent()) / elapsed / 1024 : 0) << " KiB/s)" << std::endl;
+
+        if (!latencies.empty())
+        {
+          output << "Transaction latency (ms): minimum " << latencies.front() << ", median " << latencies[latencies.size() / 2]
+                 << ", maximum " << latencies.back() << std::endl;
+        };
+
+        returnValue = (latencies.size() == transactions.size()) && (statistics.failed == 0);
+      }
+
+      weatherDatabase::close();
+      weatherDatabase::disconnect();
+
+      return returnValue;
+    }
+
+  } // namespace wire
+} // namespace WSd
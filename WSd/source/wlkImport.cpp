@@ -0,0 +1,554 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								wlkImport
+// SUBSYSTEM:						Import
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Importer for the monthly archive files (.wlk) of the WeatherLink PC software. The files are memory mapped
+//                      and their days decoded in parallel into Rev B archive records, which are passed through the ingest pipeline.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/wlkImport.h"
+
+  // Standard C++ library header files
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <tuple>
+
+  // Miscellaneous library header files
+
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+  // WSd header files
+
+#include "include/executor.h"
+#include "include/ingest.h"
+#include "include/logger.h"
+#include "include/tracer.h"
+#include "include/weatherDatabase.h"
+
+namespace WSd
+{
+  namespace wlk
+  {
+      // Layout of a .wlk file. (WeatherLink 5.x and later.) A 212 byte header is followed by 88 byte records. The header holds
+      // the number of records and, for each day of the month, the number of records of the day and the index of its first
+      // record. Each day starts with two daily summary records, followed by the weather data records of the day.
+
+    static char const ID_CODE[] = "WDAT5.";
+    static std::size_t const HEADER_SIZE = 212;
+    static std::size_t const RECORD_COUNT_OFFSET = 16;
+    static std::size_t const DAY_INDEX_OFFSET = 20;
+    static std::size_t const DAY_INDEX_SIZE = 6;              // Records in the day (int16), first record (int32).
+    static std::size_t const RECORD_SIZE = 88;
+    static std::uint8_t const RT_WEATHER_DATA = 1;
+    static std::int16_t const DASH = -32768;
+
+    static std::size_t const FILES_PER_GROUP = 12;            // Files mapped and decoded together. (Bounds the memory used.)
+    static std::size_t const BATCH_RECORDS = 1440;            // Records passed to the ingest pipeline at a time.
+
+    /// @brief The records of one day of a file, decoded by one worker.
+
+    struct SDay
+    {
+      std::uint8_t const *data;                               // First record of the day.
+      std::size_t count;                                      // Records in the day. (Including the daily summaries.)
+      int year;
+      int month;
+      int day;
+      std::vector<TRawRecord> records;                        // The decoded weather data records.
+      std::vector<double> rainfall;                           // Rainfall of each record. (Clicks of the database collector.)
+    };
+
+    /// @brief      Reads a little endian 16 bit integer.
+    /// @param[in]  data: The first byte.
+    /// @returns    The value.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::int16_t readInt16(std::uint8_t const *data)
+    {
+      return static_cast<std::int16_t>(data[0] | (data[1] << 8));
+    }
+
+    /// @brief      Reads a little endian 32 bit integer.
+    /// @param[in]  data: The first byte.
+    /// @returns    The value.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::int32_t readInt32(std::uint8_t const *data)
+    {
+      return static_cast<std::int32_t>(static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8) |
+                                       (static_cast<std::uint32_t>(data[2]) << 16) | (static_cast<std::uint32_t>(data[3]) << 24));
+    }
+
+    /// @brief      Writes a little endian 16 bit integer.
+    /// @param[in]  data: The first byte.
+    /// @param[in]  value: The value. (Signed values are written as their two's complement.)
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void writeInt16(std::uint8_t *data, std::int32_t value)
+    {
+      data[0] = static_cast<std::uint8_t>(value & 0xFF);
+      data[1] = static_cast<std::uint8_t>((value >> 8) & 0xFF);
+    }
+
+    /// @brief      Returns the size of a rain click from the collector type held in the upper bits of the rain field.
+    /// @param[in]  rain: The rain field.
+    /// @returns    The click size (mm).
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static double clickSize(std::uint16_t rain)
+    {
+      switch (rain & 0xF000)
+      {
+        case 0x0000:
+          return 2.54;                                        // 0.1 in
+        case 0x1000:
+          return 0.254;                                       // 0.01 in
+        case 0x3000:
+          return 1.0;
+        case 0x6000:
+          return 0.1;
+        default:
+          return 0.2;
+      };
+    }
+
+    /// @brief      Converts a weather data record of a .wlk file to a Rev B archive record.
+    /// @param[in]  wlk: The 88 byte weather data record.
+    /// @param[in]  year: The year of the file.
+    /// @param[in]  month: The month of the file.
+    /// @param[in]  day: The day the record is filed under.
+    /// @param[out] raw: The archive record.
+    /// @param[out] rainfall: The rainfall of the record in clicks of the rain collector assumed by the weather database, before
+    ///                       it is rounded.
+    /// @returns    false if the date of the record cannot be held in an archive record. (Before 2000.)
+    /// @note       Units are converted to those of the console. Rain is converted to clicks of the rain collector assumed by the
+    ///             weather database. The rainfall is written by carryRainfall() when the records are ingested.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Rainfall returned before it is rounded.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool convertRecord(std::uint8_t const *wlk, int year, int month, int day, TRawRecord &raw, double &rainfall)
+    {
+      std::uint8_t *data = raw.data();
+      int hour, minute;
+
+        // The time is the end of the archive period in minutes after midnight. (1440 is midnight at the end of the day.)
+
+      SArchiveRecord::splitTimeStamp(SArchiveRecord::makeTimeStamp(year, month, day, 0, 0) + readInt16(wlk + 4) * 60,
+                                     year, month, day, hour, minute);
+
+      if ( (year < 2000) || (year > 2127) )
+      {
+        return false;
+      };
+
+      auto copy16 = [wlk, data](std::size_t to, std::size_t from, std::int32_t dash)
+      {
+        std::int16_t value = readInt16(wlk + from);
+
+        writeInt16(data + to, (value == DASH) ? dash : value);
+      };
+      auto tenths = [wlk](std::size_t from, std::uint8_t dash)
+      {
+        std::int16_t value = readInt16(wlk + from);
+
+        return (value == DASH) ? dash : static_cast<std::uint8_t>(std::clamp((value + 5) / 10, 0, 254));
+      };
+
+      std::uint16_t rain = static_cast<std::uint16_t>(readInt16(wlk + 20));
+      double rainScale = clickSize(rain) / RAIN_CLICK_DEFAULT;
+      std::int16_t rainRate = readInt16(wlk + 22);
+
+      std::memset(data, 0xFF, ARCHIVE_RECORD_SIZE);
+
+      writeInt16(data + 0, day + month * 32 + (year - 2000) * 512);
+      writeInt16(data + 2, hour * 100 + minute);
+      copy16(4, 6, 32767);                                    // Outside temperature.
+      copy16(6, 8, -32768);                                   // High outside temperature.
+      copy16(8, 10, 32767);                                   // Low outside temperature.
+      rainfall = (rain & 0x0FFF) * rainScale;
+      writeInt16(data + 12, (rainRate == DASH) ? 0 : static_cast<std::int32_t>(std::lround(rainRate * rainScale)));
+      copy16(14, 14, 0);                                      // Barometer.
+      copy16(16, 32, 32767);                                  // Solar radiation.
+      copy16(18, 30, 0);                                      // Wind samples.
+      copy16(20, 12, 32767);                                  // Inside temperature.
+      data[22] = tenths(18, 255);                             // Inside humidity.
+      data[23] = tenths(16, 255);                             // Outside humidity.
+      data[24] = tenths(24, 255);                             // Average wind speed.
+      data[25] = tenths(26, 0);                               // High wind speed.
+      data[26] = wlk[29];                                     // High wind direction.
+      data[27] = wlk[28];                                     // Prevailing wind direction.
+      data[28] = wlk[36];                                     // UV index.
+      data[29] = wlk[57];                                     // ET.
+      copy16(30, 34, 0);                                      // High solar radiation.
+      data[32] = (wlk[37] == 0xFF) ? 0 : wlk[37];             // High UV index.
+      data[33] = 0;                                           // Forecast rule. (Not in the file.)
+      std::memcpy(data + 34, wlk + 38, 2);                    // Leaf temperatures.
+      std::memcpy(data + 36, wlk + 70, 2);                    // Leaf wetness.
+      std::memcpy(data + 38, wlk + 58, 4);                    // Soil temperatures.
+      data[42] = 0x00;                                        // Rev B record.
+      std::memcpy(data + 43, wlk + 81, 2);                    // Extra humidities.
+      std::memcpy(data + 45, wlk + 74, 3);                    // Extra temperatures.
+      std::memcpy(data + 48, wlk + 64, 4);                    // Soil moistures.
+
+      return true;
+    }
+
+    /// @brief      Writes the rainfall of a record, rounded to whole clicks. The part of a click that is left is carried to the
+    ///             next record, so the rainfall totals are not biased by the rounding. The records must be passed in time order.
+    /// @param[in,out] raw: The archive record.
+    /// @param[in]  rainfall: The rainfall of the record before it is rounded.
+    /// @param[in,out] remainder: The part of a click carried from the previous record.
+    /// @throws     None.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void carryRainfall(TRawRecord &raw, double rainfall, double &remainder)
+    {
+      double exact = rainfall + remainder;
+      long value = std::lround(exact);
+
+      remainder = exact - value;
+      writeInt16(raw.data() + 10, static_cast<std::int32_t>(std::min(value, 0xFFFFL)));
+    }
+
+    /// @brief      Decodes the weather data records of a day.
+    /// @param[in]  day: The day. The records are written to day.records and their rainfall to day.rainfall.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Rainfall kept to be rounded when the records are ingested.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static void decodeDay(SDay &day)
+    {
+      day.records.reserve(day.count);
+      day.rainfall.reserve(day.count);
+
+      for (std::size_t index = 0; index < day.count; index++)
+      {
+        std::uint8_t const *record = day.data + index * RECORD_SIZE;
+
+        TRawRecord raw;
+        double rainfall;
+
+        if ( (record[0] == RT_WEATHER_DATA) && convertRecord(record, day.year, day.month, day.day, raw, rainfall) )
+        {
+          day.records.push_back(raw);
+          day.rainfall.push_back(rainfall);
+        };
+      };
+    }
+
+    /// @brief      Decodes days in parallel on the executor. The days are taken from a shared counter, so the work is balanced
+    ///             between the workers.
+    /// @param[in]  days: The days to decode.
+    /// @returns    true if all the days were decoded.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Option to decode on the calling thread removed.
+    /// @version    2026-10-19/GGB - Days decoded on the shared executor rather than on threads of their own.
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool decodeDays(std::vector<SDay> &days)
+    {
+      TRACESPAN("wlkDecode", days.size());
+
+      try
+      {
+        CExecutor::global().parallelFor(days.size(), [&days](std::size_t index) { decodeDay(days[index]); });
+      }
+      catch (...)
+      {
+        return false;
+      };
+
+      return true;
+    }
+
+    /// @brief      Returns the year and month of a .wlk file from its name. (YYYY-MM.wlk)
+    /// @param[in]  fileName: The file name.
+    /// @param[out] year: The year.
+    /// @param[out] month: The month.
+    /// @returns    false if the name is not the name of a .wlk file.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool parseFileName(QString const &fileName, int &year, int &month)
+    {
+      QStringList parts = QFileInfo(fileName).completeBaseName().split('-', Qt::SkipEmptyParts);
+      bool yearValid = false, monthValid = false;
+
+      if (parts.size() == 2)
+      {
+        year = parts[0].toInt(&yearValid);
+        month = parts[1].toInt(&monthValid);
+      };
+
+      return yearValid && monthValid && (month >= 1) && (month <= 12);
+    }
+
+    /// @brief      Finds the days of a mapped .wlk file.
+    /// @param[in]  data: The mapped file.
+    /// @param[in]  size: The size of the file.
+    /// @param[in]  year: The year of the file.
+    /// @param[in]  month: The month of the file.
+    /// @param[out] days: The days are appended.
+    /// @returns    false if the file is not a .wlk file.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static bool indexFile(std::uint8_t const *data, std::size_t size, int year, int month, std::vector<SDay> &days)
+    {
+      if ( (size < HEADER_SIZE) || (std::memcmp(data, ID_CODE, sizeof(ID_CODE) - 1) != 0) )
+      {
+        return false;
+      };
+
+      std::int64_t recordCount = readInt32(data + RECORD_COUNT_OFFSET);
+
+        // A file that is still being written by WeatherLink may be shorter than its header says.
+
+      recordCount = std::clamp<std::int64_t>(recordCount, 0, static_cast<std::int64_t>((size - HEADER_SIZE) / RECORD_SIZE));
+
+      for (int day = 1; day <= 31; day++)
+      {
+        std::uint8_t const *entry = data + DAY_INDEX_OFFSET + day * DAY_INDEX_SIZE;
+        std::int64_t count = readInt16(entry);
+        std::int64_t first = readInt32(entry + 2);
+        int checkYear, checkMonth, checkDay, hour, minute;
+
+        SArchiveRecord::splitTimeStamp(SArchiveRecord::makeTimeStamp(year, month, day, 0, 0), checkYear, checkMonth, checkDay,
+                                       hour, minute);
+
+        count = std::min(count, recordCount - first);
+
+        if ( (count > 0) && (first >= 0) && (checkMonth == month) )
+        {
+          days.push_back(SDay{ data + HEADER_SIZE + first * RECORD_SIZE, static_cast<std::size_t>(count), year, month, day, {},
+                               {} });
+        };
+      };
+
+      return true;
+    }
+
+    /// @brief      Passes a batch of records through the ingest pipeline and waits for it to be written. The batch is written on
+    ///             the database thread, which resumes the ingest from the event loop, so an event loop is run until it completes.
+    /// @param[in]  ingest: The ingest pipeline of the station.
+    /// @param[in]  batch: The raw archive records.
+    /// @returns    The number of records written to the database.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Function created.
+
+    static std::size_t ingestBatch(CIngest &ingest, std::vector<TRawRecord> const &batch)
+    {
+      std::size_t returnValue = 0;
+      std::exception_ptr batchException;
+      bool completed = false;
+      QEventLoop eventLoop;
+
+      ingest.ingest(batch).start([&](std::size_t written, std::exception_ptr exception)
+      {
+        returnValue = written;
+        batchException = exception;
+        completed = true;
+        eventLoop.quit();
+      });
+
+      if (!completed)
+      {
+        eventLoop.exec();
+      };
+
+      if (batchException)
+      {
+        std::rethrow_exception(batchException);
+      };
+
+      return returnValue;
+    }
+
+    /// @brief      Imports .wlk files into the weather database and the local store of the station. The files are imported in
+    ///             time order, a group of files at a time: the days of the group are decoded in parallel, then the records are
+    ///             passed through the ingest pipeline, which skips the records that are already held. The rainfall is rounded in
+    ///             time order as the records are passed on.
+    /// @param[in]  paths: The files and directories to import. (Directories are searched for *.wlk files.)
+    /// @param[in]  configuration: The configuration snapshot.
+    /// @param[in]  out: The stream progress is written to.
+    /// @returns    true if all the files were imported.
+    /// @throws     std::bad_alloc
+    /// @version    2026-10-19/GGB - Batches written through ingestBatch().
+    /// @version    2026-10-19/GGB - Store written once per group of files.
+    /// @version    2026-10-19/GGB - Rounding remainder of the rainfall carried between records.
+    /// @version    2026-10-19/GGB - Database opened through weatherDatabase.
+    /// @version    2026-10-19/GGB - Function created.
+
+    bool import(std::vector<QString> const &paths, configuration::SConfiguration const &configuration, std::ostream &out)
+    {
+      std::vector<std::tuple<int, int, QString>> files;
+      bool returnValue = true;
+      std::size_t totalDecoded = 0;
+      std::size_t totalWritten = 0;
+      double rainRemainder = 0;                               // Carried between records, and between groups of files.
+      auto startTime = std::chrono::steady_clock::now();
+
+      TRACESPAN("wlkImport");
+
+      for (QString const &path : paths)
+      {
+        QStringList names;
+
+        if (QFileInfo(path).isDir())
+        {
+          for (QString const &name : QDir(path).entryList(QStringList{ "*.wlk" }, QDir::Files, QDir::Name))
+          {
+            names.append(path + "/" + name);
+          };
+        }
+        else
+        {
+          names.append(path);
+        };
+
+        for (QString const &name : names)
+        {
+          int year, month;
+
+          if (parseFileName(name, year, month))
+          {
+            files.emplace_back(year, month, name);
+          }
+          else
+          {
+            out << "Not a .wlk file name (YYYY-MM.wlk): " << name.toStdString() << std::endl;
+            returnValue = false;
+          };
+        };
+      };
+
+      std::sort(files.begin(), files.end());
+
+      weatherDatabase::connect(configuration.database);
+      if (!weatherDatabase::open())
+      {
+        out << "Unable to open the weather database." << std::endl;
+        return false;
+      };
+
+      CIngest ingest(configuration.station.siteID, configuration.station.instrumentID, configuration);
+
+      for (std::size_t group = 0; group < files.size(); group += FILES_PER_GROUP)
+      {
+        std::size_t groupEnd = std::min(files.size(), group + FILES_PER_GROUP);
+        std::vector<std::unique_ptr<QFile>> mappedFiles;
+        std::vector<SDay> days;
+        std::vector<TRawRecord> batch;
+        std::size_t decoded = 0;
+        std::size_t written = 0;
+
+        for (std::size_t index = group; index < groupEnd; index++)
+        {
+          auto const &[year, month, name] = files[index];
+          std::unique_ptr<QFile> file = std::make_unique<QFile>(name);
+          std::uint8_t const *data = nullptr;
+
+          if (file->open(QIODevice::ReadOnly))
+          {
+            data = file->map(0, file->size());
+          };
+
+          if ( (data == nullptr) || !indexFile(data, static_cast<std::size_t>(file->size()), year, month, days) )
+          {
+            out << "Unable to read " << name.toStdString() << std::endl;
+            returnValue = false;
+          }
+          else
+          {
+            mappedFiles.push_back(std::move(file));         // Keeps the file mapped until the group has been ingested.
+          };
+        };
+
+        if (!decodeDays(days))
+        {
+          out << "Unable to decode " << std::get<2>(files[group]).toStdString() << " - "
+              << std::get<2>(files[groupEnd - 1]).toStdString() << std::endl;
+          return false;
+        };
+
+        batch.reserve(BATCH_RECORDS);
+        for (SDay &day : days)
+        {
+          for (std::size_t index = 0; index < day.records.size(); index++)
+          {
+            carryRainfall(day.records[index], day.rainfall[index], rainRemainder);
+            batch.push_back(day.records[index]);
+            if (batch.size() == BATCH_RECORDS)
+            {
+              decoded += batch.size();
+              written += ingestBatch(ingest, batch);
+              batch.clear();
+            };
+          };
+        };
+        if (!batch.empty())
+        {
+          decoded += batch.size();
+          written += ingestBatch(ingest, batch);
+        };
+        ingest.endDownload();
+
+        out << std::get<2>(files[group]).toStdString() << " - " << std::get<2>(files[groupEnd - 1]).toStdString() << ": "
+            << decoded << " records, " << written << " written." << std::endl;
+
+        totalDecoded += decoded;
+        totalWritten += written;
+      };
+
+      weatherDatabase::close();
+      weatherDatabase::disconnect();
+
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+      out << files.size() << " files, " << totalDecoded << " records, " << totalWritten << " written in " << seconds << " s."
+          << std::endl;
+
+      return returnValue;
+    }
+
+  } // namespace wlk
+} // namespace WSd
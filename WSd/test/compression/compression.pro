@@ -0,0 +1,52 @@
+##**********************************************************************************************************************************
+#
+## PROJECT:							WSd (Weather Station - Daemon)
+## FILE:								Compression tests
+## SUBSYSTEM:						Storage
+## LANGUAGE:						C++
+## TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+## LIBRARY DEPENDANCE:	Qt (QtTest)
+## NAMESPACE:						WSd
+## AUTHOR:							Gavin Blakeman (GGB)
+## LICENSE:             GPLv2
+##
+##                      Copyright 2026 Gavin Blakeman.
+##                      This file is part of the Weather Station - Daemon (WSd)
+##
+##                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+##                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+##                      any later version.
+##
+##                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+##                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+##                      more details.
+##
+##                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+##                      see <http://www.gnu.org/licenses/>.
+##
+## OVERVIEW:            Project File. Run with "qmake && make check".
+##
+## HISTORY:             2026-10-19/GGB - File created.
+##
+##**********************************************************************************************************************************
+
+TEMPLATE = app
+TARGET = tst_compression
+CONFIG   += console testcase
+
+QT       += testlib
+QT       -= gui
+
+QMAKE_CXXFLAGS += -std=c++20
+
+OBJECTS_DIR = "objects"
+MOC_DIR = "moc"
+
+INCLUDEPATH += "../.."
+
+SOURCES += \
+  tst_compression.cpp \
+  ../../source/compression.cpp
+
+HEADERS += \
+  ../../include/compression.h
@@ -0,0 +1,209 @@
+﻿//*********************************************************************************************************************************
+//
+// PROJECT:							WSd (Weather Station - Daemon)
+// FILE:								Compression tests
+// SUBSYSTEM:						Storage
+// LANGUAGE:						C++
+// TARGET OS:						UNIX/LINUX/WINDOWS/MAC
+// LIBRARY DEPENDANCE:	Qt (QtTest)
+// NAMESPACE:						WSd
+// AUTHOR:							Gavin Blakeman (GGB)
+// LICENSE:             GPLv2
+//
+//                      Copyright 2026 Gavin Blakeman.
+//                      This file is part of the Weather Station - Daemon (WSd)
+//
+//                      WSd is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+//                      License as published by the Free Software Foundation, either version 2 of the License, or (at your option)
+//                      any later version.
+//
+//                      WSd is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+//                      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//                      more details.
+//
+//                      You should have received a copy of the GNU General Public License along with WSd.  If not,
+//                      see <http://www.gnu.org/licenses/>.
+//
+// OVERVIEW:            Round trip tests of the delta and delta of delta encodings used by the local store. The values are chosen
+//                      at the edges of the prefix buckets of writeSigned() and at the limits of int64.
+//
+// HISTORY:             2026-10-19/GGB - File created.
+//
+//*********************************************************************************************************************************
+
+#include "include/compression.h"
+
+  // Standard C++ library header files
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+  // Miscellaneous library header files.
+
+#include <QtTest>
+
+using namespace WSd;
+
+namespace
+{
+  std::int64_t const INT64_LOWEST = std::numeric_limits<std::int64_t>::min();
+  std::int64_t const INT64_HIGHEST = std::numeric_limits<std::int64_t>::max();
+  std::int64_t const INT32_LOWEST = std::numeric_limits<std::int32_t>::min();
+  std::int64_t const INT32_HIGHEST = std::numeric_limits<std::int32_t>::max();
+
+  /// @brief      Encodes the values and decodes them again.
+  /// @param[in]  values: The values to encode.
+  /// @param[in]  deltaOfDelta: true - delta of delta encoding, false - delta encoding.
+  /// @returns    The decoded values.
+  /// @throws     std::bad_alloc
+
+  std::vector<std::int64_t> encodeDecode(std::vector<std::int64_t> const &values, bool deltaOfDelta)
+  {
+    std::vector<std::uint8_t> buffer;
+    CBitWriter writer(buffer);
+    CDeltaEncoder encoder(deltaOfDelta);
+
+    for (std::int64_t value : values)
+    {
+      encoder.encode(writer, value);
+    };
+
+    CBitReader reader(buffer.data(), buffer.size());
+    CDeltaEncoder decoder(deltaOfDelta);
+    std::vector<std::int64_t> decoded;
+
+    for (std::size_t index = 0; index < values.size(); index++)
+    {
+      decoded.push_back(decoder.decode(reader));
+    };
+
+    return (reader.overrun() ? std::vector<std::int64_t>() : decoded);
+  }
+
+  /// @brief      Builds a series whose successive differences are the given deltas.
+  /// @param[in]  start: The first value.
+  /// @param[in]  deltas: The differences.
+  /// @returns    The series.
+  /// @throws     std::bad_alloc
+
+  std::vector<std::int64_t> series(std::int64_t start, std::vector<std::int64_t> const &deltas)
+  {
+    std::vector<std::int64_t> values{ start };
+
+    for (std::int64_t delta : deltas)
+    {
+      values.push_back(values.back() + delta);
+    };
+
+    return values;
+  }
+}
+
+class CTestCompression : public QObject
+{
+  Q_OBJECT
+
+private slots:
+  void signedValue_data();
+  void signedValue();
+  void roundTrip_data();
+  void roundTrip();
+};
+
+/// @brief      The values at both edges of every bucket of writeSigned(), with the number of bits each one is written in.
+
+void CTestCompression::signedValue_data()
+{
+  QTest::addColumn<std::int64_t>("value");
+  QTest::addColumn<int>("bits");
+
+  QTest::newRow("zero") << std::int64_t(0) << 1;
+  QTest::newRow("one") << std::int64_t(1) << 9;
+  QTest::newRow("minus one") << std::int64_t(-1) << 9;
+  QTest::newRow("7 bit low") << std::int64_t(-63) << 9;
+  QTest::newRow("7 bit high") << std::int64_t(64) << 9;
+  QTest::newRow("9 bit low") << std::int64_t(-64) << 12;
+  QTest::newRow("9 bit high low") << std::int64_t(65) << 12;
+  QTest::newRow("9 bit low edge") << std::int64_t(-255) << 12;
+  QTest::newRow("9 bit high") << std::int64_t(256) << 12;
+  QTest::newRow("12 bit low") << std::int64_t(-256) << 16;
+  QTest::newRow("12 bit high low") << std::int64_t(257) << 16;
+  QTest::newRow("12 bit low edge") << std::int64_t(-2047) << 16;
+  QTest::newRow("12 bit high") << std::int64_t(2048) << 16;
+  QTest::newRow("32 bit low") << std::int64_t(-2048) << 37;
+  QTest::newRow("32 bit high low") << std::int64_t(2049) << 37;
+  QTest::newRow("32 bit low edge") << INT32_LOWEST << 37;
+  QTest::newRow("32 bit high") << INT32_HIGHEST << 37;
+  QTest::newRow("64 bit low") << INT32_LOWEST - 1 << 69;
+  QTest::newRow("64 bit high low") << INT32_HIGHEST + 1 << 69;
+  QTest::newRow("64 bit low edge") << INT64_LOWEST << 69;
+  QTest::newRow("64 bit high") << INT64_HIGHEST << 69;
+}
+
+/// @brief      Each value is read back unchanged and is written in the bucket expected for it.
+
+void CTestCompression::signedValue()
+{
+  QFETCH(std::int64_t, value);
+  QFETCH(int, bits);
+
+  std::vector<std::uint8_t> buffer;
+  CBitWriter writer(buffer);
+
+  CDeltaEncoder::writeSigned(writer, value);
+  writer.write(0x01, 1);                      // Marker immediately after the value.
+
+  CBitReader reader(buffer.data(), buffer.size());
+
+  QCOMPARE(CDeltaEncoder::readSigned(reader), value);
+  QCOMPARE(reader.readBit(), true);
+  QCOMPARE(buffer.size(), static_cast<std::size_t>((bits + 1 + 7) / 8));
+}
+
+/// @brief      Series for both encodings. Negative and large deltas, deltas on the bucket edges and series whose deltas overflow
+///             int64 (these must wrap in the encoder and the decoder).
+
+void CTestCompression::roundTrip_data()
+{
+  QTest::addColumn<std::vector<std::int64_t>>("values");
+  QTest::addColumn<bool>("deltaOfDelta");
+
+  std::vector<std::int64_t> const edges{ 0, 1, -1, 64, -63, -64, 65, 256, -255, -256, 257, 2048, -2047, -2048, 2049,
+                                         INT32_HIGHEST, INT32_LOWEST, INT32_HIGHEST + 1, INT32_LOWEST - 1 };
+
+  for (bool deltaOfDelta : { false, true })
+  {
+    char const *mode = deltaOfDelta ? "delta of delta" : "delta";
+
+    QTest::addRow("%s: single value", mode) << std::vector<std::int64_t>{ 1760000000 } << deltaOfDelta;
+    QTest::addRow("%s: regular timestamps", mode) << series(1760000000, std::vector<std::int64_t>(100, 300)) << deltaOfDelta;
+    QTest::addRow("%s: timestamps with gaps", mode)
+        << series(1760000000, { 300, 300, 3600, 300, 86400 * 30, 300, 60, 60 }) << deltaOfDelta;
+    QTest::addRow("%s: bucket edges as deltas", mode) << series(0, edges) << deltaOfDelta;
+    QTest::addRow("%s: bucket edges as values", mode) << edges << deltaOfDelta;
+    QTest::addRow("%s: negative deltas", mode)
+        << series(1000000, { -1, -63, -64, -255, -256, -2047, -2048, -100000 }) << deltaOfDelta;
+    QTest::addRow("%s: negative start", mode) << series(-62135596800, { 86400, 86400, -1, 1 }) << deltaOfDelta;
+    QTest::addRow("%s: int64 limits", mode)
+        << std::vector<std::int64_t>{ INT64_LOWEST, INT64_HIGHEST, INT64_LOWEST, 0, INT64_HIGHEST, -1, INT64_LOWEST + 1 }
+        << deltaOfDelta;
+    QTest::addRow("%s: large deltas", mode)
+        << std::vector<std::int64_t>{ 0, INT64_HIGHEST / 2, -(INT64_HIGHEST / 2), INT64_HIGHEST, INT64_HIGHEST - 1, INT64_LOWEST }
+        << deltaOfDelta;
+  };
+}
+
+/// @brief      The decoded series is identical to the encoded series.
+
+void CTestCompression::roundTrip()
+{
+  QFETCH(std::vector<std::int64_t>, values);
+  QFETCH(bool, deltaOfDelta);
+
+  QVERIFY(encodeDecode(values, deltaOfDelta) == values);
+}
+
+QTEST_APPLESS_MAIN(CTestCompression)
+
+#include "tst_compression.moc"